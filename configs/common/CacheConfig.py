@@ -76,6 +76,18 @@ def config_cache(options, system):
         system.l2.cpu_side = system.tol2bus.master
         system.l2.mem_side = system.membus.slave
 
+    if options.parallel_fastmem:
+        if not options.fastmem or not options.sim_quantum:
+            print "--parallel-fastmem requires --fastmem and --sim-quantum"
+            sys.exit(1)
+    elif options.sim_quantum:
+        if buildEnv['TARGET_ISA'] == 'x86':
+            print "--sim-quantum is not supported for x86"
+            sys.exit(1)
+    elif options.parallel_cpus:
+        print "--parallel-cpus requires --sim-quantum"
+        sys.exit(1)
+
     if options.memchecker:
         system.memchecker = MemChecker()
 
@@ -117,7 +129,40 @@ def config_cache(options, system):
                 system.cpu[i].dcache_mon = dcache_mon
 
         system.cpu[i].createInterruptController()
-        if options.l2cache:
+        if options.parallel_fastmem:
+            # Everything the CPU does not access directly, e.g. page
+            # table walks and the functional accesses of system calls,
+            # goes through a bridge that accesses memory with the same
+            # synchronisation as the CPU, and takes over the event
+            # queue of the memory system for anything else
+            system.cpu[i].l1bus = NoncoherentXBar(width = 32)
+            system.cpu[i].membridge = ConcurrentMemBridge()
+            system.cpu[i].connectCachedPorts(system.cpu[i].l1bus)
+            system.cpu[i].connectUncachedPorts(system.membus)
+            system.cpu[i].l1bus.master = system.cpu[i].membridge.slave
+            system.cpu[i].membridge.master = system.membus.slave
+        elif options.sim_quantum:
+            # The CPU and its private L1s only talk to the shared
+            # memory system, including the shared L2 if there is one,
+            # through a bridge that exchanges packets at quantum
+            # boundaries, so they can live on their own event queue
+            # while the shared part stays on queue 0. The bridge
+            # forwards snoops to the L1s through a coherent crossbar.
+            if options.caches:
+                system.cpu[i].l1bus = CoherentXBar(width = 32)
+            else:
+                system.cpu[i].l1bus = NoncoherentXBar(width = 32)
+            system.cpu[i].membridge = Bridge(quantum_sync = True,
+                                             mem_side_eventq_index = 0)
+            system.cpu[i].connectAllPorts(system.cpu[i].l1bus)
+            system.cpu[i].l1bus.master = system.cpu[i].membridge.slave
+            if options.l2cache:
+                system.cpu[i].membridge.master = system.tol2bus.slave
+            else:
+                system.cpu[i].membridge.master = system.membus.slave
+            if options.parallel_cpus:
+                system.cpu[i].eventq_index = i + 1
+        elif options.l2cache:
             system.cpu[i].connectAllPorts(system.tol2bus, system.membus)
         else:
             system.cpu[i].connectAllPorts(system.membus)
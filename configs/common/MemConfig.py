@@ -50,6 +50,7 @@ _mem_classes = {}
 # first available memory controller model in the tuple will be used.
 _mem_aliases_all = [
     ("simple_mem", "SimpleMemory"),
+    ("analytical_mem", "AnalyticalMemory"),
     ("ddr3_1600_x64", "DDR3_1600_x64"),
     ("lpddr2_s4_1066_x32", "LPDDR2_S4_1066_x32"),
     ("lpddr3_1600_x32", "LPDDR3_1600_x32"),
@@ -127,6 +128,13 @@ for alias, target in _mem_aliases_all:
         # Normal alias
         _mem_aliases[alias] = target
 
+def is_dram_class(cls):
+    """Determine if a memory class has the organisation of a DRAM, i.e.
+    channels, ranks and banks."""
+
+    return issubclass(cls, (m5.objects.DRAMCtrl,
+                            m5.objects.AnalyticalMemory))
+
 def create_mem_ctrl(cls, r, i, nbr_mem_ctrls, intlv_bits, intlv_size):
     """
     Helper function for creating a single memoy controller from the given
@@ -148,8 +156,8 @@ def create_mem_ctrl(cls, r, i, nbr_mem_ctrls, intlv_bits, intlv_size):
     # mapping and row-buffer size
     ctrl = cls()
 
-    # Only do this for DRAMs
-    if issubclass(cls, m5.objects.DRAMCtrl):
+    # Only do this for DRAMs, and the analytical model of one
+    if is_dram_class(cls):
         # Inform each controller how many channels to account
         # for
         ctrl.channels = nbr_mem_ctrls
@@ -214,8 +222,7 @@ def config_mem(options, system):
                                        intlv_size)
             # Set the number of ranks based on the command-line
             # options if it was explicitly set
-            if issubclass(cls, m5.objects.DRAMCtrl) and \
-                    options.mem_ranks:
+            if is_dram_class(cls) and options.mem_ranks:
                 mem_ctrl.ranks_per_channel = options.mem_ranks
 
             mem_ctrls.append(mem_ctrl)
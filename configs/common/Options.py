@@ -115,6 +115,28 @@ def addCommonOptions(parser):
 
     parser.add_option("--memchecker", action="store_true")
 
+    # Parallel simulation options
+    parser.add_option("--sim-quantum", type="string", default=None,
+                      help="Connect each CPU and its private caches to "
+                      "the shared memory system, including any --l2cache, "
+                      "through a bridge synchronised at this quantum "
+                      "(e.g. 10ns). Packets crossing the bridge wait for "
+                      "the end of the quantum, so keep it short")
+    parser.add_option("--parallel-cpus", action="store_true",
+                      help="With --sim-quantum, simulate each CPU on its "
+                      "own event queue and host thread, and the shared "
+                      "memory system on another. Without it the same "
+                      "system runs on one thread, which gives the "
+                      "reference stats for a determinism check. Snoops "
+                      "to the private --caches of other CPUs are not "
+                      "deferred to quantum boundaries, so such runs are "
+                      "not deterministic")
+
+    parser.add_option("--parallel-fastmem", action="store_true",
+                      help="With --fastmem and --sim-quantum, simulate "
+                      "each atomic CPU on its own event queue and host "
+                      "thread, accessing memory directly")
+
     # Cache Options
     parser.add_option("--caches", action="store_true")
     parser.add_option("--l2cache", action="store_true")
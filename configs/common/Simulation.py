@@ -438,6 +438,11 @@ def run(options, root, testsys, cpu_class):
     if options.standard_switch and options.repeat_switch:
         fatal("Can't specify both --standard-switch and --repeat-switch")
 
+    if options.sim_quantum:
+        m5.ticks.fixGlobalFrequency()
+        root.sim_quantum = m5.ticks.fromSeconds(
+            m5.util.convert.anyToLatency(options.sim_quantum))
+
     if options.repeat_switch and options.take_checkpoints:
         fatal("Can't specify both --repeat-switch and --take-checkpoints")
 
@@ -0,0 +1,133 @@
+#
+# Copyright (c) 2015 The gem5 SDC model contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import optparse
+import os
+import sys
+
+import m5
+from m5.objects import *
+from m5.util import addToPath, fatal
+
+addToPath('../common')
+
+import MemConfig
+
+# this script mixes a latency-sensitive (real-time) traffic generator
+# with a bandwidth-hungry (batch) one on a single DRAM channel, and is
+# helpful to see how the quality of service settings of the controller
+# affect the read latency percentiles of the real-time master, which
+# are reported per master in the stats of the controller
+
+parser = optparse.OptionParser()
+
+parser.add_option("--mem-type", type="choice", default="ddr3_1600_x64",
+                  choices=MemConfig.mem_names(),
+                  help = "type of memory to use")
+
+parser.add_option("--rt-load", type="int", default=10,
+                  help = "Real-time load in percent of the peak bandwidth")
+
+parser.add_option("--batch-load", type="int", default=100,
+                  help = "Batch load in percent of the peak bandwidth")
+
+parser.add_option("--rt-priority", type="int", default=0,
+                  help = "QoS priority of the real-time master")
+
+parser.add_option("--rt-bw", type="string", default=None,
+                  help = "Bandwidth reserved for the real-time master")
+
+parser.add_option("--escalation", type="string", default="0ns",
+                  help = "Wait before a request is escalated one level")
+
+parser.add_option("--duration", type="int", default=1000000000,
+                  help = "Ticks to simulate")
+
+(options, args) = parser.parse_args()
+
+if args:
+    print "Error: script doesn't take any positional arguments"
+    sys.exit(1)
+
+system = System(membus = NoncoherentXBar(width = 16))
+system.clk_domain = SrcClockDomain(clock = '1.5GHz',
+                                   voltage_domain =
+                                   VoltageDomain(voltage = '1V'))
+
+mem_range = AddrRange('256MB')
+system.mem_ranges = [mem_range]
+
+options.mem_channels = 1
+options.mem_ranks = None
+MemConfig.config_mem(options, system)
+
+dram = system.mem_ctrls[0]
+if not isinstance(dram, m5.objects.DRAMCtrl):
+    fatal("This script assumes the memory is a DRAMCtrl subclass")
+
+# the batch master is left at the default priority of 0
+dram.qos_masters = ["rtgen"]
+dram.qos_priorities = [options.rt_priority]
+if options.rt_bw:
+    dram.qos_reserved_bw = [options.rt_bw]
+dram.qos_escalation = options.escalation
+
+burst_size = int((dram.devices_per_rank.value *
+                  dram.device_bus_width.value *
+                  dram.burst_length.value) / 8)
+t_burst = dram.tBURST.value * 1000000000000
+
+def write_config(file_name, mode, load):
+    itt = int(t_burst * 100 / load)
+    cfg_file = open(file_name, 'w')
+    cfg_file.write("STATE 0 %d %s 100 0 %d %d %d %d 0\n" %
+                   (options.duration, mode, mem_range.end, burst_size,
+                    itt, itt))
+    cfg_file.write("INIT 0\n")
+    cfg_file.write("TRANSITION 0 0 1\n")
+    cfg_file.close()
+
+rt_cfg = os.path.join(m5.options.outdir, "qos_rt.cfg")
+batch_cfg = os.path.join(m5.options.outdir, "qos_batch.cfg")
+write_config(rt_cfg, "RANDOM", options.rt_load)
+write_config(batch_cfg, "LINEAR", options.batch_load)
+
+system.rtgen = TrafficGen(config_file = rt_cfg)
+system.batchgen = TrafficGen(config_file = batch_cfg)
+
+system.rtgen.port = system.membus.slave
+system.batchgen.port = system.membus.slave
+
+# connect the system port even if it is not used in this example
+system.system_port = system.membus.slave
+
+root = Root(full_system = False, system = system)
+root.system.mem_mode = 'timing'
+
+m5.instantiate()
+m5.simulate(options.duration)
@@ -0,0 +1,186 @@
+#
+# Copyright (c) 2015 The gem5 SDC model contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import optparse
+import os
+import re
+import sys
+
+import m5
+from m5.objects import *
+from m5.util import addToPath, fatal
+from m5.internal.stats import periodicStatDump
+
+addToPath('../common')
+
+import MemConfig
+
+# this script runs the same traffic generator profiles against a
+# DRAMCtrl configuration and the AnalyticalMemory derived from it,
+# side by side in one system, and compares the average read latency
+# seen by the two generators for every profile
+
+parser = optparse.OptionParser()
+
+parser.add_option("--mem-type", type="choice", default="ddr3_1600_x64",
+                  choices=MemConfig.mem_names(),
+                  help = "type of DRAM to compare against")
+
+parser.add_option("--rd_perc", type="int", default=100,
+                  help = "Percentage of read commands")
+
+parser.add_option("--loads", type="string", default="10,50,90",
+                  help = "Comma-separated offered loads in percent of the "
+                  "peak bandwidth")
+
+parser.add_option("--tolerance", type="float", default=10.0,
+                  help = "Acceptable read latency error in percent")
+
+(options, args) = parser.parse_args()
+
+if args:
+    print "Error: script doesn't take any positional arguments"
+    sys.exit(1)
+
+dram_class = MemConfig.get(options.mem_type)
+if not issubclass(dram_class, m5.objects.DRAMCtrl):
+    fatal("This script assumes the memory is a DRAMCtrl subclass")
+
+system = System()
+system.clk_domain = SrcClockDomain(clock = '1.5GHz',
+                                   voltage_domain =
+                                   VoltageDomain(voltage = '1V'))
+
+# one range per memory, both of the same size so that the two see
+# identical traffic relative to the start of their range
+mem_size = 0x10000000
+ranges = [AddrRange(0, size = mem_size),
+          AddrRange(mem_size, size = mem_size)]
+system.mem_ranges = ranges
+
+system.dram = dram_class(range = ranges[0])
+system.analytical = AnalyticalMemory.fromDRAM(dram_class, range = ranges[1])
+mems = [system.dram, system.analytical]
+
+# stay in each state for 0.25 ms, long enough to warm things up
+period = 250000000
+
+dram = system.dram
+burst_size = int((dram.devices_per_rank.value *
+                  dram.device_bus_width.value *
+                  dram.burst_length.value) / 8)
+page_size = dram.devices_per_rank.value * dram.device_rowbuffer_size.value
+nbr_banks = dram.banks_per_rank.value
+ranks = dram.ranks_per_channel.value
+# the time per burst at peak bandwidth, in ticks
+t_burst = dram.tBURST.value * 1000000000000
+
+# the profiles, each run at every load, with the page hit length of
+# the DRAM profile chosen to give a mix of hits and misses
+profiles = ["LINEAR", "RANDOM", "DRAM"]
+loads = [int(l) for l in options.loads.split(',')]
+states = [(p, l) for p in profiles for l in loads]
+
+def write_config(file_name, mem_range):
+    cfg_file = open(file_name, 'w')
+    for i, (profile, load) in enumerate(states):
+        itt = int(t_burst * 100 / load)
+        cfg_file.write("STATE %d %d %s %d %d %d %d %d %d 0" %
+                       (i, period, profile, options.rd_perc,
+                        mem_range.start, mem_range.end, burst_size,
+                        itt, itt))
+        if profile == "DRAM":
+            cfg_file.write(" %d %d %d %d 1 %d" %
+                           (burst_size * 4, page_size, nbr_banks, nbr_banks,
+                            ranks))
+        cfg_file.write("\n")
+    cfg_file.write("INIT 0\n")
+    for i in range(1, len(states)):
+        cfg_file.write("TRANSITION %d %d 1\n" % (i - 1, i))
+    cfg_file.write("TRANSITION %d %d 1\n" % (len(states) - 1,
+                                              len(states) - 1))
+    cfg_file.close()
+
+# a generator, monitor and crossbar per memory, with the generators
+# following the same sequence of states
+system.tgen = []
+system.monitor = []
+system.membus = []
+for i, mem in enumerate(mems):
+    cfg_file_name = os.path.join(m5.options.outdir, "validate%d.cfg" % i)
+    write_config(cfg_file_name, ranges[i])
+    tgen = TrafficGen(config_file = cfg_file_name)
+    monitor = CommMonitor()
+    membus = NoncoherentXBar(width = 16)
+    tgen.port = monitor.slave
+    monitor.master = membus.slave
+    membus.master = mem.port
+    system.tgen.append(tgen)
+    system.monitor.append(monitor)
+    system.membus.append(membus)
+
+system.system_port = system.membus[0].slave
+
+# every period, dump and reset all stats
+periodicStatDump(period)
+
+root = Root(full_system = False, system = system)
+root.system.mem_mode = 'timing'
+
+m5.instantiate()
+m5.simulate(len(states) * period)
+m5.stats.dump()
+
+# pick the mean read latency of the two monitors out of every dump,
+# with the first dump for each state
+latency = re.compile(r"^system\.monitor(\d)\.readLatencyHist::mean\s+(\S+)")
+dumps = []
+for line in open(os.path.join(m5.options.outdir, "stats.txt")):
+    if line.startswith("---------- Begin"):
+        dumps.append({})
+        continue
+    m = latency.match(line)
+    if m and dumps:
+        dumps[-1][int(m.group(1))] = float(m.group(2))
+
+print "%-8s %5s %12s %12s %8s" % ("profile", "load", "DRAMCtrl",
+                                   "analytical", "error")
+worst = 0.0
+for (profile, load), dump in zip(states, dumps):
+    if 0 not in dump or 1 not in dump or dump[0] == 0:
+        print "%-8s %4d%% %12s" % (profile, load, "no reads")
+        continue
+    error = 100.0 * (dump[1] - dump[0]) / dump[0]
+    worst = max(worst, abs(error))
+    print "%-8s %4d%% %10.1fns %10.1fns %7.1f%%" % \
+        (profile, load, dump[0] / 1000, dump[1] / 1000, error)
+
+print "Worst case read latency error: %.1f%% (tolerance %.1f%%)" % \
+    (worst, options.tolerance)
+if worst > options.tolerance:
+    sys.exit(1)
@@ -207,6 +207,11 @@ def build_test_system(np):
         for i in xrange(np):
             if options.fastmem:
                 test_sys.cpu[i].fastmem = True
+            if options.parallel_fastmem:
+                # memory is accessed concurrently, and devices by
+                # migrating to the event queue of the system
+                test_sys.cpu[i].parallel_fastmem = True
+                test_sys.cpu[i].eventq_index = i + 1
             if options.simpoint_profile:
                 test_sys.cpu[i].addSimPointProbe(options.simpoint_interval)
             if options.checker:
@@ -0,0 +1,136 @@
+#
+# Copyright (c) 2015 The gem5 SDC model contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+import optparse
+import os
+import sys
+import time
+
+import m5
+from m5.objects import *
+from m5.util import addToPath, fatal
+
+addToPath('../common')
+
+import MemConfig
+
+# this script times the two phases of a syscall-emulation run that
+# are dominated by debug accesses through the port proxies, namely
+# loading the executable when the system is instantiated, and any
+# large system calls copying data in and out of the guest, e.g. the
+# 1 GByte read() done by tests/test-progs/bigread. When caches are
+# bypassed, or when an atomic-mode system has no caches at all, the
+# proxies copy straight to and from the backing store, whereas with
+# caches every transfer is split into cache-line packets. Running the
+# same binary with --mem-mode atomic, with and without --caches, and
+# with --mem-mode atomic_noncaching shows the difference
+
+parser = optparse.OptionParser()
+
+parser.add_option("-c", "--cmd", type="string",
+                  help="binary to load and run")
+
+parser.add_option("-o", "--options", type="string", default="",
+                  help="command-line arguments for the binary")
+
+parser.add_option("--mem-mode", type="choice", default="atomic_noncaching",
+                  choices=["atomic", "atomic_noncaching"],
+                  help="memory mode of the system")
+
+parser.add_option("--caches", action="store_true",
+                  help="add L1 caches to the CPU (atomic mode only)")
+
+parser.add_option("--mem-type", type="choice", default="simple_mem",
+                  choices=MemConfig.mem_names(),
+                  help = "type of memory to use")
+
+parser.add_option("--mem-size", action="store", type="string",
+                  default="2GB",
+                  help="Specify the memory size")
+
+parser.add_option("--mem-channels", type="int", default=1,
+                  help = "number of memory channels")
+
+parser.add_option("--mem-ranks", type="int", default=None,
+                  help = "number of memory ranks per channel")
+
+(options, args) = parser.parse_args()
+
+if args:
+    print "Error: script doesn't take any positional arguments"
+    sys.exit(1)
+
+if not options.cmd:
+    fatal("No binary specified, use --cmd")
+
+if options.caches and options.mem_mode != "atomic":
+    fatal("--caches requires --mem-mode atomic")
+
+system = System(cpu = AtomicSimpleCPU(cpu_id = 0),
+                mem_mode = options.mem_mode,
+                mem_ranges = [AddrRange(options.mem_size)])
+
+system.voltage_domain = VoltageDomain()
+system.clk_domain = SrcClockDomain(clock = '1GHz',
+                                   voltage_domain = system.voltage_domain)
+
+system.membus = CoherentXBar()
+system.system_port = system.membus.slave
+
+process = LiveProcess()
+process.executable = options.cmd
+process.cmd = [options.cmd] + options.options.split()
+process.cwd = os.getcwd()
+
+system.cpu.workload = process
+system.cpu.createThreads()
+system.cpu.createInterruptController()
+
+# with caches, the debug accesses have to go through them
+if options.caches:
+    def l1():
+        return BaseCache(size = '32kB', assoc = 2, hit_latency = 2,
+                         response_latency = 2, mshrs = 4, tgts_per_mshr = 8,
+                         is_top_level = True)
+    system.cpu.addPrivateSplitL1Caches(l1(), l1())
+system.cpu.connectAllPorts(system.membus)
+
+MemConfig.config_mem(options, system)
+
+root = Root(full_system = False, system = system)
+
+start = time.time()
+m5.instantiate()
+load = time.time() - start
+
+start = time.time()
+exit_event = m5.simulate()
+run = time.time() - start
+
+print "Loading %s took %.3f s" % (options.cmd, load)
+print "Running %s took %.3f s, exiting @ tick %i because %s" % \
+    (options.cmd, run, m5.curTick(), exit_event.getCause())
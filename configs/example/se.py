@@ -227,6 +227,11 @@ for i in xrange(np):
 
     if options.fastmem:
         system.cpu[i].fastmem = True
+    if options.parallel_fastmem:
+        # memory is accessed concurrently, and devices by
+        # migrating to the event queue of the system
+        system.cpu[i].parallel_fastmem = True
+        system.cpu[i].eventq_index = i + 1
 
     if options.simpoint_profile:
         system.cpu[i].addSimPointProbe(options.simpoint_interval)
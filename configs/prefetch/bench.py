@@ -0,0 +1,244 @@
+#
+# Copyright (c) 2015 The gem5 SDC model contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+import optparse
+import os
+import random
+import sys
+import struct
+
+import m5
+from m5.objects import *
+from m5.util import addToPath, fatal
+from m5.internal.stats import periodicStatDump
+
+addToPath('../common')
+
+import MemConfig
+
+# this script runs a set of synthetic access patterns through a single
+# cache with a configurable prefetcher, to quickly compare prefetchers
+# and tune their parameters without booting an OS. The patterns are
+# written as binary packet traces that the traffic generator replays,
+# one pattern per state, and the stats are dumped and reset at the end
+# of each state, thus giving the prefetcher accuracy, coverage and
+# timeliness per pattern
+
+parser = optparse.OptionParser()
+
+parser.add_option("--mem-type", type="choice", default="ddr3_1600_x64",
+                  choices=MemConfig.mem_names(),
+                  help = "type of memory to use")
+
+prefetchers = {
+    "none" : None,
+    "stride" : StridePrefetcher,
+    "tagged" : TaggedPrefetcher,
+    "stream" : StreamPrefetcher,
+    "best-offset" : BestOffsetPrefetcher,
+}
+
+parser.add_option("--prefetcher", type="choice", default="stream",
+                  choices=prefetchers.keys(),
+                  help = "prefetcher to evaluate")
+
+parser.add_option("--degree", type="int", default=None,
+                  help = "prefetch degree, prefetcher default if not set")
+
+patterns = ["stream", "stride", "random", "mixed"]
+
+parser.add_option("--patterns", type="string", default=",".join(patterns),
+                  help = "comma separated list of patterns from: %s" %
+                  ", ".join(patterns))
+
+parser.add_option("--accesses", type="int", default=100000,
+                  help = "number of accesses per pattern")
+
+parser.add_option("--footprint", type="string", default="64MB",
+                  help = "memory footprint of each pattern")
+
+parser.add_option("--stride", type="int", default=4,
+                  help = "stride in cache lines for the strided pattern")
+
+parser.add_option("--streams", type="int", default=4,
+                  help = "number of interleaved streams")
+
+parser.add_option("--itt", type="int", default=5000,
+                  help = "ticks between independent accesses")
+
+parser.add_option("--random-itt", type="int", default=100000,
+                  help = "ticks between random accesses, spaced to "
+                  "resemble a latency-bound pointer chase")
+
+parser.add_option("--cache-size", type="string", default="256kB",
+                  help = "size of the cache")
+
+parser.add_option("--seed", type="int", default=1,
+                  help = "seed for the random patterns")
+
+(options, args) = parser.parse_args()
+
+if args:
+    print "Error: script doesn't take any positional arguments"
+    sys.exit(1)
+
+line_size = 64
+footprint = long(MemorySize(options.footprint))
+lines = footprint / line_size
+
+random.seed(options.seed)
+
+# each pattern is a list of (delay, address) pairs, where the delay
+# is the time since the previous access
+def stream_pattern(n):
+    per_stream = lines / options.streams
+    return [(options.itt,
+             ((i % options.streams) * per_stream +
+              (i / options.streams) % per_stream) * line_size)
+            for i in range(n)]
+
+def stride_pattern(n):
+    return [(options.itt, (i * options.stride % lines) * line_size)
+            for i in range(n)]
+
+def random_pattern(n):
+    # visit the footprint in a random order, with the accesses spaced
+    # out so that only one is typically in flight; note that a trace
+    # is replayed open loop, so the accesses do not actually depend
+    # on each other as they would in a pointer chase
+    order = range(lines)
+    random.shuffle(order)
+    return [(options.random_itt, order[i % lines] * line_size)
+            for i in range(n)]
+
+def mixed_pattern(n):
+    # interleave the other patterns in separate parts of the footprint
+    parts = [stream_pattern(n), stride_pattern(n), random_pattern(n)]
+    return [(parts[i % 3][i][0] / 3, parts[i % 3][i][1] % (footprint / 3) +
+             (i % 3) * (footprint / 3)) for i in range(n)]
+
+generators = {
+    "stream" : stream_pattern,
+    "stride" : stride_pattern,
+    "random" : random_pattern,
+    "mixed" : mixed_pattern,
+}
+
+# write a pattern as a binary packet trace, see mem/packet_trace.hh,
+# with uncompressed blocks and all accesses being reads
+def write_trace(filename, pattern):
+    read_cmd = 1
+    trace = open(filename, 'wb')
+    trace.write(struct.pack('<8sIIQ104s', '\x89gem5pkt', 1, 32,
+                            10 ** 12, "prefetch_bench"))
+    block = 4096
+    tick = 0
+    for start in range(0, len(pattern), block):
+        records = pattern[start:start + block]
+        trace.write(struct.pack('<II', len(records), len(records) * 32))
+        for (delay, addr) in records:
+            tick += delay
+            trace.write(struct.pack('<QQIIII', tick, addr, line_size, 0,
+                                    read_cmd, 0))
+    trace.close()
+    return tick
+
+system = System(membus = NoncoherentXBar(width = 16))
+system.clk_domain = SrcClockDomain(clock = '2GHz',
+                                   voltage_domain =
+                                   VoltageDomain(voltage = '1V'))
+
+mem_range = AddrRange(max(footprint, long(MemorySize('256MB'))))
+system.mem_ranges = [mem_range]
+
+options.mem_channels = 1
+MemConfig.config_mem(options, system)
+
+system.cache = BaseCache(size = options.cache_size, assoc = 8,
+                         hit_latency = 20, response_latency = 20,
+                         mshrs = 32, tgts_per_mshr = 8,
+                         is_top_level = True,
+                         prefetch_on_access = True)
+
+if prefetchers[options.prefetcher]:
+    system.cache.prefetcher = prefetchers[options.prefetcher]()
+    if options.degree is not None:
+        system.cache.prefetcher.degree = options.degree
+
+# create the traces and a state per pattern, staying in each state
+# long enough to replay the whole trace
+cfg_file_name = os.path.join(m5.options.outdir, "prefetch_bench.cfg")
+cfg_file = open(cfg_file_name, 'w')
+
+selected = options.patterns.split(",")
+for p in selected:
+    if p not in generators:
+        fatal("Unknown pattern %s" % p)
+
+period = 0
+for p in selected:
+    trace_name = os.path.join(m5.options.outdir, "%s.trc" % p)
+    period = max(period, write_trace(trace_name,
+                                     generators[p](options.accesses)))
+
+# leave some time for the outstanding accesses to complete
+period = period * 2
+
+for (state, p) in enumerate(selected):
+    cfg_file.write("STATE %d %d TRACE %s 0\n" %
+                   (state, period,
+                    os.path.join(m5.options.outdir, "%s.trc" % p)))
+
+cfg_file.write("INIT 0\n")
+
+for state in range(1, len(selected)):
+    cfg_file.write("TRANSITION %d %d 1\n" % (state - 1, state))
+
+cfg_file.write("TRANSITION %d %d 1\n" %
+               (len(selected) - 1, len(selected) - 1))
+
+cfg_file.close()
+
+system.tgen = TrafficGen(config_file = cfg_file_name)
+
+system.tgen.port = system.cache.cpu_side
+system.cache.mem_side = system.membus.slave
+
+# connect the system port even if it is not used in this example
+system.system_port = system.membus.slave
+
+# every period, dump and reset all stats, one pattern at a time
+periodicStatDump(period)
+
+root = Root(full_system = False, system = system)
+root.system.mem_mode = 'timing'
+
+m5.instantiate()
+m5.simulate(len(selected) * period)
+
+print "Prefetch benchmark with %s prefetcher, patterns: %s" % \
+    (options.prefetcher, ", ".join(selected))
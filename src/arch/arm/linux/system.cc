@@ -263,6 +263,8 @@ LinuxArmSystemParams::create()
 void
 LinuxArmSystem::startup()
 {
+    ArmSystem::startup();
+
     if (enableContextSwitchStatsDump) {
         dumpStatsPCEvent = addKernelFuncEvent<DumpStatsPCEvent>("__switch_to");
         if (!dumpStatsPCEvent)
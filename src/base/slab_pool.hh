@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BASE_SLAB_POOL_HH__
+#define __BASE_SLAB_POOL_HH__
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "base/types.hh"
+
+/**
+ * A pool of fixed-size memory chunks carved out of large slabs, used
+ * for objects that are allocated and freed at a very high rate, such
+ * as packets, requests and their data. Each thread has its own free
+ * list, and the fast path is thus a few loads and stores without any
+ * locking. A chunk freed by another thread than the one that
+ * allocated it is pushed onto a lock-free list of remotely freed
+ * chunks of its owner, which the owner takes over once its own free
+ * list runs dry. Chunks thus always return to the thread that carved
+ * them out, and as the slabs are never given back to the heap, the
+ * footprint of each thread is bounded by the peak number of objects
+ * it had live at any one time, rather than growing on every thread
+ * that frees more than it allocates.
+ *
+ * The pool is keyed on a type rather than just a size to keep the
+ * allocation counts separate for different kinds of objects that
+ * happen to have the same size.
+ *
+ * @tparam T The type the pool is used for
+ * @tparam Size The size of each chunk in bytes
+ * @tparam SlabChunks The number of chunks allocated at once
+ */
+template <class T, size_t Size = sizeof(T), size_t SlabChunks = 512>
+class SlabPool
+{
+  private:
+
+    struct ThreadState;
+
+    /**
+     * A chunk is either in use or linked into a free list, and
+     * always belongs to the thread whose slab it is part of.
+     */
+    struct Chunk
+    {
+        ThreadState *owner;
+        union
+        {
+            Chunk *next;
+            uint64_t align;
+            char storage[Size];
+        } body;
+    };
+
+    /** The per-thread state of the pool. */
+    struct ThreadState
+    {
+        ThreadState() : freeList(NULL), remoteFree(NULL), allocated(0) {}
+
+        /** Only used by the owning thread. */
+        Chunk *freeList;
+
+        /** Chunks of this thread freed by other threads. */
+        std::atomic<Chunk*> remoteFree;
+
+        /** Only updated by the owning thread. */
+        Counter allocated;
+    };
+
+    /** The state of the calling thread, created on first use. */
+    static __thread ThreadState *local;
+
+    /**
+     * All thread states, used to sum up the allocation counts. These
+     * are never deleted as the free lists might still be populated.
+     */
+    static std::vector<ThreadState*> &
+    threads()
+    {
+        static std::vector<ThreadState*> _threads;
+        return _threads;
+    }
+
+    static std::mutex &
+    threadsLock()
+    {
+        static std::mutex _lock;
+        return _lock;
+    }
+
+    static ThreadState *
+    threadState()
+    {
+        if (!local) {
+            local = new ThreadState;
+            std::lock_guard<std::mutex> lock(threadsLock());
+            threads().push_back(local);
+        }
+        return local;
+    }
+
+    /**
+     * Refill the free list of the calling thread, preferably with
+     * the chunks other threads have freed, and otherwise with a new
+     * slab.
+     */
+    static void
+    refill(ThreadState *ts)
+    {
+        // the whole list is taken at once, so there is no ABA issue
+        // with the concurrent pushes in release()
+        ts->freeList = ts->remoteFree.exchange(NULL,
+                                               std::memory_order_acquire);
+        if (ts->freeList)
+            return;
+
+        Chunk *slab = new Chunk[SlabChunks];
+        for (size_t i = 0; i < SlabChunks; ++i) {
+            slab[i].owner = ts;
+            slab[i].body.next = i < SlabChunks - 1 ? &slab[i + 1] : NULL;
+        }
+        ts->freeList = slab;
+    }
+
+  public:
+
+    static void *
+    allocate()
+    {
+        ThreadState *ts = local ? local : threadState();
+        if (!ts->freeList)
+            refill(ts);
+
+        Chunk *chunk = ts->freeList;
+        ts->freeList = chunk->body.next;
+        ++ts->allocated;
+        return &chunk->body;
+    }
+
+    static void
+    release(void *p)
+    {
+        if (!p)
+            return;
+
+        Chunk *chunk = reinterpret_cast<Chunk*>(static_cast<char*>(p) -
+                                                offsetof(Chunk, body));
+        ThreadState *ts = chunk->owner;
+        if (ts == local) {
+            chunk->body.next = ts->freeList;
+            ts->freeList = chunk;
+        } else {
+            Chunk *head = ts->remoteFree.load(std::memory_order_relaxed);
+            do {
+                chunk->body.next = head;
+            } while (!ts->remoteFree.compare_exchange_weak(
+                         head, chunk, std::memory_order_release,
+                         std::memory_order_relaxed));
+        }
+    }
+
+    /**
+     * Get the number of chunks handed out by the pool across all
+     * threads. The per-thread counts are read without
+     * synchronisation, and the result is only exact when the other
+     * threads are not running, e.g. when the stats are dumped.
+     */
+    static Counter
+    allocated()
+    {
+        std::lock_guard<std::mutex> lock(threadsLock());
+        Counter total = 0;
+        for (auto ts : threads())
+            total += ts->allocated;
+        return total;
+    }
+};
+
+template <class T, size_t Size, size_t SlabChunks>
+__thread typename SlabPool<T, Size, SlabChunks>::ThreadState *
+SlabPool<T, Size, SlabChunks>::local = NULL;
+
+#endif //__BASE_SLAB_POOL_HH__
@@ -113,6 +113,14 @@ StorageParams::~StorageParams()
 {
 }
 
+const double QuantileStor::quantiles[QuantileStor::NumQuantiles] = {
+    0.5, 0.9, 0.99, 0.999
+};
+
+const char *QuantileStor::quantileNames[QuantileStor::NumQuantiles] = {
+    "p50", "p90", "p99", "p99_9"
+};
+
 NameMapType &
 nameMap()
 {
@@ -2869,6 +2869,300 @@ class SparseHistogram : public SparseHistBase<SparseHistogram, SparseHistStor>
     }
 };
 
+/**
+ * Storage for a streaming quantile estimator. Samples are counted in
+ * a log-linear histogram: values below 2^precision get a bucket each,
+ * and every following power of two is split into 2^precision equally
+ * sized buckets. The relative error of a quantile is thus bounded by
+ * 2^-precision, independent of the range of the samples, and the
+ * buckets are only allocated up to the largest value seen.
+ */
+class QuantileStor
+{
+  public:
+    /** The parameters for a quantile stat. */
+    struct Params : public StorageParams
+    {
+        /** The number of bits of resolution within a power of two. */
+        unsigned int precision;
+
+        Params() : precision(0) {}
+    };
+
+    /** The number of quantiles reported. */
+    static const size_type NumQuantiles = 4;
+    /** The quantiles reported, as fractions. */
+    static const double quantiles[NumQuantiles];
+    /** The subnames used for the quantiles. */
+    static const char *quantileNames[NumQuantiles];
+
+  private:
+    /** The number of bits of resolution within a power of two. */
+    unsigned int precision;
+    /** The largest value sampled. */
+    Counter max_val;
+    /** The number of samples. */
+    Counter samples;
+    /** Counter for each bucket, grown on demand. */
+    VCounter cvec;
+
+    /**
+     * Get the bucket a value belongs to.
+     * @param val The value, already clamped to be non-negative.
+     * @return The bucket index.
+     */
+    size_type
+    bucket(uint64_t val) const
+    {
+        if (val < (ULL(1) << precision))
+            return val;
+
+        int shift = floorLog2(val) - precision;
+        return (shift << precision) + (val >> shift);
+    }
+
+  public:
+    QuantileStor(Info *info)
+        : precision(safe_cast<const Params *>(info->storageParams)->precision)
+    {
+        reset(info);
+    }
+
+    /**
+     * Add a value to the estimator for the given number of times.
+     * Negative values are counted as zero.
+     * @param val The value to add.
+     * @param number The number of times to add the value.
+     */
+    void
+    sample(Counter val, int number)
+    {
+        size_type index = bucket(val > 0 ? (uint64_t)val : 0);
+        if (index >= cvec.size())
+            cvec.resize(index + 1);
+        cvec[index] += number;
+
+        if (val > max_val)
+            max_val = val;
+
+        samples += number;
+    }
+
+    /**
+     * Estimate a quantile by interpolating within the bucket holding
+     * the sample of the requested rank.
+     * @param q The quantile, between 0 and 1.
+     * @return The estimated value, or 0 if nothing was sampled.
+     */
+    Counter
+    quantile(double q) const
+    {
+        if (samples == Counter())
+            return 0;
+
+        Counter rank = std::max(q * samples, Counter(1));
+        Counter count = 0;
+        for (off_type i = 0; i < cvec.size(); ++i) {
+            if (count + cvec[i] < rank) {
+                count += cvec[i];
+                continue;
+            }
+
+            uint64_t low = i;
+            uint64_t width = 1;
+            if (i >= (ULL(1) << precision) << 1) {
+                int shift = (i >> precision) - 1;
+                low = (i - (shift << precision)) << shift;
+                width = ULL(1) << shift;
+            }
+            Counter val = low + (width - 1) * (rank - count) / cvec[i];
+            return std::min(val, max_val);
+        }
+
+        return max_val;
+    }
+
+    /**
+     * Return the number of samples.
+     * @return the number of samples.
+     */
+    Counter numSamples() const { return samples; }
+
+    /**
+     * Returns true if any calls to sample have been made.
+     * @return True if any values have been sampled.
+     */
+    bool
+    zero() const
+    {
+        return samples == Counter();
+    }
+
+    /**
+     * Reset stat value to default
+     */
+    void
+    reset(Info *info)
+    {
+        cvec.clear();
+        max_val = 0;
+        samples = Counter();
+    }
+};
+
+/**
+ * Implementation of a quantile stat. The estimates are presented as a
+ * vector with one entry per quantile, so that they show up in all the
+ * outputs without any further support. The storage class is
+ * determined by the Storage template.
+ */
+template <class Derived, class Stor>
+class QuantileBase : public DataWrapVec<Derived, VectorInfoProxy>
+{
+  public:
+    typedef VectorInfoProxy<Derived> Info;
+    typedef Stor Storage;
+    typedef typename Stor::Params Params;
+
+  protected:
+    /** The storage for this stat. */
+    char storage[sizeof(Storage)] __attribute__ ((aligned (8)));
+    /** Has the storage been constructed. */
+    bool initialized;
+
+  protected:
+    /**
+     * Retrieve the storage.
+     * @return The storage object for this stat.
+     */
+    Storage *
+    data()
+    {
+        return reinterpret_cast<Storage *>(storage);
+    }
+
+    /**
+     * Retrieve a const pointer to the storage.
+     * @return A const pointer to the storage object for this stat.
+     */
+    const Storage *
+    data() const
+    {
+        return reinterpret_cast<const Storage *>(storage);
+    }
+
+    void
+    doInit()
+    {
+        new (storage) Storage(this->info());
+        initialized = true;
+
+        for (off_type i = 0; i < size(); ++i)
+            this->subname(i, Storage::quantileNames[i]);
+
+        this->setInit();
+    }
+
+  public:
+    QuantileBase() : initialized(false) { }
+
+    ~QuantileBase()
+    {
+        if (initialized)
+            data()->~Storage();
+    }
+
+    /**
+     * Add a value to the estimator n times. Calls sample on the storage
+     * class.
+     * @param v The value to add.
+     * @param n The number of times to add it, defaults to 1.
+     */
+    template <typename U>
+    void sample(const U &v, int n = 1) { data()->sample(v, n); }
+
+    /**
+     * Estimate an arbitrary quantile of the samples.
+     * @param q The quantile, between 0 and 1.
+     * @return The estimated value.
+     */
+    Counter quantile(double q) const { return data()->quantile(q); }
+
+    /**
+     * Return the number of quantiles reported.
+     * @return The number of entries.
+     */
+    size_type size() const { return Storage::NumQuantiles; }
+
+    void
+    value(VCounter &vec) const
+    {
+        vec.resize(size());
+        for (off_type i = 0; i < size(); ++i)
+            vec[i] = data()->quantile(Storage::quantiles[i]);
+    }
+
+    void
+    result(VResult &vec) const
+    {
+        vec.resize(size());
+        for (off_type i = 0; i < size(); ++i)
+            vec[i] = data()->quantile(Storage::quantiles[i]);
+    }
+
+    /**
+     * The sum of the quantiles is meaningless, so report the number
+     * of samples instead.
+     * @return The number of samples.
+     */
+    Result total() const { return data()->numSamples(); }
+
+    /**
+     * Return true if no samples have been added.
+     * @return True if there haven't been any samples.
+     */
+    bool zero() const { return data()->zero(); }
+
+    bool check() const { return initialized; }
+
+    void prepare() { }
+
+    /**
+     * Reset stat value to default
+     */
+    void
+    reset()
+    {
+        data()->reset(this->info());
+    }
+};
+
+/**
+ * Tracks the 50th, 90th, 99th and 99.9th percentile of the samples,
+ * e.g. to capture tail latencies without having to size a histogram
+ * up front. @sa QuantileStor
+ */
+class Quantiles : public QuantileBase<Quantiles, QuantileStor>
+{
+  public:
+    /**
+     * Set the parameters of this estimator. @sa QuantileStor::Params
+     * @param precision The bits of resolution within a power of two,
+     * bounding the relative error to 2^-precision
+     * @return A reference to this stat.
+     */
+    Quantiles &
+    init(unsigned int precision = 5)
+    {
+        assert(precision > 0 && precision < 16 && "invalid precision");
+        QuantileStor::Params *params = new QuantileStor::Params;
+        params->precision = precision;
+        this->setParams(params);
+        this->doInit();
+        return this->self();
+    }
+};
+
 class Temp;
 /**
  * A formula for statistics that is calculated when printed. A formula is
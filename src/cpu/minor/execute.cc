@@ -474,6 +474,13 @@ namespace Minor
 							static_cast<unsigned int>(packet->getConstPtr<uint8_t>()[0]));
 				}
 
+				/* The loaded data is available to dependent instructions
+				 *  from here on */
+				if (is_load && !is_prefetch) {
+					cpu.stats.loadToUseLatency.sample(cpu.curCycle() -
+							response->issueCycle);
+				}
+
 				/* Complete the memory access instruction */
 				fault = inst->staticInst->completeAcc(packet, &context,
 						inst->traceData);
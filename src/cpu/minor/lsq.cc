@@ -92,6 +92,7 @@ LSQ::LSQRequest::LSQRequest(LSQ &port_, MinorDynInstPtr inst_, bool isLoad_,
     res(res_),
     skipped(false),
     issuedToMemory(false),
+    issueCycle(port_.cpu.curCycle()),
     state(NotIssued)
 { }
 
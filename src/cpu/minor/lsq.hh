@@ -156,6 +156,10 @@ class LSQ : public Named
          *  that's visited the memory system */
         bool issuedToMemory;
 
+        /** Cycle at which the request was pushed into the LSQ, used to
+         *  measure the load-to-use latency */
+        const Cycles issueCycle;
+
         enum LSQRequestState
         {
             NotIssued, /* Newly created */
@@ -86,6 +86,12 @@ numUnnecessaryInst
         .precision(6);
     ipc = numInsts / baseCpu.numCycles;
 
+    loadToUseLatency
+        .init()
+        .name(name + ".loadToUseLatency")
+        .desc("Percentiles of the load-to-use latency in cycles")
+        .flags(Stats::nozero);
+
     tickCyclesMain
         .name(name + ".tickCyclesMain")
         .desc("Number of cycles which we spend in Main functions");
@@ -78,6 +78,10 @@ class MinorStats
     /** CPI/IPC for total cycle counts and macro insts */
     Stats::Formula cpi;
     Stats::Formula ipc;
+
+    /** Percentiles of the cycles from a load entering the LSQ until
+     *  its data is available to dependent instructions */
+    Stats::Quantiles loadToUseLatency;
 /////fault injection
 Stats::Scalar Inst0InIQ;
 Stats::Scalar Inst1InIQ;
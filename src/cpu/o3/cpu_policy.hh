@@ -32,9 +32,12 @@
 #ifndef __CPU_O3_CPU_POLICY_HH__
 #define __CPU_O3_CPU_POLICY_HH__
 
+#include "config/o3_dep_matrix.hh"
 #include "cpu/o3/comm.hh"
 #include "cpu/o3/commit.hh"
 #include "cpu/o3/decode.hh"
+#include "cpu/o3/dep_graph.hh"
+#include "cpu/o3/dep_matrix.hh"
 #include "cpu/o3/fetch.hh"
 #include "cpu/o3/free_list.hh"
 #include "cpu/o3/iew.hh"
@@ -68,6 +71,13 @@ struct SimpleCPUPolicy
     typedef ::ROB<Impl> ROB;
     /** Typedef for the instruction queue/scheduler. */
     typedef InstructionQueue<Impl> IQ;
+#if O3_DEP_MATRIX
+    /** Typedef for the IQ's tracking of register consumers. */
+    typedef DependencyMatrix<typename Impl::DynInstPtr> DepTracker;
+#else
+    /** Typedef for the IQ's tracking of register consumers. */
+    typedef DependencyGraph<typename Impl::DynInstPtr> DepTracker;
+#endif
     /** Typedef for the memory dependence unit. */
     typedef ::MemDepUnit<StoreSet, Impl> MemDepUnit;
     /** Typedef for the LSQ. */
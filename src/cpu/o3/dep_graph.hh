@@ -75,9 +75,12 @@ class DependencyGraph
   public:
     typedef DependencyEntry<DynInstPtr> DepEntry;
 
-    /** Default construction.  Must call resize() prior to use. */
-    DependencyGraph()
-        : numEntries(0), memAllocCounter(0), nodesTraversed(0), nodesRemoved(0)
+    /** Construct a graph for an IQ of num_slots entries.  The linked
+     *  lists grow as needed, so the IQ size is only taken to match
+     *  DependencyMatrix.  Must call resize() prior to use. */
+    DependencyGraph(int num_slots)
+        : dependGraph(NULL), numEntries(0), memAllocCounter(0),
+          nodesTraversed(0), nodesRemoved(0)
     { }
 
     ~DependencyGraph();
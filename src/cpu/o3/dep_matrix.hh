@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CPU_O3_DEP_MATRIX_HH__
+#define __CPU_O3_DEP_MATRIX_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "arch/registers.hh"
+#include "base/bitfield.hh"
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "cpu/o3/comm.hh"
+#include "cpu/inst_seq.hh"
+
+/**
+ * Bitmap based dependency tracker for the IQ.  Every waiting
+ * instruction is given one of a fixed number of consumer slots (at
+ * most one per IQ entry), and each physical register keeps a bitmap
+ * with one bit per slot that is set while the slot's instruction is
+ * waiting on that register.  Waking up the consumers of a register is
+ * then a scan over a few words rather than a walk over a heap
+ * allocated linked list, and inserting or removing a consumer never
+ * allocates.  The IQ inserts all the source registers of an
+ * instruction back to back, and instructions in program order, so the
+ * slot of the instruction inserted last is all that needs remembering
+ * (which is asserted), and a consumer being removed is found among the
+ * set bits of its register.
+ *
+ * An instruction may name the same source register more than once;
+ * each slot therefore also counts the register occurrences it is
+ * waiting on, and keeps the rare repeats on the side, so that pop()
+ * returns the instruction once per occurrence, exactly like the
+ * linked list implementation.
+ *
+ * The interface is the same as DependencyGraph, and the IQ uses one
+ * or the other as chosen at build time by the CPU policy.
+ */
+template <class DynInstPtr>
+class DependencyMatrix
+{
+  public:
+    /** Construct a tracker with num_slots consumer slots.  Must call
+     *  resize() prior to use. */
+    DependencyMatrix(int num_slots);
+
+    void resize(int num_entries);
+
+    void reset();
+
+    void insert(PhysRegIndex idx, DynInstPtr &new_inst);
+
+    void setInst(PhysRegIndex idx, DynInstPtr &new_inst)
+    { producers[idx] = new_inst; }
+
+    void clearInst(PhysRegIndex idx)
+    { producers[idx] = NULL; }
+
+    void remove(PhysRegIndex idx, DynInstPtr &inst_to_remove);
+
+    /** Removes and returns a dependent of a specific register.  The
+     *  consumer in the lowest numbered slot is returned first. */
+    DynInstPtr pop(PhysRegIndex idx);
+
+    bool empty() const { return freeSlots.size() == numSlots; }
+
+    bool empty(PhysRegIndex idx) const { return !numConsumers[idx]; }
+
+    void dump();
+
+    // Debug variable, remove when done testing.
+    uint64_t nodesTraversed;
+    // Debug variable, remove when done testing.
+    uint64_t nodesRemoved;
+
+  private:
+    /** Returns the first word of the bitmap of register idx. */
+    uint64_t *row(PhysRegIndex idx)
+    { return &consumerBits[idx * wordsPerRow]; }
+
+    /** Drops one occurrence of idx from the given slot, clearing the
+     *  slot's bit (and freeing the slot) when appropriate. */
+    void release(PhysRegIndex idx, int slot);
+
+    /** Returns the slot of an instruction waiting on register idx. */
+    int findSlot(PhysRegIndex idx, const DynInstPtr &inst);
+
+    /** Number of consumer slots. */
+    const unsigned numSlots;
+
+    /** Number of 64-bit words in each register's bitmap. */
+    const unsigned wordsPerRow;
+
+    /** Number of registers tracked. */
+    int numEntries;
+
+    /** Per-register consumer bitmaps, wordsPerRow words per register. */
+    std::vector<uint64_t> consumerBits;
+
+    /** Number of outstanding consumers (with repeats) per register. */
+    std::vector<unsigned> numConsumers;
+
+    /** Producing instruction of each register. */
+    std::vector<DynInstPtr> producers;
+
+    /** Instruction held in each consumer slot. */
+    std::vector<DynInstPtr> slotInsts;
+
+    /** Number of register occurrences each slot is waiting on. */
+    std::vector<unsigned> slotPending;
+
+    /** Registers each slot waits on more than once, one entry per
+     *  occurrence beyond the first. */
+    std::vector<std::vector<PhysRegIndex> > slotRepeats;
+
+    /** Stack of currently unused slots. */
+    std::vector<int> freeSlots;
+
+    /** Slot of the instruction inserted last, or -1. */
+    int lastSlot;
+
+    /** Sequence number of the instruction given a slot last, per
+     *  thread, to check the order of insertion. */
+    std::vector<InstSeqNum> lastSeqNum;
+};
+
+template <class DynInstPtr>
+DependencyMatrix<DynInstPtr>::DependencyMatrix(int num_slots)
+    : nodesTraversed(0), nodesRemoved(0),
+      numSlots(num_slots), wordsPerRow((num_slots + 63) / 64),
+      numEntries(0), slotInsts(num_slots), slotPending(num_slots),
+      slotRepeats(num_slots),
+      lastSlot(-1)
+{
+    freeSlots.reserve(numSlots);
+    for (int slot = numSlots - 1; slot >= 0; --slot) {
+        slotRepeats[slot].reserve(TheISA::MaxInstSrcRegs);
+        freeSlots.push_back(slot);
+    }
+}
+
+template <class DynInstPtr>
+void
+DependencyMatrix<DynInstPtr>::resize(int num_entries)
+{
+    numEntries = num_entries;
+    consumerBits.assign(numEntries * wordsPerRow, 0);
+    numConsumers.assign(numEntries, 0);
+    producers.assign(numEntries, DynInstPtr());
+}
+
+template <class DynInstPtr>
+void
+DependencyMatrix<DynInstPtr>::reset()
+{
+    std::fill(consumerBits.begin(), consumerBits.end(), 0);
+    std::fill(numConsumers.begin(), numConsumers.end(), 0);
+    std::fill(producers.begin(), producers.end(), DynInstPtr());
+
+    freeSlots.clear();
+    for (int slot = numSlots - 1; slot >= 0; --slot) {
+        slotInsts[slot] = NULL;
+        slotPending[slot] = 0;
+        slotRepeats[slot].clear();
+        freeSlots.push_back(slot);
+    }
+    lastSlot = -1;
+    lastSeqNum.clear();
+}
+
+template <class DynInstPtr>
+void
+DependencyMatrix<DynInstPtr>::insert(PhysRegIndex idx, DynInstPtr &new_inst)
+{
+    int slot = lastSlot;
+
+    // The slot may have been freed and reused since, so check that it
+    // still holds the same instruction.
+    if (slot < 0 || slotInsts[slot] != new_inst) {
+        // Each thread inserts its instructions in program order, so a
+        // new slot is only ever taken for an instruction younger than
+        // the ones of its thread before it. An instruction coming back
+        // after another one was inserted would end up with two slots.
+        ThreadID tid = new_inst->threadNumber;
+        if (tid >= (ThreadID)lastSeqNum.size())
+            lastSeqNum.resize(tid + 1, 0);
+        assert(new_inst->seqNum > lastSeqNum[tid]);
+        lastSeqNum[tid] = new_inst->seqNum;
+
+        if (freeSlots.empty())
+            panic("Dependency matrix out of consumer slots (%i)!\n",
+                  numSlots);
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        slotInsts[slot] = new_inst;
+        lastSlot = slot;
+    }
+
+    uint64_t &word = row(idx)[slot / 64];
+    const uint64_t bit = ULL(1) << (slot % 64);
+    if (word & bit)
+        slotRepeats[slot].push_back(idx);
+    else
+        word |= bit;
+    ++slotPending[slot];
+    ++numConsumers[idx];
+}
+
+template <class DynInstPtr>
+void
+DependencyMatrix<DynInstPtr>::release(PhysRegIndex idx, int slot)
+{
+    --numConsumers[idx];
+
+    // Only clear the bit once the last occurrence of this register
+    // has been consumed.
+    std::vector<PhysRegIndex> &repeats = slotRepeats[slot];
+    typename std::vector<PhysRegIndex>::iterator it =
+        std::find(repeats.begin(), repeats.end(), idx);
+    if (it != repeats.end())
+        repeats.erase(it);
+    else
+        row(idx)[slot / 64] &= ~(ULL(1) << (slot % 64));
+
+    if (!--slotPending[slot]) {
+        slotInsts[slot] = NULL;
+        freeSlots.push_back(slot);
+    }
+}
+
+template <class DynInstPtr>
+void
+DependencyMatrix<DynInstPtr>::remove(PhysRegIndex idx,
+                                     DynInstPtr &inst_to_remove)
+{
+    if (!numConsumers[idx])
+        return;
+
+    nodesRemoved++;
+    release(idx, findSlot(idx, inst_to_remove));
+}
+
+template <class DynInstPtr>
+int
+DependencyMatrix<DynInstPtr>::findSlot(PhysRegIndex idx,
+                                       const DynInstPtr &inst)
+{
+    uint64_t *bits = row(idx);
+    for (unsigned word = 0; word < wordsPerRow; ++word) {
+        uint64_t w = bits[word];
+        while (w) {
+            int slot = word * 64 + findLsbSet(w);
+            if (slotInsts[slot] == inst)
+                return slot;
+            w &= w - 1;
+        }
+    }
+
+    panic("Instruction [sn:%lli] is not waiting on reg %i!\n",
+          inst->seqNum, idx);
+}
+
+template <class DynInstPtr>
+DynInstPtr
+DependencyMatrix<DynInstPtr>::pop(PhysRegIndex idx)
+{
+    if (!numConsumers[idx])
+        return NULL;
+
+    uint64_t *bits = row(idx);
+    for (unsigned word = 0; word < wordsPerRow; ++word) {
+        if (!bits[word]) {
+            nodesTraversed++;
+            continue;
+        }
+
+        int slot = word * 64 + findLsbSet(bits[word]);
+        DynInstPtr inst = slotInsts[slot];
+        release(idx, slot);
+        return inst;
+    }
+
+    panic("Dependency matrix consumer count out of sync for reg %i!\n", idx);
+}
+
+template <class DynInstPtr>
+void
+DependencyMatrix<DynInstPtr>::dump()
+{
+    for (int i = 0; i < numEntries; ++i) {
+        if (producers[i]) {
+            cprintf("dependMatrix[%i]: producer: %s [sn:%lli] consumer: ",
+                    i, producers[i]->pcState(), producers[i]->seqNum);
+        } else {
+            cprintf("dependMatrix[%i]: No producer. consumer: ", i);
+        }
+
+        uint64_t *bits = row(i);
+        for (unsigned slot = 0; slot < numSlots; ++slot) {
+            if (bits[slot / 64] & (ULL(1) << (slot % 64))) {
+                cprintf("%s [sn:%lli] ", slotInsts[slot]->pcState(),
+                        slotInsts[slot]->seqNum);
+            }
+        }
+
+        cprintf("\n");
+    }
+    cprintf("free slots: %i of %i\n", freeSlots.size(), numSlots);
+}
+
+#endif // __CPU_O3_DEP_MATRIX_HH__
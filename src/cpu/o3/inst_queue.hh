@@ -88,6 +88,7 @@ class InstructionQueue
 
     typedef typename Impl::CPUPol::IEW IEW;
     typedef typename Impl::CPUPol::MemDepUnit MemDepUnit;
+    typedef typename Impl::CPUPol::DepTracker DepTracker;
     typedef typename Impl::CPUPol::IssueStruct IssueStruct;
     typedef typename Impl::CPUPol::TimeStruct TimeStruct;
 
@@ -397,7 +398,10 @@ class InstructionQueue
      */
     void moveToYoungerInst(ListOrderIt age_order_it);
 
-    DependencyGraph<DynInstPtr> dependGraph;
+    /** Tracks the consumers of each physical register; either a
+     *  DependencyGraph or a DependencyMatrix as chosen by the CPU
+     *  policy. */
+    DepTracker dependGraph;
 
     //////////////////////////////////////
     // Various parameters
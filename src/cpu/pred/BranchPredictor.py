@@ -36,7 +36,8 @@ class BranchPredictor(SimObject):
 
     numThreads = Param.Unsigned(1, "Number of threads")
     predType = Param.String("tournament",
-        "Branch predictor type ('local', 'tournament', 'bi-mode')")
+        "Branch predictor type ('local', 'tournament', 'bi-mode', "
+        "'tage-sc-l', 'hashed-perceptron')")
     localPredictorSize = Param.Unsigned(2048, "Size of local predictor")
     localCtrBits = Param.Unsigned(2, "Bits per counter")
     localHistoryTableSize = Param.Unsigned(2048, "Size of local history table")
@@ -45,6 +46,30 @@ class BranchPredictor(SimObject):
     choicePredictorSize = Param.Unsigned(8192, "Size of choice predictor")
     choiceCtrBits = Param.Unsigned(2, "Bits of choice counters")
 
+    tageLogBimodalSize = Param.Unsigned(13,
+        "Log2 of the number of TAGE bimodal counters")
+    tageNumTables = Param.Unsigned(12, "Number of TAGE tagged tables")
+    tageLogTableSize = Param.Unsigned(10,
+        "Log2 of the number of entries per TAGE tagged table")
+    tageMinHist = Param.Unsigned(4, "Shortest TAGE history length")
+    tageMaxHist = Param.Unsigned(640, "Longest TAGE history length")
+    tageMinTagBits = Param.Unsigned(8, "Tag width of the shortest TAGE table")
+    tageMaxTagBits = Param.Unsigned(15, "Tag width of the longest TAGE table")
+    tageLogUResetPeriod = Param.Unsigned(18,
+        "Log2 of the number of updates between TAGE useful bit decays")
+    loopLogSets = Param.Unsigned(4, "Log2 of the number of loop predictor sets")
+    scLogTableSize = Param.Unsigned(10,
+        "Log2 of the number of weights per statistical corrector table")
+    scHistLengths = VectorParam.Unsigned([6, 11, 21, 40],
+        "History lengths of the statistical corrector tables")
+
+    perceptronLogTableSize = Param.Unsigned(10,
+        "Log2 of the number of weights per perceptron table")
+    perceptronWeightBits = Param.Unsigned(7, "Bits per perceptron weight")
+    perceptronHistLengths = VectorParam.Unsigned(
+        [0, 3, 5, 8, 12, 17, 24, 33, 46, 64, 90, 128, 180, 256],
+        "History lengths of the perceptron tables")
+
     BTBEntries = Param.Unsigned(4096, "Number of BTB entries")
     BTBTagSize = Param.Unsigned(16, "Size of the BTB tags, in bits")
 
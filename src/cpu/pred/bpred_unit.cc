@@ -34,6 +34,7 @@
 #include "cpu/pred/2bit_local.hh"
 #include "cpu/pred/bi_mode.hh"
 #include "cpu/pred/bpred_unit_impl.hh"
+#include "cpu/pred/cond_bp.hh"
 #include "cpu/pred/tournament.hh"
 
 BPredUnit *
@@ -46,6 +47,8 @@ BranchPredictorParams::create()
         return new TournamentBP(this);
     } else if (predType == "bi-mode") {
         return new BiModeBP(this);
+    } else if (predType == "tage-sc-l" || predType == "hashed-perceptron") {
+        return new CondBP(this);
     } else {
         fatal("Invalid BP selected!");
     }
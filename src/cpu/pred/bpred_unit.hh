@@ -67,6 +67,16 @@ class BPredUnit : public SimObject
 {
   public:
       typedef BranchPredictorParams Params;
+
+    /** A committed branch, as notified to the Commit probe point. */
+    struct CommittedBranch
+    {
+        ThreadID tid;
+        Addr pc;
+        bool taken;
+        bool conditional;
+    };
+
     /**
      * @param params The params object, that has the size of the BP and BTB.
      */
@@ -210,7 +220,7 @@ class BPredUnit : public SimObject
                          ThreadID _tid)
             : seqNum(seq_num), pc(instPC), bpHistory(bp_history), RASTarget(0),
               RASIndex(0), tid(_tid), predTaken(pred_taken), usedRAS(0), pushedRAS(0),
-              wasCall(0), wasReturn(0), wasSquashed(0)
+              wasCall(0), wasReturn(0), wasSquashed(0), wasUncond(0)
         {}
 
         bool operator==(const PredictorHistory &entry) const {
@@ -255,6 +265,9 @@ class BPredUnit : public SimObject
 
         /** Whether this instruction has already mispredicted/updated bp */
         bool wasSquashed;
+
+        /** Whether or not the instruction was an unconditional branch. */
+        bool wasUncond;
     };
 
     typedef std::deque<PredictorHistory> History;
@@ -320,6 +333,9 @@ class BPredUnit : public SimObject
     /** Miss-predicted branches */
     ProbePoints::PMUUPtr ppMisses;
 
+    /** Branches committed, with their actual outcome */
+    std::unique_ptr<ProbePointArg<CommittedBranch> > ppCommit;
+
     /** @} */
 };
 
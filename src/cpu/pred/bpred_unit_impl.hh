@@ -133,6 +133,8 @@ BPredUnit::regProbePoints()
 {
     ppBranches = pmuProbePoint("Branches");
     ppMisses = pmuProbePoint("Misses");
+    ppCommit.reset(new ProbePointArg<CommittedBranch>(getProbeManager(),
+                                                      "Commit"));
 }
 
 void
@@ -179,6 +181,7 @@ BPredUnit::predict(const StaticInstPtr &inst, const InstSeqNum &seqNum,
 
     PredictorHistory predict_record(seqNum, pc.instAddr(),
                                     pred_taken, bp_history, tid);
+    predict_record.wasUncond = inst->isUncondCtrl();
 
     // Now lookup in the BTB or RAS.
     if (pred_taken) {
@@ -303,6 +306,7 @@ BPredUnit::predictInOrder(const StaticInstPtr &inst, const InstSeqNum &seqNum,
 
     PredictorHistory predict_record(seqNum, predPC.instAddr(), pred_taken,
                                     bp_history, tid);
+    predict_record.wasUncond = inst->isUncondCtrl();
 
     // Now lookup in the BTB or RAS.
     if (pred_taken) {
@@ -398,6 +402,12 @@ BPredUnit::update(const InstSeqNum &done_sn, ThreadID tid)
             retireSquashed(predHist[tid].back().bpHistory);
         }
 
+        // By now predTaken has been corrected to the actual outcome
+        CommittedBranch committed = { tid, predHist[tid].back().pc,
+                                      predHist[tid].back().predTaken,
+                                      !predHist[tid].back().wasUncond };
+        ppCommit->notify(committed);
+
         predHist[tid].pop_back();
     }
 }
@@ -490,6 +500,7 @@ BPredUnit::squash(const InstSeqNum &squashed_sn,
         update((*hist_it).pc, actually_taken,
                pred_hist.front().bpHistory, true);
         hist_it->wasSquashed = true;
+        hist_it->predTaken = actually_taken;
 
         if (actually_taken) {
             if (hist_it->wasReturn && !hist_it->usedRAS) {
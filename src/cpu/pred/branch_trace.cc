@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cpu/pred/branch_trace.hh"
+
+#include "base/callback.hh"
+#include "base/output.hh"
+#include "cpu/base.hh"
+#include "proto/bpred.pb.h"
+#include "sim/core.hh"
+
+BranchTrace::BranchTrace(const BranchTraceParams *p)
+    : ProbeListenerObject(p), cpu(p->cpu),
+      traceStream(new ProtoOutputStream(simout.resolve(p->file_name))),
+      instsSinceBranch(0)
+{
+    ProtoMessage::BranchHeader header_msg;
+    header_msg.set_obj_id(name());
+    header_msg.set_ver(0);
+    traceStream->write(header_msg);
+
+    // get a callback when we exit so we can close the file
+    Callback *cb = new MakeCallback<BranchTrace,
+                                    &BranchTrace::closeStreams>(this);
+    registerExitCallback(cb);
+}
+
+BranchTrace::~BranchTrace()
+{
+    closeStreams();
+}
+
+void
+BranchTrace::closeStreams()
+{
+    if (!traceStream)
+        return;
+
+    delete traceStream;
+    traceStream = NULL;
+}
+
+void
+BranchTrace::regProbeListeners()
+{
+    typedef ProbeListenerArg<BranchTrace, BPredUnit::CommittedBranch>
+        CommitListener;
+    listeners.push_back(new CommitListener(this, "Commit",
+                                           &BranchTrace::traceCommit));
+
+    if (cpu) {
+        listeners.push_back(
+            new RetiredInstsListener(*this, cpu->getProbeManager()));
+    }
+}
+
+void
+BranchTrace::traceCommit(const BPredUnit::CommittedBranch &branch)
+{
+    if (!traceStream)
+        return;
+
+    ProtoMessage::Branch branch_msg;
+    branch_msg.set_pc(branch.pc);
+    branch_msg.set_taken(branch.taken);
+    if (!branch.conditional)
+        branch_msg.set_uncond(true);
+    // the predictor learns about commits a little after the CPU, so
+    // the count may include a few younger instructions; the total
+    // over the trace is exact
+    if (instsSinceBranch)
+        branch_msg.set_insts(instsSinceBranch);
+    instsSinceBranch = 0;
+
+    traceStream->write(branch_msg);
+}
+
+BranchTrace*
+BranchTraceParams::create()
+{
+    return new BranchTrace(this);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Declaration of a probe listener that records committed branches in
+ * a protobuf trace.
+ */
+
+#ifndef __CPU_PRED_BRANCH_TRACE_HH__
+#define __CPU_PRED_BRANCH_TRACE_HH__
+
+#include <string>
+
+#include "cpu/pred/bpred_unit.hh"
+#include "params/BranchTrace.hh"
+#include "proto/protoio.hh"
+#include "sim/probe/probe.hh"
+
+/**
+ * Listens to the Commit probe point of a branch predictor and writes
+ * every committed branch, with the number of instructions committed
+ * by the CPU since the previous one, to a protobuf trace. The trace
+ * lets the standalone replay tool in util/bpred_replay evaluate other
+ * predictor configurations without running the simulation again.
+ */
+class BranchTrace : public ProbeListenerObject
+{
+  public:
+    BranchTrace(const BranchTraceParams *params);
+    ~BranchTrace();
+
+    /** Register the probe listeners. */
+    void regProbeListeners() M5_ATTR_OVERRIDE;
+
+    /** Flush and close the trace file. */
+    void closeStreams();
+
+  private:
+    /**
+     * Listener for the RetiredInsts probe point of the CPU, which
+     * lives in another probe manager than the branch predictor.
+     */
+    class RetiredInstsListener : public ProbeListenerArgBase<uint64_t>
+    {
+      public:
+        RetiredInstsListener(BranchTrace &_parent, ProbeManager *pm)
+            : ProbeListenerArgBase<uint64_t>(pm, "RetiredInsts"),
+              parent(_parent)
+        { }
+
+        void notify(const uint64_t &count) M5_ATTR_OVERRIDE
+        { parent.instsSinceBranch += count; }
+
+      private:
+        BranchTrace &parent;
+    };
+
+    void traceCommit(const BPredUnit::CommittedBranch &branch);
+
+    /** CPU whose committed instructions are counted, may be NULL. */
+    SimObject *cpu;
+
+    /** The trace output. */
+    ProtoOutputStream *traceStream;
+
+    /** Instructions committed since the last traced branch. */
+    uint64_t instsSinceBranch;
+};
+
+#endif // __CPU_PRED_BRANCH_TRACE_HH__
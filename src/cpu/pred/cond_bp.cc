@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* @file
+ * Adaptor between BPredUnit and the standalone direction predictors
+ */
+
+#include "cpu/pred/cond_bp.hh"
+
+#include "cpu/pred/hashed_perceptron.hh"
+#include "cpu/pred/tage_sc_l.hh"
+
+CondBP::CondBP(const Params *params)
+    : BPredUnit(params), pred(NULL)
+{
+    if (params->predType == "tage-sc-l") {
+        TageSCL::Config c;
+        c.instShiftAmt = params->instShiftAmt;
+        c.logBimodalSize = params->tageLogBimodalSize;
+        c.numTables = params->tageNumTables;
+        c.logTableSize = params->tageLogTableSize;
+        c.minHist = params->tageMinHist;
+        c.maxHist = params->tageMaxHist;
+        c.minTagBits = params->tageMinTagBits;
+        c.maxTagBits = params->tageMaxTagBits;
+        c.logUResetPeriod = params->tageLogUResetPeriod;
+        c.logLoopSets = params->loopLogSets;
+        c.logSCTableSize = params->scLogTableSize;
+        c.scHistLengths = params->scHistLengths;
+
+        if (const char *err = c.check())
+            fatal("%s: %s.\n", name(), err);
+
+        pred = new TageSCL(c);
+    } else if (params->predType == "hashed-perceptron") {
+        HashedPerceptron::Config c;
+        c.instShiftAmt = params->instShiftAmt;
+        c.logTableSize = params->perceptronLogTableSize;
+        c.weightBits = params->perceptronWeightBits;
+        c.histLengths = params->perceptronHistLengths;
+
+        if (const char *err = c.check())
+            fatal("%s: %s.\n", name(), err);
+
+        pred = new HashedPerceptron(c);
+    } else {
+        fatal("Invalid conditional predictor %s.\n", params->predType);
+    }
+}
+
+CondBP::~CondBP()
+{
+    delete pred;
+}
+
+void
+CondBP::uncondBranch(void * &bp_history)
+{
+    pred->uncondBranch(bp_history);
+}
+
+void
+CondBP::squash(void *bp_history)
+{
+    pred->squash(bp_history);
+}
+
+bool
+CondBP::lookup(Addr branch_addr, void * &bp_history)
+{
+    return pred->lookup(branch_addr, bp_history);
+}
+
+void
+CondBP::btbUpdate(Addr branch_addr, void * &bp_history)
+{
+    pred->btbUpdate(branch_addr, bp_history);
+}
+
+void
+CondBP::update(Addr branch_addr, bool taken, void *bp_history,
+               bool squashed)
+{
+    pred->update(branch_addr, taken, bp_history, squashed);
+}
+
+void
+CondBP::retireSquashed(void *bp_history)
+{
+    pred->retireSquashed(bp_history);
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* @file
+ * Interface of the direction predictors that are independent of the
+ * rest of the simulator.
+ */
+
+#ifndef __CPU_PRED_COND_PRED_HH__
+#define __CPU_PRED_COND_PRED_HH__
+
+#include "base/types.hh"
+
+/**
+ * A conditional branch direction predictor that only depends on the
+ * base library, so it can be driven either by a BPredUnit inside a
+ * simulated CPU (see CondBP) or by a standalone trace replay tool.
+ * The methods mirror the direction predictor half of BPredUnit and
+ * follow the same protocol for the per-branch history objects.
+ */
+class ConditionalPredictor
+{
+  public:
+    virtual ~ConditionalPredictor() { }
+
+    /**
+     * Records an unconditional branch in the history.
+     * @param bp_history Set to the history object of the branch.
+     */
+    virtual void uncondBranch(void * &bp_history) = 0;
+
+    /**
+     * Predicts the direction of a conditional branch.
+     * @param branch_addr The PC of the branch.
+     * @param bp_history Set to the history object of the branch.
+     * @return Whether the branch is predicted taken.
+     */
+    virtual bool lookup(Addr branch_addr, void * &bp_history) = 0;
+
+    /**
+     * Changes the last prediction to not taken because the BTB had
+     * no target for it.
+     * @param branch_addr The PC of the branch.
+     * @param bp_history The history object returned by lookup().
+     */
+    virtual void btbUpdate(Addr branch_addr, void * &bp_history) = 0;
+
+    /**
+     * Trains the predictor with the outcome of a branch.
+     * @param branch_addr The PC of the branch.
+     * @param taken The actual outcome.
+     * @param bp_history The history object of the branch.
+     * @param squashed True when called on a misprediction, in which
+     * case the speculative history is repaired and the history object
+     * is kept until retireSquashed(); otherwise it is deleted.
+     */
+    virtual void update(Addr branch_addr, bool taken, void *bp_history,
+                        bool squashed) = 0;
+
+    /**
+     * Undoes the speculative history update of a squashed branch and
+     * deletes its history object.
+     */
+    virtual void squash(void *bp_history) = 0;
+
+    /** Deletes the history object of a branch trained at squash time. */
+    virtual void retireSquashed(void *bp_history) = 0;
+};
+
+#endif // __CPU_PRED_COND_PRED_HH__
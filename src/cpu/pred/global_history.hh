@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* @file
+ * Speculative global branch history shared by the history based
+ * direction predictors.
+ */
+
+#ifndef __CPU_PRED_GLOBAL_HISTORY_HH__
+#define __CPU_PRED_GLOBAL_HISTORY_HH__
+
+#include <cassert>
+#include <vector>
+
+#include "base/types.hh"
+
+/**
+ * Global branch history kept as a circular buffer of outcome bits.
+ * New outcomes are pushed at a decreasing pointer, so restoring the
+ * history after a squash only means restoring the pointer, provided
+ * the buffer is larger than the longest history used plus the number
+ * of branches in flight.
+ */
+class GlobalHistory
+{
+  public:
+    /**
+     * @param size Number of history bits kept; a power of two.
+     */
+    GlobalHistory(unsigned size)
+        : bits(size, 0), mask(size - 1), pt(0)
+    {
+        assert(size && !(size & (size - 1)));
+    }
+
+    /** Shift a new outcome into the history. */
+    void push(bool taken)
+    {
+        pt = (pt - 1) & mask;
+        bits[pt] = taken;
+    }
+
+    /** Returns the i-th most recent outcome, 0 being the newest. */
+    bool operator[](unsigned i) const { return bits[(pt + i) & mask]; }
+
+    /** Current position of the newest outcome. */
+    unsigned pointer() const { return pt; }
+
+    /** Roll the history back to a previously saved pointer. */
+    void restore(unsigned _pt) { pt = _pt; }
+
+    /** Number of history bits kept. */
+    unsigned size() const { return bits.size(); }
+
+  private:
+    std::vector<uint8_t> bits;
+    const unsigned mask;
+    unsigned pt;
+};
+
+/**
+ * A global history of a given length folded (XOR-compressed) into a
+ * smaller number of bits, updated incrementally each time an outcome
+ * is pushed into the GlobalHistory it follows.
+ */
+class FoldedHistory
+{
+  public:
+    FoldedHistory()
+        : comp(0), compLength(0), origLength(0), outPoint(0)
+    { }
+
+    /**
+     * @param original_length Number of history bits folded.
+     * @param compressed_length Number of bits folded into.
+     */
+    void init(unsigned original_length, unsigned compressed_length)
+    {
+        comp = 0;
+        origLength = original_length;
+        compLength = compressed_length;
+        outPoint = compLength ? origLength % compLength : 0;
+    }
+
+    /** Account for the outcome just pushed into h. */
+    void update(const GlobalHistory &h)
+    {
+        if (!compLength)
+            return;
+        comp = (comp << 1) | h[0];
+        comp ^= (unsigned)h[origLength] << outPoint;
+        comp ^= comp >> compLength;
+        comp &= (1U << compLength) - 1;
+    }
+
+    /** The folded value. */
+    unsigned comp;
+
+  private:
+    unsigned compLength;
+    unsigned origLength;
+    unsigned outPoint;
+};
+
+#endif // __CPU_PRED_GLOBAL_HISTORY_HH__
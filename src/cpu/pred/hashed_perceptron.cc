@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* @file
+ * Implementation of a hashed perceptron branch predictor
+ */
+
+#include "cpu/pred/hashed_perceptron.hh"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "base/intmath.hh"
+#include "base/misc.hh"
+
+HashedPerceptron::Config::Config()
+    : instShiftAmt(2), logTableSize(10), weightBits(7)
+{
+    static const unsigned lengths[] =
+        { 0, 3, 5, 8, 12, 17, 24, 33, 46, 64, 90, 128, 180, 256 };
+    histLengths.assign(lengths, lengths + sizeof(lengths) / sizeof(*lengths));
+}
+
+const char *
+HashedPerceptron::Config::check() const
+{
+    if (instShiftAmt > MaxInstShiftAmt)
+        return "invalid instruction shift amount";
+    if (histLengths.empty() || histLengths.size() > MaxTables)
+        return "the perceptron needs between 1 and 32 tables";
+    for (auto l : histLengths) {
+        if (l > MaxHist)
+            return "invalid perceptron history lengths";
+    }
+    if (weightBits < 2 || weightBits > 8)
+        return "invalid perceptron weight width";
+    if (logTableSize == 0 || logTableSize > 24)
+        return "invalid perceptron table size";
+    return NULL;
+}
+
+HashedPerceptron::HashedPerceptron(const Config &c)
+    : instShiftAmt(c.instShiftAmt), logTableSize(c.logTableSize),
+      maxWeight((1 << (c.weightBits - 1)) - 1),
+      minWeight(-(1 << (c.weightBits - 1))),
+      numTables(c.histLengths.size()),
+      weights(c.histLengths.size() << c.logTableSize, 0),
+      ghist(ceilPow2(*std::max_element(c.histLengths.begin(),
+                                       c.histLengths.end()) + 2048)),
+      comp(c.histLengths.size()),
+      // initial threshold from Jimenez and Lin, scaled to the tables
+      theta((int)(1.93 * c.histLengths.size() + 14)), thetaCtr(0)
+{
+    if (const char *err = c.check())
+        fatal("Invalid hashed perceptron configuration: %s.\n", err);
+
+    for (unsigned i = 0; i < numTables; ++i)
+        comp[i].init(c.histLengths[i], logTableSize);
+}
+
+void
+HashedPerceptron::saveHistory(BranchInfo *bi) const
+{
+    bi->ghistPtr = ghist.pointer();
+    for (unsigned i = 0; i < numTables; ++i)
+        bi->comp[i] = comp[i].comp;
+}
+
+void
+HashedPerceptron::restoreHistory(BranchInfo *bi)
+{
+    ghist.restore(bi->ghistPtr);
+    for (unsigned i = 0; i < numTables; ++i)
+        comp[i].comp = bi->comp[i];
+}
+
+void
+HashedPerceptron::speculativeUpdate(bool taken)
+{
+    ghist.push(taken);
+    for (unsigned i = 0; i < numTables; ++i)
+        comp[i].update(ghist);
+}
+
+void
+HashedPerceptron::uncondBranch(void * &bp_history)
+{
+    BranchInfo *bi = new BranchInfo;
+    bi->conditional = false;
+    bi->pred = true;
+    saveHistory(bi);
+    speculativeUpdate(true);
+    bp_history = static_cast<void *>(bi);
+}
+
+bool
+HashedPerceptron::lookup(Addr branch_addr, void * &bp_history)
+{
+    unsigned pc = branch_addr >> instShiftAmt;
+    const unsigned tbl_mask = (1 << logTableSize) - 1;
+
+    BranchInfo *bi = new BranchInfo;
+    bi->conditional = true;
+    saveHistory(bi);
+
+    int sum = 0;
+    for (unsigned i = 0; i < numTables; ++i) {
+        // spread the PC differently in every table to limit aliasing
+        unsigned idx = (pc ^ (pc >> (i + 1)) ^ (comp[i].comp << 1) ^
+                        (comp[i].comp >> 3)) & tbl_mask;
+        bi->index[i] = (i << logTableSize) | idx;
+        sum += weights[bi->index[i]];
+    }
+
+    bi->sum = sum;
+    bi->pred = sum >= 0;
+    speculativeUpdate(bi->pred);
+
+    bp_history = static_cast<void *>(bi);
+    return bi->pred;
+}
+
+void
+HashedPerceptron::btbUpdate(Addr branch_addr, void * &bp_history)
+{
+    BranchInfo *bi = static_cast<BranchInfo *>(bp_history);
+    restoreHistory(bi);
+    speculativeUpdate(false);
+}
+
+void
+HashedPerceptron::update(Addr branch_addr, bool taken, void *bp_history,
+                         bool squashed)
+{
+    BranchInfo *bi = static_cast<BranchInfo *>(bp_history);
+    if (!bi)
+        return;
+
+    if (bi->conditional) {
+        bool mispred = bi->pred != taken;
+
+        if (mispred || std::abs(bi->sum) <= theta) {
+            for (unsigned i = 0; i < numTables; ++i) {
+                int8_t &w = weights[bi->index[i]];
+                if (taken && w < maxWeight)
+                    ++w;
+                else if (!taken && w > minWeight)
+                    --w;
+            }
+        }
+
+        // keep the number of mispredictions and of low-confidence
+        // updates balanced
+        if (mispred) {
+            if (++thetaCtr >= 63) {
+                ++theta;
+                thetaCtr = 0;
+            }
+        } else if (std::abs(bi->sum) <= theta) {
+            if (--thetaCtr <= -64) {
+                if (theta > 0)
+                    --theta;
+                thetaCtr = 0;
+            }
+        }
+    }
+
+    if (squashed) {
+        restoreHistory(bi);
+        speculativeUpdate(taken);
+    } else {
+        delete bi;
+    }
+}
+
+void
+HashedPerceptron::squash(void *bp_history)
+{
+    BranchInfo *bi = static_cast<BranchInfo *>(bp_history);
+    restoreHistory(bi);
+    delete bi;
+}
+
+void
+HashedPerceptron::retireSquashed(void *bp_history)
+{
+    delete static_cast<BranchInfo *>(bp_history);
+}
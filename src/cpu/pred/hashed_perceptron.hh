@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* @file
+ * Implementation of a hashed perceptron branch predictor
+ */
+
+#ifndef __CPU_PRED_HASHED_PERCEPTRON_HH__
+#define __CPU_PRED_HASHED_PERCEPTRON_HH__
+
+#include <vector>
+
+#include "base/types.hh"
+#include "cpu/pred/cond_pred.hh"
+#include "cpu/pred/global_history.hh"
+
+/**
+ * Hashed perceptron conditional branch predictor, after Tarjan and
+ * Skadron ("Merging path and gshare indexing in perceptron branch
+ * prediction") with the adaptive training threshold of Seznec's
+ * O-GEHL. Every table is indexed by a hash of the PC and a global
+ * history of a different length; the prediction is the sign of the
+ * sum of the selected weights. Table 0 is indexed by the PC only.
+ */
+class HashedPerceptron : public ConditionalPredictor
+{
+  public:
+    /** Geometry of the predictor. */
+    struct Config
+    {
+        Config();
+
+        /** Returns why the geometry is invalid, or NULL if it is valid. */
+        const char *check() const;
+
+        /** Number of bits to shift the PC by. */
+        unsigned instShiftAmt;
+        /** Log2 of the number of weights per table. */
+        unsigned logTableSize;
+        /** Width of the weights, at most 8 bits. */
+        unsigned weightBits;
+        /** History length of each table, the first one being 0. */
+        std::vector<unsigned> histLengths;
+    };
+
+    /** Upper bound on the number of tables. */
+    static const unsigned MaxTables = 32;
+    static const unsigned MaxHist = 65536;
+    static const unsigned MaxInstShiftAmt = 16;
+
+    HashedPerceptron(const Config &config);
+
+    void uncondBranch(void * &bp_history);
+    bool lookup(Addr branch_addr, void * &bp_history);
+    void btbUpdate(Addr branch_addr, void * &bp_history);
+    void update(Addr branch_addr, bool taken, void *bp_history,
+                bool squashed);
+    void squash(void *bp_history);
+    void retireSquashed(void *bp_history);
+
+  private:
+    /** State kept for every branch between prediction and update. */
+    struct BranchInfo
+    {
+        bool conditional;
+        unsigned ghistPtr;
+        unsigned comp[MaxTables];
+        unsigned index[MaxTables];
+        int sum;
+        bool pred;
+    };
+
+    void saveHistory(BranchInfo *bi) const;
+    void restoreHistory(BranchInfo *bi);
+    void speculativeUpdate(bool taken);
+
+    const unsigned instShiftAmt;
+    const unsigned logTableSize;
+    const int maxWeight;
+    const int minWeight;
+    const unsigned numTables;
+
+    /** All weights in one array, table after table. */
+    std::vector<int8_t> weights;
+
+    GlobalHistory ghist;
+    std::vector<FoldedHistory> comp;
+
+    /** Training threshold and its adaptation counter. */
+    int theta;
+    int thetaCtr;
+};
+
+#endif // __CPU_PRED_HASHED_PERCEPTRON_HH__
@@ -0,0 +1,609 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* @file
+ * Implementation of a TAGE-SC-L branch predictor
+ */
+
+#include "cpu/pred/tage_sc_l.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "base/intmath.hh"
+#include "base/misc.hh"
+
+namespace
+{
+
+/** Width of the tagged table prediction counters. */
+const int TageCtrBits = 3;
+/** Maximum value of the useful counters. */
+const uint8_t MaxUseful = 3;
+/** Width of the statistical corrector weights. */
+const int SCWeightBits = 6;
+/** Scale of the TAGE confidence vote in the statistical corrector. */
+const int TageVoteWeight = 16;
+/** Ways per loop predictor set. */
+const unsigned LoopWays = 4;
+/** Width of the loop predictor tags. */
+const unsigned LoopTagBits = 14;
+/** Confidence at which a loop entry is used for prediction. */
+const uint8_t LoopMaxConf = 3;
+/** Age given to a newly allocated loop entry. */
+const uint8_t LoopInitAge = 7;
+/** Maximum loop entry age. */
+const uint8_t LoopMaxAge = 255;
+/** Number of path history bits kept. */
+const unsigned PathHistBits = 16;
+
+/** Saturating update of a signed counter of nbits bits. */
+template <class T>
+inline void
+ctrUpdate(T &ctr, bool up, int nbits)
+{
+    if (up) {
+        if (ctr < (1 << (nbits - 1)) - 1)
+            ++ctr;
+    } else {
+        if (ctr > -(1 << (nbits - 1)))
+            --ctr;
+    }
+}
+
+} // anonymous namespace
+
+TageSCL::Config::Config()
+    : instShiftAmt(2), logBimodalSize(13), numTables(12), logTableSize(10),
+      minHist(4), maxHist(640), minTagBits(8), maxTagBits(15),
+      logUResetPeriod(18), logLoopSets(4), logSCTableSize(10)
+{
+    scHistLengths.push_back(6);
+    scHistLengths.push_back(11);
+    scHistLengths.push_back(21);
+    scHistLengths.push_back(40);
+}
+
+const char *
+TageSCL::Config::check() const
+{
+    if (instShiftAmt > MaxInstShiftAmt)
+        return "invalid instruction shift amount";
+    if (numTables == 0 || numTables > MaxTables)
+        return "TAGE needs between 1 and 20 tagged tables";
+    if (minHist == 0 || minHist > maxHist || maxHist > MaxHist)
+        return "invalid TAGE history lengths";
+    if (minTagBits < 2 || minTagBits > maxTagBits || maxTagBits > 16)
+        return "invalid TAGE tag widths";
+    if (logTableSize < 2 || logTableSize > 24 || logBimodalSize > 28)
+        return "invalid TAGE table sizes";
+    if (logUResetPeriod == 0 || logUResetPeriod > 63)
+        return "invalid TAGE useful bit reset period";
+    if (logLoopSets > 16 || logSCTableSize == 0 || logSCTableSize > 24)
+        return "invalid loop predictor or statistical corrector size";
+    if (scHistLengths.empty() || scHistLengths.size() > MaxSCTables)
+        return "the statistical corrector needs between 1 and 8 tables";
+    for (auto l : scHistLengths) {
+        if (l > MaxHist)
+            return "invalid statistical corrector history lengths";
+    }
+    return NULL;
+}
+
+TageSCL::TageSCL(const Config &c)
+    : instShiftAmt(c.instShiftAmt), numTables(c.numTables),
+      logTableSize(c.logTableSize), logUResetPeriod(c.logUResetPeriod),
+      logLoopSets(c.logLoopSets), logSCTableSize(c.logSCTableSize),
+      numSCTables(c.scHistLengths.size()),
+      histLengths(c.numTables + 1, 0), tagBits(c.numTables + 1, 0),
+      bimodal((ULL(1) << c.logBimodalSize) / 4 + 1, 0xaa),
+      bimodalMask((1 << c.logBimodalSize) - 1),
+      tables(c.numTables + 1),
+      scTables(c.scHistLengths.size() + 1,
+               std::vector<int8_t>(1 << c.logSCTableSize, 0)),
+      loopTable(LoopWays << c.logLoopSets),
+      ghist(ceilPow2(std::max(c.maxHist,
+                              *std::max_element(c.scHistLengths.begin(),
+                                                c.scHistLengths.end()))
+                     + 2048)),
+      pathHist(0),
+      indexComp(c.numTables + 1), tagComp0(c.numTables + 1),
+      tagComp1(c.numTables + 1), scComp(c.scHistLengths.size()),
+      useAltOnNa(0), withLoop(-1), scThreshold(35), scThresholdCtr(0),
+      uResetCounter(0), seed(0x2545f491)
+{
+    if (const char *err = c.check())
+        fatal("Invalid TAGE-SC-L configuration: %s.\n", err);
+
+    // geometric series of history lengths between minHist and maxHist,
+    // and tag widths growing linearly with the history length
+    for (unsigned i = 1; i <= numTables; ++i) {
+        if (numTables == 1) {
+            histLengths[i] = c.minHist;
+            tagBits[i] = c.minTagBits;
+        } else {
+            double ratio = (double)c.maxHist / c.minHist;
+            double exp = (double)(i - 1) / (numTables - 1);
+            histLengths[i] = (unsigned)(c.minHist * pow(ratio, exp) + 0.5);
+            tagBits[i] = c.minTagBits +
+                (c.maxTagBits - c.minTagBits) * (i - 1) / (numTables - 1);
+        }
+
+        tables[i].resize(1 << logTableSize);
+        indexComp[i].init(histLengths[i], logTableSize);
+        tagComp0[i].init(histLengths[i], tagBits[i]);
+        tagComp1[i].init(histLengths[i], tagBits[i] - 1);
+    }
+
+    for (unsigned i = 0; i < numSCTables; ++i)
+        scComp[i].init(c.scHistLengths[i], logSCTableSize);
+}
+
+unsigned
+TageSCL::random()
+{
+    // xorshift32
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+void
+TageSCL::saveHistory(BranchInfo *bi) const
+{
+    bi->ghistPtr = ghist.pointer();
+    bi->pathHist = pathHist;
+    for (unsigned i = 1; i <= numTables; ++i) {
+        bi->indexComp[i] = indexComp[i].comp;
+        bi->tagComp0[i] = tagComp0[i].comp;
+        bi->tagComp1[i] = tagComp1[i].comp;
+    }
+    for (unsigned i = 0; i < numSCTables; ++i)
+        bi->scComp[i] = scComp[i].comp;
+    bi->loopHit = false;
+}
+
+void
+TageSCL::restoreHistory(BranchInfo *bi)
+{
+    ghist.restore(bi->ghistPtr);
+    pathHist = bi->pathHist;
+    for (unsigned i = 1; i <= numTables; ++i) {
+        indexComp[i].comp = bi->indexComp[i];
+        tagComp0[i].comp = bi->tagComp0[i];
+        tagComp1[i].comp = bi->tagComp1[i];
+    }
+    for (unsigned i = 0; i < numSCTables; ++i)
+        scComp[i].comp = bi->scComp[i];
+
+    if (bi->loopHit && loopTable[bi->loopIndex].tag == bi->loopTag)
+        loopTable[bi->loopIndex].currentIterSpec = bi->loopIterSpec;
+}
+
+void
+TageSCL::speculativeUpdate(BranchInfo *bi, unsigned pc, bool taken)
+{
+    if (bi->loopHit && loopTable[bi->loopIndex].tag == bi->loopTag) {
+        LoopEntry &e = loopTable[bi->loopIndex];
+        if (taken != e.dir)
+            e.currentIterSpec = 0;
+        else if (e.currentIterSpec < 0xffff)
+            ++e.currentIterSpec;
+    }
+
+    ghist.push(taken);
+    pathHist = ((pathHist << 1) ^ (pc & 1)) & ((1 << PathHistBits) - 1);
+
+    for (unsigned i = 1; i <= numTables; ++i) {
+        indexComp[i].update(ghist);
+        tagComp0[i].update(ghist);
+        tagComp1[i].update(ghist);
+    }
+    for (unsigned i = 0; i < numSCTables; ++i)
+        scComp[i].update(ghist);
+}
+
+unsigned
+TageSCL::pathHash(unsigned path, unsigned size, unsigned bank) const
+{
+    const unsigned tbl_mask = (1 << logTableSize) - 1;
+    const unsigned shift = bank % (logTableSize - 1) + 1;
+
+    unsigned a = path & ((1 << size) - 1);
+    unsigned a1 = a & tbl_mask;
+    unsigned a2 = a >> logTableSize;
+    a2 = ((a2 << shift) & tbl_mask) + (a2 >> (logTableSize - shift));
+    a = a1 ^ a2;
+    a = ((a << shift) & tbl_mask) + (a >> (logTableSize - shift));
+    return a;
+}
+
+unsigned
+TageSCL::gindex(unsigned pc, unsigned bank) const
+{
+    unsigned shift = std::abs((int)logTableSize - (int)bank) + 1;
+    unsigned path_len = std::min(histLengths[bank], PathHistBits);
+    unsigned index = pc ^ (pc >> shift) ^ indexComp[bank].comp ^
+        pathHash(pathHist, path_len, bank);
+    return index & ((1 << logTableSize) - 1);
+}
+
+uint16_t
+TageSCL::gtag(unsigned pc, unsigned bank) const
+{
+    unsigned tag = pc ^ tagComp0[bank].comp ^ (tagComp1[bank].comp << 1);
+    return tag & ((1 << tagBits[bank]) - 1);
+}
+
+unsigned
+TageSCL::readBimodal(unsigned idx) const
+{
+    return (bimodal[idx >> 2] >> ((idx & 3) * 2)) & 3;
+}
+
+void
+TageSCL::updateBimodal(unsigned idx, bool taken)
+{
+    unsigned ctr = readBimodal(idx);
+    if (taken && ctr < 3)
+        ++ctr;
+    else if (!taken && ctr > 0)
+        --ctr;
+
+    uint8_t &byte = bimodal[idx >> 2];
+    unsigned shift = (idx & 3) * 2;
+    byte = (byte & ~(3 << shift)) | (ctr << shift);
+}
+
+TageSCL::LoopEntry *
+TageSCL::loopLookup(unsigned pc, unsigned &index)
+{
+    unsigned set = pc & ((1 << logLoopSets) - 1);
+    uint16_t tag = (pc >> logLoopSets) & ((1 << LoopTagBits) - 1);
+
+    for (unsigned way = 0; way < LoopWays; ++way) {
+        index = set * LoopWays + way;
+        if (loopTable[index].tag == tag && loopTable[index].age)
+            return &loopTable[index];
+    }
+    return NULL;
+}
+
+void
+TageSCL::scPredict(BranchInfo *bi, unsigned pc, int tage_conf)
+{
+    const unsigned sc_mask = (1 << logSCTableSize) - 1;
+
+    // the bias table is indexed by the PC and the TAGE prediction, the
+    // GEHL tables by the PC and a folded global history
+    bi->scIndex[0] = (((pc ^ (pc >> 2)) << 1) | bi->tagePred) & sc_mask;
+    for (unsigned i = 0; i < numSCTables; ++i) {
+        bi->scIndex[i + 1] =
+            (pc ^ (pc >> (i + 2)) ^ (scComp[i].comp << 1)) & sc_mask;
+    }
+
+    int sum = (bi->tagePred ? 1 : -1) * tage_conf * TageVoteWeight;
+    for (unsigned i = 0; i <= numSCTables; ++i)
+        sum += 2 * scTables[i][bi->scIndex[i]] + 1;
+
+    bi->scSum = sum;
+    bi->scPred = sum >= 0;
+}
+
+void
+TageSCL::uncondBranch(void * &bp_history)
+{
+    BranchInfo *bi = new BranchInfo;
+    bi->conditional = false;
+    saveHistory(bi);
+    bi->tagePred = bi->scPred = bi->finalPred = true;
+    speculativeUpdate(bi, 0, true);
+    bp_history = static_cast<void *>(bi);
+}
+
+bool
+TageSCL::lookup(Addr branch_addr, void * &bp_history)
+{
+    unsigned pc = branch_addr >> instShiftAmt;
+    BranchInfo *bi = new BranchInfo;
+    bi->conditional = true;
+    saveHistory(bi);
+
+    // TAGE: find the longest and second longest matching tables
+    bi->bimodalIndex = pc & bimodalMask;
+    bool bim_pred = readBimodal(bi->bimodalIndex) >= 2;
+
+    for (unsigned i = 1; i <= numTables; ++i) {
+        bi->tableIndex[i] = gindex(pc, i);
+        bi->tableTag[i] = gtag(pc, i);
+    }
+
+    bi->hitBank = 0;
+    bi->altBank = 0;
+    for (unsigned i = numTables; i > 0; --i) {
+        if (tables[i][bi->tableIndex[i]].tag == bi->tableTag[i]) {
+            bi->hitBank = i;
+            break;
+        }
+    }
+    for (unsigned i = bi->hitBank ? bi->hitBank - 1 : 0; i > 0; --i) {
+        if (tables[i][bi->tableIndex[i]].tag == bi->tableTag[i]) {
+            bi->altBank = i;
+            break;
+        }
+    }
+
+    int tage_conf;
+    if (bi->hitBank) {
+        const TageEntry &e = tables[bi->hitBank][bi->tableIndex[bi->hitBank]];
+        bi->altTaken = bi->altBank ?
+            tables[bi->altBank][bi->tableIndex[bi->altBank]].ctr >= 0 :
+            bim_pred;
+        bi->longestMatchPred = e.ctr >= 0;
+        bi->providerWeak = e.ctr == 0 || e.ctr == -1;
+        bi->tagePred = (bi->providerWeak && useAltOnNa >= 0) ?
+            bi->altTaken : bi->longestMatchPred;
+        tage_conf = std::abs(2 * e.ctr + 1);
+    } else {
+        bi->altTaken = bi->longestMatchPred = bi->tagePred = bim_pred;
+        bi->providerWeak = false;
+        tage_conf = std::abs(2 * (int)readBimodal(bi->bimodalIndex) - 3);
+    }
+
+    // SC: possibly revert the TAGE prediction
+    scPredict(bi, pc, tage_conf);
+    bool pred = bi->scPred;
+
+    // L: a confident loop entry overrides both
+    LoopEntry *le = loopLookup(pc, bi->loopIndex);
+    bi->loopPredValid = false;
+    bi->loopPred = false;
+    if (le) {
+        bi->loopHit = true;
+        bi->loopTag = le->tag;
+        bi->loopIterSpec = le->currentIterSpec;
+        bi->loopPredValid = le->confidence == LoopMaxConf;
+        bi->loopPred = le->currentIterSpec == le->numIter ? !le->dir : le->dir;
+        if (bi->loopPredValid && withLoop >= 0)
+            pred = bi->loopPred;
+    }
+
+    bi->finalPred = pred;
+    speculativeUpdate(bi, pc, pred);
+
+    bp_history = static_cast<void *>(bi);
+    return pred;
+}
+
+void
+TageSCL::btbUpdate(Addr branch_addr, void * &bp_history)
+{
+    BranchInfo *bi = static_cast<BranchInfo *>(bp_history);
+    restoreHistory(bi);
+    speculativeUpdate(bi, branch_addr >> instShiftAmt, false);
+}
+
+void
+TageSCL::loopUpdate(BranchInfo *bi, unsigned pc, bool taken)
+{
+    if (bi->loopHit) {
+        LoopEntry &e = loopTable[bi->loopIndex];
+        if (e.tag != bi->loopTag)
+            return;
+
+        if (bi->loopPredValid) {
+            if (bi->loopPred != bi->scPred)
+                ctrUpdate(withLoop, bi->loopPred == taken, 7);
+
+            if (bi->loopPred != taken) {
+                // a confident entry got it wrong, free it
+                e = LoopEntry();
+                return;
+            }
+            if (bi->loopPred != bi->scPred && e.age < LoopMaxAge)
+                ++e.age;
+        }
+
+        if (taken == e.dir) {
+            if (e.currentIter == 0xffff) {
+                e = LoopEntry();
+                return;
+            }
+            ++e.currentIter;
+        } else {
+            // loop exit: learn or confirm the trip count
+            if (e.numIter == 0 || e.currentIter != e.numIter) {
+                e.numIter = e.currentIter;
+                e.confidence = 0;
+            } else if (e.confidence < LoopMaxConf) {
+                ++e.confidence;
+            }
+            e.currentIter = 0;
+        }
+    } else if (bi->finalPred != taken && (random() & 3) == 0) {
+        // allocate assuming the mispredicted outcome was a loop exit
+        unsigned set = pc & ((1 << logLoopSets) - 1);
+        unsigned start = random() % LoopWays;
+        for (unsigned i = 0; i < LoopWays; ++i) {
+            LoopEntry &e = loopTable[set * LoopWays + (start + i) % LoopWays];
+            if (e.age == 0) {
+                e = LoopEntry();
+                e.tag = (pc >> logLoopSets) & ((1 << LoopTagBits) - 1);
+                e.dir = !taken;
+                e.age = LoopInitAge;
+                return;
+            }
+        }
+        for (unsigned i = 0; i < LoopWays; ++i) {
+            LoopEntry &e = loopTable[set * LoopWays + i];
+            if (e.age)
+                --e.age;
+        }
+    }
+}
+
+void
+TageSCL::scUpdate(BranchInfo *bi, bool taken)
+{
+    if (bi->scPred != taken || std::abs(bi->scSum) < scThreshold) {
+        for (unsigned i = 0; i <= numSCTables; ++i)
+            ctrUpdate(scTables[i][bi->scIndex[i]], taken, SCWeightBits);
+    }
+
+    // adapt the update threshold to balance mispredictions against
+    // low-confidence correct predictions (as in O-GEHL)
+    if (bi->scPred != taken) {
+        if (++scThresholdCtr >= 31) {
+            ++scThreshold;
+            scThresholdCtr = 0;
+        }
+    } else if (std::abs(bi->scSum) < scThreshold) {
+        if (--scThresholdCtr <= -32) {
+            if (scThreshold > 1)
+                --scThreshold;
+            scThresholdCtr = 0;
+        }
+    }
+}
+
+void
+TageSCL::tageUpdate(BranchInfo *bi, bool taken)
+{
+    bool alloc = bi->tagePred != taken && bi->hitBank < numTables;
+
+    if (bi->hitBank && bi->providerWeak) {
+        // a newly allocated entry that was right needs no company
+        if (bi->longestMatchPred == taken)
+            alloc = false;
+        if (bi->longestMatchPred != bi->altTaken)
+            ctrUpdate(useAltOnNa, bi->altTaken == taken, 4);
+    }
+
+    if (alloc) {
+        // allocate one entry in a longer history table, sometimes
+        // skipping a table to spread allocations
+        unsigned start = bi->hitBank + 1;
+        if ((random() & 1) && start < numTables)
+            ++start;
+
+        bool allocated = false;
+        for (unsigned i = start; i <= numTables; ++i) {
+            TageEntry &e = tables[i][bi->tableIndex[i]];
+            if (e.u == 0) {
+                e.tag = bi->tableTag[i];
+                e.ctr = taken ? 0 : -1;
+                allocated = true;
+                break;
+            }
+        }
+
+        if (!allocated) {
+            for (unsigned i = start; i <= numTables; ++i) {
+                TageEntry &e = tables[i][bi->tableIndex[i]];
+                if (e.u)
+                    --e.u;
+            }
+        }
+    }
+
+    // periodically decay the useful counters
+    if ((++uResetCounter & ((ULL(1) << logUResetPeriod) - 1)) == 0) {
+        for (unsigned i = 1; i <= numTables; ++i) {
+            for (auto &e : tables[i])
+                e.u >>= 1;
+        }
+    }
+
+    if (bi->hitBank) {
+        TageEntry &e = tables[bi->hitBank][bi->tableIndex[bi->hitBank]];
+        ctrUpdate(e.ctr, taken, TageCtrBits);
+
+        // also train the alternate prediction while the provider is
+        // not yet known to be useful
+        if (e.u == 0) {
+            if (bi->altBank) {
+                ctrUpdate(tables[bi->altBank][bi->tableIndex[bi->altBank]].ctr,
+                          taken, TageCtrBits);
+            } else {
+                updateBimodal(bi->bimodalIndex, taken);
+            }
+        }
+
+        if (bi->longestMatchPred != bi->altTaken) {
+            if (bi->longestMatchPred == taken) {
+                if (e.u < MaxUseful)
+                    ++e.u;
+            } else if (e.u) {
+                --e.u;
+            }
+        }
+    } else {
+        updateBimodal(bi->bimodalIndex, taken);
+    }
+}
+
+void
+TageSCL::update(Addr branch_addr, bool taken, void *bp_history,
+                bool squashed)
+{
+    BranchInfo *bi = static_cast<BranchInfo *>(bp_history);
+    if (!bi)
+        return;
+
+    unsigned pc = branch_addr >> instShiftAmt;
+
+    if (bi->conditional) {
+        loopUpdate(bi, pc, taken);
+        scUpdate(bi, taken);
+        tageUpdate(bi, taken);
+    }
+
+    if (squashed) {
+        // repair the speculative history with the actual outcome
+        restoreHistory(bi);
+        speculativeUpdate(bi, bi->conditional ? pc : 0, taken);
+    } else {
+        delete bi;
+    }
+}
+
+void
+TageSCL::squash(void *bp_history)
+{
+    BranchInfo *bi = static_cast<BranchInfo *>(bp_history);
+    restoreHistory(bi);
+    delete bi;
+}
+
+void
+TageSCL::retireSquashed(void *bp_history)
+{
+    delete static_cast<BranchInfo *>(bp_history);
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* @file
+ * Implementation of a TAGE-SC-L branch predictor
+ */
+
+#ifndef __CPU_PRED_TAGE_SC_L_HH__
+#define __CPU_PRED_TAGE_SC_L_HH__
+
+#include <vector>
+
+#include "base/types.hh"
+#include "cpu/pred/cond_pred.hh"
+#include "cpu/pred/global_history.hh"
+
+/**
+ * TAGE-SC-L conditional branch predictor, after Seznec ("TAGE-SC-L
+ * branch predictors", CBP-4). It combines three components:
+ *
+ * - TAGE: a bimodal base predictor and a set of partially tagged
+ *   tables indexed with geometrically increasing global history
+ *   lengths. The longest matching table provides the prediction.
+ * - SC: a statistical corrector made of a bias table and a few GEHL
+ *   tables whose weighted sum, which includes a vote from TAGE scaled
+ *   by its confidence, may revert the TAGE prediction.
+ * - L: a loop predictor that overrides the others for branches with a
+ *   constant trip count once it is confident.
+ *
+ * All tables are kept in compact contiguous arrays: the bimodal
+ * counters are packed four to a byte and a tagged entry takes four
+ * bytes. The predictor only depends on the base library so that it
+ * can also be driven by standalone tools.
+ */
+class TageSCL : public ConditionalPredictor
+{
+  public:
+    /** Geometry of the predictor. */
+    struct Config
+    {
+        Config();
+
+        /** Returns why the geometry is invalid, or NULL if it is valid. */
+        const char *check() const;
+
+        /** Number of bits to shift the PC by. */
+        unsigned instShiftAmt;
+        /** Log2 of the number of bimodal counters. */
+        unsigned logBimodalSize;
+        /** Number of tagged tables. */
+        unsigned numTables;
+        /** Log2 of the number of entries per tagged table. */
+        unsigned logTableSize;
+        /** History length of the shortest tagged table. */
+        unsigned minHist;
+        /** History length of the longest tagged table. */
+        unsigned maxHist;
+        /** Tag width of the shortest history table. */
+        unsigned minTagBits;
+        /** Tag width of the longest history table. */
+        unsigned maxTagBits;
+        /** Log2 of the number of updates between useful bit decays. */
+        unsigned logUResetPeriod;
+        /** Log2 of the number of sets of the loop predictor. */
+        unsigned logLoopSets;
+        /** Log2 of the number of weights per statistical corrector table. */
+        unsigned logSCTableSize;
+        /** History lengths of the statistical corrector GEHL tables. */
+        std::vector<unsigned> scHistLengths;
+    };
+
+    /** Upper bounds of the geometry, used to size the branch state. */
+    static const unsigned MaxTables = 20;
+    static const unsigned MaxSCTables = 8;
+    static const unsigned MaxHist = 65536;
+    static const unsigned MaxInstShiftAmt = 16;
+
+    TageSCL(const Config &config);
+
+    void uncondBranch(void * &bp_history);
+    bool lookup(Addr branch_addr, void * &bp_history);
+    void btbUpdate(Addr branch_addr, void * &bp_history);
+    void update(Addr branch_addr, bool taken, void *bp_history,
+                bool squashed);
+    void squash(void *bp_history);
+    void retireSquashed(void *bp_history);
+
+  private:
+    /** Entry of a tagged table, packed into four bytes. */
+    struct TageEntry
+    {
+        TageEntry() : ctr(0), u(0), tag(0) { }
+        int8_t ctr;
+        uint8_t u;
+        uint16_t tag;
+    };
+
+    /** Entry of the loop predictor. */
+    struct LoopEntry
+    {
+        LoopEntry()
+            : tag(0), numIter(0), currentIter(0), currentIterSpec(0),
+              confidence(0), age(0), dir(false)
+        { }
+        uint16_t tag;
+        uint16_t numIter;
+        uint16_t currentIter;
+        uint16_t currentIterSpec;
+        uint8_t confidence;
+        uint8_t age;
+        bool dir;
+    };
+
+    /** State kept for every branch between prediction and update. */
+    struct BranchInfo
+    {
+        bool conditional;
+
+        // speculative history to restore on a squash
+        unsigned ghistPtr;
+        unsigned pathHist;
+        unsigned indexComp[MaxTables + 1];
+        unsigned tagComp0[MaxTables + 1];
+        unsigned tagComp1[MaxTables + 1];
+        unsigned scComp[MaxSCTables];
+
+        // TAGE
+        unsigned bimodalIndex;
+        unsigned tableIndex[MaxTables + 1];
+        uint16_t tableTag[MaxTables + 1];
+        unsigned hitBank;
+        unsigned altBank;
+        bool longestMatchPred;
+        bool altTaken;
+        bool providerWeak;
+        bool tagePred;
+
+        // SC
+        unsigned scIndex[MaxSCTables + 1];
+        int scSum;
+        bool scPred;
+
+        // L
+        bool loopHit;
+        unsigned loopIndex;
+        uint16_t loopTag;
+        bool loopPredValid;
+        bool loopPred;
+        uint16_t loopIterSpec;
+
+        bool finalPred;
+    };
+
+    /** Saves the speculative history into bi. */
+    void saveHistory(BranchInfo *bi) const;
+
+    /** Rolls the speculative history back to what bi saved. */
+    void restoreHistory(BranchInfo *bi);
+
+    /** Speculatively records a branch outcome in all histories. */
+    void speculativeUpdate(BranchInfo *bi, unsigned pc, bool taken);
+
+    /** @{ TAGE helpers */
+    unsigned pathHash(unsigned path, unsigned size, unsigned bank) const;
+    unsigned gindex(unsigned pc, unsigned bank) const;
+    uint16_t gtag(unsigned pc, unsigned bank) const;
+    unsigned readBimodal(unsigned idx) const;
+    void updateBimodal(unsigned idx, bool taken);
+    void tageUpdate(BranchInfo *bi, bool taken);
+    /** @} */
+
+    /** @{ Statistical corrector helpers */
+    void scPredict(BranchInfo *bi, unsigned pc, int tage_conf);
+    void scUpdate(BranchInfo *bi, bool taken);
+    /** @} */
+
+    /** @{ Loop predictor helpers */
+    LoopEntry *loopLookup(unsigned pc, unsigned &index);
+    void loopUpdate(BranchInfo *bi, unsigned pc, bool taken);
+    /** @} */
+
+    /** Small pseudo random generator for allocation decisions. */
+    unsigned random();
+
+    const unsigned instShiftAmt;
+    const unsigned numTables;
+    const unsigned logTableSize;
+    const unsigned logUResetPeriod;
+    const unsigned logLoopSets;
+    const unsigned logSCTableSize;
+    const unsigned numSCTables;
+
+    /** History length and tag width of each tagged table (1-based). */
+    std::vector<unsigned> histLengths;
+    std::vector<unsigned> tagBits;
+
+    /** Bimodal counters, four 2-bit counters per byte. */
+    std::vector<uint8_t> bimodal;
+    const unsigned bimodalMask;
+
+    /** Tagged tables, one contiguous array per table (1-based). */
+    std::vector<std::vector<TageEntry> > tables;
+
+    /** Statistical corrector weights; table 0 is the bias table. */
+    std::vector<std::vector<int8_t> > scTables;
+
+    /** Loop predictor, four ways per set. */
+    std::vector<LoopEntry> loopTable;
+
+    GlobalHistory ghist;
+    unsigned pathHist;
+    std::vector<FoldedHistory> indexComp;
+    std::vector<FoldedHistory> tagComp0;
+    std::vector<FoldedHistory> tagComp1;
+    std::vector<FoldedHistory> scComp;
+
+    /** Chooses between the provider and the alternate prediction for
+     *  newly allocated (weak) entries. */
+    int useAltOnNa;
+    /** Chooses whether the loop predictor is trusted. */
+    int withLoop;
+    /** Statistical corrector update threshold and its adaptation. */
+    int scThreshold;
+    int scThresholdCtr;
+    /** Counts updates to decay the useful bits periodically. */
+    uint64_t uResetCounter;
+    unsigned seed;
+};
+
+#endif // __CPU_PRED_TAGE_SC_L_HH__
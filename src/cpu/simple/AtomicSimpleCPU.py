@@ -62,6 +62,8 @@ class AtomicSimpleCPU(BaseSimpleCPU):
     simulate_data_stalls = Param.Bool(False, "Simulate dcache stall cycles")
     simulate_inst_stalls = Param.Bool(False, "Simulate icache stall cycles")
     fastmem = Param.Bool(False, "Access memory directly")
+    parallel_fastmem = Param.Bool(False, "Access memory directly, safe "
+                                  "for CPUs on separate event queues")
 
     def addSimPointProbe(self, interval):
         simpoint = SimPoint()
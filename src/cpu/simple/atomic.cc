@@ -57,6 +57,7 @@
 #include "mem/physical.hh"
 #include "params/AtomicSimpleCPU.hh"
 #include "sim/faults.hh"
+#include "sim/global_event.hh"
 #include "sim/system.hh"
 #include "sim/full_system.hh"
 
@@ -98,6 +99,18 @@ AtomicSimpleCPU::init()
         }
     }
 
+    if (parallelFastmem) {
+        if (simQuantum == 0)
+            fatal("%s: parallel_fastmem requires a simulation quantum\n",
+                  name());
+        // reservations cleared by other CPUs are only acted upon at
+        // quantum boundaries, when touching this CPU is safe
+        system->getPhysMem().addConcurrentContext(&memContext);
+        registerQuantumCallback(
+            new MakeCallback<AtomicSimpleCPU,
+                             &AtomicSimpleCPU::checkMonitor>(this));
+    }
+
     // Atomic doesn't do MT right now, so contextId == threadId
     ifetch_req.setThreadContext(_cpuId, 0); // Add thread ID if we add MT
     data_read_req.setThreadContext(_cpuId, 0); // Add thread ID here too
@@ -111,7 +124,8 @@ AtomicSimpleCPU::AtomicSimpleCPU(AtomicSimpleCPUParams *p)
       drain_manager(NULL),
       icachePort(name() + ".icache_port", this),
       dcachePort(name() + ".dcache_port", this),
-      fastmem(p->fastmem), dcache_access(false), dcache_latency(0),
+      fastmem(p->fastmem), parallelFastmem(p->parallel_fastmem),
+      dcache_access(false), dcache_latency(0),
       ppCommit(nullptr)
 {
     _status = Idle;
@@ -310,6 +324,25 @@ AtomicSimpleCPU::AtomicCPUDPort::recvFunctionalSnoop(PacketPtr pkt)
     }
 }
 
+Tick
+AtomicSimpleCPU::sendParallelAtomic(MasterPort &port, PacketPtr pkt)
+{
+    if (system->getPhysMem().concurrentAccess(pkt, memContext))
+        return 0;
+
+    // everything else, e.g. devices, goes through the
+    // ConcurrentMemBridge, which takes over the event queue of the
+    // memory system for the access
+    return port.sendAtomic(pkt);
+}
+
+void
+AtomicSimpleCPU::checkMonitor()
+{
+    if (memContext.monitorCleared.exchange(false) && !switchedOut())
+        wakeup();
+}
+
 Fault
 AtomicSimpleCPU::readMem(Addr addr, uint8_t * data,
                          unsigned size, unsigned flags)
@@ -348,7 +381,9 @@ AtomicSimpleCPU::readMem(Addr addr, uint8_t * data,
             if (req->isMmappedIpr())
                 dcache_latency += TheISA::handleIprRead(thread->getTC(), &pkt);
             else {
-                if (fastmem && system->isMemAddr(pkt.getAddr()))
+                if (parallelFastmem)
+                    dcache_latency += sendParallelAtomic(dcachePort, &pkt);
+                else if (fastmem && system->isMemAddr(pkt.getAddr()))
                     system->getPhysMem().access(&pkt);
                 else
                     dcache_latency += dcachePort.sendAtomic(&pkt);
@@ -364,6 +399,10 @@ AtomicSimpleCPU::readMem(Addr addr, uint8_t * data,
 
         //If there's a fault, return it
         if (fault != NoFault) {
+            // a locked access that faults on its second line is
+            // restarted, so let go of the first one
+            if (parallelFastmem && req->isLocked())
+                system->getPhysMem().concurrentUnlock(memContext);
             if (req->isPrefetch()) {
                 return NoFault;
             } else {
@@ -458,7 +497,10 @@ AtomicSimpleCPU::writeMem(uint8_t *data, unsigned size,
                     dcache_latency +=
                         TheISA::handleIprWrite(thread->getTC(), &pkt);
                 } else {
-                    if (fastmem && system->isMemAddr(pkt.getAddr()))
+                    if (parallelFastmem)
+                        dcache_latency +=
+                            sendParallelAtomic(dcachePort, &pkt);
+                    else if (fastmem && system->isMemAddr(pkt.getAddr()))
                         system->getPhysMem().access(&pkt);
                     else
                         dcache_latency += dcachePort.sendAtomic(&pkt);
@@ -485,6 +527,8 @@ AtomicSimpleCPU::writeMem(uint8_t *data, unsigned size,
                 assert(locked);
                 locked = false;
             }
+            if (parallelFastmem && req->isLocked())
+                system->getPhysMem().concurrentUnlock(memContext);
             if (fault != NoFault && req->isPrefetch()) {
                 return NoFault;
             } else {
@@ -558,7 +602,11 @@ AtomicSimpleCPU::tick()
                     Packet ifetch_pkt = Packet(&ifetch_req, MemCmd::ReadReq);
                     ifetch_pkt.dataStatic(&inst);
 
-                    if (fastmem && system->isMemAddr(ifetch_pkt.getAddr()))
+                    if (parallelFastmem)
+                        icache_latency =
+                            sendParallelAtomic(icachePort, &ifetch_pkt);
+                    else if (fastmem &&
+                             system->isMemAddr(ifetch_pkt.getAddr()))
                         system->getPhysMem().access(&ifetch_pkt);
                     else
                         icache_latency = icachePort.sendAtomic(&ifetch_pkt);
@@ -44,6 +44,7 @@
 #define __CPU_SIMPLE_ATOMIC_HH__
 
 #include "cpu/simple/base.hh"
+#include "mem/physical.hh"
 #include "params/AtomicSimpleCPU.hh"
 #include "sim/probe/probe.hh"
 
@@ -172,6 +173,34 @@ class AtomicSimpleCPU : public BaseSimpleCPU
     AtomicCPUDPort dcachePort;
 
     bool fastmem;
+
+    /**
+     * Access memory directly in a way that is safe when the CPUs of
+     * the system run on separate event queues and host threads. The
+     * ports are expected to reach the memory system through a
+     * ConcurrentMemBridge, which takes care of anything else.
+     */
+    const bool parallelFastmem;
+
+    /** Load-locked and locked access state for parallelFastmem. */
+    PhysicalMemory::ConcurrentContext memContext;
+
+    /**
+     * Send an atomic request in the parallelFastmem mode.
+     *
+     * @param port Port to use if the request is not for memory
+     * @param pkt Packet to send
+     * @return The latency of the access
+     */
+    Tick sendParallelAtomic(MasterPort &port, PacketPtr pkt);
+
+    /**
+     * Wake up the CPU if a write by another CPU cleared its
+     * load-locked reservation. Called at quantum boundaries in the
+     * parallelFastmem mode, when no other thread is running.
+     */
+    void checkMonitor();
+
     Request ifetch_req;
     Request data_read_req;
     Request data_write_req;
@@ -405,38 +405,75 @@ RandomGen::nextPacketTick(bool elastic, Tick delay) const
 }
 
 TraceGen::InputStream::InputStream(const std::string& filename)
-    : trace(filename)
+    : protoTrace(NULL), binaryTrace(NULL)
 {
+    if (PacketTrace::isPacketTrace(filename))
+        binaryTrace = new PacketTraceInput(filename);
+    else
+        protoTrace = new ProtoInputStream(filename);
+
     init();
 }
 
+TraceGen::InputStream::~InputStream()
+{
+    delete protoTrace;
+    delete binaryTrace;
+}
+
 void
 TraceGen::InputStream::init()
 {
-    // Create a protobuf message for the header and read it from the stream
-    ProtoMessage::PacketHeader header_msg;
-    if (!trace.read(header_msg)) {
-        panic("Failed to read packet header from trace\n");
-
-        if (header_msg.tick_freq() != SimClock::Frequency) {
-            panic("Trace was recorded with a different tick frequency %d\n",
-                  header_msg.tick_freq());
-        }
+    uint64_t tick_freq;
+
+    if (binaryTrace) {
+        tick_freq = binaryTrace->tickFreq();
+    } else {
+        // Create a protobuf message for the header and read it from
+        // the stream
+        ProtoMessage::PacketHeader header_msg;
+        if (!protoTrace->read(header_msg))
+            panic("Failed to read packet header from trace\n");
+        tick_freq = header_msg.tick_freq();
+    }
+
+    if (tick_freq != SimClock::Frequency) {
+        panic("Trace was recorded with a different tick frequency %d\n",
+              tick_freq);
     }
 }
 
 void
 TraceGen::InputStream::reset()
 {
-    trace.reset();
-    init();
+    if (binaryTrace) {
+        binaryTrace->reset();
+    } else {
+        protoTrace->reset();
+        init();
+    }
 }
 
 bool
 TraceGen::InputStream::read(TraceElement& element)
 {
+    if (binaryTrace) {
+        // The records are used straight from the decompressed block
+        const PacketTraceRecord* record = binaryTrace->read();
+        if (record) {
+            element.cmd = record->cmd;
+            element.addr = record->addr;
+            element.blocksize = record->size;
+            element.tick = record->tick;
+            element.flags = record->flags;
+            return true;
+        }
+
+        return false;
+    }
+
     ProtoMessage::Packet pkt_msg;
-    if (trace.read(pkt_msg)) {
+    if (protoTrace->read(pkt_msg)) {
         element.cmd = pkt_msg.cmd();
         element.addr = pkt_msg.addr();
         element.blocksize = pkt_msg.size();
@@ -53,6 +53,7 @@
 #include "base/bitfield.hh"
 #include "base/intmath.hh"
 #include "mem/packet.hh"
+#include "mem/packet_trace.hh"
 #include "proto/protoio.hh"
 
 /**
@@ -539,15 +540,19 @@ class TraceGen : public BaseGen
     /**
      * The InputStream encapsulates a trace file and the
      * internal buffers and populates TraceElements based on
-     * the input.
+     * the input. The trace is either a protobuf trace, or a binary
+     * packet trace, as determined by looking at the file.
      */
     class InputStream
     {
 
       private:
 
-        /// Input file stream for the protobuf trace
-        ProtoInputStream trace;
+        /// Input file stream for a protobuf trace
+        ProtoInputStream* protoTrace;
+
+        /// Input for a binary packet trace
+        PacketTraceInput* binaryTrace;
 
       public:
 
@@ -558,6 +563,8 @@ class TraceGen : public BaseGen
          */
         InputStream(const std::string& filename);
 
+        ~InputStream();
+
         /**
          * Reset the stream such that it can be played once
          * again.
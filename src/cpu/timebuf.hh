@@ -34,8 +34,17 @@
 
 #include <cassert>
 #include <cstring>
-#include <vector>
 
+#include "base/intmath.hh"
+
+/**
+ * Fixed size circular buffer of per-cycle structures used to model
+ * delayed communication between pipeline stages.  Elements are stored
+ * contiguously in a ring whose capacity is rounded up to a power of
+ * two, so advancing the buffer only moves the base index and resets
+ * the slot that becomes the new future-most entry; nothing is copied
+ * between slots.
+ */
 template <class T>
 class TimeBuffer
 {
@@ -45,10 +54,29 @@ class TimeBuffer
     unsigned size;
     int _id;
 
+    /** Number of slots allocated; a power of two no smaller than size. */
+    unsigned capacity;
+    /** capacity - 1, used to wrap slot indices. */
+    unsigned mask;
+
     char *data;
-    std::vector<char *> index;
     unsigned base;
 
+    /** Returns the storage of the slot at ring position pos. */
+    T *slot(unsigned pos) const
+    {
+        return reinterpret_cast<T *>(data + pos * sizeof(T));
+    }
+
+    /** Destroys and zero-initialises the slot at ring position pos. */
+    void reset(unsigned pos)
+    {
+        T *ptr = slot(pos);
+        ptr->~T();
+        std::memset(static_cast<void *>(ptr), 0, sizeof(T));
+        new (ptr) T;
+    }
+
     void valid(int idx) const
     {
         assert (idx >= -past && idx <= future);
@@ -138,30 +166,28 @@ class TimeBuffer
 
   public:
     TimeBuffer(int p, int f)
-        : past(p), future(f), size(past + future + 1), 
-          data(new char[size * sizeof(T)]), index(size), base(0)
+        : past(p), future(f), size(past + future + 1),
+          capacity(ceilPow2(size)), mask(capacity - 1),
+          data(new char[capacity * sizeof(T)]), base(0)
     {
         assert(past >= 0 && future >= 0);
-        char *ptr = data;
-        for (unsigned i = 0; i < size; i++) {
-            index[i] = ptr;
-            std::memset(ptr, 0, sizeof(T));
-            new (ptr) T;
-            ptr += sizeof(T);
+        for (unsigned i = 0; i < capacity; i++) {
+            std::memset(static_cast<void *>(slot(i)), 0, sizeof(T));
+            new (slot(i)) T;
         }
 
         _id = -1;
     }
 
     TimeBuffer()
-        : data(NULL)
+        : capacity(0), data(NULL)
     {
     }
 
     ~TimeBuffer()
     {
-        for (unsigned i = 0; i < size; ++i)
-            (reinterpret_cast<T *>(index[i]))->~T();
+        for (unsigned i = 0; i < capacity; ++i)
+            slot(i)->~T();
         delete [] data;
     }
 
@@ -178,55 +204,38 @@ class TimeBuffer
     void
     advance()
     {
-        if (++base >= size)
-            base = 0;
+        base = (base + 1) & mask;
 
-        int ptr = base + future;
-        if (ptr >= (int)size)
-            ptr -= size;
-        (reinterpret_cast<T *>(index[ptr]))->~T();
-        std::memset(index[ptr], 0, sizeof(T));
-        new (index[ptr]) T;
+        // Slots beyond the past/future window are never accessed, so
+        // only the slot that becomes the future-most one needs to be
+        // cleared.
+        reset((base + future) & mask);
     }
 
   protected:
-    //Calculate the index into this->index for element at position idx
+    //Calculate the ring position of the element at position idx
     //relative to now
-    inline int calculateVectorIndex(int idx) const
+    inline unsigned calculateVectorIndex(int idx) const
     {
-        //Need more complex math here to calculate index.
         valid(idx);
 
-        int vector_index = idx + base;
-        if (vector_index >= (int)size) {
-            vector_index -= size;
-        } else if (vector_index < 0) {
-            vector_index += size;
-        }
-
-        return vector_index;
+        return (base + idx) & mask;
     }
 
   public:
     T *access(int idx)
     {
-        int vector_index = calculateVectorIndex(idx);
-
-        return reinterpret_cast<T *>(index[vector_index]);
+        return slot(calculateVectorIndex(idx));
     }
 
     T &operator[](int idx)
     {
-        int vector_index = calculateVectorIndex(idx);
-
-        return reinterpret_cast<T &>(*index[vector_index]);
+        return *slot(calculateVectorIndex(idx));
     }
 
     const T &operator[] (int idx) const
     {
-        int vector_index = calculateVectorIndex(idx);
-
-        return reinterpret_cast<const T &>(*index[vector_index]);
+        return *slot(calculateVectorIndex(idx));
     }
 
     wire getWire(int idx)
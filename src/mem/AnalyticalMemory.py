@@ -0,0 +1,96 @@
+#
+# Copyright (c) 2015 The gem5 SDC model contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+from m5.params import *
+from AbstractMemory import *
+from DRAMCtrl import AddrMap, PageManage
+
+# AnalyticalMemory is a cheap stand-in for the DRAMCtrl that places
+# every burst on the data bus as it arrives, based on the open row and
+# timing state of each bank, rather than queueing and scheduling
+# commands. The parameters are a subset of those of the DRAMCtrl, with
+# the same meaning, and default to a DDR3-1600 x64 channel.
+class AnalyticalMemory(AbstractMemory):
+    type = 'AnalyticalMemory'
+    cxx_header = "mem/analytical_mem.hh"
+
+    port = SlavePort("Slave port")
+
+    # buffers are only used for flow control, an entry is held until
+    # the burst completes on the data bus
+    write_buffer_size = Param.Unsigned(64, "Number of write queue entries")
+    read_buffer_size = Param.Unsigned(32, "Number of read queue entries")
+
+    # the read-to-write and write-to-read turnaround is shared by this
+    # many write bursts
+    min_writes_per_switch = Param.Unsigned(16, "Minimum write bursts before "
+                                           "switching to reads")
+
+    addr_mapping = Param.AddrMap('RoRaBaCoCh', "Address mapping policy")
+    page_policy = Param.PageManage('open_adaptive', "Page management policy")
+
+    static_frontend_latency = Param.Latency("10ns", "Static frontend latency")
+    static_backend_latency = Param.Latency("10ns", "Static backend latency")
+
+    # the physical organisation of the DRAM
+    device_bus_width = Param.Unsigned(8, "data bus width in bits for each "
+                                      "DRAM device/chip")
+    burst_length = Param.Unsigned(8, "Burst lenght (BL) in beats")
+    device_rowbuffer_size = Param.MemorySize('1kB', "Page (row buffer) size "
+                                             "per device/chip")
+    devices_per_rank = Param.Unsigned(8, "Number of devices/chips per rank")
+    ranks_per_channel = Param.Unsigned(2, "Number of ranks per channel")
+    banks_per_rank = Param.Unsigned(8, "Number of banks per rank")
+    channels = Param.Unsigned(1, "Number of channels")
+
+    # timing behaviour and constraints
+    tRCD = Param.Latency('13.75ns', "RAS to CAS delay")
+    tCL = Param.Latency('13.75ns', "CAS latency")
+    tRP = Param.Latency('13.75ns', "Row precharge time")
+    tRAS = Param.Latency('35ns', "ACT to PRE delay")
+    tWR = Param.Latency('15ns', "Write recovery time")
+    tBURST = Param.Latency('5ns', "Burst duration")
+    tRFC = Param.Latency('260ns', "Refresh cycle time")
+    tREFI = Param.Latency('7.8us', "Refresh command interval")
+    tWTR = Param.Latency('7.5ns', "Write to read, same rank switching time")
+    tRTW = Param.Latency('2.5ns', "Read to write, same rank switching time")
+
+    # Create an analytical memory with the organisation and timing of
+    # one of the DRAMCtrl configurations, e.g. DDR3_1600_x64, with any
+    # keyword arguments overriding the parameters of the result, and
+    # the parameters common to all memories left to the caller
+    @classmethod
+    def fromDRAM(cls, dram_class, **kwargs):
+        params = {}
+        for name in cls._params.keys():
+            if name in AbstractMemory._params:
+                continue
+            if name in dram_class._params and hasattr(dram_class, name):
+                params[name] = getattr(dram_class, name)
+        params.update(kwargs)
+        return cls(**params)
@@ -52,3 +52,7 @@ class Bridge(MemObject):
     delay = Param.Latency('0ns', "The latency of this bridge")
     ranges = VectorParam.AddrRange([AllMemory],
                                    "Address ranges to pass through the bridge")
+    mem_side_eventq_index = Param.Int(-1, "Event queue of the master side, "
+                                      "-1 to use the bridge's own queue")
+    quantum_sync = Param.Bool(False, "Only pass packets and flow control "
+                              "between the two sides at quantum boundaries")
@@ -41,6 +41,10 @@ from m5.proxy import *
 from MemObject import MemObject
 from System import System
 
+# Format of the packet trace, either protobuf messages, or fixed-size
+# binary records written in blocks by a separate thread
+class PacketTraceFormat(Enum): vals = ['protobuf', 'binary']
+
 # The communication monitor will most typically be used in combination
 # with periodic dumping and resetting of stats using schedStatEvent
 class CommMonitor(MemObject):
@@ -63,6 +67,12 @@ class CommMonitor(MemObject):
     # packet trace output file, disabled by default
     trace_file = Param.String("", "Packet trace output file")
 
+    # the binary format buffers the records, and compresses and writes
+    # them in the background, which is considerably cheaper
+    trace_format = Param.PacketTraceFormat('protobuf', "Packet trace format")
+    trace_buffer_records = Param.Unsigned(65536, "Records per buffer " \
+                                              "for binary traces")
+
     # control the sample period window length of this monitor
     sample_period = Param.Clock("1ms", "Sample period for histograms")
 
@@ -84,6 +94,11 @@ class CommMonitor(MemObject):
     latency_bins = Param.Unsigned('20', "# bins in latency histograms")
     disable_latency_hists = Param.Bool(False, "Disable latency histograms")
 
+    # the latency percentiles are estimated with a relative error
+    # bounded by 2^-latency_precision
+    latency_precision = Param.Unsigned(5, "Bits of resolution per power " \
+                                           "of two in latency percentiles")
+
     # inter transaction time (ITT) distributions in uniformly sized
     # bins up to the maximum, independently for read-to-read,
     # write-to-write and the combined request-to-request that does not
@@ -99,6 +99,24 @@ class DRAMCtrl(AbstractMemory):
     max_accesses_per_row = Param.Unsigned(16, "Max accesses per row before "
                                           "closing");
 
+    # quality of service, with the masters given by their names as
+    # they appear in the per-master stats (e.g. cpu.data), and masters
+    # that are not listed having priority 0. Only the most urgent of
+    # the queued requests are considered by the scheduling policy,
+    # with requests escalated one level for every escalation period
+    # they have been waiting, and requests of a master that has not
+    # used up its reserved bandwidth going before anything else
+    qos_masters = VectorParam.String([], "Names of the QoS masters")
+    qos_priorities = VectorParam.Unsigned([], "Priority of each QoS master, "
+                                          "higher is more urgent")
+    qos_reserved_bw = VectorParam.MemoryBandwidth([], "Bandwidth reserved "
+                                                  "for each QoS master")
+    qos_reservation_window = Param.Latency("1us", "Window over which unused "
+                                           "reserved bandwidth is kept")
+    qos_escalation = Param.Latency("0ns", "Wait before a request is "
+                                   "escalated one priority level, 0 to "
+                                   "disable")
+
     # size of DRAM Chip in Bytes
     device_size = Param.MemorySize("Size of DRAM chip")
 
@@ -185,6 +203,15 @@ class DRAMCtrl(AbstractMemory):
     # to be sent. It is 7.8 us for a 64ms refresh requirement
     tREFI = Param.Latency("Refresh command interval")
 
+    # refresh one bank at a time, every tREFI / banks_per_rank, rather
+    # than all the banks of a rank at once every tREFI, thus leaving
+    # the other banks of the rank available for accesses
+    per_bank_refresh = Param.Bool(False, "Refresh a single bank at a time")
+
+    # time taken to refresh a single bank, only used with per-bank
+    # refresh
+    tRFCpb = Param.Latency("0ns", "Per-bank refresh cycle time")
+
     # write-to-read, same rank turnaround penalty
     tWTR = Param.Latency("Write to read, same rank switching time")
 
@@ -428,9 +455,8 @@ class DDR4_2400_x64(DRAMCtrl):
     # Set to 4 for x4, x8 case
     bank_groups_per_rank = 4
 
-    # DDR4 has 16 banks (4 bank groups) in all
-    # configurations. Currently we do not capture the additional
-    # constraints incurred by the bank groups
+    # DDR4 has 16 banks (4 bank groups) for x4 and x8
+    # configurations, and 8 banks (2 bank groups) for x16
     banks_per_rank = 16
 
     # 1200 MHz
@@ -493,6 +519,51 @@ class DDR4_2400_x64(DRAMCtrl):
     VDD = '1.2V'
     VDD2 = '2.5V'
 
+# A single DDR4-2400 x64 channel (one command and address bus), with
+# timings based on a DDR4-2400 8 Gbit datasheet (Micron MT40A512M16)
+# in a 4x16 configuration.
+class DDR4_2400_4x16(DDR4_2400_x64):
+    # size of device
+    device_size = '1GB'
+
+    # 4x16 configuration, 4 devices each with a 16-bit interface
+    device_bus_width = 16
+
+    # Each device has a page (row buffer) size of 2 Kbyte (1K columns x16)
+    device_rowbuffer_size = '2kB'
+
+    # 4x16 configuration, so 4 devices
+    devices_per_rank = 4
+
+    # Single rank for x16
+    ranks_per_channel = 1
+
+    # DDR4 has 2 bank groups (with 4 banks each) for x16
+    bank_groups_per_rank = 2
+    banks_per_rank = 8
+
+    # RRD_S (different bank group) for 2K page is MAX(4 CK, 5.3ns)
+    tRRD = '5.3ns'
+
+    # RRD_L (same bank group) for 2K page is MAX(4 CK, 6.4ns)
+    tRRD_L = '6.4ns';
+
+    # tFAW for 2K page is 30 ns
+    tXAW = '30ns'
+
+    # 8 Gbit device
+    tRFC = '350ns'
+
+    # Current values from datasheet
+    IDD0 = '80mA'
+    IDD02 = '4mA'
+    IDD2N = '34mA'
+    IDD3N = '47mA'
+    IDD3N2 = '3mA'
+    IDD4W = '228mA'
+    IDD4R = '243mA'
+    IDD5 = '280mA'
+
 # A single LPDDR2-S4 x32 interface (one command/address bus), with
 # default timings based on a LPDDR2-1066 4 Gbit part (Micron MT42L128M32D1)
 # in a 1x32 configuration.
@@ -821,3 +892,214 @@ class GDDR5_4000_x64(DRAMCtrl):
     # Default different rank bus delay to 2 CK, @1000 MHz = 2 ns
     tCS = '2ns'
     tREFI = '3.9us'
+
+# A single LPDDR4 x16 channel (one command/address bus), with default
+# timings based on a LPDDR4-3200 8 Gbit part (Micron MT53B256M32D1)
+# where each of the two 16-bit channels of the device is modelled by
+# a controller, so instantiate two channels per device.
+class LPDDR4_3200_1x16(DRAMCtrl):
+    # No DLL for LPDDR4
+    dll = False
+
+    # size of a single channel of the device
+    device_size = '512MB'
+
+    # 1x16 configuration, 1 device with a 16-bit interface
+    device_bus_width = 16
+
+    # LPDDR4 is a BL16 device
+    burst_length = 16
+
+    # Each channel has a page (row buffer) size of 2KB
+    device_rowbuffer_size = '2kB'
+
+    # 1x16 configuration, so 1 device
+    devices_per_rank = 1
+
+    # single rank
+    ranks_per_channel = 1
+
+    # LPDDR4 has 8 banks per channel and no bank groups
+    banks_per_rank = 8
+
+    # 1600 MHz
+    tCK = '0.625ns'
+
+    # 16 beats across an x16 DDR interface translates to 8 clocks @
+    # 1600 MHz, requests larger than 32 bytes are broken down into
+    # multiple requests in the controller
+    tBURST = '5ns'
+
+    tRCD = '18ns'
+
+    # 28 CK read latency @ 1600 MHz, 0.625 ns cycle time
+    tCL = '17.5ns'
+
+    # Pre-charge one bank 18 ns (all banks 21 ns)
+    tRP = '18ns'
+    tRAS = '42ns'
+    tWR = '18ns'
+
+    # Greater of 8 CK or 7.5 ns
+    tRTP = '7.5ns'
+
+    # Greater of 8 CK or 10 ns
+    tWTR = '10ns'
+
+    # Default same rank rd-to-wr bus turnaround to 2 CK, @1600 MHz = 1.25 ns
+    tRTW = '1.25ns'
+
+    # Default different rank bus delay to 2 CK, @1600 MHz = 1.25 ns
+    tCS = '1.25ns'
+
+    # Activate to activate irrespective of density and speed grade
+    tRRD = '10ns'
+
+    # Irrespective of size, tFAW is 40 ns
+    tXAW = '40ns'
+    activation_limit = 4
+
+    # LPDDR4 refreshes one bank at a time, all-bank refresh is 280 ns
+    # and per-bank refresh 140 ns for an 8 Gbit part
+    tRFC = '280ns'
+    per_bank_refresh = True
+    tRFCpb = '140ns'
+    tREFI = '3.9us'
+
+    # Greater of 5 CK or 7.5 ns
+    tXP = '7.5ns'
+
+    # tRFC + 7.5 ns
+    tXS = '287.5ns'
+
+    # Current values from datasheet
+    IDD0 = '3mA'
+    IDD02 = '58mA'
+    IDD2N = '0.7mA'
+    IDD2N2 = '21mA'
+    IDD3N = '1.5mA'
+    IDD3N2 = '30mA'
+    IDD4W = '2mA'
+    IDD4W2 = '250mA'
+    IDD4R = '2mA'
+    IDD4R2 = '260mA'
+    IDD5 = '12mA'
+    IDD52 = '90mA'
+    VDD = '1.8V'
+    VDD2 = '1.1V'
+
+# A single HBM x128 interface (one command and address bus), with
+# default timings based on HBM gen1 and publicly available data, for a
+# 4H stack of 2 Gbit dies, i.e. 1 GB of memory per stack. HBM has 8
+# independent 128-bit channels per stack, so set the number of
+# channels to 8 to model a complete stack.
+class HBM_1000_4H_x128(DRAMCtrl):
+    # HBM has no DLL
+    dll = False
+
+    # size of a channel, 1 GB per stack with 8 channels
+    device_size = '128MB'
+
+    # 128-bit interface legacy mode
+    device_bus_width = 128
+
+    # HBM supports BL4 and BL2 (legacy mode only), default to BL4
+    burst_length = 4
+
+    device_rowbuffer_size = '2kB'
+
+    # 1x128 configuration
+    devices_per_rank = 1
+
+    # HBM does not have a CS pin, so a single rank
+    ranks_per_channel = 1
+
+    # HBM has 8 or 16 banks depending on capacity, 2 Gbit dies have 8
+    banks_per_rank = 8
+
+    # The specification does not define when bank groups are
+    # required, so do not use them for now
+    bank_groups_per_rank = 0
+
+    # 500 MHz for a 1 Gbps DDR data rate
+    tCK = '2ns'
+
+    # use the IDD measurement values from the JEDEC specification
+    tRP = '15ns'
+    tRCD = '15ns'
+    tCL = '15ns'
+    tRAS = '33ns'
+
+    # 4 beats across an x128 DDR interface translates to 2 clocks @
+    # 500 MHz
+    tBURST = '4ns'
+
+    # 2 Gbit device values from the JEDEC specification
+    tRFC = '160ns'
+    tREFI = '3.9us'
+
+    # HBM supports per-bank refresh, 2 Gbit device
+    per_bank_refresh = True
+    tRFCpb = '90ns'
+
+    # extrapolate from the LPDDR configurations
+    tWR = '18ns'
+    tRTP = '7.5ns'
+    tWTR = '10ns'
+
+    # Default same rank rd-to-wr bus turnaround to 2 CK, @500 MHz = 4 ns
+    tRTW = '4ns'
+
+    # single rank device
+    tCS = '0ns'
+
+    # 2 CK
+    tRRD = '4ns'
+
+    tXAW = '30ns'
+    activation_limit = 4
+
+    # 4 CK
+    tXP = '8ns'
+
+    # tRFC + tXP
+    tXS = '168ns'
+
+# A single HBM pseudo channel (one half of a 128-bit channel), with
+# timings based on HBM gen2 in pseudo-channel mode for a 4H stack of 8
+# Gbit dies, i.e. 4 GB of memory per stack. The two pseudo channels
+# of a channel share the command and address bus, but are otherwise
+# independent and each get their own controller, so set the number of
+# channels to 16 to model a complete stack.
+class HBM_1000_4H_x64(HBM_1000_4H_x128):
+    # 64-bit pseudo-channel interface
+    device_bus_width = 64
+
+    # HBM pseudo channels only support BL4
+    burst_length = 4
+
+    # size of a pseudo channel, 4 GB per stack with 16 pseudo channels
+    device_size = '256MB'
+
+    # the page size is halved with pseudo channels
+    device_rowbuffer_size = '1kB'
+
+    # 8 Gbit dies have 16 banks per pseudo channel in 4 bank groups
+    banks_per_rank = 16
+    bank_groups_per_rank = 4
+
+    # 4 beats across an x64 DDR interface translates to 2 clocks @
+    # 500 MHz, and bursts to the same bank group are 3 clocks apart
+    tBURST = '4ns'
+    tCCD_L = '6ns'
+
+    # RRD_S and RRD_L, 2 and 3 CK
+    tRRD = '4ns'
+    tRRD_L = '6ns'
+
+    # 8 Gbit device
+    tRFC = '350ns'
+    tRFCpb = '160ns'
+
+    # tRFC + tXP
+    tXS = '358ns'
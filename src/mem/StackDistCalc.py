@@ -45,6 +45,10 @@ class StackDistCalc(SimObject):
     # enable verification stack
     verify = Param.Bool(False, "Verify behaviuor with reference implementation")
 
+    # fraction of the addresses tracked, selected by a hash of the
+    # address, with the distances scaled to the full address stream
+    sampling_rate = Param.Float(1.0, "Fraction of addresses sampled")
+
     # linear histogram bins and enable/disable
     linear_hist_bins = Param.Unsigned('16', "Bins in linear histograms")
     disable_linear_hists = Param.Bool(False, "Disable linear histograms")
@@ -45,6 +45,13 @@ from m5.params import *
 from m5.proxy import *
 from m5.SimObject import SimObject
 
+# Arbitration between the ports waiting for a crossbar layer. Age
+# grants the port that has been waiting the longest, round robin
+# grants the next waiting port after the one last granted, and qos
+# shares the layer between the waiting ports in proportion to their
+# weights.
+class XBarArbitration(Enum): vals = ['age', 'round_robin', 'qos']
+
 class BaseXBar(MemObject):
     type = 'BaseXBar'
     abstract = True
@@ -66,6 +73,22 @@ class BaseXBar(MemObject):
     use_default_range = Param.Bool(False, "Perform address mapping for " \
                                        "the default port")
 
+    # arbitration policy used by all the layers, with the weights of
+    # the qos policy given per slave port (an empty list gives all
+    # ports the same weight), and applied to the request and snoop
+    # response layers only
+    arbitration = Param.XBarArbitration('age', "Layer arbitration policy")
+    qos_weights = VectorParam.Unsigned([], "Per slave port weights for " \
+                                           "qos arbitration")
+
+    # the per-layer distribution of the time each source port spends
+    # waiting for the layer, disabled by default as it adds a
+    # distribution per source port to every layer
+    disable_wait_time_hists = Param.Bool(True, "Disable wait time " \
+                                             "histograms")
+    wait_time_bins = Param.Unsigned(16, "# bins in wait time histograms")
+    wait_time_bucket = Param.Cycles(1, "Bucket size of wait time histograms")
+
 class NoncoherentXBar(BaseXBar):
     type = 'NoncoherentXBar'
     cxx_header = "mem/noncoherent_xbar.hh"
@@ -82,4 +105,9 @@ class SnoopFilter(SimObject):
     cxx_header = "mem/snoop_filter.hh"
     lookup_latency = Param.Cycles(3, "lookup latency (cycles)")
 
+    # the number of lines that can be tracked, lines evicted from the
+    # filter are invalidated in the caches above
+    entries = Param.Unsigned(65536, "Number of lines tracked")
+    assoc = Param.Unsigned(16, "Associativity of the filter")
+
     system = Param.System(Parent.any, "System that the crossbar belongs to.")
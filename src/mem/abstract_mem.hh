@@ -110,6 +110,10 @@ class AbstractMemory : public MemObject
     // Pointer to host memory used to implement this memory
     uint8_t* pmemAddr;
 
+    // Optional bitmap of the pages in the backing store that have
+    // been written, used for incremental checkpoints
+    uint64_t* dirtyPages;
+
     // Enable specific memories to be reported to the configuration table
     bool confTableReported;
 
@@ -215,6 +219,53 @@ class AbstractMemory : public MemObject
      */
     void setBackingStore(uint8_t* pmem_addr);
 
+    /**
+     * Granularity at which writes to the backing store are tracked.
+     */
+    static const unsigned int DirtyPageShift = 12;
+
+    /**
+     * Track the pages of the backing store that are written, by
+     * setting a bit per page in a bitmap owned by the caller. The
+     * bitmap covers the complete backing store, which may be shared
+     * with other memories.
+     *
+     * @param dirty_pages Bitmap with one bit per page, or NULL
+     */
+    void setDirtyPages(uint64_t* dirty_pages) { dirtyPages = dirty_pages; }
+
+    /**
+     * Mark the pages covered by a write as dirty, if tracking.
+     *
+     * @param host_addr Host address of the write
+     * @param size Size of the write in bytes
+     */
+    void markDirty(const uint8_t* host_addr, unsigned int size)
+    {
+        if (!dirtyPages)
+            return;
+
+        uint64_t first = (host_addr - pmemAddr) >> DirtyPageShift;
+        uint64_t last = (host_addr - pmemAddr + size - 1) >> DirtyPageShift;
+        for (uint64_t p = first; p <= last; ++p) {
+            uint64_t bit = ULL(1) << (p % 64);
+            // most writes are to pages that are already dirty, so
+            // only pay for the atomic update when the bit changes
+            if (!(dirtyPages[p / 64] & bit))
+                __atomic_fetch_or(&dirtyPages[p / 64], bit, __ATOMIC_RELAXED);
+        }
+    }
+
+    /**
+     * Translate a physical address of this memory to the host
+     * address in the backing store.
+     *
+     * @param addr Physical address within the range of this memory
+     * @return Host address, or NULL if there is no backing store
+     */
+    uint8_t* toHostAddr(Addr addr) const
+    { return pmemAddr ? pmemAddr + addr - range.start() : NULL; }
+
     /**
      * Get the list of locked addresses to allow checkpointing.
      */
@@ -0,0 +1,475 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/analytical_mem.hh"
+
+#include <algorithm>
+
+#include "base/intmath.hh"
+
+using namespace std;
+
+AnalyticalMemory::AnalyticalMemory(const AnalyticalMemoryParams* p) :
+    AbstractMemory(p),
+    port(name() + ".port", *this),
+    banks(p->ranks_per_channel * p->banks_per_rank),
+    busFreeAt(0), retryReq(false), retryEvent(this),
+    burstSize((p->devices_per_rank * p->burst_length *
+               p->device_bus_width) / 8),
+    rowBufferSize(p->devices_per_rank * p->device_rowbuffer_size),
+    columnsPerRowBuffer(rowBufferSize / burstSize),
+    columnsPerStripe(range.interleaved() ?
+                     range.granularity() / burstSize : 1),
+    ranksPerChannel(p->ranks_per_channel),
+    banksPerRank(p->banks_per_rank), channels(p->channels), rowsPerBank(0),
+    readBufferSize(p->read_buffer_size),
+    writeBufferSize(p->write_buffer_size),
+    tRCD(p->tRCD), tCL(p->tCL), tRP(p->tRP), tRAS(p->tRAS), tWR(p->tWR),
+    tBURST(p->tBURST), tRFC(p->tRFC), tREFI(p->tREFI),
+    writeTurnaround((p->tRTW + p->tWTR) / max(1u, p->min_writes_per_switch)),
+    addrMapping(p->addr_mapping), pageMgmt(p->page_policy),
+    frontendLatency(p->static_frontend_latency),
+    backendLatency(p->static_backend_latency)
+{
+    fatal_if(!isPowerOf2(burstSize), "%s: burst size %d is not a power "
+             "of two\n", name(), burstSize);
+
+    if (range.interleaved() && channels != range.stripes())
+        fatal("%s has %d interleaved address stripes but %d channel(s)\n",
+              name(), range.stripes(), channels);
+
+    // the same sizing of the rows as in the DRAMCtrl, so that the
+    // address decoding matches
+    uint64_t capacity = ULL(1) << ceilLog2(AbstractMemory::size());
+    rowsPerBank = capacity / (rowBufferSize * banksPerRank * ranksPerChannel);
+    fatal_if(rowsPerBank == 0, "%s: memory of %d bytes is too small for the "
+             "organisation\n", name(), AbstractMemory::size());
+}
+
+void
+AnalyticalMemory::init()
+{
+    AbstractMemory::init();
+
+    if (!port.isConnected()) {
+        fatal("AnalyticalMemory %s is unconnected!\n", name());
+    } else {
+        port.sendRangeChange();
+    }
+}
+
+void
+AnalyticalMemory::decodeAddr(Addr addr, unsigned int& bank_id,
+                             uint32_t& row) const
+{
+    // see DRAMCtrl::decodeAddr, with Ro, Ra, Co, Ba and Ch denoting
+    // row, rank, column, bank and channel
+    addr = addr / burstSize;
+
+    unsigned int bank;
+    unsigned int rank;
+    if (addrMapping == Enums::RoRaBaChCo) {
+        addr = addr / columnsPerRowBuffer;
+        addr = addr / channels;
+        bank = addr % banksPerRank;
+        addr = addr / banksPerRank;
+        rank = addr % ranksPerChannel;
+        addr = addr / ranksPerChannel;
+    } else if (addrMapping == Enums::RoRaBaCoCh) {
+        addr = addr / columnsPerStripe;
+        addr = addr / channels;
+        addr = addr / (columnsPerRowBuffer / columnsPerStripe);
+        bank = addr % banksPerRank;
+        addr = addr / banksPerRank;
+        rank = addr % ranksPerChannel;
+        addr = addr / ranksPerChannel;
+    } else if (addrMapping == Enums::RoCoRaBaCh) {
+        addr = addr / columnsPerStripe;
+        addr = addr / channels;
+        bank = addr % banksPerRank;
+        addr = addr / banksPerRank;
+        rank = addr % ranksPerChannel;
+        addr = addr / ranksPerChannel;
+        addr = addr / (columnsPerRowBuffer / columnsPerStripe);
+    } else {
+        panic("Unknown address mapping policy chosen!");
+    }
+
+    row = addr % rowsPerBank;
+    bank_id = rank * banksPerRank + bank;
+}
+
+Tick
+AnalyticalMemory::scheduleBurst(Addr addr, bool is_read, Tick arrival)
+{
+    unsigned int bank_id;
+    uint32_t row;
+    decodeAddr(addr, bank_id, row);
+    Bank& bank = banks[bank_id];
+
+    // all rows are closed by the refresh at the start of every
+    // refresh interval, and the bank is busy until it is done
+    if (tREFI) {
+        uint64_t epoch = arrival / tREFI;
+        if (epoch != bank.refreshEpoch) {
+            bank.refreshEpoch = epoch;
+            bank.openRow = NoRow;
+            bank.actAllowedAt = max(bank.actAllowedAt,
+                                    epoch * tREFI + tRFC);
+        }
+    }
+
+    // the time at which the column command can go out, and the time
+    // it would go out if the bank was not busy
+    Tick col_at;
+    Tick unloaded_col_at;
+    bool row_hit = bank.openRow == row;
+    if (row_hit) {
+        col_at = max(arrival, bank.colAllowedAt);
+        unloaded_col_at = arrival;
+    } else {
+        Tick act_at;
+        if (bank.openRow != NoRow) {
+            act_at = max(arrival, bank.preAllowedAt) + tRP;
+            unloaded_col_at = arrival + tRP + tRCD;
+        } else {
+            act_at = max(arrival, bank.actAllowedAt);
+            unloaded_col_at = arrival + tRCD;
+        }
+        col_at = act_at + tRCD;
+        bank.openRow = row;
+        bank.preAllowedAt = act_at + tRAS;
+    }
+
+    // the bursts go out on the bus in the order they arrive
+    Tick data_at = max(col_at + tCL, busFreeAt);
+
+    // the bus is unavailable while refreshing
+    if (tREFI && data_at % tREFI < tRFC) {
+        data_at += tRFC - data_at % tREFI;
+        ++refreshStalls;
+    }
+
+    Tick done = data_at + tBURST;
+    busFreeAt = is_read ? done : done + writeTurnaround;
+    totBusBusy += busFreeAt - data_at;
+
+    // the next column command to the same bank can follow directly
+    bank.colAllowedAt = data_at - tCL + tBURST;
+    if (!is_read)
+        bank.preAllowedAt = max(bank.preAllowedAt, done + tWR);
+
+    // with a closed page policy the row is closed right away, with
+    // the adaptive policies being treated like their base policy
+    if (pageMgmt == Enums::close || pageMgmt == Enums::close_adaptive) {
+        bank.openRow = NoRow;
+        bank.actAllowedAt = max(data_at, bank.preAllowedAt) + tRP;
+    }
+
+    if (is_read) {
+        ++readBursts;
+        if (row_hit)
+            ++readRowHits;
+        totQLat += data_at - (unloaded_col_at + tCL);
+        totMemAccLat += done - arrival;
+    } else {
+        ++writeBursts;
+        if (row_hit)
+            ++writeRowHits;
+    }
+
+    return done;
+}
+
+Tick
+AnalyticalMemory::schedulePacket(PacketPtr pkt)
+{
+    Tick arrival = curTick() + frontendLatency;
+    Addr addr = pkt->getAddr();
+    Addr end = addr + pkt->getSize();
+    Tick done = arrival;
+    for (Addr burst = addr & ~Addr(burstSize - 1); burst < end;
+         burst += burstSize)
+        done = max(done, scheduleBurst(burst, pkt->isRead(), arrival));
+    return done;
+}
+
+void
+AnalyticalMemory::retireInFlight()
+{
+    while (!readsInFlight.empty() && readsInFlight.front() <= curTick())
+        readsInFlight.pop_front();
+    while (!writesInFlight.empty() && writesInFlight.front() <= curTick())
+        writesInFlight.pop_front();
+}
+
+Tick
+AnalyticalMemory::recvAtomic(PacketPtr pkt)
+{
+    access(pkt);
+
+    Tick latency = 0;
+    if (!pkt->memInhibitAsserted() && pkt->hasData()) {
+        // as for the DRAMCtrl, this is not supposed to be accurate,
+        // just enough to keep things going, mimic a closed page
+        latency = tRP + tRCD + tCL;
+    }
+    return latency;
+}
+
+void
+AnalyticalMemory::recvFunctional(PacketPtr pkt)
+{
+    pkt->pushLabel(name());
+
+    functionalAccess(pkt);
+
+    // potentially update the packets in our response queue as well
+    port.checkFunctional(pkt);
+
+    pkt->popLabel();
+}
+
+bool
+AnalyticalMemory::recvTimingReq(PacketPtr pkt)
+{
+    /// @todo temporary hack to deal with memory corruption issues until
+    /// 4-phase transactions are complete
+    for (int x = 0; x < pendingDelete.size(); x++)
+        delete pendingDelete[x];
+    pendingDelete.clear();
+
+    if (pkt->memInhibitAsserted()) {
+        pendingDelete.push_back(pkt);
+        return true;
+    }
+
+    if (retryReq)
+        return false;
+
+    // reads hold on to their buffer entry until the data is on the
+    // bus, and writes until they are written
+    retireInFlight();
+    std::deque<Tick>& in_flight = pkt->isRead() ? readsInFlight :
+        writesInFlight;
+    if (pkt->isRead() || pkt->isWrite()) {
+        unsigned int limit = pkt->isRead() ? readBufferSize :
+            writeBufferSize;
+        if (in_flight.size() >= limit) {
+            if (pkt->isRead())
+                ++numRdRetry;
+            else
+                ++numWrRetry;
+            retryReq = true;
+            if (!retryEvent.scheduled())
+                schedule(retryEvent, in_flight.front());
+            return false;
+        }
+    }
+
+    Tick response_at;
+    if (pkt->isRead() || pkt->isWrite()) {
+        Tick done = schedulePacket(pkt);
+        in_flight.push_back(done);
+        // writes are acknowledged as soon as they are accepted
+        response_at = pkt->isRead() ? done + backendLatency :
+            curTick() + frontendLatency;
+    } else {
+        response_at = curTick() + 1;
+    }
+
+    bool needs_response = pkt->needsResponse();
+    access(pkt);
+
+    if (needs_response) {
+        assert(pkt->isResponse());
+
+        // @todo someone should pay for this
+        pkt->headerDelay = pkt->payloadDelay = 0;
+
+        port.schedTimingResp(pkt, response_at);
+    } else {
+        pendingDelete.push_back(pkt);
+    }
+
+    return true;
+}
+
+void
+AnalyticalMemory::processRetryEvent()
+{
+    assert(retryReq);
+    retryReq = false;
+    port.sendRetry();
+}
+
+BaseSlavePort&
+AnalyticalMemory::getSlavePort(const string &if_name, PortID idx)
+{
+    if (if_name != "port") {
+        return MemObject::getSlavePort(if_name, idx);
+    } else {
+        return port;
+    }
+}
+
+unsigned int
+AnalyticalMemory::drain(DrainManager *dm)
+{
+    // the responses are all in the port, and the bank and bus state
+    // only refers to the future
+    unsigned int count = port.drain(dm);
+
+    if (count)
+        setDrainState(Drainable::Draining);
+    else
+        setDrainState(Drainable::Drained);
+    return count;
+}
+
+void
+AnalyticalMemory::regStats()
+{
+    using namespace Stats;
+
+    AbstractMemory::regStats();
+
+    readBursts
+        .name(name() + ".readBursts")
+        .desc("Number of DRAM read bursts");
+
+    writeBursts
+        .name(name() + ".writeBursts")
+        .desc("Number of DRAM write bursts");
+
+    readRowHits
+        .name(name() + ".readRowHits")
+        .desc("Number of row buffer hits during reads");
+
+    writeRowHits
+        .name(name() + ".writeRowHits")
+        .desc("Number of row buffer hits during writes");
+
+    readRowHitRate
+        .name(name() + ".readRowHitRate")
+        .desc("Row buffer hit rate for reads")
+        .precision(2);
+
+    readRowHitRate = (readRowHits / readBursts) * 100;
+
+    writeRowHitRate
+        .name(name() + ".writeRowHitRate")
+        .desc("Row buffer hit rate for writes")
+        .precision(2);
+
+    writeRowHitRate = (writeRowHits / writeBursts) * 100;
+
+    refreshStalls
+        .name(name() + ".refreshStalls")
+        .desc("Number of bursts delayed by a refresh");
+
+    numRdRetry
+        .name(name() + ".numRdRetry")
+        .desc("Number of times read queue was full causing retry");
+
+    numWrRetry
+        .name(name() + ".numWrRetry")
+        .desc("Number of times write queue was full causing retry");
+
+    totQLat
+        .name(name() + ".totQLat")
+        .desc("Total ticks spent queuing");
+
+    totMemAccLat
+        .name(name() + ".totMemAccLat")
+        .desc("Total ticks spent from burst creation until serviced "
+              "by the DRAM");
+
+    avgQLat
+        .name(name() + ".avgQLat")
+        .desc("Average queueing delay per DRAM burst")
+        .precision(2);
+
+    avgQLat = totQLat / readBursts;
+
+    avgMemAccLat
+        .name(name() + ".avgMemAccLat")
+        .desc("Average memory access latency per DRAM burst")
+        .precision(2);
+
+    avgMemAccLat = totMemAccLat / readBursts;
+
+    totBusBusy
+        .name(name() + ".totBusBusy")
+        .desc("Total ticks the data bus is busy, including turnarounds");
+
+    busUtil
+        .name(name() + ".busUtil")
+        .desc("Data bus utilization in percentage")
+        .precision(2);
+
+    busUtil = totBusBusy / simTicks * 100;
+}
+
+AnalyticalMemory::MemoryPort::MemoryPort(const std::string& name,
+                                         AnalyticalMemory& _memory)
+    : QueuedSlavePort(name, &_memory, queue), queue(_memory, *this),
+      memory(_memory)
+{ }
+
+AddrRangeList
+AnalyticalMemory::MemoryPort::getAddrRanges() const
+{
+    AddrRangeList ranges;
+    ranges.push_back(memory.getAddrRange());
+    return ranges;
+}
+
+void
+AnalyticalMemory::MemoryPort::recvFunctional(PacketPtr pkt)
+{
+    memory.recvFunctional(pkt);
+}
+
+Tick
+AnalyticalMemory::MemoryPort::recvAtomic(PacketPtr pkt)
+{
+    return memory.recvAtomic(pkt);
+}
+
+bool
+AnalyticalMemory::MemoryPort::recvTimingReq(PacketPtr pkt)
+{
+    return memory.recvTimingReq(pkt);
+}
+
+AnalyticalMemory*
+AnalyticalMemoryParams::create()
+{
+    return new AnalyticalMemory(this);
+}
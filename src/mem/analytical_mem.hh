@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * AnalyticalMemory declaration
+ */
+
+#ifndef __MEM_ANALYTICAL_MEM_HH__
+#define __MEM_ANALYTICAL_MEM_HH__
+
+#include <deque>
+#include <vector>
+
+#include "base/statistics.hh"
+#include "enums/AddrMap.hh"
+#include "enums/PageManage.hh"
+#include "mem/abstract_mem.hh"
+#include "mem/qport.hh"
+#include "params/AnalyticalMemory.hh"
+
+/**
+ * A memory controller model that sits between the SimpleMemory and
+ * the DRAMCtrl in terms of cost and accuracy. Rather than queueing
+ * requests and scheduling DRAM commands, every burst is assigned its
+ * slot on the data bus the moment it arrives, based on a handful of
+ * timestamps per bank and for the channel as a whole. The channel
+ * thus behaves as a first-come first-served queue with a
+ * deterministic service time (the burst duration) fed by the actual
+ * arrival process, which for Poisson arrivals is the M/D/1 queue,
+ * and each bank tracks its open row to determine whether an access
+ * pays for a precharge and activate. Refresh closes all rows and
+ * blocks the bus for tRFC every tREFI, and write-to-read turnarounds
+ * are amortised over the writes as if they were drained in batches.
+ *
+ * Responses are scheduled as soon as the burst is placed, so apart
+ * from the response itself no events are needed. Compared to the
+ * DRAMCtrl, there is no reordering of hits before misses, no
+ * read-after-write forwarding from the write queue, and no
+ * activation window or power modelling.
+ */
+class AnalyticalMemory : public AbstractMemory
+{
+
+  private:
+
+    class MemoryPort : public QueuedSlavePort
+    {
+
+        SlavePacketQueue queue;
+        AnalyticalMemory& memory;
+
+      public:
+
+        MemoryPort(const std::string& name, AnalyticalMemory& _memory);
+
+      protected:
+
+        Tick recvAtomic(PacketPtr pkt);
+
+        void recvFunctional(PacketPtr pkt);
+
+        bool recvTimingReq(PacketPtr pkt);
+
+        AddrRangeList getAddrRanges() const;
+
+    };
+
+    MemoryPort port;
+
+    /** Row value used for banks that have no open row. */
+    static const uint32_t NoRow = -1;
+
+    /**
+     * The timing state of a bank, i.e. the open row and the earliest
+     * time the next command of each kind may be issued.
+     */
+    struct Bank
+    {
+        uint32_t openRow;
+        Tick colAllowedAt;
+        Tick preAllowedAt;
+        Tick actAllowedAt;
+
+        /** Refresh interval the state was last updated in */
+        uint64_t refreshEpoch;
+
+        Bank() : openRow(NoRow), colAllowedAt(0), preAllowedAt(0),
+                 actAllowedAt(0), refreshEpoch(0)
+        { }
+    };
+
+    std::vector<Bank> banks;
+
+    /** Time the data bus is free for the next burst. */
+    Tick busFreeAt;
+
+    /**
+     * Completion times of the reads and writes that occupy the read
+     * and write buffers. As the bus is first-come first-served these
+     * are in ascending order.
+     */
+    std::deque<Tick> readsInFlight;
+    std::deque<Tick> writesInFlight;
+
+    /** Remember that a request was rejected and needs a retry. */
+    bool retryReq;
+
+    /**
+     * Let the requester retry once a buffer entry is freed.
+     */
+    void processRetryEvent();
+
+    EventWrapper<AnalyticalMemory,
+                 &AnalyticalMemory::processRetryEvent> retryEvent;
+
+    /**
+     * Organisation of the memory, see DRAMCtrl for the details.
+     */
+    const uint32_t burstSize;
+    const uint32_t rowBufferSize;
+    const uint32_t columnsPerRowBuffer;
+    const uint32_t columnsPerStripe;
+    const uint32_t ranksPerChannel;
+    const uint32_t banksPerRank;
+    const uint32_t channels;
+    uint32_t rowsPerBank;
+    const uint32_t readBufferSize;
+    const uint32_t writeBufferSize;
+
+    /**
+     * Timing of the memory, see DRAMCtrl for the details.
+     */
+    const Tick tRCD;
+    const Tick tCL;
+    const Tick tRP;
+    const Tick tRAS;
+    const Tick tWR;
+    const Tick tBURST;
+    const Tick tRFC;
+    const Tick tREFI;
+
+    /**
+     * Bus turnaround cost charged to every write burst, i.e. a
+     * read-to-write and write-to-read switch shared by the writes
+     * drained between two switches.
+     */
+    const Tick writeTurnaround;
+
+    const Enums::AddrMap addrMapping;
+    const Enums::PageManage pageMgmt;
+
+    const Tick frontendLatency;
+    const Tick backendLatency;
+
+    /**
+     * Decode an address to the bank (across all ranks) and row it
+     * maps to, in the same way as the DRAMCtrl.
+     */
+    void decodeAddr(Addr addr, unsigned int& bank_id, uint32_t& row) const;
+
+    /**
+     * Place a single burst on the bus and update the bank state.
+     *
+     * @param addr Address of the burst
+     * @param is_read Whether the burst is a read or a write
+     * @param arrival Time the burst is ready to be scheduled
+     * @return Time the burst completes on the data bus
+     */
+    Tick scheduleBurst(Addr addr, bool is_read, Tick arrival);
+
+    /**
+     * Place all the bursts of a packet.
+     *
+     * @return Time the last burst completes on the data bus
+     */
+    Tick schedulePacket(PacketPtr pkt);
+
+    /**
+     * Drop the buffer entries of accesses that are completed.
+     */
+    void retireInFlight();
+
+    /** @todo see SimpleMemory */
+    std::vector<PacketPtr> pendingDelete;
+
+    // Statistics
+    Stats::Scalar readBursts;
+    Stats::Scalar writeBursts;
+    Stats::Scalar readRowHits;
+    Stats::Scalar writeRowHits;
+    Stats::Scalar refreshStalls;
+    Stats::Scalar numRdRetry;
+    Stats::Scalar numWrRetry;
+    Stats::Scalar totQLat;
+    Stats::Scalar totMemAccLat;
+    Stats::Scalar totBusBusy;
+    Stats::Formula readRowHitRate;
+    Stats::Formula writeRowHitRate;
+    Stats::Formula avgQLat;
+    Stats::Formula avgMemAccLat;
+    Stats::Formula busUtil;
+
+  protected:
+
+    Tick recvAtomic(PacketPtr pkt);
+
+    void recvFunctional(PacketPtr pkt);
+
+    bool recvTimingReq(PacketPtr pkt);
+
+  public:
+
+    AnalyticalMemory(const AnalyticalMemoryParams* p);
+
+    unsigned int drain(DrainManager* dm);
+
+    BaseSlavePort& getSlavePort(const std::string& if_name,
+                                PortID idx = InvalidPortID);
+
+    void init();
+
+    void regStats();
+
+};
+
+#endif //__MEM_ANALYTICAL_MEM_HH__
@@ -48,10 +48,12 @@
  * and a slave through a request and response queue.
  */
 
+#include "base/callback.hh"
 #include "base/trace.hh"
 #include "debug/Bridge.hh"
 #include "mem/bridge.hh"
 #include "params/Bridge.hh"
+#include "sim/global_event.hh"
 
 Bridge::BridgeSlavePort::BridgeSlavePort(const std::string& _name,
                                          Bridge& _bridge,
@@ -61,7 +63,8 @@ Bridge::BridgeSlavePort::BridgeSlavePort(const std::string& _name,
     : SlavePort(_name, &_bridge), bridge(_bridge), masterPort(_masterPort),
       delay(_delay), ranges(_ranges.begin(), _ranges.end()),
       outstandingResponses(0), retryReq(false),
-      respQueueLimit(_resp_limit), sendEvent(*this)
+      respQueueLimit(_resp_limit), reqCredits(0), sendEvent(*this),
+      retryEvent(*this)
 {
 }
 
@@ -70,7 +73,8 @@ Bridge::BridgeMasterPort::BridgeMasterPort(const std::string& _name,
                                            BridgeSlavePort& _slavePort,
                                            Cycles _delay, int _req_limit)
     : MasterPort(_name, &_bridge), bridge(_bridge), slavePort(_slavePort),
-      delay(_delay), reqQueueLimit(_req_limit), sendEvent(*this)
+      delay(_delay), reqQueueLimit(_req_limit),
+      sendQueue(_bridge.eventQueue()), freedCredits(0), sendEvent(*this)
 {
 }
 
@@ -79,8 +83,21 @@ Bridge::Bridge(Params *p)
       slavePort(p->name + ".slave", *this, masterPort,
                 ticksToCycles(p->delay), p->resp_size, p->ranges),
       masterPort(p->name + ".master", *this, slavePort,
-                 ticksToCycles(p->delay), p->req_size)
+                 ticksToCycles(p->delay), p->req_size),
+      quantumSync(p->quantum_sync)
 {
+    if (p->mem_side_eventq_index >= 0) {
+        if (!quantumSync)
+            fatal("Bridge %s: the master side can only use a separate "
+                  "event queue when quantum_sync is set\n", name());
+        masterPort.sendQueue = getEventQueue(p->mem_side_eventq_index);
+    }
+
+    if (quantumSync) {
+        slavePort.reqCredits = p->req_size;
+        registerQuantumCallback(
+            new MakeCallback<Bridge, &Bridge::exchange>(this));
+    }
 }
 
 BaseMasterPort&
@@ -110,10 +127,52 @@ Bridge::init()
     if (!slavePort.isConnected() || !masterPort.isConnected())
         fatal("Both ports of a bridge must be connected.\n");
 
+    if (quantumSync && simQuantum == 0)
+        fatal("Bridge %s: quantum_sync requires a simulation quantum\n",
+              name());
+
     // notify the master side  of our address ranges
     slavePort.sendRangeChange();
 }
 
+void
+Bridge::exchange()
+{
+    // requests accepted on the slave side move to the request queue,
+    // packets that were due before the quantum ended are sent right
+    // away as they cannot be delivered in the past of the other side
+    while (!slavePort.reqOutbox.empty()) {
+        DeferredPacket req = slavePort.reqOutbox.front();
+        masterPort.schedTimingReq(req.pkt, std::max(req.tick, curTick()));
+        slavePort.reqOutbox.pop_front();
+    }
+
+    // snoop responses received on the slave side share the request
+    // queue, but do not take a request slot
+    while (!slavePort.snoopRespOutbox.empty()) {
+        DeferredPacket resp = slavePort.snoopRespOutbox.front();
+        masterPort.schedTimingReq(resp.pkt, std::max(resp.tick, curTick()),
+                                  true);
+        slavePort.snoopRespOutbox.pop_front();
+    }
+
+    // responses received on the master side move to the response queue
+    while (!masterPort.respOutbox.empty()) {
+        DeferredPacket resp = masterPort.respOutbox.front();
+        slavePort.schedTimingResp(resp.pkt, std::max(resp.tick, curTick()));
+        masterPort.respOutbox.pop_front();
+    }
+
+    // return the request queue slots freed during the quantum, and
+    // wake up a stalled request on the slave side if there is one
+    slavePort.reqCredits += masterPort.freedCredits;
+    masterPort.freedCredits = 0;
+
+    if (slavePort.retryReq && !slavePort.reqQueueFull() &&
+        !slavePort.retryEvent.scheduled())
+        schedule(slavePort.retryEvent, curTick());
+}
+
 bool
 Bridge::BridgeSlavePort::respQueueFull() const
 {
@@ -126,6 +185,12 @@ Bridge::BridgeMasterPort::reqQueueFull() const
     return transmitList.size() == reqQueueLimit;
 }
 
+bool
+Bridge::BridgeSlavePort::reqQueueFull() const
+{
+    return bridge.quantumSync ? reqCredits == 0 : masterPort.reqQueueFull();
+}
+
 bool
 Bridge::BridgeMasterPort::recvTimingResp(PacketPtr pkt)
 {
@@ -139,7 +204,33 @@ Bridge::BridgeMasterPort::recvTimingResp(PacketPtr pkt)
     // @todo: We need to pay for this and not just zero it out
     pkt->headerDelay = pkt->payloadDelay = 0;
 
-    slavePort.schedTimingResp(pkt, bridge.clockEdge(delay));
+    if (bridge.quantumSync) {
+        // this side may run on another thread than the bridge's
+        // clock, so do not touch the clocked state here
+        respOutbox.push_back(DeferredPacket(pkt, curTick() +
+                                            delay * bridge.clockPeriod()));
+    } else {
+        slavePort.schedTimingResp(pkt, bridge.clockEdge(delay));
+    }
+
+    return true;
+}
+
+bool
+Bridge::BridgeSlavePort::recvTimingSnoopResp(PacketPtr pkt)
+{
+    // we only snoop when synchronising at quantum boundaries
+    assert(bridge.quantumSync);
+
+    DPRINTF(Bridge, "recvTimingSnoopResp: %s addr 0x%x\n",
+            pkt->cmdString(), pkt->getAddr());
+
+    // @todo: We need to pay for this and not just zero it out
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    // the snoop request was not counted against our response queue,
+    // so there is nothing to reserve here
+    snoopRespOutbox.push_back(DeferredPacket(pkt, bridge.clockEdge(delay)));
 
     return true;
 }
@@ -157,7 +248,7 @@ Bridge::BridgeSlavePort::recvTimingReq(PacketPtr pkt)
             transmitList.size(), outstandingResponses);
 
     // if the request queue is full then there is no hope
-    if (masterPort.reqQueueFull()) {
+    if (reqQueueFull()) {
         DPRINTF(Bridge, "Request queue full\n");
         retryReq = true;
     } else {
@@ -183,7 +274,13 @@ Bridge::BridgeSlavePort::recvTimingReq(PacketPtr pkt)
             // @todo: We need to pay for this and not just zero it out
             pkt->headerDelay = pkt->payloadDelay = 0;
 
-            masterPort.schedTimingReq(pkt, bridge.clockEdge(delay));
+            if (bridge.quantumSync) {
+                --reqCredits;
+                reqOutbox.push_back(DeferredPacket(pkt,
+                                                   bridge.clockEdge(delay)));
+            } else {
+                masterPort.schedTimingReq(pkt, bridge.clockEdge(delay));
+            }
         }
     }
 
@@ -205,19 +302,22 @@ Bridge::BridgeSlavePort::retryStalledReq()
 }
 
 void
-Bridge::BridgeMasterPort::schedTimingReq(PacketPtr pkt, Tick when)
+Bridge::BridgeMasterPort::schedTimingReq(PacketPtr pkt, Tick when,
+                                         bool send_as_snoop)
 {
     // If we're about to put this packet at the head of the queue, we
     // need to schedule an event to do the transmit.  Otherwise there
     // should already be an event scheduled for sending the head
     // packet.
     if (transmitList.empty()) {
-        bridge.schedule(sendEvent, when);
+        sendQueue->schedule(&sendEvent, when);
     }
 
-    assert(transmitList.size() != reqQueueLimit);
+    // with quantum_sync the credits of the slave side bound the
+    // requests, and the snoop responses come on top of them
+    assert(bridge.quantumSync || transmitList.size() != reqQueueLimit);
 
-    transmitList.push_back(DeferredPacket(pkt, when));
+    transmitList.push_back(DeferredPacket(pkt, when, send_as_snoop));
 }
 
 
@@ -249,7 +349,8 @@ Bridge::BridgeMasterPort::trySendTiming()
     DPRINTF(Bridge, "trySend request addr 0x%x, queue size %d\n",
             pkt->getAddr(), transmitList.size());
 
-    if (sendTimingReq(pkt)) {
+    bool snoop_resp = req.sendAsSnoop;
+    if (snoop_resp ? sendTimingSnoopResp(pkt) : sendTimingReq(pkt)) {
         // send successful
         transmitList.pop_front();
         DPRINTF(Bridge, "trySend request successful\n");
@@ -258,15 +359,31 @@ Bridge::BridgeMasterPort::trySendTiming()
         if (!transmitList.empty()) {
             DeferredPacket next_req = transmitList.front();
             DPRINTF(Bridge, "Scheduling next send\n");
-            bridge.schedule(sendEvent, std::max(next_req.tick,
-                                                bridge.clockEdge()));
+            if (bridge.quantumSync) {
+                sendQueue->schedule(&sendEvent, std::max(next_req.tick,
+                                                         curTick()));
+            } else {
+                bridge.schedule(sendEvent, std::max(next_req.tick,
+                                                    bridge.clockEdge()));
+            }
         }
 
-        // if we have stalled a request due to a full request queue,
-        // then send a retry at this point, also note that if the
-        // request we stalled was waiting for the response queue
-        // rather than the request queue we might stall it again
-        slavePort.retryStalledReq();
+        // snoop responses do not take a request slot
+        if (snoop_resp) {
+            return;
+        }
+
+        if (bridge.quantumSync) {
+            // the slot is handed back to the slave side at the next
+            // quantum boundary, which also takes care of any retry
+            ++freedCredits;
+        } else {
+            // if we have stalled a request due to a full request queue,
+            // then send a retry at this point, also note that if the
+            // request we stalled was waiting for the response queue
+            // rather than the request queue we might stall it again
+            slavePort.retryStalledReq();
+        }
     }
 
     // if the send failed, then we try again once we receive a retry,
@@ -306,7 +423,7 @@ Bridge::BridgeSlavePort::trySendTiming()
         // if there is space in the request queue and we were stalling
         // a request, it will definitely be possible to accept it now
         // since there is guaranteed space in the response queue
-        if (!masterPort.reqQueueFull() && retryReq) {
+        if (!reqQueueFull() && retryReq) {
             DPRINTF(Bridge, "Request waiting for retry, now retrying\n");
             retryReq = false;
             sendRetry();
@@ -329,9 +446,80 @@ Bridge::BridgeSlavePort::recvRetry()
     trySendTiming();
 }
 
+bool
+Bridge::BridgeMasterPort::isSnooping() const
+{
+    return bridge.quantumSync && slavePort.isSnooping();
+}
+
+bool
+Bridge::BridgeMasterPort::slaveSideRemote() const
+{
+    return bridge.quantumSync && inParallelMode &&
+        bridge.eventQueue() != curEventQueue();
+}
+
+void
+Bridge::BridgeMasterPort::recvTimingSnoopReq(PacketPtr pkt)
+{
+    DPRINTF(Bridge, "recvTimingSnoopReq: %s addr 0x%x\n",
+            pkt->cmdString(), pkt->getAddr());
+
+    // the snooper has to assert any ownership or sharing before the
+    // snooping crossbar carries on, so the snoop cannot wait for the
+    // next quantum boundary, any response it causes does
+    if (slaveSideRemote()) {
+        EventQueue::ScopedMigration migrate(bridge.eventQueue());
+        slavePort.sendTimingSnoopReq(pkt);
+    } else {
+        slavePort.sendTimingSnoopReq(pkt);
+    }
+}
+
+Tick
+Bridge::BridgeMasterPort::recvAtomicSnoop(PacketPtr pkt)
+{
+    if (slaveSideRemote()) {
+        EventQueue::ScopedMigration migrate(bridge.eventQueue());
+        return delay * bridge.clockPeriod() + slavePort.sendAtomicSnoop(pkt);
+    }
+
+    return delay * bridge.clockPeriod() + slavePort.sendAtomicSnoop(pkt);
+}
+
+void
+Bridge::BridgeMasterPort::recvFunctionalSnoop(PacketPtr pkt)
+{
+    // packets queued on their way down, e.g. writebacks, may hold
+    // newer data than the memory below
+    if (checkFunctional(pkt))
+        return;
+
+    if (slaveSideRemote()) {
+        EventQueue::ScopedMigration migrate(bridge.eventQueue());
+        if (!slavePort.checkOutboxes(pkt))
+            slavePort.sendFunctionalSnoop(pkt);
+    } else {
+        if (!slavePort.checkOutboxes(pkt))
+            slavePort.sendFunctionalSnoop(pkt);
+    }
+}
+
+bool
+Bridge::BridgeSlavePort::masterSideRemote() const
+{
+    return bridge.quantumSync && inParallelMode &&
+        masterPort.sendQueue != curEventQueue();
+}
+
 Tick
 Bridge::BridgeSlavePort::recvAtomic(PacketPtr pkt)
 {
+    if (masterSideRemote()) {
+        EventQueue::ScopedMigration migrate(masterPort.sendQueue);
+        return delay * bridge.clockPeriod() + masterPort.sendAtomic(pkt);
+    }
+
     return delay * bridge.clockPeriod() + masterPort.sendAtomic(pkt);
 }
 
@@ -348,7 +536,45 @@ Bridge::BridgeSlavePort::recvFunctional(PacketPtr pkt)
         }
     }
 
-    // also check the master port's request queue
+    // also check the packets still waiting for the next quantum
+    // boundary
+    if (checkOutboxes(pkt))
+        return;
+
+    // the rest of the access touches the master side, which may be
+    // simulated by another thread
+    if (masterSideRemote()) {
+        EventQueue::ScopedMigration migrate(masterPort.sendQueue);
+        forwardFunctional(pkt);
+    } else {
+        forwardFunctional(pkt);
+    }
+}
+
+bool
+Bridge::BridgeSlavePort::checkOutboxes(PacketPtr pkt)
+{
+    for (auto i = reqOutbox.begin(); i != reqOutbox.end(); ++i) {
+        if (pkt->checkFunctional((*i).pkt)) {
+            pkt->makeResponse();
+            return true;
+        }
+    }
+
+    for (auto i = snoopRespOutbox.begin(); i != snoopRespOutbox.end(); ++i) {
+        if (pkt->checkFunctional((*i).pkt)) {
+            pkt->makeResponse();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+Bridge::BridgeSlavePort::forwardFunctional(PacketPtr pkt)
+{
+    // check the master port's request queue
     if (masterPort.checkFunctional(pkt)) {
         return;
     }
@@ -373,6 +599,17 @@ Bridge::BridgeMasterPort::checkFunctional(PacketPtr pkt)
         ++i;
     }
 
+    // also check the responses still waiting for the next quantum
+    // boundary
+    i = respOutbox.begin();
+    while (i != respOutbox.end() && !found) {
+        if (pkt->checkFunctional((*i).pkt)) {
+            pkt->makeResponse();
+            found = true;
+        }
+        ++i;
+    }
+
     return found;
 }
 
@@ -69,6 +69,28 @@
  * before forwarding the request. If there is no space present, then
  * the bridge will delay accepting the packet until space becomes
  * available.
+ *
+ * With quantum_sync set, the two sides of the bridge only exchange
+ * packets and request-queue credits at quantum boundaries (see
+ * registerQuantumCallback()), and the master side may live on a
+ * different event queue than the slave side.  This lets the bridge
+ * join parts of the system that are simulated by different host
+ * threads without any locking in the timing path.  A packet that
+ * would reach the other side before the end of the quantum in which
+ * it was sent is delivered at the quantum boundary instead, so the
+ * quantum bounds the extra latency and should be kept short.  Atomic
+ * and functional accesses that cross to another thread temporarily
+ * take over the event queue of the master side, like the KVM CPU does
+ * for device accesses, which keeps them safe at the expense of
+ * determinism.
+ *
+ * A quantum-synchronised bridge also forwards snoops when the slave
+ * side is connected to a snooping master, e.g. a coherent crossbar
+ * with private caches above it, so that such caches are kept
+ * coherent with the rest of the system. Snoop requests have to be
+ * answered immediately, and are passed to the slave side by taking
+ * over its event queue in the same way. Snoop responses go back
+ * across the bridge at quantum boundaries, like other responses.
  */
 class Bridge : public MemObject
 {
@@ -85,8 +107,10 @@ class Bridge : public MemObject
 
         const Tick tick;
         const PacketPtr pkt;
+        const bool sendAsSnoop; ///< Is it a snoop response
 
-        DeferredPacket(PacketPtr _pkt, Tick _tick) : tick(_tick), pkt(_pkt)
+        DeferredPacket(PacketPtr _pkt, Tick _tick, bool send_as_snoop = false)
+            : tick(_tick), pkt(_pkt), sendAsSnoop(send_as_snoop)
         { }
     };
 
@@ -102,6 +126,8 @@ class Bridge : public MemObject
     class BridgeSlavePort : public SlavePort
     {
 
+        friend class Bridge;
+
       private:
 
         /** The bridge to which this port belongs. */
@@ -135,6 +161,24 @@ class Bridge : public MemObject
         /** Max queue size for reserved responses. */
         unsigned int respQueueLimit;
 
+        /**
+         * Free request queue slots as known to this side, only used
+         * when the bridge synchronises at quantum boundaries.
+         */
+        unsigned int reqCredits;
+
+        /**
+         * Requests accepted during the current quantum, handed to the
+         * master side at the next quantum boundary.
+         */
+        std::deque<DeferredPacket> reqOutbox;
+
+        /**
+         * Snoop responses received during the current quantum, handed
+         * to the master side at the next quantum boundary.
+         */
+        std::deque<DeferredPacket> snoopRespOutbox;
+
         /**
          * Is this side blocked from accepting new response packets.
          *
@@ -142,6 +186,14 @@ class Bridge : public MemObject
          */
         bool respQueueFull() const;
 
+        /**
+         * Is there no space left on the master side for another
+         * request.
+         *
+         * @return true if a new request cannot be accepted
+         */
+        bool reqQueueFull() const;
+
         /**
          * Handle send event, scheduled when the packet at the head of
          * the response queue is ready to transmit (for timing
@@ -185,6 +237,39 @@ class Bridge : public MemObject
          */
         void retryStalledReq();
 
+      private:
+
+        /** Event to retry a stalled request once credits are returned. */
+        EventWrapper<BridgeSlavePort,
+                     &BridgeSlavePort::retryStalledReq> retryEvent;
+
+        /**
+         * Is the master side simulated by another thread than the
+         * one currently executing, in which case atomic and
+         * functional accesses have to migrate to its event queue.
+         *
+         * @return true if the master side is on another thread
+         */
+        bool masterSideRemote() const;
+
+        /**
+         * Check a functional request against the master side and
+         * forward it if it is not satisfied there.
+         *
+         * @param pkt functional request to forward
+         */
+        void forwardFunctional(PacketPtr pkt);
+
+        /**
+         * Check a functional request against the packets waiting for
+         * the next quantum boundary on this side.
+         *
+         * @param pkt packet to check against
+         *
+         * @return true if we find a match
+         */
+        bool checkOutboxes(PacketPtr pkt);
+
       protected:
 
         /** When receiving a timing request from the peer port,
@@ -195,6 +280,10 @@ class Bridge : public MemObject
             pass it to the bridge. */
         void recvRetry();
 
+        /** When receiving a timing snoop response from the peer port,
+            hold it until the next quantum boundary. */
+        bool recvTimingSnoopResp(PacketPtr pkt);
+
         /** When receiving a Atomic requestfrom the peer port,
             pass it to the bridge. */
         Tick recvAtomic(PacketPtr pkt);
@@ -217,6 +306,8 @@ class Bridge : public MemObject
     class BridgeMasterPort : public MasterPort
     {
 
+        friend class Bridge;
+
       private:
 
         /** The bridge to which this port belongs. */
@@ -241,6 +332,21 @@ class Bridge : public MemObject
         /** Max queue size for request packets */
         const unsigned int reqQueueLimit;
 
+        /** Event queue the sending side of this port runs on. */
+        EventQueue *sendQueue;
+
+        /**
+         * Responses received during the current quantum, handed to
+         * the slave side at the next quantum boundary.
+         */
+        std::deque<DeferredPacket> respOutbox;
+
+        /**
+         * Request queue slots freed during the current quantum, handed
+         * back to the slave side at the next quantum boundary.
+         */
+        unsigned int freedCredits;
+
         /**
          * Handle send event, scheduled when the packet at the head of
          * the outbound queue is ready to transmit (for timing
@@ -280,12 +386,15 @@ class Bridge : public MemObject
          *
          * @param pkt a request to send out after a delay
          * @param when tick when response packet should be sent
+         * @param send_as_snoop send the packet as a snoop response
          */
-        void schedTimingReq(PacketPtr pkt, Tick when);
+        void schedTimingReq(PacketPtr pkt, Tick when,
+                            bool send_as_snoop = false);
 
         /**
          * Check a functional request against the packets in our
-         * request queue.
+         * request queue, and the responses waiting for the next
+         * quantum boundary.
          *
          * @param pkt packet to check against
          *
@@ -293,6 +402,17 @@ class Bridge : public MemObject
          */
         bool checkFunctional(PacketPtr pkt);
 
+      private:
+
+        /**
+         * Is the slave side simulated by another thread than the one
+         * currently executing, in which case snoops have to migrate
+         * to its event queue.
+         *
+         * @return true if the slave side is on another thread
+         */
+        bool slaveSideRemote() const;
+
       protected:
 
         /** When receiving a timing request from the peer port,
@@ -302,6 +422,23 @@ class Bridge : public MemObject
         /** When receiving a retry request from the peer port,
             pass it to the bridge. */
         void recvRetry();
+
+        /** Snoop on behalf of the slave side if the master connected
+            to it snoops, which needs a quantum-synchronised bridge. */
+        bool isSnooping() const;
+
+        /** When receiving a timing snoop request from the peer port,
+            pass it to the slave side straight away. */
+        void recvTimingSnoopReq(PacketPtr pkt);
+
+        /** When receiving an atomic snoop request from the peer port,
+            pass it to the slave side. */
+        Tick recvAtomicSnoop(PacketPtr pkt);
+
+        /** When receiving a functional snoop request from the peer
+            port, check the queued packets and pass it to the slave
+            side. */
+        void recvFunctionalSnoop(PacketPtr pkt);
     };
 
     /** Slave port of the bridge. */
@@ -310,6 +447,16 @@ class Bridge : public MemObject
     /** Master port of the bridge. */
     BridgeMasterPort masterPort;
 
+    /** Are the two sides only synchronised at quantum boundaries. */
+    const bool quantumSync;
+
+    /**
+     * Move the packets and credits accumulated during the last
+     * quantum across the bridge. Called at every quantum boundary
+     * when quantumSync is set.
+     */
+    void exchange();
+
   public:
 
     virtual BaseMasterPort& getMasterPort(const std::string& if_name,
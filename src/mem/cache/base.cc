@@ -47,9 +47,13 @@
 
 #include "debug/Cache.hh"
 #include "debug/Drain.hh"
+#include "mem/cache/tags/dip.hh"
 #include "mem/cache/tags/fa_lru.hh"
 #include "mem/cache/tags/lru.hh"
 #include "mem/cache/tags/random_repl.hh"
+#include "mem/cache/tags/rrip.hh"
+#include "mem/cache/tags/ship.hh"
+#include "mem/cache/tags/tree_plru.hh"
 #include "mem/cache/base.hh"
 #include "mem/cache/cache.hh"
 #include "mem/cache/mshr.hh"
@@ -68,9 +72,10 @@ BaseCache::CacheSlavePort::CacheSlavePort(const std::string &_name,
 BaseCache::BaseCache(const Params *p)
     : MemObject(p),
       cpuSidePort(nullptr), memSidePort(nullptr),
-      mshrQueue("MSHRs", p->mshrs, 4, p->demand_mshr_reserve, MSHRQueue_MSHRs),
+      mshrQueue("MSHRs", p->mshrs, 4, p->demand_mshr_reserve, MSHRQueue_MSHRs,
+                p->system->cacheLineSize()),
       writeBuffer("write buffer", p->write_buffers, p->mshrs+1000, 0,
-                  MSHRQueue_WriteBuffer),
+                  MSHRQueue_WriteBuffer, p->system->cacheLineSize()),
       blkSize(p->system->cacheLineSize()),
       lookupLatency(p->hit_latency),
       forwardLatency(p->hit_latency),
@@ -86,6 +91,7 @@ BaseCache::BaseCache(const Params *p)
       addrRanges(p->addr_ranges.begin(), p->addr_ranges.end()),
       system(p->system)
 {
+    system->registerCache();
 }
 
 void
@@ -791,12 +797,21 @@ BaseCacheParams::create()
         if (numSets != 1)
             fatal("Got FALRU tags with more than one set\n");
         return new Cache<FALRU>(this);
+    } else if (dynamic_cast<DIP*>(tags)) {
+        // check the derived tags before their base classes
+        return new Cache<DIP>(this);
     } else if (dynamic_cast<LRU*>(tags)) {
         if (numSets == 1)
             warn("Consider using FALRU tags for a fully associative cache\n");
         return new Cache<LRU>(this);
     } else if (dynamic_cast<RandomRepl*>(tags)) {
         return new Cache<RandomRepl>(this);
+    } else if (dynamic_cast<SHiP*>(tags)) {
+        return new Cache<SHiP>(this);
+    } else if (dynamic_cast<RRIP*>(tags)) {
+        return new Cache<RRIP>(this);
+    } else if (dynamic_cast<TreePLRU*>(tags)) {
+        return new Cache<TreePLRU>(this);
     } else {
         fatal("No suitable tags selected\n");
     }
@@ -36,16 +36,24 @@
  * Cache template instantiations.
  */
 
+#include "mem/cache/tags/dip.hh"
 #include "mem/cache/tags/fa_lru.hh"
 #include "mem/cache/tags/lru.hh"
 #include "mem/cache/tags/random_repl.hh"
+#include "mem/cache/tags/rrip.hh"
+#include "mem/cache/tags/ship.hh"
+#include "mem/cache/tags/tree_plru.hh"
 #include "mem/cache/cache_impl.hh"
 
 // Template Instantiations
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
+template class Cache<DIP>;
 template class Cache<FALRU>;
 template class Cache<LRU>;
 template class Cache<RandomRepl>;
+template class Cache<RRIP>;
+template class Cache<SHiP>;
+template class Cache<TreePLRU>;
 
 #endif //DOXYGEN_SHOULD_SKIP_THIS
@@ -568,6 +568,9 @@ Cache<TagStore>::recvTimingReq(PacketPtr pkt)
         // hit (for all other request types)
 
         if (prefetcher && (prefetchOnAccess || (blk && blk->wasPrefetched()))) {
+            if (blk && blk->wasPrefetched() && !pkt->cmd.isPrefetch())
+                prefetcher->usefulPrefetch();
+
             if (blk)
                 blk->status &= ~BlkHWPrefetched;
 
@@ -657,6 +660,7 @@ Cache<TagStore>::recvTimingReq(PacketPtr pkt)
             if (pkt) {
                 assert(pkt->req->masterId() < system->maxMasters());
                 mshr_hits[pkt->cmdToIndex()][pkt->req->masterId()]++;
+
                 if (mshr->threadNum != 0/*pkt->req->threadId()*/) {
                     mshr->threadNum = -1;
                 }
@@ -692,6 +696,9 @@ Cache<TagStore>::recvTimingReq(PacketPtr pkt)
             // no MSHR
             assert(pkt->req->masterId() < system->maxMasters());
             mshr_misses[pkt->cmdToIndex()][pkt->req->masterId()]++;
+
+            if (prefetcher && !pkt->cmd.isPrefetch())
+                prefetcher->demandMiss();
             // always mark as cache fill for now... if we implement
             // no-write-allocate or bypass accesses this will have to
             // be changed.
@@ -1196,7 +1203,12 @@ Cache<TagStore>::recvTimingResp(PacketPtr pkt)
 
           case MSHR::Target::FromPrefetcher:
             assert(target->pkt->cmd == MemCmd::HardPFReq);
-            if (blk)
+            // a demand access waiting for the prefetch makes it a
+            // late one, and the block is then not marked so that it
+            // is not also counted as useful or unused later on
+            if (prefetcher && mshr->hasDemandTarget())
+                prefetcher->latePrefetch();
+            else if (blk)
                 blk->status |= BlkHWPrefetched;
             delete target->pkt->req;
             delete target->pkt;
@@ -1420,6 +1432,9 @@ Cache<TagStore>::allocateBlock(Addr addr, bool is_secure,
                     addr, is_secure ? "s" : "ns",
                     blk->isDirty() ? "writeback" : "clean");
 
+            if (prefetcher && blk->wasPrefetched())
+                prefetcher->unusedPrefetch();
+
             if (blk->isDirty()) {
                 // Save writeback packet for handling by caller
                 writebacks.push_back(writebackBlk(blk));
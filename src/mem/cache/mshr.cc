@@ -391,6 +391,17 @@ MSHR::handleSnoop(PacketPtr pkt, Counter _order)
 }
 
 
+bool
+MSHR::hasDemandTarget() const
+{
+    for (const auto& t : targets) {
+        if (t.source == Target::FromCPU && !t.pkt->cmd.isPrefetch())
+            return true;
+    }
+    return false;
+}
+
+
 bool
 MSHR::promoteDeferredTargets()
 {
@@ -275,6 +275,13 @@ class MSHR : public Packet::SenderState, public Printable
         targets.pop_front();
     }
 
+    /**
+     * Check if a demand access from the CPU side is among the targets,
+     * e.g. because it joined an MSHR allocated by the prefetcher.
+     * @return true if there is a demand target
+     */
+    bool hasDemandTarget() const;
+
     bool isForwardNoResponse() const
     {
         if (getNumTargets() != 1)
@@ -45,38 +45,125 @@
  * Definition of MSHRQueue class functions.
  */
 
+#include <algorithm>
+
+#include "base/intmath.hh"
 #include "base/trace.hh"
 #include "mem/cache/mshr_queue.hh"
 #include "debug/Drain.hh"
 
 using namespace std;
 
+/** Size of the address index, a power of two of at least twice the entries */
+static size_t
+indexSize(int num_entries)
+{
+    size_t size = 16;
+    while (size < 2 * num_entries)
+        size *= 2;
+    return size;
+}
+
 MSHRQueue::MSHRQueue(const std::string &_label,
                      int num_entries, int reserve, int demand_reserve,
-                     int _index)
+                     int _index, unsigned blk_size)
     : label(_label), numEntries(num_entries + reserve - 1),
       numReserve(reserve), demandReserve(demand_reserve),
-      registers(numEntries), drainManager(NULL), allocated(0),
-      inServiceEntries(0), index(_index)
+      registers(numEntries), drainManager(NULL),
+      addrIndex(indexSize(numEntries), IndexEntry{NULL, 0}),
+      indexMask(addrIndex.size() - 1), blkSize(blk_size), allocSeq(0),
+      maxSpan(0), allocated(0), inServiceEntries(0), index(_index)
 {
+    if (!isPowerOf2(blkSize))
+        fatal("MSHR queue %s block size must be a power of two\n", label);
+
     for (int i = 0; i < numEntries; ++i) {
         registers[i].queue = this;
         freeList.push_back(&registers[i]);
     }
 }
 
+uint64_t
+MSHRQueue::indexSlot(Addr blk_addr, bool is_secure) const
+{
+    // multiplicative hashing of the block number, using the upper
+    // bits of the product as they depend on all the bits of the key
+    uint64_t key = ((blk_addr / blkSize) << 1) | is_secure;
+    return ((key * 0x9e3779b97f4a7c15ULL) >> 32) & indexMask;
+}
+
+void
+MSHRQueue::indexInsert(MSHR *mshr)
+{
+    uint64_t slot = indexSlot(blockAlign(mshr->addr), mshr->isSecure);
+    while (addrIndex[slot].mshr)
+        slot = (slot + 1) & indexMask;
+    addrIndex[slot].mshr = mshr;
+    addrIndex[slot].seq = allocSeq++;
+
+    Addr span = (blockAlign(mshr->addr + mshr->size - 1) -
+                 blockAlign(mshr->addr)) / blkSize;
+    maxSpan = std::max(maxSpan, span);
+}
+
+void
+MSHRQueue::indexRemove(MSHR *mshr)
+{
+    uint64_t slot = indexSlot(blockAlign(mshr->addr), mshr->isSecure);
+    while (addrIndex[slot].mshr != mshr) {
+        assert(addrIndex[slot].mshr);
+        slot = (slot + 1) & indexMask;
+    }
+
+    // shift back any following entries that would otherwise no
+    // longer be reachable from their home slot, which also keeps the
+    // entries of the same block in allocation order
+    uint64_t hole = slot;
+    uint64_t next = slot;
+    while (true) {
+        next = (next + 1) & indexMask;
+        MSHR *other = addrIndex[next].mshr;
+        if (!other)
+            break;
+        uint64_t home = indexSlot(blockAlign(other->addr), other->isSecure);
+        bool reachable = hole <= next ? (hole < home && home <= next) :
+            (hole < home || home <= next);
+        if (!reachable) {
+            addrIndex[hole] = addrIndex[next];
+            hole = next;
+        }
+    }
+    addrIndex[hole].mshr = NULL;
+}
+
+void
+MSHRQueue::indexFind(Addr blk_addr, bool is_secure,
+                     vector<IndexEntry>& found) const
+{
+    uint64_t slot = indexSlot(blk_addr, is_secure);
+    while (MSHR *mshr = addrIndex[slot].mshr) {
+        if (blockAlign(mshr->addr) == blk_addr && mshr->isSecure == is_secure)
+            found.push_back(addrIndex[slot]);
+        slot = (slot + 1) & indexMask;
+    }
+}
+
 MSHR *
 MSHRQueue::findMatch(Addr addr, bool is_secure) const
 {
-    MSHR::ConstIterator i = allocatedList.begin();
-    MSHR::ConstIterator end = allocatedList.end();
-    for (; i != end; ++i) {
-        MSHR *mshr = *i;
-        if (mshr->addr == addr && mshr->isSecure == is_secure) {
-            return mshr;
+    // return the earliest allocated entry with a matching address
+    MSHR *match = NULL;
+    uint64_t match_seq = 0;
+    uint64_t slot = indexSlot(blockAlign(addr), is_secure);
+    while (MSHR *mshr = addrIndex[slot].mshr) {
+        if (mshr->addr == addr && mshr->isSecure == is_secure &&
+            (!match || addrIndex[slot].seq < match_seq)) {
+            match = mshr;
+            match_seq = addrIndex[slot].seq;
         }
+        slot = (slot + 1) & indexMask;
     }
-    return NULL;
+    return match;
 }
 
 bool
@@ -84,17 +171,14 @@ MSHRQueue::findMatches(Addr addr, bool is_secure, vector<MSHR*>& matches) const
 {
     // Need an empty vector
     assert(matches.empty());
-    bool retval = false;
-    MSHR::ConstIterator i = allocatedList.begin();
-    MSHR::ConstIterator end = allocatedList.end();
-    for (; i != end; ++i) {
-        MSHR *mshr = *i;
-        if (mshr->addr == addr && mshr->isSecure == is_secure) {
-            retval = true;
-            matches.push_back(mshr);
-        }
+    vector<IndexEntry> found;
+    indexFind(blockAlign(addr), is_secure, found);
+    sort(found.begin(), found.end());
+    for (auto e : found) {
+        if (e.mshr->addr == addr)
+            matches.push_back(e.mshr);
     }
-    return retval;
+    return !matches.empty();
 }
 
 
@@ -102,11 +186,13 @@ bool
 MSHRQueue::checkFunctional(PacketPtr pkt, Addr blk_addr)
 {
     pkt->pushLabel(label);
-    MSHR::ConstIterator i = allocatedList.begin();
-    MSHR::ConstIterator end = allocatedList.end();
-    for (; i != end; ++i) {
-        MSHR *mshr = *i;
-        if (mshr->addr == blk_addr && mshr->checkFunctional(pkt)) {
+    vector<IndexEntry> found;
+    // the security state is not considered for functional accesses
+    indexFind(blockAlign(blk_addr), false, found);
+    indexFind(blockAlign(blk_addr), true, found);
+    sort(found.begin(), found.end());
+    for (auto e : found) {
+        if (e.mshr->addr == blk_addr && e.mshr->checkFunctional(pkt)) {
             pkt->popLabel();
             return true;
         }
@@ -119,6 +205,35 @@ MSHRQueue::checkFunctional(PacketPtr pkt, Addr blk_addr)
 MSHR *
 MSHRQueue::findPending(Addr addr, int size, bool is_secure) const
 {
+    // look at the blocks covered by the range, and far enough before
+    // it to catch any entry starting earlier and spanning into it
+    vector<IndexEntry> found;
+    Addr first = blockAlign(addr);
+    Addr last = blockAlign(addr + size - 1);
+    Addr start = first >= maxSpan * blkSize ? first - maxSpan * blkSize : 0;
+    for (Addr blk_addr = start; blk_addr <= last && blk_addr >= start;
+         blk_addr += blkSize) {
+        indexFind(blk_addr, is_secure, found);
+    }
+
+    MSHR *match = NULL;
+    unsigned num_matches = 0;
+    for (auto e : found) {
+        MSHR *mshr = e.mshr;
+        if (mshr->inService)
+            continue;
+        bool overlap = mshr->addr < addr ? mshr->addr + mshr->size > addr :
+            addr + size > mshr->addr;
+        if (overlap) {
+            match = mshr;
+            ++num_matches;
+        }
+    }
+
+    if (num_matches <= 1)
+        return match;
+
+    // with several candidates, the earliest on the ready list wins
     MSHR::ConstIterator i = readyList.begin();
     MSHR::ConstIterator end = readyList.end();
     for (; i != end; ++i) {
@@ -167,6 +282,7 @@ MSHRQueue::allocate(Addr addr, int size, PacketPtr &pkt,
 
     mshr->allocate(addr, size, pkt, when, order);
     mshr->allocIter = allocatedList.insert(allocatedList.end(), mshr);
+    indexInsert(mshr);
     mshr->readyIter = addToReadyList(mshr);
 
     allocated += 1;
@@ -184,6 +300,7 @@ MSHR::Iterator
 MSHRQueue::deallocateOne(MSHR *mshr)
 {
     MSHR::Iterator retval = allocatedList.erase(mshr->allocIter);
+    indexRemove(mshr);
     freeList.push_front(mshr);
     allocated--;
     if (mshr->inService) {
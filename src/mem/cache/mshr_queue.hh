@@ -97,6 +97,64 @@ class MSHRQueue : public Drainable
 
     MSHR::Iterator addToReadyList(MSHR *mshr);
 
+    /**
+     * An entry in the address index, where the sequence number
+     * reflects the position of the MSHR in the allocated list.
+     */
+    struct IndexEntry
+    {
+        MSHR *mshr;
+        uint64_t seq;
+
+        /** Order by position in the allocated list. */
+        bool operator<(const IndexEntry& other) const
+        { return seq < other.seq; }
+    };
+
+    /**
+     * Open-addressed hash index of all allocated entries, keyed on
+     * the aligned block of the start address and the security
+     * state, and resolving collisions by linear probing. The table
+     * is at least twice the number of entries, so probe sequences
+     * stay short.
+     */
+    std::vector<IndexEntry> addrIndex;
+
+    /** Mask to turn a hash into an index slot. */
+    const uint64_t indexMask;
+
+    /** Block size used to key the index. */
+    const unsigned blkSize;
+
+    /** Sequence number for the next allocated entry. */
+    uint64_t allocSeq;
+
+    /**
+     * The largest number of blocks beyond the first that any entry
+     * has covered, used to find entries starting in an earlier
+     * block that overlap a given range. This is zero unless there
+     * are uncacheable entries crossing a block boundary.
+     */
+    Addr maxSpan;
+
+    Addr blockAlign(Addr addr) const { return addr & ~Addr(blkSize - 1); }
+
+    /** Home slot in the index of a block. */
+    uint64_t indexSlot(Addr blk_addr, bool is_secure) const;
+
+    /** Add an allocated entry to the index. */
+    void indexInsert(MSHR *mshr);
+
+    /** Remove an entry from the index. */
+    void indexRemove(MSHR *mshr);
+
+    /**
+     * Collect all the index entries for the given block in the
+     * provided vector.
+     */
+    void indexFind(Addr blk_addr, bool is_secure,
+                   std::vector<IndexEntry>& found) const;
+
 
   public:
     /** The number of allocated entries. */
@@ -114,9 +172,10 @@ class MSHRQueue : public Drainable
      * any access.
      * @param demand_reserve The minimum number of entries needed to satisfy
      * demand accesses.
+     * @param blk_size The block size of the cache.
      */
     MSHRQueue(const std::string &_label, int num_entries, int reserve,
-              int demand_reserve, int index);
+              int demand_reserve, int index, unsigned blk_size);
 
     /**
      * Find the first MSHR that matches the provided address.
@@ -90,3 +90,31 @@ class TaggedPrefetcher(QueuedPrefetcher):
     cxx_header = "mem/cache/prefetch/tagged.hh"
 
     degree = Param.Int(2, "Number of prefetches to generate")
+
+class StreamPrefetcher(QueuedPrefetcher):
+    type = 'StreamPrefetcher'
+    cxx_class = 'StreamPrefetcher'
+    cxx_header = "mem/cache/prefetch/stream.hh"
+
+    streams = Param.Unsigned(16, "Number of streams tracked")
+    region_blocks = Param.Unsigned(64, "Blocks per region tracked by a stream")
+
+    max_conf = Param.Int(3, "Maximum confidence level")
+    thresh_conf = Param.Int(2, "Threshold confidence level")
+
+    distance = Param.Unsigned(4, "Blocks the prefetches run ahead")
+    degree = Param.Unsigned(4, "Number of prefetches to generate")
+
+class BestOffsetPrefetcher(QueuedPrefetcher):
+    type = 'BestOffsetPrefetcher'
+    cxx_class = 'BestOffsetPrefetcher'
+    cxx_header = "mem/cache/prefetch/best_offset.hh"
+
+    max_offset = Param.Int(256, "Largest candidate offset in blocks")
+    rr_entries = Param.Unsigned(256, "Entries in the recent requests table")
+    score_max = Param.Unsigned(31, "Score ending a learning phase")
+    round_max = Param.Unsigned(100, "Rounds ending a learning phase")
+    bad_score = Param.Unsigned(1, "Score at or below which prefetching " \
+                                      "is turned off")
+
+    degree = Param.Unsigned(1, "Number of prefetches to generate")
@@ -76,6 +76,44 @@ BasePrefetcher::regStats()
         .name(name() + ".num_hwpf_issued")
         .desc("number of hwpf issued")
         ;
+
+    pfUseful
+        .name(name() + ".pf_useful")
+        .desc("number of demand accesses hitting a prefetched block")
+        ;
+
+    pfLate
+        .name(name() + ".pf_late")
+        .desc("number of demand accesses hitting an in-flight prefetch")
+        ;
+
+    pfUnused
+        .name(name() + ".pf_unused")
+        .desc("number of prefetched blocks evicted without being used")
+        ;
+
+    demandMisses
+        .name(name() + ".demand_misses")
+        .desc("number of demand misses not covered by a prefetch")
+        ;
+
+    accuracy
+        .name(name() + ".accuracy")
+        .desc("fraction of the issued prefetches used by demand accesses")
+        ;
+    accuracy = (pfUseful + pfLate) / pfIssued;
+
+    coverage
+        .name(name() + ".coverage")
+        .desc("fraction of the demand misses covered by prefetches")
+        ;
+    coverage = (pfUseful + pfLate) / (pfUseful + pfLate + demandMisses);
+
+    timeliness
+        .name(name() + ".timeliness")
+        .desc("fraction of the used prefetches arriving in time")
+        ;
+    timeliness = pfUseful / (pfUseful + pfLate);
 }
 
 bool
@@ -105,6 +105,27 @@ class BasePrefetcher : public ClockedObject
 
     Stats::Scalar pfIssued;
 
+    /** Demand accesses hitting a prefetched block. */
+    Stats::Scalar pfUseful;
+
+    /** Demand accesses hitting a prefetch still in flight. */
+    Stats::Scalar pfLate;
+
+    /** Prefetched blocks evicted without being used. */
+    Stats::Scalar pfUnused;
+
+    /** Demand accesses not helped by any prefetch. */
+    Stats::Scalar demandMisses;
+
+    /** Fraction of the issued prefetches that were used. */
+    Stats::Formula accuracy;
+
+    /** Fraction of the demand misses removed by prefetching. */
+    Stats::Formula coverage;
+
+    /** Fraction of the used prefetches that arrived in time. */
+    Stats::Formula timeliness;
+
   public:
 
     BasePrefetcher(const BasePrefetcherParams *p);
@@ -124,6 +145,17 @@ class BasePrefetcher : public ClockedObject
 
     virtual Tick nextPrefetchReadyTime() const = 0;
 
+    /**
+     * Notify the prefetcher of the outcome of its prefetches, as seen
+     * by the cache, and of the demand misses it did not cover.
+     * @{
+     */
+    void usefulPrefetch() { ++pfUseful; }
+    void latePrefetch() { ++pfLate; }
+    void unusedPrefetch() { ++pfUnused; }
+    void demandMiss() { ++demandMisses; }
+    /** @} */
+
     virtual void regStats();
 };
 #endif //__MEM_CACHE_PREFETCH_BASE_HH__
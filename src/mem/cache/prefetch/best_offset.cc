@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Best-offset Prefetcher definitions.
+ */
+
+#include <algorithm>
+
+#include "base/intmath.hh"
+#include "debug/HWPrefetch.hh"
+#include "mem/cache/prefetch/best_offset.hh"
+
+BestOffsetPrefetcher::BestOffsetPrefetcher(
+    const BestOffsetPrefetcherParams *p)
+    : QueuedPrefetcher(p),
+      scoreMax(p->score_max),
+      roundMax(p->round_max),
+      badScore(p->bad_score),
+      degree(p->degree),
+      recentRequests(p->rr_entries, MaxAddr),
+      testIndex(0),
+      round(0),
+      bestOffset(1),
+      prefetchOn(true)
+{
+    if (!isPowerOf2(p->rr_entries))
+        fatal("%s: needs a power of 2 recent requests entries\n", name());
+
+    // as in the original design, use the offsets with no prime
+    // factor other than 2, 3 and 5
+    for (int offset = 1; offset <= p->max_offset; ++offset) {
+        int n = offset;
+        for (int f : { 2, 3, 5 }) {
+            while (n % f == 0)
+                n /= f;
+        }
+        if (n == 1)
+            offsets.push_back(offset);
+    }
+
+    if (offsets.empty())
+        fatal("%s: needs a positive maximum offset\n", name());
+
+    scores.resize(offsets.size(), 0);
+}
+
+unsigned
+BestOffsetPrefetcher::rrIndex(Addr blk) const
+{
+    return (blk ^ (blk >> floorLog2(recentRequests.size()))) &
+        (recentRequests.size() - 1);
+}
+
+void
+BestOffsetPrefetcher::endPhase()
+{
+    auto best = std::max_element(scores.begin(), scores.end());
+
+    bestOffset = offsets[best - scores.begin()];
+    prefetchOn = *best > badScore;
+
+    DPRINTF(HWPrefetch, "Best offset %d with score %d, prefetching %s\n",
+            bestOffset, *best, prefetchOn ? "on" : "off");
+
+    ++phases;
+    if (prefetchOn)
+        offsetDist.sample(bestOffset);
+
+    std::fill(scores.begin(), scores.end(), 0);
+    testIndex = 0;
+    round = 0;
+}
+
+void
+BestOffsetPrefetcher::calculatePrefetch(const PacketPtr &pkt,
+                                        std::vector<Addr> &addresses)
+{
+    Addr blk = pkt->getAddr() / blkSize;
+
+    // test the next offset against the recent requests
+    Addr base = blk - offsets[testIndex];
+    if (recentRequests[rrIndex(base)] == base &&
+        ++scores[testIndex] >= scoreMax) {
+        endPhase();
+    } else if (++testIndex == offsets.size()) {
+        testIndex = 0;
+        if (++round == roundMax)
+            endPhase();
+    }
+
+    recentRequests[rrIndex(blk)] = blk;
+
+    if (!prefetchOn)
+        return;
+
+    Addr pkt_addr = blk * blkSize;
+    for (unsigned d = 1; d <= degree; ++d) {
+        Addr pf_addr = (blk + Addr(bestOffset) * d) * blkSize;
+        if (!samePage(pkt_addr, pf_addr)) {
+            // Spanned the page, so now stop
+            pfSpanPage += degree - d + 1;
+            return;
+        }
+
+        DPRINTF(HWPrefetch, "Queuing prefetch to %#x at offset %d.\n",
+                pf_addr, bestOffset * d);
+        addresses.push_back(pf_addr);
+    }
+}
+
+void
+BestOffsetPrefetcher::regStats()
+{
+    QueuedPrefetcher::regStats();
+
+    phases
+        .name(name() + ".phases")
+        .desc("number of completed learning phases")
+        ;
+
+    offsetDist
+        .init(1, offsets.back(), 1)
+        .name(name() + ".offsetDist")
+        .desc("distribution of the selected offsets")
+        .flags(Stats::nozero)
+        ;
+}
+
+BestOffsetPrefetcher*
+BestOffsetPrefetcherParams::create()
+{
+    return new BestOffsetPrefetcher(this);
+}
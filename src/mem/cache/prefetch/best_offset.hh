@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Describes a best-offset prefetcher.
+ */
+
+#ifndef __MEM_CACHE_PREFETCH_BEST_OFFSET_HH__
+#define __MEM_CACHE_PREFETCH_BEST_OFFSET_HH__
+
+#include <vector>
+
+#include "mem/cache/prefetch/queued.hh"
+#include "params/BestOffsetPrefetcher.hh"
+
+/**
+ * The best-offset prefetcher (Michaud, HPCA 2016) prefetches the
+ * block at a single offset from each access, and continuously learns
+ * the best offset. In a learning phase, each access tests one of the
+ * candidate offsets, scoring it if the block at that offset behind
+ * the access is in a table of recent requests. The phase ends when an
+ * offset reaches the maximum score or after a number of rounds over
+ * all the offsets, and the offset with the highest score is used for
+ * the next phase. Prefetching is turned off if no offset scores
+ * better than a threshold.
+ *
+ * The original design fills the recent requests table as prefetches
+ * complete, thus also learning timeliness. Here the accesses are
+ * inserted when observed, as the prefetcher is not told about fills.
+ */
+class BestOffsetPrefetcher : public QueuedPrefetcher
+{
+  protected:
+    const unsigned scoreMax;
+    const unsigned roundMax;
+    const unsigned badScore;
+    const unsigned degree;
+
+    /** The candidate offsets, in blocks. */
+    std::vector<int> offsets;
+
+    /** The score of each offset in the current phase. */
+    std::vector<unsigned> scores;
+
+    /** The recent requests, direct mapped, holding block numbers. */
+    std::vector<Addr> recentRequests;
+
+    /** The offset to test with the next access. */
+    unsigned testIndex;
+
+    /** The round of the current phase. */
+    unsigned round;
+
+    /** The offset used for prefetching. */
+    int bestOffset;
+
+    /** Whether prefetching is turned on. */
+    bool prefetchOn;
+
+    /** Get the index of a block in the recent requests table. */
+    unsigned rrIndex(Addr blk) const;
+
+    /** End the learning phase and pick the best offset. */
+    void endPhase();
+
+    Stats::Scalar phases;
+    Stats::Distribution offsetDist;
+
+  public:
+
+    BestOffsetPrefetcher(const BestOffsetPrefetcherParams *p);
+
+    void calculatePrefetch(const PacketPtr &pkt, std::vector<Addr> &addresses);
+
+    void regStats();
+};
+
+#endif // __MEM_CACHE_PREFETCH_BEST_OFFSET_HH__
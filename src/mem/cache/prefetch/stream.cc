@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Stream Prefetcher definitions.
+ */
+
+#include "debug/HWPrefetch.hh"
+#include "mem/cache/prefetch/stream.hh"
+
+StreamPrefetcher::StreamPrefetcher(const StreamPrefetcherParams *p)
+    : QueuedPrefetcher(p),
+      maxConf(p->max_conf),
+      threshConf(p->thresh_conf),
+      regionBlks(p->region_blocks),
+      distance(p->distance),
+      degree(p->degree),
+      streams(p->streams),
+      useCount(0)
+{
+    if (streams.empty())
+        fatal("%s: needs at least one stream\n", name());
+    if (regionBlks == 0)
+        fatal("%s: needs a non-zero region size\n", name());
+}
+
+StreamPrefetcher::Stream*
+StreamPrefetcher::findStream(Addr region, bool is_secure)
+{
+    for (auto &s : streams) {
+        if (s.valid && s.region == region && s.isSecure == is_secure)
+            return &s;
+    }
+
+    // a confident stream carries on in the next region in its
+    // direction
+    for (auto &s : streams) {
+        if (s.valid && s.isSecure == is_secure &&
+            s.confidence >= threshConf && s.region + s.direction == region) {
+            s.region = region;
+            return &s;
+        }
+    }
+
+    return NULL;
+}
+
+StreamPrefetcher::Stream*
+StreamPrefetcher::streamVictim()
+{
+    Stream *victim = &streams[0];
+    for (auto &s : streams) {
+        if (!s.valid)
+            return &s;
+        if (s.lastUse < victim->lastUse)
+            victim = &s;
+    }
+    return victim;
+}
+
+void
+StreamPrefetcher::calculatePrefetch(const PacketPtr &pkt,
+                                    std::vector<Addr> &addresses)
+{
+    Addr blk = pkt->getAddr() / blkSize;
+    Addr region = blk / regionBlks;
+    bool is_secure = pkt->isSecure();
+
+    Stream *stream = findStream(region, is_secure);
+
+    if (!stream) {
+        // start a new stream in this region
+        stream = streamVictim();
+        *stream = Stream();
+        stream->valid = true;
+        stream->region = region;
+        stream->lastBlk = blk;
+        stream->isSecure = is_secure;
+        stream->lastUse = ++useCount;
+        ++streamsAllocated;
+        DPRINTF(HWPrefetch, "Allocating stream for region %#x\n",
+                region * regionBlks * blkSize);
+        return;
+    }
+
+    stream->lastUse = ++useCount;
+
+    if (blk == stream->lastBlk)
+        return;
+
+    // train the direction of the stream
+    int direction = blk > stream->lastBlk ? 1 : -1;
+    if (direction == stream->direction) {
+        if (stream->confidence < maxConf)
+            stream->confidence++;
+    } else {
+        stream->direction = direction;
+        stream->confidence = 0;
+    }
+    stream->lastBlk = blk;
+
+    if (stream->confidence < threshConf)
+        return;
+
+    Addr pkt_addr = blk * blkSize;
+    for (unsigned d = 0; d < degree; ++d) {
+        Addr pf_addr = (blk + direction * Addr(distance + d)) * blkSize;
+        if (!samePage(pkt_addr, pf_addr)) {
+            // Spanned the page, so now stop
+            pfSpanPage += degree - d;
+            return;
+        }
+
+        DPRINTF(HWPrefetch, "Queuing prefetch to %#x for stream in "
+                "region %#x.\n", pf_addr, stream->region * regionBlks *
+                blkSize);
+        addresses.push_back(pf_addr);
+    }
+}
+
+void
+StreamPrefetcher::regStats()
+{
+    QueuedPrefetcher::regStats();
+
+    streamsAllocated
+        .name(name() + ".streamsAllocated")
+        .desc("number of streams allocated")
+        ;
+}
+
+StreamPrefetcher*
+StreamPrefetcherParams::create()
+{
+    return new StreamPrefetcher(this);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Describes a multi-stream prefetcher tracking memory regions.
+ */
+
+#ifndef __MEM_CACHE_PREFETCH_STREAM_HH__
+#define __MEM_CACHE_PREFETCH_STREAM_HH__
+
+#include <vector>
+
+#include "mem/cache/prefetch/queued.hh"
+#include "params/StreamPrefetcher.hh"
+
+/**
+ * The stream prefetcher follows a number of independent streams, each
+ * confined to a memory region at a time. Accesses within the region
+ * of a stream train its direction, and once the confidence in the
+ * direction reaches a threshold, the prefetcher runs ahead of the
+ * stream by a distance, issuing degree blocks per access. A stream
+ * moves on to the next region in its direction rather than starting
+ * over. As the streams are identified by address alone, the
+ * prefetcher does not rely on the PC of the accesses.
+ */
+class StreamPrefetcher : public QueuedPrefetcher
+{
+  protected:
+    const int maxConf;
+    const int threshConf;
+
+    /** Size of the regions tracked by the streams, in blocks. */
+    const unsigned regionBlks;
+
+    /** Number of blocks the prefetches run ahead of a stream. */
+    const unsigned distance;
+
+    const unsigned degree;
+
+    struct Stream
+    {
+        Stream() : valid(false), region(0), lastBlk(0), isSecure(false),
+                   direction(0), confidence(0), lastUse(0)
+        { }
+
+        bool valid;
+        /** Region of the stream, in units of regions. */
+        Addr region;
+        /** Last block accessed by the stream. */
+        Addr lastBlk;
+        bool isSecure;
+        /** Direction of the stream, -1, 0 for unknown, or 1. */
+        int direction;
+        int confidence;
+        /** Time of the last access, for replacement. */
+        uint64_t lastUse;
+    };
+
+    std::vector<Stream> streams;
+
+    /** Counter providing the time of the accesses. */
+    uint64_t useCount;
+
+    /**
+     * Find the stream an access belongs to, either by its region, or
+     * by a confident stream crossing into the region.
+     * @param region The region of the access.
+     * @param is_secure Security of the access.
+     * @return The stream, or NULL if there is none.
+     */
+    Stream* findStream(Addr region, bool is_secure);
+
+    /** Get the least recently used stream. */
+    Stream* streamVictim();
+
+    Stats::Scalar streamsAllocated;
+
+  public:
+
+    StreamPrefetcher(const StreamPrefetcherParams *p);
+
+    void calculatePrefetch(const PacketPtr &pkt, std::vector<Addr> &addresses);
+
+    void regStats();
+};
+
+#endif // __MEM_CACHE_PREFETCH_STREAM_HH__
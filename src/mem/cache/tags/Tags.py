@@ -71,6 +71,53 @@ class RandomRepl(BaseSetAssoc):
     cxx_class = 'RandomRepl'
     cxx_header = "mem/cache/tags/random_repl.hh"
 
+class TreePLRU(BaseSetAssoc):
+    type = 'TreePLRU'
+    cxx_class = 'TreePLRU'
+    cxx_header = "mem/cache/tags/tree_plru.hh"
+
+class DIP(LRU):
+    type = 'DIP'
+    cxx_class = 'DIP'
+    cxx_header = "mem/cache/tags/dip.hh"
+    bip_throttle = Param.Unsigned(32, "One in this many BIP insertions " \
+                                      "are at the MRU position")
+    leader_sets = Param.Unsigned(32, "Leader sets per policy")
+    psel_bits = Param.Unsigned(10, "Bits of the policy selector")
+
+# Static, bimodal or dynamic (set dueling) re-reference interval
+# prediction
+class RRIPInsertion(Enum): vals = ['SRRIP', 'BRRIP', 'DRRIP']
+
+class RRIP(BaseSetAssoc):
+    type = 'RRIP'
+    cxx_class = 'RRIP'
+    cxx_header = "mem/cache/tags/rrip.hh"
+    rrpv_bits = Param.Unsigned(2, "Bits per re-reference prediction value")
+    insertion = Param.RRIPInsertion('SRRIP', "Insertion policy")
+    brrip_throttle = Param.Unsigned(32, "One in this many BRRIP " \
+                                        "insertions are at the long RRPV")
+    leader_sets = Param.Unsigned(32, "Leader sets per policy for DRRIP")
+    psel_bits = Param.Unsigned(10, "Bits of the policy selector for DRRIP")
+
+class SRRIP(RRIP):
+    insertion = 'SRRIP'
+
+class BRRIP(RRIP):
+    insertion = 'BRRIP'
+
+class DRRIP(RRIP):
+    insertion = 'DRRIP'
+
+class SHiP(RRIP):
+    type = 'SHiP'
+    cxx_class = 'SHiP'
+    cxx_header = "mem/cache/tags/ship.hh"
+    shct_entries = Param.Unsigned(16384, "Entries in the signature table")
+    shct_bits = Param.Unsigned(3, "Bits per signature table counter")
+    region_shift = Param.Unsigned(14, "Address bits below the memory " \
+                                      "region used as signature without PC")
+
 class FALRU(BaseTags):
     type = 'FALRU'
     cxx_class = 'FALRU'
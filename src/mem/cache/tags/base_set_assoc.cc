@@ -76,24 +76,19 @@ BaseSetAssoc::BaseSetAssoc(const Params *p)
     /** @todo Make warmup percentage a parameter. */
     warmupBound = numSets * assoc;
 
-    sets = new SetType[numSets];
     blks = new BlkType[numSets * assoc];
+    blkTags = new Addr[numSets * assoc];
     // allocate data storage in one big chunk
     numBlocks = numSets * assoc;
     dataBlks = new uint8_t[numBlocks * blkSize];
 
     unsigned blkIndex = 0;       // index into blks array
     for (unsigned i = 0; i < numSets; ++i) {
-        sets[i].assoc = assoc;
-
-        sets[i].blks = new BlkType*[assoc];
-
         // link in the data blocks
         for (unsigned j = 0; j < assoc; ++j) {
             // locate next cache block
             BlkType *blk = &blks[blkIndex];
             blk->data = &dataBlks[blkSize*blkIndex];
-            ++blkIndex;
 
             // invalidate new cache block
             blk->invalidate();
@@ -103,10 +98,11 @@ BaseSetAssoc::BaseSetAssoc(const Params *p)
             // Setting the tag to j is just to prevent long chains in the hash
             // table; won't matter because the block is invalid
             blk->tag = j;
+            blkTags[blkIndex] = j;
+            ++blkIndex;
             blk->whenReady = 0;
             blk->isTouched = false;
             blk->size = blkSize;
-            sets[i].blks[j]=blk;
             blk->set = i;
         }
     }
@@ -115,8 +111,8 @@ BaseSetAssoc::BaseSetAssoc(const Params *p)
 BaseSetAssoc::~BaseSetAssoc()
 {
     delete [] dataBlks;
+    delete [] blkTags;
     delete [] blks;
-    delete [] sets;
 }
 
 BaseSetAssoc::BlkType*
@@ -124,7 +120,7 @@ BaseSetAssoc::findBlock(Addr addr, bool is_secure) const
 {
     Addr tag = extractTag(addr);
     unsigned set = extractSet(addr);
-    BlkType *blk = sets[set].findBlk(tag, is_secure);
+    BlkType *blk = findBlk(tag, set, is_secure);
     return blk;
 }
 
@@ -142,7 +138,7 @@ BaseSetAssoc::print() const {
     for (unsigned i = 0; i < numSets; ++i) {
         // link in the data blocks
         for (unsigned j = 0; j < assoc; ++j) {
-            BlkType *blk = sets[i].blks[j];
+            BlkType *blk = &blks[i * assoc + j];
             if (blk->isValid())
                 cache_state += csprintf("\tset: %d block: %d %s\n", i, j,
                         blk->print());
@@ -48,12 +48,13 @@
 #ifndef __MEM_CACHE_TAGS_BASESETASSOC_HH__
 #define __MEM_CACHE_TAGS_BASESETASSOC_HH__
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <list>
 
+#include "base/bitfield.hh"
 #include "mem/cache/tags/base.hh"
-#include "mem/cache/tags/cacheset.hh"
 #include "mem/cache/base.hh"
 #include "mem/cache/blk.hh"
 #include "mem/packet.hh"
@@ -64,8 +65,12 @@
  * @sa  \ref gem5MemorySystem "gem5 Memory System"
  *
  * The BaseSetAssoc tags provide a base, as well as the functionality
- * common to any set associative tags. Any derived class must implement
- * the methods related to the specifics of the actual replacment policy.
+ * common to any set associative tags. The blocks of a set are kept in
+ * way order, with the tags of all the blocks in a separate contiguous
+ * array, such that a lookup only touches the tags of a single set, and
+ * compares them without any branches. Any derived class must implement
+ * the methods related to the specifics of the actual replacment policy,
+ * keeping its state in arrays indexed by the block index.
  * These are:
  *
  * BlkType* accessBlock();
@@ -80,8 +85,6 @@ class BaseSetAssoc : public BaseTags
     typedef CacheBlk BlkType;
     /** Typedef for a list of pointers to the local block class. */
     typedef std::list<BlkType*> BlkList;
-    /** Typedef the set type used in this tag store. */
-    typedef CacheSet<CacheBlk> SetType;
 
 
   protected:
@@ -92,11 +95,14 @@ class BaseSetAssoc : public BaseTags
     /** Whether tags and data are accessed sequentially. */
     const bool sequentialAccess;
 
-    /** The cache sets. */
-    SetType *sets;
-
-    /** The cache blocks. */
+    /** The cache blocks, with the ways of a set next to each other. */
     BlkType *blks;
+    /**
+     * The tags of the cache blocks, in the same order as the
+     * blocks. Invalid blocks may keep a stale tag, and a matching
+     * tag is thus only a hit if the block is valid.
+     */
+    Addr *blkTags;
     /** The data blocks, 1 per cache block. */
     uint8_t *dataBlks;
 
@@ -109,6 +115,51 @@ class BaseSetAssoc : public BaseTags
     /** Mask out all bits that aren't part of the block offset. */
     unsigned blkMask;
 
+    /**
+     * Get the index of a block, which is also the index of its
+     * replacement state in the derived classes.
+     * @param blk The block in this tag store.
+     * @return The index of the block.
+     */
+    unsigned blkIndex(const BlkType *blk) const
+    {
+        return blk - blks;
+    }
+
+    /**
+     * Find the block matching a tag in a set.
+     * @param tag The tag to find.
+     * @param set The set to look in.
+     * @param is_secure True if the target memory space is secure.
+     * @return Pointer to the block if found.
+     */
+    BlkType* findBlk(Addr tag, unsigned set, bool is_secure) const
+    {
+        const unsigned first = set * assoc;
+        const Addr *set_tags = &blkTags[first];
+
+        for (unsigned base = 0; base < assoc; base += 64) {
+            const unsigned ways = std::min(assoc - base, 64u);
+
+            // compare all the tags without branching, leaving it to
+            // the compiler to vectorise the loop
+            uint64_t matches = 0;
+            for (unsigned i = 0; i < ways; ++i)
+                matches |= uint64_t(set_tags[base + i] == tag) << i;
+
+            // we rarely have more than one match, and only if one of
+            // the blocks is invalid or differs in security
+            while (matches) {
+                BlkType *blk = &blks[first + base + findLsbSet(matches)];
+                if (blk->isValid() && blk->isSecure() == is_secure)
+                    return blk;
+                matches &= matches - 1;
+            }
+        }
+
+        return NULL;
+    }
+
 public:
 
     /** Convenience typedef. */
@@ -177,8 +228,8 @@ public:
     {
         Addr tag = extractTag(addr);
         int set = extractSet(addr);
-        BlkType *blk = sets[set].findBlk(tag, is_secure);
-        lat = accessLatency;;
+        BlkType *blk = findBlk(tag, set, is_secure);
+        lat = accessLatency;
 
         // Access all tags in parallel, hence one in each way.  The data side
         // either accesses all blocks in parallel, or one block sequentially on
@@ -217,7 +268,7 @@ public:
     /**
      * Find an invalid block to evict for the address provided.
      * If there are no invalid blocks, this will return the block
-     * in the least-recently-used position.
+     * in the last way of the set.
      * @param addr The addr to a find a replacement candidate for.
      * @return The candidate block.
      */
@@ -228,7 +279,7 @@ public:
 
         // prefer to evict an invalid block
         for (int i = 0; i < assoc; ++i) {
-            blk = sets[set].blks[i];
+            blk = &blks[set * assoc + i];
             if (!blk->isValid()) {
                 break;
             }
@@ -278,6 +329,7 @@ public:
 
          // Set tag for new block.  Caller is responsible for setting status.
          blk->tag = extractTag(addr);
+         blkTags[blkIndex(blk)] = blk->tag;
 
          // deal with what we are bringing in
          assert(master_id < cache->system->maxMasters());
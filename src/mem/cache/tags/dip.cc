@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Definitions of a DIP tag store.
+ */
+
+#include "base/random.hh"
+#include "mem/cache/tags/dip.hh"
+#include "mem/cache/base.hh"
+
+DIP::DIP(const Params *p)
+    : LRU(p), bipThrottle(p->bip_throttle),
+      dueling(numSets, p->leader_sets, p->psel_bits)
+{
+    if (bipThrottle == 0)
+        fatal("DIP needs a non-zero BIP throttle\n");
+}
+
+void
+DIP::regStats()
+{
+    LRU::regStats();
+
+    mruInsertions
+        .name(name() + ".mru_insertions")
+        .desc("Number of blocks inserted at the MRU position")
+        ;
+
+    lruInsertions
+        .name(name() + ".lru_insertions")
+        .desc("Number of blocks inserted at the LRU position")
+        ;
+
+    dueling.regStats(name());
+}
+
+void
+DIP::insertBlock(PacketPtr pkt, BlkType *blk)
+{
+    BaseSetAssoc::insertBlock(pkt, blk);
+
+    // every insertion is the result of a miss, and LRU is the first
+    // policy and BIP the second
+    dueling.miss(blk->set);
+
+    if (dueling.useSecond(blk->set) &&
+        random_mt.random<unsigned>(0, bipThrottle - 1) != 0) {
+        // the oldest possible use makes the block the next victim
+        lastUse[blkIndex(blk)] = 0;
+        ++lruInsertions;
+    } else {
+        lastUse[blkIndex(blk)] = ++useCount;
+        ++mruInsertions;
+    }
+}
+
+DIP*
+DIPParams::create()
+{
+    return new DIP(this);
+}
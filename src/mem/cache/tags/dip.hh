@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Declaration of a DIP tag store.
+ * Dynamic insertion (Qureshi et al., ISCA 2007) uses set dueling to
+ * choose between the LRU insertion of new blocks at the MRU position,
+ * and bimodal insertion (BIP) where all but one in bip_throttle blocks
+ * are inserted at the LRU position. The latter keeps part of a working
+ * set larger than the cache, rather than thrashing it.
+ */
+
+#ifndef __MEM_CACHE_TAGS_DIP_HH__
+#define __MEM_CACHE_TAGS_DIP_HH__
+
+#include "mem/cache/tags/lru.hh"
+#include "mem/cache/tags/set_dueling.hh"
+#include "params/DIP.hh"
+
+class DIP : public LRU
+{
+  public:
+    /** Convenience typedef. */
+    typedef DIPParams Params;
+
+    /**
+     * Construct and initialize this tag store.
+     */
+    DIP(const Params *p);
+
+    /**
+     * Destructor
+     */
+    ~DIP() {}
+
+    void regStats();
+
+    void insertBlock(PacketPtr pkt, BlkType *blk);
+
+  private:
+    /** One in this many BIP insertions are at the MRU position. */
+    const unsigned bipThrottle;
+
+    /** Dueling between LRU and BIP. */
+    SetDueling dueling;
+
+    /** Number of blocks inserted at the MRU position. */
+    Stats::Scalar mruInsertions;
+
+    /** Number of blocks inserted at the LRU position. */
+    Stats::Scalar lruInsertions;
+};
+
+#endif // __MEM_CACHE_TAGS_DIP_HH__
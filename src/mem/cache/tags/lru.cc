@@ -45,12 +45,14 @@
  * Definitions of a LRU tag store.
  */
 
+#include <algorithm>
+
 #include "debug/CacheRepl.hh"
 #include "mem/cache/tags/lru.hh"
 #include "mem/cache/base.hh"
 
 LRU::LRU(const Params *p)
-    : BaseSetAssoc(p)
+    : BaseSetAssoc(p), lastUse(numSets * assoc, 0), useCount(0)
 {
 }
 
@@ -60,8 +62,8 @@ LRU::accessBlock(Addr addr, bool is_secure, Cycles &lat, int master_id)
     BlkType *blk = BaseSetAssoc::accessBlock(addr, is_secure, lat, master_id);
 
     if (blk != NULL) {
-        // move this block to head of the MRU list
-        sets[blk->set].moveToHead(blk);
+        // make this block the most recently used
+        lastUse[blkIndex(blk)] = ++useCount;
         DPRINTF(CacheRepl, "set %x: moving blk %x (%s) to MRU\n",
                 blk->set, regenerateBlkAddr(blk->tag, blk->set),
                 is_secure ? "s" : "ns");
@@ -73,11 +75,16 @@ LRU::accessBlock(Addr addr, bool is_secure, Cycles &lat, int master_id)
 BaseSetAssoc::BlkType*
 LRU::findVictim(Addr addr) const
 {
-    int set = extractSet(addr);
-    // grab a replacement candidate
-    BlkType *blk = sets[set].blks[assoc - 1];
+    BlkType *blk = BaseSetAssoc::findVictim(addr);
 
+    // if all blocks are valid, pick the least recently used one
     if (blk->isValid()) {
+        int set = extractSet(addr);
+        const uint64_t *set_use = &lastUse[set * assoc];
+        unsigned victim = std::min_element(set_use, set_use + assoc) -
+            set_use;
+        blk = &blks[set * assoc + victim];
+
         DPRINTF(CacheRepl, "set %x: selecting blk %x for replacement\n",
                 set, regenerateBlkAddr(blk->tag, set));
     }
@@ -90,8 +97,7 @@ LRU::insertBlock(PacketPtr pkt, BlkType *blk)
 {
     BaseSetAssoc::insertBlock(pkt, blk);
 
-    int set = extractSet(pkt->getAddr());
-    sets[set].moveToHead(blk);
+    lastUse[blkIndex(blk)] = ++useCount;
 }
 
 void
@@ -100,8 +106,7 @@ LRU::invalidate(BlkType *blk)
     BaseSetAssoc::invalidate(blk);
 
     // should be evicted before valid blocks
-    int set = blk->set;
-    sets[set].moveToTail(blk);
+    lastUse[blkIndex(blk)] = 0;
 }
 
 LRU*
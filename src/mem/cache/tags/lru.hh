@@ -44,12 +44,16 @@
  * @file
  * Declaration of a LRU tag store.
  * The LRU tags guarantee that the true least-recently-used way in
- * a set will always be evicted.
+ * a set will always be evicted. Rather than keeping the blocks of a
+ * set in LRU order, every block holds the time of its last use, and
+ * the victim is the block with the oldest one.
  */
 
 #ifndef __MEM_CACHE_TAGS_LRU_HH__
 #define __MEM_CACHE_TAGS_LRU_HH__
 
+#include <vector>
+
 #include "mem/cache/tags/base_set_assoc.hh"
 #include "params/LRU.hh"
 
@@ -74,6 +78,13 @@ class LRU : public BaseSetAssoc
     BlkType* findVictim(Addr addr) const;
     void insertBlock(PacketPtr pkt, BlkType *blk);
     void invalidate(BlkType *blk);
+
+  protected:
+    /** Time of the last use of each block, zero if unused. */
+    std::vector<uint64_t> lastUse;
+
+    /** Counter providing the time of the uses. */
+    uint64_t useCount;
 };
 
 #endif // __MEM_CACHE_TAGS_LRU_HH__
@@ -61,7 +61,7 @@ RandomRepl::findVictim(Addr addr) const
         int idx = random_mt.random<int>(0, assoc - 1);
         assert(idx < assoc);
         assert(idx >= 0);
-        blk = sets[extractSet(addr)].blks[idx];
+        blk = &blks[extractSet(addr) * assoc + idx];
 
         DPRINTF(CacheRepl, "set %x: selecting blk %x for replacement\n",
                 blk->set, regenerateBlkAddr(blk->tag, blk->set));
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Definitions of a RRIP tag store.
+ */
+
+#include <algorithm>
+
+#include "base/random.hh"
+#include "debug/CacheRepl.hh"
+#include "mem/cache/tags/rrip.hh"
+#include "mem/cache/base.hh"
+
+RRIP::RRIP(const Params *p)
+    : BaseSetAssoc(p), maxRRPV((1 << p->rrpv_bits) - 1),
+      insertion(p->insertion), brripThrottle(p->brrip_throttle),
+      dueling(NULL), rrpv(numSets * assoc, maxRRPV)
+{
+    if (p->rrpv_bits < 1 || p->rrpv_bits > 7)
+        fatal("RRIP needs between 1 and 7 bits per RRPV\n");
+    if (brripThrottle == 0)
+        fatal("RRIP needs a non-zero BRRIP throttle\n");
+
+    // SRRIP is the first policy and BRRIP the second
+    if (insertion == Enums::DRRIP)
+        dueling = new SetDueling(numSets, p->leader_sets, p->psel_bits);
+}
+
+RRIP::~RRIP()
+{
+    delete dueling;
+}
+
+void
+RRIP::regStats()
+{
+    BaseSetAssoc::regStats();
+
+    distantInsertions
+        .name(name() + ".distant_insertions")
+        .desc("Number of blocks inserted at the distant RRPV")
+        ;
+
+    longInsertions
+        .name(name() + ".long_insertions")
+        .desc("Number of blocks inserted at the long RRPV")
+        ;
+
+    if (dueling)
+        dueling->regStats(name());
+}
+
+BaseSetAssoc::BlkType*
+RRIP::accessBlock(Addr addr, bool is_secure, Cycles &lat, int master_id)
+{
+    BlkType *blk = BaseSetAssoc::accessBlock(addr, is_secure, lat, master_id);
+
+    // predict a near-immediate re-reference on a hit
+    if (blk != NULL)
+        rrpv[blkIndex(blk)] = 0;
+
+    return blk;
+}
+
+BaseSetAssoc::BlkType*
+RRIP::findVictim(Addr addr) const
+{
+    BlkType *blk = BaseSetAssoc::findVictim(addr);
+
+    // if all blocks are valid, pick the first block with the largest
+    // RRPV, the set is aged when the block is replaced
+    if (blk->isValid()) {
+        int set = extractSet(addr);
+        const uint8_t *set_rrpv = &rrpv[set * assoc];
+        unsigned victim = std::max_element(set_rrpv, set_rrpv + assoc) -
+            set_rrpv;
+        blk = &blks[set * assoc + victim];
+
+        DPRINTF(CacheRepl, "set %x: selecting blk %x for replacement\n",
+                set, regenerateBlkAddr(blk->tag, set));
+    }
+
+    return blk;
+}
+
+void
+RRIP::ageSet(const BlkType *blk)
+{
+    // Replacing a valid block ages the set until the victim reaches
+    // the largest RRPV, which is the same as incrementing all the
+    // RRPVs repeatedly while searching for a victim
+    if (blk->isValid()) {
+        uint8_t *set_rrpv = &rrpv[blk->set * assoc];
+        uint8_t age = maxRRPV - rrpv[blkIndex(blk)];
+        if (age != 0) {
+            for (unsigned i = 0; i < assoc; ++i)
+                set_rrpv[i] = std::min<uint8_t>(set_rrpv[i] + age, maxRRPV);
+        }
+    }
+}
+
+void
+RRIP::setInsertionRRPV(const BlkType *blk, bool distant)
+{
+    if (distant) {
+        rrpv[blkIndex(blk)] = maxRRPV;
+        ++distantInsertions;
+    } else {
+        rrpv[blkIndex(blk)] = maxRRPV - 1;
+        ++longInsertions;
+    }
+}
+
+void
+RRIP::insertBlock(PacketPtr pkt, BlkType *blk)
+{
+    ageSet(blk);
+
+    BaseSetAssoc::insertBlock(pkt, blk);
+
+    // every insertion is the result of a miss
+    bool bimodal = insertion == Enums::BRRIP;
+    if (dueling) {
+        dueling->miss(blk->set);
+        bimodal = dueling->useSecond(blk->set);
+    }
+
+    // predict a long re-reference interval for new blocks, or for
+    // BRRIP a distant one for all but a few blocks
+    setInsertionRRPV(blk, bimodal &&
+                     random_mt.random<unsigned>(0, brripThrottle - 1) != 0);
+}
+
+void
+RRIP::invalidate(BlkType *blk)
+{
+    BaseSetAssoc::invalidate(blk);
+
+    rrpv[blkIndex(blk)] = maxRRPV;
+}
+
+RRIP*
+RRIPParams::create()
+{
+    return new RRIP(this);
+}
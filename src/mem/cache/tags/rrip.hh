@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Declaration of a RRIP tag store.
+ * Static re-reference interval prediction (Jaleel et al., ISCA 2010)
+ * keeps a small re-reference prediction value (RRPV) per block. New
+ * blocks are predicted to be re-referenced in the distant future, a
+ * hit predicts a near-immediate re-reference, and the victim is a
+ * block predicted to be re-referenced the furthest away. This makes
+ * the cache resistant to scans that would flush an LRU cache.
+ *
+ * Bimodal RRIP (BRRIP) inserts most blocks at the distant RRPV, and
+ * only one in brrip_throttle at the long one, which protects the cache
+ * against working sets larger than the cache. Dynamic RRIP (DRRIP)
+ * uses set dueling to choose between the two.
+ */
+
+#ifndef __MEM_CACHE_TAGS_RRIP_HH__
+#define __MEM_CACHE_TAGS_RRIP_HH__
+
+#include <vector>
+
+#include "mem/cache/tags/base_set_assoc.hh"
+#include "mem/cache/tags/set_dueling.hh"
+#include "params/RRIP.hh"
+
+class RRIP : public BaseSetAssoc
+{
+  public:
+    /** Convenience typedef. */
+    typedef RRIPParams Params;
+
+    /**
+     * Construct and initialize this tag store.
+     */
+    RRIP(const Params *p);
+
+    /**
+     * Destructor
+     */
+    ~RRIP();
+
+    void regStats();
+
+    BlkType* accessBlock(Addr addr, bool is_secure, Cycles &lat,
+                         int context_src);
+    BlkType* findVictim(Addr addr) const;
+    void insertBlock(PacketPtr pkt, BlkType *blk);
+    void invalidate(BlkType *blk);
+
+  protected:
+    /**
+     * Age the set of a block about to be replaced, such that the
+     * block reaches the largest RRPV.
+     * @param blk The block to be replaced.
+     */
+    void ageSet(const BlkType *blk);
+
+    /**
+     * Set the RRPV of an inserted block and count the insertion.
+     * @param blk The inserted block.
+     * @param distant Predict a distant rather than a long
+     *                re-reference interval.
+     */
+    void setInsertionRRPV(const BlkType *blk, bool distant);
+
+    /** The largest RRPV, predicting a distant re-reference. */
+    const uint8_t maxRRPV;
+
+    /** The insertion policy. */
+    const Enums::RRIPInsertion insertion;
+
+    /** One in this many BRRIP insertions are at the long RRPV. */
+    const unsigned brripThrottle;
+
+    /** Dueling between SRRIP and BRRIP, only used by DRRIP. */
+    SetDueling *dueling;
+
+    /** The RRPV of each block. */
+    std::vector<uint8_t> rrpv;
+
+    /** Number of blocks inserted at the distant RRPV. */
+    Stats::Scalar distantInsertions;
+
+    /** Number of blocks inserted at the long RRPV. */
+    Stats::Scalar longInsertions;
+};
+
+#endif // __MEM_CACHE_TAGS_RRIP_HH__
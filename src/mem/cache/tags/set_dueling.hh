@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Declaration of set dueling between two replacement policies.
+ */
+
+#ifndef __MEM_CACHE_TAGS_SET_DUELING_HH__
+#define __MEM_CACHE_TAGS_SET_DUELING_HH__
+
+#include <string>
+
+#include "base/misc.hh"
+#include "base/statistics.hh"
+
+/**
+ * Set dueling (Qureshi et al., ISCA 2007) dedicates a few leader sets
+ * to each of two policies, and counts the misses in the leader sets
+ * with a saturating policy selector (PSEL), incremented on the misses
+ * of the first policy and decremented on the ones of the
+ * second. The remaining follower sets use the second policy when the
+ * first one misses more often, i.e. when the counter is in its upper
+ * half.
+ */
+class SetDueling
+{
+  public:
+
+    /**
+     * The number of leader sets is scaled down for caches with too few
+     * sets, so that at least a third of the sets are followers.
+     *
+     * @param num_sets Number of sets in the cache
+     * @param leader_sets Number of leader sets per policy
+     * @param psel_bits Width of the policy selector
+     */
+    SetDueling(unsigned num_sets, unsigned leader_sets, unsigned psel_bits)
+        : stride(leaderStride(num_sets, leader_sets)),
+          pselMax((1 << psel_bits) - 1), psel(pselMax / 2)
+    {
+        if (psel_bits < 1 || psel_bits > 16)
+            fatal("Set dueling needs between 1 and 16 PSEL bits\n");
+    }
+
+    /**
+     * Determine the policy to use in a set.
+     * @param set The set to determine the policy of
+     * @return true if the set uses the second policy
+     */
+    bool useSecond(unsigned set) const
+    {
+        unsigned offset = set % stride;
+        if (offset == 0)
+            return false;
+        if (offset == stride - 1)
+            return true;
+        return psel > pselMax / 2;
+    }
+
+    /**
+     * Record a miss in a set, updating the selector if it is a leader
+     * set.
+     * @param set The set of the miss
+     */
+    void miss(unsigned set)
+    {
+        unsigned offset = set % stride;
+        if (offset == 0) {
+            if (psel < pselMax)
+                ++psel;
+        } else if (offset == stride - 1) {
+            if (psel > 0)
+                --psel;
+        } else {
+            return;
+        }
+        pselDist.sample(psel);
+    }
+
+    /**
+     * Register the stats of the selector.
+     * @param name Name of the owner of the selector
+     */
+    void regStats(const std::string &name)
+    {
+        pselValue
+            .scalar(psel)
+            .name(name + ".psel")
+            .desc("Current value of the policy selector")
+            ;
+
+        pselDist
+            .init(0, pselMax, (pselMax + 16) / 16)
+            .name(name + ".psel_dist")
+            .desc("Policy selector values after each leader set miss")
+            .flags(Stats::pdf)
+            ;
+    }
+
+  private:
+
+    /**
+     * Distance between the leader sets of a policy, with one leader
+     * set of each policy and at least one follower set per stride.
+     */
+    static unsigned leaderStride(unsigned num_sets, unsigned leader_sets)
+    {
+        if (leader_sets == 0)
+            fatal("Set dueling needs at least one leader set per policy\n");
+        if (num_sets < 3)
+            fatal("Set dueling needs at least three sets, got %d\n",
+                  num_sets);
+        if (leader_sets > num_sets / 3) {
+            warn("Using %d rather than %d leader sets per policy for %d "
+                 "sets\n", num_sets / 3, leader_sets, num_sets);
+            leader_sets = num_sets / 3;
+        }
+        return num_sets / leader_sets;
+    }
+
+    /** Distance between the leader sets of a policy. */
+    const unsigned stride;
+
+    /** Largest value of the selector. */
+    const unsigned pselMax;
+
+    /** The policy selector. */
+    unsigned psel;
+
+    Stats::Value pselValue;
+    Stats::Distribution pselDist;
+};
+
+#endif // __MEM_CACHE_TAGS_SET_DUELING_HH__
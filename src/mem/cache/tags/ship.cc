@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Definitions of a SHiP tag store.
+ */
+
+#include <algorithm>
+
+#include "base/intmath.hh"
+#include "mem/cache/tags/ship.hh"
+#include "mem/cache/base.hh"
+
+SHiP::SHiP(const Params *p)
+    : RRIP(p), shctMax((1 << p->shct_bits) - 1),
+      regionShift(p->region_shift), shct(p->shct_entries, 0),
+      blkSignature(numSets * assoc, 0), blkReused(numSets * assoc, 0)
+{
+    if (!isPowerOf2(p->shct_entries))
+        fatal("SHiP needs the number of SHCT entries to be a power of 2\n");
+    if (p->shct_bits < 1 || p->shct_bits > 8)
+        fatal("SHiP needs between 1 and 8 bits per SHCT counter\n");
+    if (insertion != Enums::SRRIP)
+        fatal("SHiP predicts the insertion itself, and is only used "
+              "with SRRIP\n");
+
+    // start out predicting that all blocks are reused, as SRRIP
+    std::fill(shct.begin(), shct.end(), 1);
+}
+
+void
+SHiP::regStats()
+{
+    RRIP::regStats();
+
+    deadEvictions
+        .name(name() + ".dead_evictions")
+        .desc("Number of blocks evicted without being hit")
+        ;
+}
+
+unsigned
+SHiP::signature(PacketPtr pkt) const
+{
+    uint64_t sig = pkt->req->hasPC() ? pkt->req->getPC() :
+        pkt->getAddr() >> regionShift;
+
+    // fold the signature to the size of the table
+    sig ^= sig >> 32;
+    sig ^= sig >> 16;
+    return sig & (shct.size() - 1);
+}
+
+BaseSetAssoc::BlkType*
+SHiP::accessBlock(Addr addr, bool is_secure, Cycles &lat, int master_id)
+{
+    BlkType *blk = RRIP::accessBlock(addr, is_secure, lat, master_id);
+
+    if (blk != NULL) {
+        unsigned idx = blkIndex(blk);
+        blkReused[idx] = 1;
+        uint8_t &counter = shct[blkSignature[idx]];
+        if (counter < shctMax)
+            ++counter;
+    }
+
+    return blk;
+}
+
+void
+SHiP::insertBlock(PacketPtr pkt, BlkType *blk)
+{
+    unsigned idx = blkIndex(blk);
+
+    // train on the block being evicted
+    if (blk->isValid() && !blkReused[idx]) {
+        uint8_t &counter = shct[blkSignature[idx]];
+        if (counter > 0)
+            --counter;
+        ++deadEvictions;
+    }
+
+    ageSet(blk);
+
+    BaseSetAssoc::insertBlock(pkt, blk);
+
+    blkSignature[idx] = signature(pkt);
+    blkReused[idx] = 0;
+    setInsertionRRPV(blk, shct[blkSignature[idx]] == 0);
+}
+
+SHiP*
+SHiPParams::create()
+{
+    return new SHiP(this);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Declaration of a SHiP tag store.
+ * Signature-based hit prediction (Wu et al., MICRO 2011) builds on
+ * RRIP, and predicts the re-reference interval of a new block from a
+ * signature of the access that brought it in. A table of saturating
+ * counters (SHCT), indexed by signature, is incremented when a block
+ * is hit, and decremented when a block is evicted without ever being
+ * hit. Blocks with a signature whose counter is zero are inserted at
+ * the distant RRPV, and all others at the long RRPV.
+ *
+ * The signature is the PC of the access when known, and otherwise
+ * the memory region of the address.
+ */
+
+#ifndef __MEM_CACHE_TAGS_SHIP_HH__
+#define __MEM_CACHE_TAGS_SHIP_HH__
+
+#include <vector>
+
+#include "mem/cache/tags/rrip.hh"
+#include "params/SHiP.hh"
+
+class SHiP : public RRIP
+{
+  public:
+    /** Convenience typedef. */
+    typedef SHiPParams Params;
+
+    /**
+     * Construct and initialize this tag store.
+     */
+    SHiP(const Params *p);
+
+    /**
+     * Destructor
+     */
+    ~SHiP() {}
+
+    void regStats();
+
+    BlkType* accessBlock(Addr addr, bool is_secure, Cycles &lat,
+                         int context_src);
+    void insertBlock(PacketPtr pkt, BlkType *blk);
+
+  private:
+    /**
+     * Get the signature of the access of a packet.
+     * @param pkt The packet to get the signature of.
+     * @return The index in the SHCT.
+     */
+    unsigned signature(PacketPtr pkt) const;
+
+    /** The largest value of a SHCT counter. */
+    const uint8_t shctMax;
+
+    /** The amount to shift addresses by to get their region. */
+    const unsigned regionShift;
+
+    /** The signature history counter table. */
+    std::vector<uint8_t> shct;
+
+    /** The signature of each block. */
+    std::vector<uint32_t> blkSignature;
+
+    /** Whether each block was hit since it was inserted. */
+    std::vector<uint8_t> blkReused;
+
+    /** Number of blocks evicted without being hit. */
+    Stats::Scalar deadEvictions;
+};
+
+#endif // __MEM_CACHE_TAGS_SHIP_HH__
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Definitions of a tree pseudo-LRU tag store.
+ */
+
+#include "base/intmath.hh"
+#include "debug/CacheRepl.hh"
+#include "mem/cache/tags/tree_plru.hh"
+#include "mem/cache/base.hh"
+
+TreePLRU::TreePLRU(const Params *p)
+    : BaseSetAssoc(p), levels(floorLog2(assoc)),
+      tree(numSets * (assoc - 1), 0)
+{
+    if (!isPowerOf2(assoc))
+        fatal("Tree PLRU needs the associativity to be a power of 2\n");
+}
+
+void
+TreePLRU::touch(const BlkType *blk, bool towards)
+{
+    unsigned way = blkIndex(blk) - blk->set * assoc;
+    uint8_t *set_tree = tree.data() + blk->set * (assoc - 1);
+
+    unsigned node = 0;
+    for (int level = levels - 1; level >= 0; --level) {
+        uint8_t right = (way >> level) & 1;
+        set_tree[node] = towards ? right : !right;
+        node = 2 * node + 1 + right;
+    }
+}
+
+BaseSetAssoc::BlkType*
+TreePLRU::accessBlock(Addr addr, bool is_secure, Cycles &lat, int master_id)
+{
+    BlkType *blk = BaseSetAssoc::accessBlock(addr, is_secure, lat, master_id);
+
+    if (blk != NULL)
+        touch(blk, false);
+
+    return blk;
+}
+
+BaseSetAssoc::BlkType*
+TreePLRU::findVictim(Addr addr) const
+{
+    BlkType *blk = BaseSetAssoc::findVictim(addr);
+
+    // if all blocks are valid, follow the bits to the victim
+    if (blk->isValid()) {
+        int set = extractSet(addr);
+        const uint8_t *set_tree = tree.data() + set * (assoc - 1);
+
+        unsigned node = 0;
+        unsigned way = 0;
+        for (unsigned level = 0; level < levels; ++level) {
+            way = (way << 1) | set_tree[node];
+            node = 2 * node + 1 + set_tree[node];
+        }
+        blk = &blks[set * assoc + way];
+
+        DPRINTF(CacheRepl, "set %x: selecting blk %x for replacement\n",
+                set, regenerateBlkAddr(blk->tag, set));
+    }
+
+    return blk;
+}
+
+void
+TreePLRU::insertBlock(PacketPtr pkt, BlkType *blk)
+{
+    BaseSetAssoc::insertBlock(pkt, blk);
+
+    touch(blk, false);
+}
+
+void
+TreePLRU::invalidate(BlkType *blk)
+{
+    BaseSetAssoc::invalidate(blk);
+
+    // make the block the next one to go
+    touch(blk, true);
+}
+
+TreePLRU*
+TreePLRUParams::create()
+{
+    return new TreePLRU(this);
+}
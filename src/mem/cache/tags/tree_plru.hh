@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Declaration of a tree pseudo-LRU tag store.
+ * Every set has a binary tree of bits with a leaf per way, where each
+ * bit points towards the half of its subtree that was least recently
+ * used. The victim is found by following the bits from the root, and
+ * a use flips the bits on the path to the way to point away from it,
+ * needing a single bit per way instead of a full LRU order.
+ */
+
+#ifndef __MEM_CACHE_TAGS_TREE_PLRU_HH__
+#define __MEM_CACHE_TAGS_TREE_PLRU_HH__
+
+#include <vector>
+
+#include "mem/cache/tags/base_set_assoc.hh"
+#include "params/TreePLRU.hh"
+
+class TreePLRU : public BaseSetAssoc
+{
+  public:
+    /** Convenience typedef. */
+    typedef TreePLRUParams Params;
+
+    /**
+     * Construct and initialize this tag store.
+     */
+    TreePLRU(const Params *p);
+
+    /**
+     * Destructor
+     */
+    ~TreePLRU() {}
+
+    BlkType* accessBlock(Addr addr, bool is_secure, Cycles &lat,
+                         int context_src);
+    BlkType* findVictim(Addr addr) const;
+    void insertBlock(PacketPtr pkt, BlkType *blk);
+    void invalidate(BlkType *blk);
+
+  private:
+    /**
+     * Update the bits on the path to a block.
+     * @param blk The block to update the path of.
+     * @param towards Point the bits towards the block rather than
+     *                away from it.
+     */
+    void touch(const BlkType *blk, bool towards);
+
+    /** Number of levels in the tree of each set. */
+    const unsigned levels;
+
+    /**
+     * The bits of the trees, assoc - 1 per set, with the children of
+     * node n at 2n + 1 and 2n + 2. A set bit points to the right.
+     */
+    std::vector<uint8_t> tree;
+};
+
+#endif // __MEM_CACHE_TAGS_TREE_PLRU_HH__
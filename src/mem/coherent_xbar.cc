@@ -47,6 +47,9 @@
  * Definition of a crossbar object.
  */
 
+#include <algorithm>
+
+#include "base/bitfield.hh"
 #include "base/misc.hh"
 #include "base/trace.hh"
 #include "debug/AddrRanges.hh"
@@ -55,7 +58,9 @@
 #include "sim/system.hh"
 
 CoherentXBar::CoherentXBar(const CoherentXBarParams *p)
-    : BaseXBar(p), system(p->system), snoopFilter(p->snoop_filter)
+    : BaseXBar(p), backInvPort(*this), backInvRetryPort(*this),
+      backInvBlocked(false), backInvRetryEvent(*this), system(p->system),
+      snoopFilter(p->snoop_filter)
 {
     // create the ports based on the size of the master and slave
     // vector ports, and the presence of the default port, the ports
@@ -98,6 +103,31 @@ CoherentXBar::CoherentXBar(const CoherentXBarParams *p)
     if (snoopFilter)
         snoopFilter->setSlavePorts(slavePorts);
 
+    outstandingSnoop.reserve(maxOutstandingSnoops);
+
+    // the back-invalidation snoops are sent from an internal port,
+    // with the retries of the snoop layers coming back to its peer
+    backInvRetryPort.bind(backInvPort);
+
+    // now that all the ports exist, tell the layers who they
+    // arbitrate between, with the response layers also seeing snoop
+    // responses that are turned into normal responses, and the snoop
+    // layers also seeing the back-invalidations
+    std::vector<MasterPort*> resp_sources(masterPorts);
+    resp_sources.insert(resp_sources.end(), snoopRespPorts.begin(),
+                        snoopRespPorts.end());
+    std::vector<SlavePort*> snoop_sources(slavePorts);
+    snoop_sources.push_back(&backInvPort);
+    std::vector<unsigned int> snoop_weights(qosWeights);
+    if (!snoop_weights.empty())
+        snoop_weights.push_back(1);
+    for (auto l: reqLayers)
+        l->setSources(slavePorts, qosWeights);
+    for (auto l: snoopLayers)
+        l->setSources(snoop_sources, snoop_weights);
+    for (auto l: respLayers)
+        l->setSources(resp_sources, std::vector<unsigned int>());
+
     clearPortCache();
 }
 
@@ -150,6 +180,22 @@ CoherentXBar::recvTimingReq(PacketPtr pkt, PortID slave_port_id)
     // determine the destination based on the address
     PortID master_port_id = findPort(pkt->getAddr());
 
+    // the holders of a line that is being back-invalidated may still
+    // have it, or its dirty data may be on its way to memory, so hold
+    // off any request to it until that is done
+    if (!is_express_snoop && !backInvLines.empty() &&
+        backInvLines.count(pkt->getAddr() &
+                           ~Addr(system->cacheLineSize() - 1))) {
+        DPRINTF(CoherentXBar, "recvTimingReq: src %s %s 0x%x BACK-INV\n",
+                src_port->name(), pkt->cmdString(), pkt->getAddr());
+        if (std::find(backInvWaiting.begin(), backInvWaiting.end(),
+                      src_port) == backInvWaiting.end())
+            backInvWaiting.push_back(src_port);
+        if (!backInvRetryEvent.scheduled())
+            schedule(backInvRetryEvent, clockEdge(Cycles(1)));
+        return false;
+    }
+
     // test if the crossbar should be considered occupied for the current
     // port, and exclude express snoops from the check
     if (!is_express_snoop && !reqLayers[master_port_id]->tryTiming(src_port)) {
@@ -180,9 +226,10 @@ CoherentXBar::recvTimingReq(PacketPtr pkt, PortID slave_port_id)
             packetFinishTime += sf_res.second * clockPeriod();
             DPRINTF(CoherentXBar, "recvTimingReq: src %s %s 0x%x"\
                     " SF size: %i lat: %i\n", src_port->name(),
-                    pkt->cmdString(), pkt->getAddr(), sf_res.first.size(),
-                    sf_res.second);
+                    pkt->cmdString(), pkt->getAddr(),
+                    popCount(sf_res.first), sf_res.second);
             forwardTiming(pkt, slave_port_id, sf_res.first);
+            backInvalidate(true);
         } else {
             forwardTiming(pkt, slave_port_id);
         }
@@ -212,6 +259,7 @@ CoherentXBar::recvTimingReq(PacketPtr pkt, PortID slave_port_id)
         // Let the snoop filter know about the success of the send operation
         snoopFilter->updateRequest(pkt, *src_port, !success);
         pkt->cmd = tmp_cmd;
+        backInvalidate(true);
     }
 
     // check if we were successful in sending the packet onwards
@@ -237,13 +285,15 @@ CoherentXBar::recvTimingReq(PacketPtr pkt, PortID slave_port_id)
             // response
             if (expect_snoop_resp) {
                 // we should never have an exsiting request outstanding
-                assert(outstandingSnoop.find(pkt->req) ==
+                assert(std::find(outstandingSnoop.begin(),
+                                 outstandingSnoop.end(), pkt->req) ==
                        outstandingSnoop.end());
-                outstandingSnoop.insert(pkt->req);
 
                 // basic sanity check on the outstanding snoops
-                panic_if(outstandingSnoop.size() > 512,
+                panic_if(outstandingSnoop.size() == maxOutstandingSnoops,
                          "Outstanding snoop requests exceeded 512\n");
+
+                outstandingSnoop.push_back(pkt->req);
             }
 
             // remember where to route the normal response to
@@ -306,6 +356,7 @@ CoherentXBar::recvTimingResp(PacketPtr pkt, PortID master_port_id)
     if (snoopFilter && !pkt->req->isUncacheable() && !system->bypassCaches()) {
         // let the snoop filter inspect the response and update its state
         snoopFilter->updateResponse(pkt, *slavePorts[slave_port_id]);
+        backInvalidate(true);
     }
 
     // send the packet through the destination slave port
@@ -351,7 +402,7 @@ CoherentXBar::recvTimingSnoopReq(PacketPtr pkt, PortID master_port_id)
         // No timing here: packetFinishTime += sf_res.second * clockPeriod();
         DPRINTF(CoherentXBar, "recvTimingSnoopReq: src %s %s 0x%x"\
                 " SF size: %i lat: %i\n", masterPorts[master_port_id]->name(),
-                pkt->cmdString(), pkt->getAddr(), sf_res.first.size(),
+                pkt->cmdString(), pkt->getAddr(), popCount(sf_res.first),
                 sf_res.second);
 
         // forward to all snoopers
@@ -380,6 +431,11 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID slave_port_id)
     // determine the source port based on the id
     SlavePort* src_port = slavePorts[slave_port_id];
 
+    // a holder of a line that was back-invalidated is supplying the
+    // dirty data, which has to go to memory
+    if (backInvalidationReqs.count(pkt->req))
+        return writebackBackInvalidation(pkt, slave_port_id);
+
     // get the destination
     const auto route_lookup = routeTo.find(pkt->req);
     assert(route_lookup != routeTo.end());
@@ -390,8 +446,9 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID slave_port_id)
     // created as the result of a normal request (in which case it
     // should be in the outstandingSnoop), or if we merely forwarded
     // someone else's snoop request
-    const bool forwardAsSnoop = outstandingSnoop.find(pkt->req) ==
-        outstandingSnoop.end();
+    auto outstanding = std::find(outstandingSnoop.begin(),
+                                 outstandingSnoop.end(), pkt->req);
+    const bool forwardAsSnoop = outstanding == outstandingSnoop.end();
 
     // test if the crossbar should be considered occupied for the
     // current port, note that the check is bypassed if the response
@@ -453,7 +510,8 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID slave_port_id)
         // i.e. from a coherent master connected to the crossbar, and
         // since we created the snoop request as part of recvTiming,
         // this should now be a normal response again
-        outstandingSnoop.erase(pkt->req);
+        *outstanding = outstandingSnoop.back();
+        outstandingSnoop.pop_back();
 
         // this is a snoop response from a coherent master, hence it
         // should never go back to where the snoop response came from,
@@ -464,6 +522,7 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID slave_port_id)
             // update the probe filter so that it can properly track the line
             snoopFilter->updateSnoopResponse(pkt, *slavePorts[slave_port_id],
                                     *slavePorts[dest_port_id]);
+            backInvalidate(true);
         }
 
         DPRINTF(CoherentXBar, "recvTimingSnoopResp: src %s %s 0x%x"\
@@ -500,7 +559,7 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID slave_port_id)
 
 void
 CoherentXBar::forwardTiming(PacketPtr pkt, PortID exclude_slave_port_id,
-                           const std::vector<SlavePort*>& dests)
+                           SnoopFilter::SnoopMask dests)
 {
     DPRINTF(CoherentXBar, "%s for %s address %x size %d\n", __func__,
             pkt->cmdString(), pkt->getAddr(), pkt->getSize());
@@ -510,7 +569,10 @@ CoherentXBar::forwardTiming(PacketPtr pkt, PortID exclude_slave_port_id,
 
     unsigned fanout = 0;
 
-    for (const auto& p: dests) {
+    for (const auto& p: snoopPorts) {
+        if (dests != AllSnoopers && !SnoopFilter::inMask(dests, *p))
+            continue;
+
         // we could have gotten this request from a snooping master
         // (corresponding to our own slave port that is also in
         // snoopPorts) and should not send it back to where it came
@@ -527,6 +589,175 @@ CoherentXBar::forwardTiming(PacketPtr pkt, PortID exclude_slave_port_id,
     snoopFanout.sample(fanout);
 }
 
+void
+CoherentXBar::backInvalidate(bool timing)
+{
+    Addr line_addr;
+    SnoopFilter::SnoopMask holders;
+
+    while (snoopFilter->nextBackInvalidation(line_addr, holders)) {
+        DPRINTF(CoherentXBar, "%s: line 0x%x holders %x\n", __func__,
+                line_addr, holders);
+
+        if (timing) {
+            backInvQueue.push_back(std::make_pair(line_addr, holders));
+            backInvLines.insert(line_addr);
+            continue;
+        }
+
+        // use an invalidating read so that a dirty holder supplies
+        // the data and no copy is left behind
+        RequestPtr req = new Request(line_addr, system->cacheLineSize(), 0,
+                                     Request::wbMasterId);
+        Packet pkt(req, MemCmd::ReadExReq);
+        pkt.allocate();
+        for (const auto& p: snoopPorts) {
+            if (SnoopFilter::inMask(holders, *p))
+                p->sendAtomicSnoop(&pkt);
+        }
+        if (pkt.memInhibitAsserted()) {
+            RequestPtr wb_req = new Request(line_addr,
+                                            system->cacheLineSize(), 0,
+                                            Request::wbMasterId);
+            Packet wb_pkt(wb_req, MemCmd::Writeback);
+            wb_pkt.dataStatic(pkt.getPtr<uint8_t>());
+            masterPorts[findPort(line_addr)]->sendAtomic(&wb_pkt);
+        }
+        delete req;
+    }
+
+    if (timing && !backInvBlocked)
+        sendBackInvalidations();
+}
+
+void
+CoherentXBar::sendBackInvalidations()
+{
+    backInvBlocked = false;
+
+    while (!backInvQueue.empty()) {
+        Addr line_addr = backInvQueue.front().first;
+        SnoopFilter::SnoopMask holders = backInvQueue.front().second;
+        PortID master_port_id = findPort(line_addr);
+
+        // the snoops share the snoop layer of the port the line maps
+        // to with the snoop responses, and we wait for a retry if it
+        // is busy
+        if (!snoopLayers[master_port_id]->tryTiming(&backInvPort)) {
+            DPRINTF(CoherentXBar, "%s: line 0x%x BUSY\n", __func__,
+                    line_addr);
+            backInvBlocked = true;
+            return;
+        }
+
+        DPRINTF(CoherentXBar, "%s: line 0x%x holders %x\n", __func__,
+                line_addr, holders);
+
+        // use an invalidating read so that a dirty holder supplies
+        // the data and no copy is left behind
+        RequestPtr req = new Request(line_addr, system->cacheLineSize(), 0,
+                                     Request::wbMasterId);
+        PacketPtr pkt = new Packet(req, MemCmd::ReadExReq);
+
+        forwardTiming(pkt, InvalidPortID, holders);
+        transDist[pkt->cmdToIndex()]++;
+        snoops++;
+
+        snoopLayers[master_port_id]->succeededTiming(clockEdge(headerCycles));
+
+        // if a holder is supplying data, it will send a snoop
+        // response referring to the request later on, and the line
+        // stays blocked until we have passed the data on to memory
+        if (pkt->memInhibitAsserted()) {
+            backInvalidationReqs.insert(req);
+        } else {
+            delete req;
+            finishBackInvalidation(line_addr);
+        }
+        delete pkt;
+
+        backInvQueue.pop_front();
+    }
+}
+
+bool
+CoherentXBar::writebackBackInvalidation(PacketPtr pkt, PortID slave_port_id)
+{
+    SlavePort* src_port = slavePorts[slave_port_id];
+    Addr line_addr = pkt->getAddr();
+    PortID master_port_id = findPort(line_addr);
+
+    // the data goes to memory like any other writeback, and the
+    // holder retries the snoop response if the layer is busy
+    if (!reqLayers[master_port_id]->tryTiming(src_port)) {
+        DPRINTF(CoherentXBar, "%s: src %s %s 0x%x BUSY\n", __func__,
+                src_port->name(), pkt->cmdString(), line_addr);
+        return false;
+    }
+
+    DPRINTF(CoherentXBar, "%s: src %s %s 0x%x\n", __func__,
+            src_port->name(), pkt->cmdString(), line_addr);
+
+    RequestPtr wb_req = new Request(line_addr, system->cacheLineSize(), 0,
+                                    Request::wbMasterId);
+    PacketPtr wb_pkt = new Packet(wb_req, MemCmd::Writeback);
+    wb_pkt->allocate();
+    wb_pkt->setData(pkt->getConstPtr<uint8_t>());
+    unsigned int wb_cmd = wb_pkt->cmdToIndex();
+
+    calcPacketTiming(wb_pkt);
+    Tick packetFinishTime = curTick() + wb_pkt->payloadDelay;
+
+    if (!masterPorts[master_port_id]->sendTimingReq(wb_pkt)) {
+        DPRINTF(CoherentXBar, "%s: src %s %s 0x%x RETRY\n", __func__,
+                src_port->name(), pkt->cmdString(), line_addr);
+        // the writeback owns its request
+        delete wb_pkt;
+        reqLayers[master_port_id]->failedTiming(src_port,
+                                                clockEdge(headerCycles));
+        return false;
+    }
+
+    reqLayers[master_port_id]->succeededTiming(packetFinishTime);
+
+    pktCount[slave_port_id][master_port_id]++;
+    pktSize[slave_port_id][master_port_id] += system->cacheLineSize();
+    transDist[pkt->cmdToIndex()]++;
+    transDist[wb_cmd]++;
+    snoops++;
+
+    RequestPtr req = pkt->req;
+    backInvalidationReqs.erase(req);
+    delete pkt;
+    delete req;
+
+    finishBackInvalidation(line_addr);
+
+    return true;
+}
+
+void
+CoherentXBar::finishBackInvalidation(Addr line_addr)
+{
+    backInvLines.erase(line_addr);
+
+    if (!backInvWaiting.empty() && !backInvRetryEvent.scheduled())
+        schedule(backInvRetryEvent, clockEdge());
+}
+
+void
+CoherentXBar::retryBackInvWaiting()
+{
+    // retry every refused port, which also lets a holder that was
+    // refused while still owing us the dirty data send it, as a
+    // cache sends any due snoop response before retrying a request,
+    // and any port that is refused again is retried a cycle later
+    std::vector<SlavePort*> waiting;
+    waiting.swap(backInvWaiting);
+    for (auto p: waiting)
+        p->sendRetry();
+}
+
 void
 CoherentXBar::recvRetry(PortID master_port_id)
 {
@@ -561,9 +792,10 @@ CoherentXBar::recvAtomic(PacketPtr pkt, PortID slave_port_id)
             DPRINTF(CoherentXBar, "%s: src %s %s 0x%x"\
                     " SF size: %i lat: %i\n", __func__,
                     slavePorts[slave_port_id]->name(), pkt->cmdString(),
-                    pkt->getAddr(), sf_res.first.size(), sf_res.second);
+                    pkt->getAddr(), popCount(sf_res.first), sf_res.second);
             snoop_result = forwardAtomic(pkt, slave_port_id, InvalidPortID,
                                          sf_res.first);
+            backInvalidate(false);
         } else {
             snoop_result = forwardAtomic(pkt, slave_port_id);
         }
@@ -587,6 +819,7 @@ CoherentXBar::recvAtomic(PacketPtr pkt, PortID slave_port_id)
     if (snoopFilter && !pkt->req->isUncacheable() && !system->bypassCaches() &&
         pkt->isResponse()) {
         snoopFilter->updateResponse(pkt, *slavePorts[slave_port_id]);
+        backInvalidate(false);
     }
 
     // if we got a response from a snooper, restore it here
@@ -631,7 +864,7 @@ CoherentXBar::recvAtomicSnoop(PacketPtr pkt, PortID master_port_id)
         snoop_response_latency += sf_res.second * clockPeriod();
         DPRINTF(CoherentXBar, "%s: src %s %s 0x%x SF size: %i lat: %i\n",
                 __func__, masterPorts[master_port_id]->name(), pkt->cmdString(),
-                pkt->getAddr(), sf_res.first.size(), sf_res.second);
+                pkt->getAddr(), popCount(sf_res.first), sf_res.second);
         snoop_result = forwardAtomic(pkt, InvalidPortID, master_port_id,
                                      sf_res.first);
     } else {
@@ -656,7 +889,7 @@ CoherentXBar::recvAtomicSnoop(PacketPtr pkt, PortID master_port_id)
 std::pair<MemCmd, Tick>
 CoherentXBar::forwardAtomic(PacketPtr pkt, PortID exclude_slave_port_id,
                            PortID source_master_port_id,
-                           const std::vector<SlavePort*>& dests)
+                           SnoopFilter::SnoopMask dests)
 {
     // the packet may be changed on snoops, record the original
     // command to enable us to restore it between snoops so that
@@ -670,7 +903,10 @@ CoherentXBar::forwardAtomic(PacketPtr pkt, PortID exclude_slave_port_id,
 
     unsigned fanout = 0;
 
-    for (const auto& p: dests) {
+    for (const auto& p: snoopPorts) {
+        if (dests != AllSnoopers && !SnoopFilter::inMask(dests, *p))
+            continue;
+
         // we could have gotten this request from a snooping master
         // (corresponding to our own slave port that is also in
         // snoopPorts) and should not send it back to where it came
@@ -51,6 +51,8 @@
 #ifndef __MEM_COHERENT_XBAR_HH__
 #define __MEM_COHERENT_XBAR_HH__
 
+#include <deque>
+
 #include "mem/snoop_filter.hh"
 #include "mem/xbar.hh"
 #include "params/CoherentXBar.hh"
@@ -255,14 +257,133 @@ class CoherentXBar : public BaseXBar
 
     std::vector<SnoopRespPort*> snoopRespPorts;
 
+    /**
+     * Internal port that the back-invalidation snoops are sent from,
+     * so that they arbitrate for the snoop layers like the snoop
+     * responses of the slave ports. It is a dangling slave port,
+     * bound to a BackInvRetryPort that receives the retries of the
+     * layers.
+     */
+    class BackInvPort : public SlavePort
+    {
+
+      public:
+
+        BackInvPort(CoherentXBar& _xbar) :
+            SlavePort(_xbar.name() + ".backInvPort", &_xbar) { }
+
+      protected:
+
+        /**
+         * Provided as necessary.
+         */
+        Tick recvAtomic(PacketPtr pkt)
+        { panic("BackInvPort should never see atomic request\n"); }
+
+        void recvFunctional(PacketPtr pkt)
+        { panic("BackInvPort should never see functional request\n"); }
+
+        bool recvTimingReq(PacketPtr pkt)
+        { panic("BackInvPort should never see timing request\n"); }
+
+        void recvRetry() { panic("BackInvPort should never see retry\n"); }
+
+        AddrRangeList getAddrRanges() const { return AddrRangeList(); }
+
+    };
+
+    /**
+     * Peer of the BackInvPort, passing the retries of the snoop
+     * layers back to the crossbar.
+     */
+    class BackInvRetryPort : public MasterPort
+    {
+
+      private:
+
+        /** The crossbar sending the back-invalidations. */
+        CoherentXBar& xbar;
+
+      public:
+
+        BackInvRetryPort(CoherentXBar& _xbar) :
+            MasterPort(_xbar.name() + ".backInvRetryPort", &_xbar),
+            xbar(_xbar) { }
+
+        /**
+         * A snoop layer is free again, carry on with the
+         * back-invalidations.
+         */
+        void recvRetry() { xbar.sendBackInvalidations(); }
+
+        /**
+         * Provided as necessary.
+         */
+        bool recvTimingResp(PacketPtr pkt)
+        {
+            panic("BackInvRetryPort should never see timing response\n");
+            return false;
+        }
+
+    };
+
+    BackInvPort backInvPort;
+    BackInvRetryPort backInvRetryPort;
+
     std::vector<SlavePort*> snoopPorts;
 
+    /** Snoop mask used to forward snoops to all the snoopers. */
+    static const SnoopFilter::SnoopMask AllSnoopers =
+        ~SnoopFilter::SnoopMask(0);
+
+    /**
+     * Lines evicted from the snoop filter whose holders are yet to be
+     * snooped, in eviction order, along with the holders.
+     */
+    std::deque<std::pair<Addr, SnoopFilter::SnoopMask> > backInvQueue;
+
+    /**
+     * Lines that are being back-invalidated, from their eviction from
+     * the snoop filter until the holders are invalidated and any
+     * dirty data is on its way to memory. Requests to these lines are
+     * refused, as the filter no longer tracks them.
+     */
+    m5::hash_set<Addr> backInvLines;
+
+    /**
+     * Requests of back-invalidations that are waiting for a snoop
+     * response from a dirty holder of the line, which is written back
+     * to memory.
+     */
+    m5::hash_set<RequestPtr> backInvalidationReqs;
+
+    /** Is the next back-invalidation waiting for a snoop layer */
+    bool backInvBlocked;
+
+    /** Slave ports refused because of a back-invalidated line */
+    std::vector<SlavePort*> backInvWaiting;
+
+    /**
+     * Retry the slave ports that were refused because of a
+     * back-invalidated line.
+     */
+    void retryBackInvWaiting();
+
+    /** Event to retry the refused slave ports. */
+    EventWrapper<CoherentXBar,
+                 &CoherentXBar::retryBackInvWaiting> backInvRetryEvent;
+
     /**
      * Store the outstanding requests that we are expecting snoop
      * responses from so we can determine which snoop responses we
-     * generated and which ones were merely forwarded.
+     * generated and which ones were merely forwarded. There are
+     * rarely more than a handful, so a vector that is searched
+     * linearly beats a hash set, and it is sized up front.
      */
-    m5::hash_set<RequestPtr> outstandingSnoop;
+    std::vector<RequestPtr> outstandingSnoop;
+
+    /** Upper bound on the outstanding snoops, as a sanity check */
+    static const unsigned int maxOutstandingSnoops = 512;
 
     /**
      * Keep a pointer to the system to be allow to querying memory system
@@ -303,20 +424,20 @@ class CoherentXBar : public BaseXBar
      * @param exclude_slave_port_id Id of slave port to exclude
      */
     void forwardTiming(PacketPtr pkt, PortID exclude_slave_port_id) {
-        forwardTiming(pkt, exclude_slave_port_id, snoopPorts);
+        forwardTiming(pkt, exclude_slave_port_id, AllSnoopers);
     }
 
     /**
-     * Forward a timing packet to a selected list of snoopers, potentially
+     * Forward a timing packet to a selected set of snoopers, potentially
      * excluding one of the connected coherent masters to avoid sending a packet
      * back to where it came from.
      *
      * @param pkt Packet to forward
      * @param exclude_slave_port_id Id of slave port to exclude
-     * @param dests Vector of destination ports for the forwarded pkt
+     * @param dests Mask of destination ports for the forwarded pkt
      */
     void forwardTiming(PacketPtr pkt, PortID exclude_slave_port_id,
-                       const std::vector<SlavePort*>& dests);
+                       SnoopFilter::SnoopMask dests);
 
     /** Function called by the port when the crossbar is recieving a Atomic
       transaction.*/
@@ -339,25 +460,64 @@ class CoherentXBar : public BaseXBar
     std::pair<MemCmd, Tick> forwardAtomic(PacketPtr pkt,
                                           PortID exclude_slave_port_id)
     {
-        return forwardAtomic(pkt, exclude_slave_port_id, InvalidPortID, snoopPorts);
+        return forwardAtomic(pkt, exclude_slave_port_id, InvalidPortID,
+                             AllSnoopers);
     }
 
     /**
-     * Forward an atomic packet to a selected list of snoopers, potentially
+     * Forward an atomic packet to a selected set of snoopers, potentially
      * excluding one of the connected coherent masters to avoid sending a packet
      * back to where it came from.
      *
      * @param pkt Packet to forward
      * @param exclude_slave_port_id Id of slave port to exclude
      * @param source_master_port_id Id of the master port for snoops from below
-     * @param dests Vector of destination ports for the forwarded pkt
+     * @param dests Mask of destination ports for the forwarded pkt
      *
      * @return a pair containing the snoop response and snoop latency
      */
     std::pair<MemCmd, Tick> forwardAtomic(PacketPtr pkt,
                                           PortID exclude_slave_port_id,
                                           PortID source_master_port_id,
-                                          const std::vector<SlavePort*>& dests);
+                                          SnoopFilter::SnoopMask dests);
+
+    /**
+     * Invalidate the lines evicted from the snoop filter in the
+     * caches holding them. In timing mode the invalidating snoops
+     * are queued for the snoop layer of the port the line maps to,
+     * and a dirty holder supplies the data in a snoop response that
+     * goes to memory as a writeback through the request layer. The
+     * line is blocked in the meantime. In atomic mode it all happens
+     * straight away.
+     *
+     * @param timing Whether to use timing or atomic snoops
+     */
+    void backInvalidate(bool timing);
+
+    /**
+     * Send the queued back-invalidation snoops for as long as their
+     * snoop layers are free.
+     */
+    void sendBackInvalidations();
+
+    /**
+     * Write the dirty data of a back-invalidated line, supplied in a
+     * snoop response, back to memory through the request layer.
+     *
+     * @param pkt Snoop response carrying the data
+     * @param slave_port_id Id of the slave port it arrived on
+     *
+     * @return false if the layer or memory is busy
+     */
+    bool writebackBackInvalidation(PacketPtr pkt, PortID slave_port_id);
+
+    /**
+     * Unblock a back-invalidated line once its holders are
+     * invalidated and any dirty data is on its way to memory.
+     *
+     * @param line_addr Address of the line
+     */
+    void finishBackInvalidation(Addr line_addr);
 
     /** Function called by the port when the crossbar is recieving a Functional
         transaction.*/
@@ -57,10 +57,20 @@ CommMonitor::CommMonitor(Params* params)
       stats(params),
       stackDistCalc(params->stack_dist_calc),
       traceStream(NULL),
+      binaryTrace(NULL),
       system(params->system)
 {
+    fatal_if(params->latency_precision == 0 ||
+             params->latency_precision > 15,
+             "%s: latency_precision must be between 1 and 15\n", name());
+
     // If we are using a trace file, then open the file
     if (params->trace_enable) {
+        // The binary format compresses the blocks itself, and thus
+        // never uses a .gz suffix
+        const bool binary = params->trace_format == Enums::binary;
+        const bool gzip = params->trace_compress && !binary;
+
         std::string filename;
         if (params->trace_file != "") {
             // If the trace file is not specified as an absolute path,
@@ -70,7 +80,7 @@ CommMonitor::CommMonitor(Params* params)
             std::string suffix = ".gz";
             // If trace_compress has been set, check the suffix. Append
             // accordingly.
-            if (params->trace_compress &&
+            if (gzip &&
                 filename.compare(filename.size() - suffix.size(), suffix.size(),
                                  suffix) != 0)
                     filename = filename + suffix;
@@ -78,17 +88,24 @@ CommMonitor::CommMonitor(Params* params)
             // Generate a filename from the name of the SimObject. Append .trc
             // and .gz if we want compression enabled.
             filename = simout.resolve(name() + ".trc" +
-                                      (params->trace_compress ? ".gz" : ""));
+                                      (gzip ? ".gz" : ""));
         }
 
-        traceStream = new ProtoOutputStream(filename);
-
-        // Create a protobuf message for the header and write it to
-        // the stream
-        ProtoMessage::PacketHeader header_msg;
-        header_msg.set_obj_id(name());
-        header_msg.set_tick_freq(SimClock::Frequency);
-        traceStream->write(header_msg);
+        if (binary) {
+            binaryTrace = new PacketTraceOutput(filename, name(),
+                                                SimClock::Frequency,
+                                                params->trace_compress,
+                                                params->trace_buffer_records);
+        } else {
+            traceStream = new ProtoOutputStream(filename);
+
+            // Create a protobuf message for the header and write it to
+            // the stream
+            ProtoMessage::PacketHeader header_msg;
+            header_msg.set_obj_id(name());
+            header_msg.set_tick_freq(SimClock::Frequency);
+            traceStream->write(header_msg);
+        }
 
         // Register a callback to compensate for the destructor not
         // being called. The callback forces the stream to flush and
@@ -115,8 +132,16 @@ CommMonitor::~CommMonitor()
 void
 CommMonitor::closeStreams()
 {
-    if (traceStream != NULL)
+    if (traceStream != NULL) {
         delete traceStream;
+        traceStream = NULL;
+    }
+
+    // flush the remaining records and wait for the writer thread
+    if (binaryTrace != NULL) {
+        delete binaryTrace;
+        binaryTrace = NULL;
+    }
 }
 
 CommMonitor*
@@ -132,7 +157,7 @@ CommMonitor::init()
     if (!slavePort.isConnected() || !masterPort.isConnected())
         fatal("Communication monitor is not connected on both sides.\n");
 
-    if (traceStream != NULL) {
+    if (traceStream != NULL || binaryTrace != NULL) {
         // Check the memory mode. We only record something when in
         // timing mode. Warn accordingly.
         if (!system->isTimingMode())
@@ -202,6 +227,7 @@ CommMonitor::recvTimingReq(PacketPtr pkt)
     MemCmd cmd = pkt->cmd;
     int cmd_idx = pkt->cmdToIndex();
     Request::FlagsType req_flags = pkt->req->getFlags();
+    MasterID master_id = pkt->req->masterId();
     unsigned size = pkt->getSize();
     Addr addr = pkt->getAddr();
     bool expects_response = pkt->needsResponse() && !pkt->memInhibitAsserted();
@@ -242,6 +268,18 @@ CommMonitor::recvTimingReq(PacketPtr pkt)
         traceStream->write(pkt_msg);
     }
 
+    if (successful && binaryTrace != NULL) {
+        // Fill in the record in place, it is written by the trace
+        // once the buffer is full
+        PacketTraceRecord& record = binaryTrace->next();
+        record.tick = curTick();
+        record.addr = addr;
+        record.size = size;
+        record.flags = req_flags;
+        record.cmd = cmd_idx;
+        record.masterId = master_id;
+    }
+
     if (successful && is_read) {
         DPRINTF(CommMonitor, "Forwarded read request\n");
 
@@ -377,6 +415,7 @@ CommMonitor::recvTimingResp(PacketPtr pkt)
 
         if (!stats.disableLatencyHists) {
             stats.readLatencyHist.sample(latency);
+            stats.readLatencyQuantiles.sample(latency);
         }
 
         // Update the bandwidth stats based on responses for reads
@@ -395,6 +434,7 @@ CommMonitor::recvTimingResp(PacketPtr pkt)
 
         if (!stats.disableLatencyHists) {
             stats.writeLatencyHist.sample(latency);
+            stats.writeLatencyQuantiles.sample(latency);
         }
     } else if (successful) {
         DPRINTF(CommMonitor, "Received non read/write response\n");
@@ -514,6 +554,18 @@ CommMonitor::regStats()
         .desc("Write request-response latency")
         .flags(stats.disableLatencyHists ? nozero : pdf);
 
+    stats.readLatencyQuantiles
+        .init(params()->latency_precision)
+        .name(name() + ".readLatencyQuantiles")
+        .desc("Read request-response latency percentiles")
+        .flags(nozero);
+
+    stats.writeLatencyQuantiles
+        .init(params()->latency_precision)
+        .name(name() + ".writeLatencyQuantiles")
+        .desc("Write request-response latency percentiles")
+        .flags(nozero);
+
     stats.ittReadRead
         .init(1, params()->itt_max_bin, params()->itt_max_bin /
               params()->itt_bins)
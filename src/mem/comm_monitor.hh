@@ -44,6 +44,7 @@
 #include "base/statistics.hh"
 #include "base/time.hh"
 #include "mem/mem_object.hh"
+#include "mem/packet_trace.hh"
 #include "mem/stack_dist_calc.hh"
 #include "params/CommMonitor.hh"
 #include "proto/protoio.hh"
@@ -312,6 +313,12 @@ class CommMonitor : public MemObject
         /** Histogram of write request-to-response latencies */
         Stats::Histogram writeLatencyHist;
 
+        /** Percentiles of read request-to-response latencies */
+        Stats::Quantiles readLatencyQuantiles;
+
+        /** Percentiles of write request-to-response latencies */
+        Stats::Quantiles writeLatencyQuantiles;
+
         /** Disable flag for ITT distributions. */
         bool disableITTDists;
 
@@ -422,6 +429,9 @@ class CommMonitor : public MemObject
     /** Output stream for a potential trace. */
     ProtoOutputStream* traceStream;
 
+    /** Output for a potential binary trace. */
+    PacketTraceOutput* binaryTrace;
+
     /** The system in which the monitor lives */
     System *system;
 };
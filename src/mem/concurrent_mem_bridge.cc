@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * ConcurrentMemBridge definitions
+ */
+
+#include "mem/concurrent_mem_bridge.hh"
+#include "sim/system.hh"
+
+ConcurrentMemBridge::ConcurrentMemBridge(const Params* p)
+    : MemObject(p),
+      masterPort(name() + "-master", *this),
+      slavePort(name() + "-slave", *this),
+      system(p->system),
+      memSideQueue(getEventQueue(p->mem_side_eventq_index))
+{
+}
+
+BaseMasterPort&
+ConcurrentMemBridge::getMasterPort(const std::string& if_name, PortID idx)
+{
+    if (if_name == "master") {
+        return masterPort;
+    } else {
+        return MemObject::getMasterPort(if_name, idx);
+    }
+}
+
+BaseSlavePort&
+ConcurrentMemBridge::getSlavePort(const std::string& if_name, PortID idx)
+{
+    if (if_name == "slave") {
+        return slavePort;
+    } else {
+        return MemObject::getSlavePort(if_name, idx);
+    }
+}
+
+void
+ConcurrentMemBridge::init()
+{
+    if (!slavePort.isConnected() || !masterPort.isConnected())
+        fatal("Both ports of %s must be connected.\n", name());
+
+    slavePort.sendRangeChange();
+}
+
+bool
+ConcurrentMemBridge::memSideRemote() const
+{
+    return inParallelMode && memSideQueue != curEventQueue();
+}
+
+Tick
+ConcurrentMemBridge::recvAtomic(PacketPtr pkt)
+{
+    // the accesses are untimed, just like the direct accesses of the
+    // CPU itself
+    if (system->getPhysMem().concurrentAccess(pkt, memContext))
+        return 0;
+
+    if (memSideRemote()) {
+        EventQueue::ScopedMigration migrate(memSideQueue);
+        return masterPort.sendAtomic(pkt);
+    }
+
+    return masterPort.sendAtomic(pkt);
+}
+
+void
+ConcurrentMemBridge::recvFunctional(PacketPtr pkt)
+{
+    // functional reads and writes of memory, e.g. by system calls,
+    // must not race with the stores of other CPUs, anything else
+    // (like print requests) goes to the memory side
+    if ((pkt->isRead() || pkt->isWrite()) &&
+        system->getPhysMem().concurrentAccess(pkt, memContext))
+        return;
+
+    if (memSideRemote()) {
+        EventQueue::ScopedMigration migrate(memSideQueue);
+        masterPort.sendFunctional(pkt);
+    } else {
+        masterPort.sendFunctional(pkt);
+    }
+}
+
+ConcurrentMemBridge*
+ConcurrentMemBridgeParams::create()
+{
+    return new ConcurrentMemBridge(this);
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * ConcurrentMemBridge declaration
+ */
+
+#ifndef __MEM_CONCURRENT_MEM_BRIDGE_HH__
+#define __MEM_CONCURRENT_MEM_BRIDGE_HH__
+
+#include "mem/mem_object.hh"
+#include "mem/physical.hh"
+#include "params/ConcurrentMemBridge.hh"
+
+class System;
+
+/**
+ * The concurrent memory bridge connects the ports of a CPU that is
+ * simulated on its own event queue and host thread, i.e. an atomic
+ * CPU in the parallel_fastmem mode, to the shared memory system.
+ * Everything the CPU does not access directly passes through here,
+ * most notably the page table walks and the functional accesses of
+ * system calls. Accesses to memory use
+ * PhysicalMemory::concurrentAccess(), and thus take the same line
+ * locks and clear the same reservations as the accesses of the CPUs
+ * themselves. Anything else, e.g. devices, is accessed after taking
+ * over the event queue of the memory side, like the KVM CPU does for
+ * MMIO. Only atomic and functional accesses are supported.
+ */
+class ConcurrentMemBridge : public MemObject
+{
+  public:
+
+    typedef ConcurrentMemBridgeParams Params;
+
+    ConcurrentMemBridge(const Params* p);
+
+    virtual BaseMasterPort& getMasterPort(const std::string& if_name,
+                                          PortID idx = InvalidPortID);
+    virtual BaseSlavePort& getSlavePort(const std::string& if_name,
+                                        PortID idx = InvalidPortID);
+
+    virtual void init();
+
+  protected:
+
+    class BridgeMasterPort : public MasterPort
+    {
+      public:
+
+        BridgeMasterPort(const std::string& _name,
+                         ConcurrentMemBridge& _bridge)
+            : MasterPort(_name, &_bridge), bridge(_bridge)
+        { }
+
+      protected:
+
+        bool recvTimingResp(PacketPtr pkt)
+        {
+            panic("%s does not support timing accesses\n", name());
+        }
+
+        void recvRetry()
+        {
+            panic("%s does not support timing accesses\n", name());
+        }
+
+        void recvRangeChange()
+        {
+            bridge.slavePort.sendRangeChange();
+        }
+
+      private:
+
+        ConcurrentMemBridge& bridge;
+    };
+
+    /** Instance of master port, facing the memory side */
+    BridgeMasterPort masterPort;
+
+    class BridgeSlavePort : public SlavePort
+    {
+      public:
+
+        BridgeSlavePort(const std::string& _name,
+                        ConcurrentMemBridge& _bridge)
+            : SlavePort(_name, &_bridge), bridge(_bridge)
+        { }
+
+      protected:
+
+        Tick recvAtomic(PacketPtr pkt)
+        {
+            return bridge.recvAtomic(pkt);
+        }
+
+        void recvFunctional(PacketPtr pkt)
+        {
+            bridge.recvFunctional(pkt);
+        }
+
+        bool recvTimingReq(PacketPtr pkt)
+        {
+            panic("%s does not support timing accesses\n", name());
+        }
+
+        void recvRetry()
+        {
+            panic("%s does not support timing accesses\n", name());
+        }
+
+        AddrRangeList getAddrRanges() const
+        {
+            return bridge.masterPort.getAddrRanges();
+        }
+
+      private:
+
+        ConcurrentMemBridge& bridge;
+    };
+
+    /** Instance of slave port, i.e. on the CPU side */
+    BridgeSlavePort slavePort;
+
+    /** The system whose memory is accessed directly. */
+    System* system;
+
+    /** Event queue the memory side is simulated by. */
+    EventQueue* memSideQueue;
+
+    /** Reservation state, as needed by concurrentAccess(). */
+    PhysicalMemory::ConcurrentContext memContext;
+
+    /**
+     * Is the memory side simulated by another thread than the one
+     * currently executing.
+     *
+     * @return true if accesses have to migrate to the memory side
+     */
+    bool memSideRemote() const;
+
+    Tick recvAtomic(PacketPtr pkt);
+
+    void recvFunctional(PacketPtr pkt);
+};
+
+#endif //__MEM_CONCURRENT_MEM_BRIDGE_HH__
@@ -43,7 +43,11 @@
  *          Omar Naji
  */
 
+#include <algorithm>
+
 #include "base/bitfield.hh"
+#include "base/intmath.hh"
+#include "base/str.hh"
 #include "base/trace.hh"
 #include "debug/DRAM.hh"
 #include "debug/DRAMPower.hh"
@@ -82,10 +86,16 @@ DRAMCtrl::DRAMCtrl(const DRAMCtrlParams* p) :
     writesThisTime(0), readsThisTime(0),
     tCK(p->tCK), tWTR(p->tWTR), tRTW(p->tRTW), tCS(p->tCS), tBURST(p->tBURST),
     tCCD_L(p->tCCD_L), tRCD(p->tRCD), tCL(p->tCL), tRP(p->tRP), tRAS(p->tRAS),
-    tWR(p->tWR), tRTP(p->tRTP), tRFC(p->tRFC), tREFI(p->tREFI), tRRD(p->tRRD),
+    tWR(p->tWR), tRTP(p->tRTP), tRFC(p->tRFC), tREFI(p->tREFI),
+    perBankRefresh(p->per_bank_refresh), tRFCpb(p->tRFCpb),
+    tREFIpb(p->tREFI / p->banks_per_rank), tRRD(p->tRRD),
     tRRD_L(p->tRRD_L), tXAW(p->tXAW), activationLimit(p->activation_limit),
     memSchedPolicy(p->mem_sched_policy), addrMapping(p->addr_mapping),
     pageMgmt(p->page_policy),
+    qosMasterNames(p->qos_masters), qosMasterPriorities(p->qos_priorities),
+    qosMasterBandwidths(p->qos_reserved_bw),
+    qosReservationWindow(p->qos_reservation_window),
+    qosEscalation(p->qos_escalation), qosMaxPriority(0),
     maxAccessesPerRow(p->max_accesses_per_row),
     frontendLatency(p->static_frontend_latency),
     backendLatency(p->static_backend_latency),
@@ -126,12 +136,25 @@ DRAMCtrl::DRAMCtrl(const DRAMCtrlParams* p) :
         }
     }
 
+    readQueue.init(burstSize, ranksPerChannel * banksPerRank,
+                   readBufferSize);
+    writeQueue.init(burstSize, ranksPerChannel * banksPerRank,
+                    writeBufferSize);
+
     // perform a basic check of the write thresholds
     if (p->write_low_thresh_perc >= p->write_high_thresh_perc)
         fatal("Write buffer low threshold %d must be smaller than the "
               "high threshold %d\n", p->write_low_thresh_perc,
               p->write_high_thresh_perc);
 
+    // the quality of service settings are given per master
+    if (qosMasterPriorities.size() != qosMasterNames.size() ||
+        (!qosMasterBandwidths.empty() &&
+         qosMasterBandwidths.size() != qosMasterNames.size()))
+        fatal("%s needs a QoS priority, and optionally a reserved "
+              "bandwidth, for each of its %d QoS masters\n", name(),
+              qosMasterNames.size());
+
     // determine the rows per bank by looking at the total capacity
     uint64_t capacity = ULL(1) << ceilLog2(AbstractMemory::size());
 
@@ -159,6 +182,14 @@ DRAMCtrl::DRAMCtrl(const DRAMCtrlParams* p) :
               tREFI, tRP, tRFC);
     }
 
+    if (perBankRefresh) {
+        if (tRFCpb == 0 || tREFIpb <= tRFCpb + tRP) {
+            fatal("tREFI / banks per rank (%d) must be larger than tRFCpb "
+                  "(%d) and tRP (%d) with per-bank refresh\n",
+                  tREFIpb, tRFCpb, tRP);
+        }
+    }
+
     // basic bank group architecture checks ->
     if (bankGroupArch) {
         // must have at least one bank per bank group
@@ -190,6 +221,12 @@ DRAMCtrl::DRAMCtrl(const DRAMCtrlParams* p) :
 
 }
 
+DRAMCtrl::~DRAMCtrl()
+{
+    for (auto p : dramPktPool)
+        ::operator delete(p);
+}
+
 void
 DRAMCtrl::init()
 {
@@ -248,14 +285,38 @@ DRAMCtrl::startup()
     // remember the memory system mode of operation
     isTimingMode = system()->isTimingMode();
 
+    // now that all the masters have their ids, look up the ones that
+    // have a quality of service configuration
+    if (!qosMasterNames.empty()) {
+        qosMasters.resize(system()->maxMasters());
+        for (int i = 0; i < qosMasterNames.size(); i++) {
+            QoSMaster& master = qosMasters[qosMasterId(qosMasterNames[i])];
+            master.priority = qosMasterPriorities[i];
+            // the bandwidth parameters are in ticks per byte, and
+            // zero means that nothing is reserved
+            if (!qosMasterBandwidths.empty() &&
+                qosMasterBandwidths[i] > 0) {
+                master.bytesPerTick = 1.0 / qosMasterBandwidths[i];
+                master.maxCredit = master.bytesPerTick *
+                    qosReservationWindow;
+                master.credit = master.maxCredit;
+                master.creditUpdated = curTick();
+            }
+            qosMaxPriority = std::max(qosMaxPriority, master.priority);
+        }
+    }
+
     if (isTimingMode) {
         // timestamp offset should be in clock cycles for DRAMPower
         timeStampOffset = divCeil(curTick(), tCK);
 
         // update the start tick for the precharge accounting to the
         // current tick
+        // with per-bank refresh the first bank is refreshed after
+        // its share of the refresh interval
         for (auto r : ranks) {
-            r->startup(curTick() + tREFI - tRP);
+            r->startup(curTick() + (perBankRefresh ? tREFIpb :
+                                    tREFI - tRP));
         }
 
         // shift the bus busy time sufficiently far ahead that we never
@@ -407,8 +468,162 @@ DRAMCtrl::decodeAddr(PacketPtr pkt, Addr dramPktAddr, unsigned size,
     // ready time set to the current tick, the latter will be updated
     // later
     uint16_t bank_id = banksPerRank * rank + bank;
-    return new DRAMPacket(pkt, isRead, rank, bank, row, bank_id, dramPktAddr,
-                          size, ranks[rank]->banks[bank], *ranks[rank]);
+    return allocDRAMPacket(pkt, isRead, rank, bank, row, bank_id,
+                           dramPktAddr, size);
+}
+
+DRAMCtrl::DRAMPacket*
+DRAMCtrl::allocDRAMPacket(PacketPtr pkt, bool is_read, uint8_t rank,
+                          uint8_t bank, uint32_t row, uint16_t bank_id,
+                          Addr addr, unsigned int size)
+{
+    void* storage;
+    if (dramPktPool.empty()) {
+        storage = ::operator new(sizeof(DRAMPacket));
+    } else {
+        storage = dramPktPool.back();
+        dramPktPool.pop_back();
+    }
+
+    DRAMPacket* dram_pkt =
+        new (storage) DRAMPacket(pkt, is_read, rank, bank, row, bank_id,
+                                 addr, size, ranks[rank]->banks[bank],
+                                 *ranks[rank]);
+
+    // the configured priority of the master does not change, so look
+    // it up once rather than every time the packet is arbitrated
+    if (!qosMasters.empty())
+        dram_pkt->qosPriority = qosMasters[dram_pkt->masterId].priority;
+
+    return dram_pkt;
+}
+
+void
+DRAMCtrl::freeDRAMPacket(DRAMPacket* dram_pkt)
+{
+    dram_pkt->~DRAMPacket();
+    dramPktPool.push_back(dram_pkt);
+}
+
+template <DRAMCtrl::PacketLink L>
+void
+DRAMCtrl::PacketIndex<L>::init(size_t max_packets)
+{
+    // keep the table at most half full, so that the probe sequences
+    // stay short
+    bits = ceilLog2(std::max(2 * max_packets, size_t(2)));
+    slots.assign(size_t(1) << bits, Slot());
+}
+
+template <DRAMCtrl::PacketLink L>
+size_t
+DRAMCtrl::PacketIndex<L>::lookup(uint64_t key) const
+{
+    size_t mask = slots.size() - 1;
+    size_t i = home(key);
+    while (!slots[i].list.empty() && slots[i].key != key)
+        i = (i + 1) & mask;
+    return i;
+}
+
+template <DRAMCtrl::PacketLink L>
+const DRAMCtrl::PacketList<L>*
+DRAMCtrl::PacketIndex<L>::find(uint64_t key) const
+{
+    const Slot& slot = slots[lookup(key)];
+    return slot.list.empty() ? NULL : &slot.list;
+}
+
+template <DRAMCtrl::PacketLink L>
+void
+DRAMCtrl::PacketIndex<L>::insert(uint64_t key, DRAMPacket* dram_pkt)
+{
+    Slot& slot = slots[lookup(key)];
+    slot.key = key;
+    slot.list.push_back(dram_pkt);
+}
+
+template <DRAMCtrl::PacketLink L>
+void
+DRAMCtrl::PacketIndex<L>::erase(uint64_t key, DRAMPacket* dram_pkt)
+{
+    size_t i = lookup(key);
+    panic_if(slots[i].list.empty(),
+             "DRAM packet %lld missing from the index\n", dram_pkt->addr);
+    slots[i].list.erase(dram_pkt);
+    if (!slots[i].list.empty())
+        return;
+
+    // the slot is now free, move any later slot of the probe
+    // sequence back into it that would otherwise no longer be found
+    size_t mask = slots.size() - 1;
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (slots[j].list.empty())
+            return;
+        size_t k = home(slots[j].key);
+        if (((j - k) & mask) >= ((j - i) & mask)) {
+            std::swap(slots[i], slots[j]);
+            i = j;
+        }
+    }
+}
+
+void
+DRAMCtrl::DRAMQueue::push_back(DRAMPacket* dram_pkt)
+{
+    dram_pkt->seqNum = nextSeqNum++;
+    packets.push_back(dram_pkt);
+    perBank[dram_pkt->bankId].push_back(dram_pkt);
+    perRow.insert(rowKey(dram_pkt->bankId, dram_pkt->row), dram_pkt);
+    perBurst.insert(dram_pkt->addr / burstSize, dram_pkt);
+}
+
+void
+DRAMCtrl::DRAMQueue::remove(DRAMPacket* dram_pkt)
+{
+    packets.erase(dram_pkt);
+    perBank[dram_pkt->bankId].erase(dram_pkt);
+    perRow.erase(rowKey(dram_pkt->bankId, dram_pkt->row), dram_pkt);
+    perBurst.erase(dram_pkt->addr / burstSize, dram_pkt);
+}
+
+void
+DRAMCtrl::DRAMQueue::nearPackets(Addr addr,
+                                 std::vector<DRAMPacket*>& pkts) const
+{
+    pkts.clear();
+
+    // a queued packet is at most a burst in size, so it can only
+    // overlap with, or be adjacent to, an access if it starts in the
+    // same burst or in one of the two neighbouring ones
+    Addr burst = addr / burstSize;
+    for (Addr b = burst ? burst - 1 : 0; b <= burst + 1; ++b) {
+        const PacketList<BurstLink>* burst_pkts = perBurst.find(b);
+        if (!burst_pkts)
+            continue;
+        for (auto i = burst_pkts->begin(); i != burst_pkts->end(); ++i)
+            pkts.push_back(*i);
+    }
+
+    std::sort(pkts.begin(), pkts.end(),
+              [](const DRAMPacket* a, const DRAMPacket* b)
+              { return a->seqNum < b->seqNum; });
+}
+
+void
+DRAMCtrl::DRAMQueue::updateAddr(DRAMPacket* dram_pkt, Addr addr,
+                                unsigned int size)
+{
+    if (addr / burstSize != dram_pkt->addr / burstSize) {
+        perBurst.erase(dram_pkt->addr / burstSize, dram_pkt);
+        dram_pkt->addr = addr;
+        perBurst.insert(addr / burstSize, dram_pkt);
+    } else {
+        dram_pkt->addr = addr;
+    }
+    dram_pkt->size = size;
 }
 
 void
@@ -438,7 +653,8 @@ DRAMCtrl::addToReadQueue(PacketPtr pkt, unsigned int pktCount)
         // First check write buffer to see if the data is already at
         // the controller
         bool foundInWrQ = false;
-        for (auto i = writeQueue.begin(); i != writeQueue.end(); ++i) {
+        writeQueue.nearPackets(addr, nearPkts);
+        for (auto i = nearPkts.begin(); i != nearPkts.end(); ++i) {
             // check if the read is subsumed in the write entry we are
             // looking at
             if ((*i)->addr <= addr &&
@@ -521,9 +737,10 @@ DRAMCtrl::addToWriteQueue(PacketPtr pkt, unsigned int pktCount)
         // can stop at that point and also avoid enqueueing a new
         // request
         bool merged = false;
-        auto w = writeQueue.begin();
+        writeQueue.nearPackets(addr, nearPkts);
+        auto w = nearPkts.begin();
 
-        while(!merged && w != writeQueue.end()) {
+        while(!merged && w != nearPkts.end()) {
             // either of the two could be first, if they are the same
             // it does not matter which way we go
             if ((*w)->addr >= addr) {
@@ -536,8 +753,7 @@ DRAMCtrl::addToWriteQueue(PacketPtr pkt, unsigned int pktCount)
                     DPRINTF(DRAM, "Merging write covering existing burst\n");
                     merged = true;
                     // update both the address and the size
-                    (*w)->addr = addr;
-                    (*w)->size = size;
+                    writeQueue.updateAddr(*w, addr, size);
                 } else if ((addr + size) >= (*w)->addr &&
                            ((*w)->addr + (*w)->size - addr) <= burstSize) {
                     // the new one is just before or partially
@@ -547,8 +763,8 @@ DRAMCtrl::addToWriteQueue(PacketPtr pkt, unsigned int pktCount)
                     merged = true;
                     // the existing queue item needs to be adjusted with
                     // respect to both address and size
-                    (*w)->size = (*w)->addr + (*w)->size - addr;
-                    (*w)->addr = addr;
+                    writeQueue.updateAddr(*w, addr,
+                                          (*w)->addr + (*w)->size - addr);
                 }
             } else {
                 // the new one starts after the current one, figure
@@ -727,7 +943,7 @@ DRAMCtrl::processRespondEvent()
         accessAndRespond(dram_pkt->pkt, frontendLatency + backendLatency);
     }
 
-    delete respQueue.front();
+    freeDRAMPacket(respQueue.front());
     respQueue.pop_front();
 
     if (!respQueue.empty()) {
@@ -752,115 +968,255 @@ DRAMCtrl::processRespondEvent()
     }
 }
 
-bool
-DRAMCtrl::chooseNext(std::deque<DRAMPacket*>& queue, bool switched_cmd_type)
+MasterID
+DRAMCtrl::qosMasterId(const std::string& master_name) const
+{
+    std::string short_name = master_name;
+    if (startswith(short_name, system()->name() + "."))
+        short_name.erase(0, system()->name().size() + 1);
+
+    MasterID id = 0;
+    while (id < system()->maxMasters() &&
+           system()->getMasterName(id) != short_name)
+        ++id;
+    if (id == system()->maxMasters())
+        fatal("%s has no master named %s for QoS\n", name(), master_name);
+
+    return id;
+}
+
+DRAMCtrl::DRAMPacket*
+DRAMCtrl::chooseNext(const DRAMQueue& queue, bool switched_cmd_type)
 {
     // This method does the arbitration between requests. The chosen
-    // packet is simply moved to the head of the queue. The other
-    // methods know that this is the place to look. For example, with
-    // FCFS, this method does nothing
+    // packet is returned, and the caller takes it out of the queue
+    // once it is issued. For example, with FCFS, this is the oldest
+    // packet to an available rank
     assert(!queue.empty());
 
-    // bool to indicate if a packet to an available rank is found
-    bool found_packet = false;
     if (queue.size() == 1) {
-        DRAMPacket* dram_pkt = queue.front();
+        DRAMPacket* dram_pkt = *queue.begin();
         // available rank corresponds to state refresh idle
         if (ranks[dram_pkt->rank]->isAvailable()) {
-            found_packet = true;
             DPRINTF(DRAM, "Single request, going to a free rank\n");
+            return dram_pkt;
         } else {
             DPRINTF(DRAM, "Single request, going to a busy rank\n");
+            return NULL;
         }
-        return found_packet;
+    }
+
+    if (!qosMasters.empty()) {
+        DRAMPacket* dram_pkt;
+        if (chooseNextQoS(queue, switched_cmd_type, dram_pkt))
+            return dram_pkt;
     }
 
     if (memSchedPolicy == Enums::fcfs) {
         // check if there is a packet going to a free rank
         for(auto i = queue.begin(); i != queue.end() ; ++i) {
-            DRAMPacket* dram_pkt = *i;
-            if (ranks[dram_pkt->rank]->isAvailable()) {
-                queue.erase(i);
-                queue.push_front(dram_pkt);
-                found_packet = true;
-                break;
-            }
+            if (ranks[(*i)->rank]->isAvailable())
+                return *i;
         }
+        return NULL;
     } else if (memSchedPolicy == Enums::frfcfs) {
-        found_packet = reorderQueue(queue, switched_cmd_type);
+        return reorderQueue(queue, switched_cmd_type);
     } else
         panic("No scheduling policy chosen\n");
-    return found_packet;
 }
 
-bool
-DRAMCtrl::reorderQueue(std::deque<DRAMPacket*>& queue, bool switched_cmd_type)
+DRAMCtrl::DRAMPacket*
+DRAMCtrl::reorderQueue(const DRAMQueue& queue, bool switched_cmd_type)
 {
-    // Only determine this when needed
-    uint64_t earliest_banks = 0;
-
     // Search for row hits first, if no row hit is found then schedule the
-    // packet to one of the earliest banks available
-    bool found_packet = false;
-    bool found_earliest_pkt = false;
-    bool found_prepped_diff_rank_pkt = false;
-    auto selected_pkt_it = queue.end();
-
-    for (auto i = queue.begin(); i != queue.end() ; ++i) {
-        DRAMPacket* dram_pkt = *i;
-        const Bank& bank = dram_pkt->bankRef;
-        // check if rank is busy. If this is the case jump to the next packet
-        // Check if it is a row hit
-        if (dram_pkt->rankRef.isAvailable()) {
-            if (bank.openRow == dram_pkt->row) {
-                if (dram_pkt->rank == activeRank || switched_cmd_type) {
-                    // FCFS within the hits, giving priority to commands
-                    // that access the same rank as the previous burst
-                    // to minimize bus turnaround delays
-                    // Only give rank prioity when command type is
-                    // not changing
-                    DPRINTF(DRAM, "Row buffer hit\n");
-                    selected_pkt_it = i;
-                    break;
-                } else if (!found_prepped_diff_rank_pkt) {
-                    // found row hit for command on different rank
-                    // than prev burst
-                    selected_pkt_it = i;
-                    found_prepped_diff_rank_pkt = true;
+    // packet to one of the earliest banks available. Rather than
+    // scanning the queue, look at the open row of every bank in the
+    // ranks that are available, and compare the oldest packet to it
+    DRAMPacket* same_rank_hit = NULL;
+    DRAMPacket* stalled_hit = NULL;
+    DRAMPacket* diff_rank_hit = NULL;
+
+    // with bank groups, a burst to the same bank group as the
+    // previous one has to wait tCCD_L rather than tBURST, so prefer
+    // the hits that can go back-to-back with the burst on the bus,
+    // effectively alternating between the bank groups
+    const Tick seamless_col_at = std::max(curTick(), busBusyUntil - tCL);
+
+    for (int i = 0; i < ranksPerChannel; i++) {
+        // check if rank is busy. If this is the case skip its banks
+        if (!ranks[i]->isAvailable())
+            continue;
+
+        for (int j = 0; j < banksPerRank; j++) {
+            const Bank& bank = ranks[i]->banks[j];
+            if (bank.openRow == Bank::NO_ROW)
+                continue;
+
+            const PacketList<RowLink>* hits =
+                queue.rowPackets(i * banksPerRank + j, bank.openRow);
+            if (!hits)
+                continue;
+
+            DRAMPacket* dram_pkt = hits->front();
+            if (i == activeRank || switched_cmd_type) {
+                // FCFS within the hits, giving priority to commands
+                // that access the same rank as the previous burst
+                // to minimize bus turnaround delays
+                // Only give rank prioity when command type is
+                // not changing
+                if (bankGroupArch && bank.colAllowedAt > seamless_col_at) {
+                    if (!stalled_hit ||
+                        dram_pkt->seqNum < stalled_hit->seqNum)
+                        stalled_hit = dram_pkt;
+                } else if (!same_rank_hit ||
+                           dram_pkt->seqNum < same_rank_hit->seqNum) {
+                    same_rank_hit = dram_pkt;
                 }
-            } else if (!found_earliest_pkt & !found_prepped_diff_rank_pkt) {
-                // packet going to a rank which is currently not waiting for a
-                // refresh, No row hit and
-                // haven't found an entry with a row hit to a new rank
-                if (earliest_banks == 0)
-                    // Determine entries with earliest bank prep delay
-                    // Function will give priority to commands that access the
-                    // same rank as previous burst and can prep
-                    // the bank seamlessly
-                    earliest_banks = minBankPrep(queue, switched_cmd_type);
-
-                // FCFS - Bank is first available bank
-                if (bits(earliest_banks, dram_pkt->bankId,
-                    dram_pkt->bankId)) {
-                    // Remember the packet to be scheduled to one of
-                    // the earliest banks available, FCFS amongst the
-                    // earliest banks
-                    selected_pkt_it = i;
-                    //if the packet found is going to a rank that is currently
-                    //not busy then update the found_packet to true
-                    found_earliest_pkt = true;
+            } else {
+                // row hit for command on different rank than prev burst
+                if (!diff_rank_hit || dram_pkt->seqNum < diff_rank_hit->seqNum)
+                    diff_rank_hit = dram_pkt;
+            }
+        }
+    }
+
+    if (same_rank_hit) {
+        DPRINTF(DRAM, "Row buffer hit\n");
+        return same_rank_hit;
+    }
+    if (stalled_hit) {
+        DPRINTF(DRAM, "Row buffer hit, same bank group\n");
+        return stalled_hit;
+    }
+    if (diff_rank_hit)
+        return diff_rank_hit;
+
+    // No row hit, so determine the banks with the earliest bank prep
+    // delay, giving priority to commands that access the same rank as
+    // the previous burst and can prep the bank seamlessly, and pick
+    // the oldest packet to one of them (FCFS amongst the earliest banks)
+    uint64_t earliest_banks = minBankPrep(queue, switched_cmd_type);
+
+    DRAMPacket* selected_pkt = NULL;
+    for (int bank_id = 0; earliest_banks; ++bank_id, earliest_banks >>= 1) {
+        if (!(earliest_banks & 1))
+            continue;
+
+        const PacketList<BankLink>& pkts = queue.bankPackets(bank_id);
+        if (!pkts.empty() &&
+            (!selected_pkt || pkts.front()->seqNum < selected_pkt->seqNum))
+            selected_pkt = pkts.front();
+    }
+
+    assert(!selected_pkt || selected_pkt->rankRef.isAvailable());
+    return selected_pkt;
+}
+
+bool
+DRAMCtrl::chooseNextQoS(const DRAMQueue& queue, bool switched_cmd_type,
+                        DRAMPacket*& selected)
+{
+    // rather than looking at every queued packet, arbitrate between
+    // the oldest packet and the oldest row hit of every bank in the
+    // ranks that are available, so that the packets to a bank stay in
+    // order amongst themselves. If the candidates are all equally
+    // urgent there is nothing for us to add to the normal scheduling
+    // policy
+    bool found = false;
+    bool mixed = false;
+    unsigned int top = 0;
+    DRAMPacket* oldest = NULL;
+    DRAMPacket* oldest_hit = NULL;
+
+    for (int i = 0; i < ranksPerChannel; i++) {
+        if (!ranks[i]->isAvailable())
+            continue;
+
+        for (int j = 0; j < banksPerRank; j++) {
+            const uint16_t bank_id = i * banksPerRank + j;
+            const PacketList<BankLink>& pkts = queue.bankPackets(bank_id);
+            if (pkts.empty())
+                continue;
+
+            // for FCFS only the oldest packet of the bank matters
+            DRAMPacket* candidates[2] = { pkts.front(), NULL };
+            const Bank& bank = ranks[i]->banks[j];
+            if (memSchedPolicy == Enums::frfcfs &&
+                bank.openRow != Bank::NO_ROW) {
+                const PacketList<RowLink>* hits =
+                    queue.rowPackets(bank_id, bank.openRow);
+                if (hits)
+                    candidates[1] = hits->front();
+            }
+
+            for (int k = 0; k < 2; k++) {
+                DRAMPacket* dram_pkt = candidates[k];
+                if (!dram_pkt || (k == 1 && dram_pkt == candidates[0]))
+                    continue;
+
+                unsigned int priority = qosPriority(dram_pkt);
+                if (found && priority != top)
+                    mixed = true;
+                if (!found || priority > top) {
+                    top = priority;
+                    oldest = NULL;
+                    oldest_hit = NULL;
                 }
+                found = true;
+                if (priority != top)
+                    continue;
+
+                if (!oldest || dram_pkt->seqNum < oldest->seqNum)
+                    oldest = dram_pkt;
+                if (dram_pkt->row == bank.openRow &&
+                    (!oldest_hit || dram_pkt->seqNum < oldest_hit->seqNum))
+                    oldest_hit = dram_pkt;
             }
         }
     }
 
-    if (selected_pkt_it != queue.end()) {
-        DRAMPacket* selected_pkt = *selected_pkt_it;
-        queue.erase(selected_pkt_it);
-        queue.push_front(selected_pkt);
-        found_packet = true;
+    if (!mixed)
+        return false;
+
+    // amongst the most urgent candidates, pick the oldest one for
+    // FCFS, and for FR-FCFS the oldest row hit, or else the oldest
+    // packet
+    selected = oldest_hit ? oldest_hit : oldest;
+
+    DPRINTF(DRAM, "QoS picked master %d at priority %d\n",
+            selected->masterId, top);
+
+    return true;
+}
+
+unsigned int
+DRAMCtrl::qosPriority(const DRAMPacket* dram_pkt) const
+{
+    const QoSMaster& master = qosMasters[dram_pkt->masterId];
+
+    // traffic within the bandwidth reserved for its master goes
+    // before everything else
+    if (master.bytesPerTick > 0 &&
+        master.creditAt(curTick()) >= dram_pkt->size)
+        return qosMaxPriority + 1;
+
+    // escalate one level for every escalation period the packet has
+    // been waiting, up to the highest configured priority
+    Tick priority = dram_pkt->qosPriority;
+    if (qosEscalation)
+        priority += (curTick() - dram_pkt->entryTime) / qosEscalation;
+    return std::min(priority, Tick(qosMaxPriority));
+}
+
+void
+DRAMCtrl::qosCharge(const DRAMPacket* dram_pkt)
+{
+    QoSMaster& master = qosMasters[dram_pkt->masterId];
+    if (master.bytesPerTick > 0) {
+        master.credit = std::max(0.0, master.creditAt(curTick()) -
+                                 dram_pkt->size);
+        master.creditUpdated = curTick();
     }
-    return found_packet;
 }
 
 void
@@ -1161,26 +1517,17 @@ DRAMCtrl::doDRAMAccess(DRAMPacket* dram_pkt)
         bool got_more_hits = false;
         bool got_bank_conflict = false;
 
-        // either look at the read queue or write queue
-        const deque<DRAMPacket*>& queue = dram_pkt->isRead ? readQueue :
-            writeQueue;
-        auto p = queue.begin();
-        // make sure we are not considering the packet that we are
-        // currently dealing with (which is the head of the queue)
-        ++p;
-
-        // keep on looking until we have found required condition or
-        // reached the end
-        while (!(got_more_hits &&
-                 (got_bank_conflict || pageMgmt == Enums::close_adaptive)) &&
-               p != queue.end()) {
-            bool same_rank_bank = (dram_pkt->rank == (*p)->rank) &&
-                (dram_pkt->bank == (*p)->bank);
-            bool same_row = dram_pkt->row == (*p)->row;
-            got_more_hits |= same_rank_bank && same_row;
-            got_bank_conflict |= same_rank_bank && !same_row;
-            ++p;
-        }
+        // either look at the read queue or write queue, and make
+        // sure we are not considering the packet that we are
+        // currently dealing with (which is still in the queue)
+        const DRAMQueue& queue = dram_pkt->isRead ? readQueue : writeQueue;
+        const PacketList<RowLink>* same_row =
+            queue.rowPackets(dram_pkt->bankId, dram_pkt->row);
+        size_t same_row_pkts = same_row ? same_row->size() - 1 : 0;
+        size_t same_bank_pkts = queue.bankPackets(dram_pkt->bankId).size() - 1;
+
+        got_more_hits = same_row_pkts != 0;
+        got_bank_conflict = same_bank_pkts != same_row_pkts;
 
         // auto pre-charge when either
         // 1) open_adaptive policy, we have not got any more hits, and
@@ -1238,13 +1585,27 @@ DRAMCtrl::doDRAMAccess(DRAMPacket* dram_pkt)
         totMemAccLat += dram_pkt->readyTime - dram_pkt->entryTime;
         totBusLat += tBURST;
         totQLat += cmd_at - dram_pkt->entryTime;
+        rdQLatQuantiles.sample(cmd_at - dram_pkt->entryTime);
+
+        perMasterRdBursts[dram_pkt->masterId]++;
+        perMasterTotMemAccLat[dram_pkt->masterId] +=
+            dram_pkt->readyTime - dram_pkt->entryTime;
+        if (!perMasterMemAccLatQuantiles.empty() &&
+            perMasterMemAccLatQuantiles[dram_pkt->masterId])
+            perMasterMemAccLatQuantiles[dram_pkt->masterId]->sample(
+                dram_pkt->readyTime - dram_pkt->entryTime);
     } else {
         ++writesThisTime;
         if (row_hit)
             writeRowHits++;
         bytesWritten += burstSize;
         perBankWrBursts[dram_pkt->bankId]++;
+
+        wrQLatQuantiles.sample(cmd_at - dram_pkt->entryTime);
     }
+
+    if (!qosMasters.empty())
+        qosCharge(dram_pkt);
 }
 
 void
@@ -1322,22 +1683,17 @@ DRAMCtrl::processNextReqEvent()
                 return;
             }
         } else {
-            // bool to check if there is a read to a free rank
-            bool found_read = false;
-
-            // Figure out which read request goes next, and move it to the
-            // front of the read queue
-            found_read = chooseNext(readQueue, switched_cmd_type);
+            // Figure out which read request goes next
+            DRAMPacket* dram_pkt = chooseNext(readQueue, switched_cmd_type);
 
             // if no read to an available rank is found then return
             // at this point. There could be writes to the available ranks
             // which are above the required threshold. However, to
             // avoid adding more complexity to the code, return and wait
             // for a refresh event to kick things into action again.
-            if (!found_read)
+            if (!dram_pkt)
                 return;
 
-            DRAMPacket* dram_pkt = readQueue.front();
             assert(dram_pkt->rankRef.isAvailable());
             // here we get a bit creative and shift the bus busy time not
             // just the tWTR, but also a CAS latency to capture the fact
@@ -1351,7 +1707,7 @@ DRAMCtrl::processNextReqEvent()
             doDRAMAccess(dram_pkt);
 
             // At this point we're done dealing with the request
-            readQueue.pop_front();
+            readQueue.remove(dram_pkt);
 
             // sanity check
             assert(dram_pkt->size <= burstSize);
@@ -1383,19 +1739,15 @@ DRAMCtrl::processNextReqEvent()
             busState = READ_TO_WRITE;
         }
     } else {
-        // bool to check if write to free rank is found
-        bool found_write = false;
-
-        found_write = chooseNext(writeQueue, switched_cmd_type);
+        DRAMPacket* dram_pkt = chooseNext(writeQueue, switched_cmd_type);
 
         // if no writes to an available rank are found then return.
         // There could be reads to the available ranks. However, to avoid
         // adding more complexity to the code, return at this point and wait
         // for a refresh event to kick things into action again.
-        if (!found_write)
+        if (!dram_pkt)
             return;
 
-        DRAMPacket* dram_pkt = writeQueue.front();
         assert(dram_pkt->rankRef.isAvailable());
         // sanity check
         assert(dram_pkt->size <= burstSize);
@@ -1410,8 +1762,8 @@ DRAMCtrl::processNextReqEvent()
 
         doDRAMAccess(dram_pkt);
 
-        writeQueue.pop_front();
-        delete dram_pkt;
+        writeQueue.remove(dram_pkt);
+        freeDRAMPacket(dram_pkt);
 
         // If we emptied the write queue, or got sufficiently below the
         // threshold (using the minWritesPerSwitch as the hysteresis) and
@@ -1446,7 +1798,7 @@ DRAMCtrl::processNextReqEvent()
 }
 
 uint64_t
-DRAMCtrl::minBankPrep(const deque<DRAMPacket*>& queue,
+DRAMCtrl::minBankPrep(const DRAMQueue& queue,
                       bool switched_cmd_type) const
 {
     uint64_t bank_mask = 0;
@@ -1460,19 +1812,14 @@ DRAMCtrl::minBankPrep(const deque<DRAMPacket*>& queue,
 
     // determine if we have queued transactions targetting the
     // bank in question
-    vector<bool> got_waiting(ranksPerChannel * banksPerRank, false);
-    for (const auto& p : queue) {
-        if(p->rankRef.isAvailable())
-            got_waiting[p->bankId] = true;
-    }
-
     for (int i = 0; i < ranksPerChannel; i++) {
         for (int j = 0; j < banksPerRank; j++) {
             uint16_t bank_id = i * banksPerRank + j;
 
             // if we have waiting requests for the bank, and it is
             // amongst the first available, update the mask
-            if (got_waiting[bank_id]) {
+            if (ranks[i]->isAvailable() &&
+                !queue.bankPackets(bank_id).empty()) {
                 // make sure this rank is not currently refreshing.
                 assert(ranks[i]->isAvailable());
                 // simplistic approximation of when the bank can issue
@@ -1547,7 +1894,7 @@ DRAMCtrl::minBankPrep(const deque<DRAMPacket*>& queue,
 DRAMCtrl::Rank::Rank(DRAMCtrl& _memory, const DRAMCtrlParams* _p)
     : EventManager(&_memory), memory(_memory),
       pwrStateTrans(PWR_IDLE), pwrState(PWR_IDLE), pwrStateTick(0),
-      refreshState(REF_IDLE), refreshDueAt(0),
+      refreshState(REF_IDLE), refreshDueAt(0), refreshBank(0),
       power(_p, false), numBanksActive(0),
       activateEvent(*this), prechargeEvent(*this),
       refreshEvent(*this), powerEvent(*this)
@@ -1611,6 +1958,13 @@ DRAMCtrl::Rank::processPrechargeEvent()
 void
 DRAMCtrl::Rank::processRefreshEvent()
 {
+    // the rank never leaves the idle refresh state when refreshing
+    // one bank at a time
+    if (memory.perBankRefresh) {
+        refreshNextBank();
+        return;
+    }
+
     // when first preparing the refresh, remember when it was due
     if (refreshState == REF_IDLE) {
         // remember when the refresh is due
@@ -1838,6 +2192,36 @@ DRAMCtrl::Rank::processPowerEvent()
     }
 }
 
+void
+DRAMCtrl::Rank::refreshNextBank()
+{
+    assert(refreshState == REF_IDLE);
+
+    Bank& bank = banks[refreshBank];
+    refreshBank = (refreshBank + 1) % banks.size();
+
+    // close the bank if needed, respecting any constraints due to
+    // accesses that are already scheduled
+    if (bank.openRow != Bank::NO_ROW) {
+        memory.prechargeBank(*this, bank,
+                             std::max(curTick(), bank.preAllowedAt));
+    }
+
+    // the refresh starts once the bank is precharged, and no
+    // activate is allowed until it is done
+    Tick ref_at = std::max(curTick(), bank.actAllowedAt);
+    bank.actAllowedAt = ref_at + memory.tRFCpb;
+
+    // DRAMPower has no notion of a per-bank refresh, so the refresh
+    // is not part of the power trace
+    DPRINTF(DRAM, "Refreshing bank %d, rank %d at tick %lld until %lld\n",
+            bank.bank, rank, ref_at, bank.actAllowedAt);
+
+    // the event is never delayed, so the next refresh is simply
+    // scheduled one interval from now
+    schedule(refreshEvent, curTick() + memory.tREFIpb);
+}
+
 void
 DRAMCtrl::Rank::updatePowerStats()
 {
@@ -1990,6 +2374,18 @@ DRAMCtrl::regStats()
 
     avgQLat = totQLat / (readBursts - servicedByWrQ);
 
+    rdQLatQuantiles
+        .init()
+        .name(name() + ".rdQLatQuantiles")
+        .desc("Percentiles of the queueing delay per read DRAM burst")
+        .flags(nozero);
+
+    wrQLatQuantiles
+        .init()
+        .name(name() + ".wrQLatQuantiles")
+        .desc("Percentiles of the queueing delay per write DRAM burst")
+        .flags(nozero);
+
     avgBusLat
         .name(name() + ".avgBusLat")
         .desc("Average bus latency per DRAM burst")
@@ -2004,6 +2400,55 @@ DRAMCtrl::regStats()
 
     avgMemAccLat = totMemAccLat / (readBursts - servicedByWrQ);
 
+    perMasterRdBursts
+        .init(system()->maxMasters())
+        .name(name() + ".perMasterRdBursts")
+        .desc("Per master read bursts serviced by the DRAM")
+        .flags(nozero);
+
+    perMasterTotMemAccLat
+        .init(system()->maxMasters())
+        .name(name() + ".perMasterTotMemAccLat")
+        .desc("Per master total ticks from burst creation until serviced "
+              "by the DRAM")
+        .flags(nozero);
+
+    perMasterAvgMemAccLat
+        .name(name() + ".perMasterAvgMemAccLat")
+        .desc("Per master average memory access latency per DRAM burst")
+        .precision(2)
+        .flags(nozero | nonan);
+
+    perMasterAvgMemAccLat = perMasterTotMemAccLat / perMasterRdBursts;
+
+    for (int i = 0; i < system()->maxMasters(); i++) {
+        const std::string master = system()->getMasterName(i);
+        perMasterRdBursts.subname(i, master);
+        perMasterTotMemAccLat.subname(i, master);
+        perMasterAvgMemAccLat.subname(i, master);
+    }
+
+    // the latency percentiles are only kept for the masters with a
+    // quality of service configuration, as they are the ones that
+    // have latency targets
+    if (!qosMasterNames.empty())
+        perMasterMemAccLatQuantiles.resize(system()->maxMasters());
+    for (int i = 0; i < qosMasterNames.size(); i++) {
+        MasterID id = qosMasterId(qosMasterNames[i]);
+        if (perMasterMemAccLatQuantiles[id])
+            continue;
+
+        const std::string master = system()->getMasterName(id);
+
+        Stats::Quantiles* quantiles = new Stats::Quantiles();
+        quantiles->init()
+            .name(name() + ".perMasterMemAccLat." + master)
+            .desc("Memory access latency percentiles per DRAM burst for "
+                  "master " + master)
+            .flags(nozero);
+        perMasterMemAccLatQuantiles[id].reset(quantiles);
+    }
+
     numRdRetry
         .name(name() + ".numRdRetry")
         .desc("Number of times read queue was full causing retry");
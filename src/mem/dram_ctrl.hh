@@ -51,8 +51,11 @@
 #ifndef __MEM_DRAM_CTRL_HH__
 #define __MEM_DRAM_CTRL_HH__
 
+#include <algorithm>
 #include <deque>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/statistics.hh"
 #include "enums/AddrMap.hh"
@@ -261,6 +264,18 @@ class DRAMCtrl : public AbstractMemory
          */
         Tick refreshDueAt;
 
+        /**
+         * With per-bank refresh, the bank to refresh next
+         */
+        unsigned int refreshBank;
+
+        /**
+         * Refresh a single bank, and leave the rest of the rank
+         * available for scheduling. The banks are refreshed in a
+         * round-robin fashion, one every tREFI / banks per rank.
+         */
+        void refreshNextBank();
+
         /*
          * Command energies
          */
@@ -406,6 +421,25 @@ class DRAMCtrl : public AbstractMemory
         { }
     };
 
+    /** The lists of a DRAMQueue that a DRAM packet is linked into */
+    enum PacketLink {
+        QueueLink,
+        BankLink,
+        RowLink,
+        BurstLink,
+        NumLinks
+    };
+
+    class DRAMPacket;
+
+    /** Links of a DRAM packet in one of the lists of a DRAMQueue */
+    struct Link {
+        DRAMPacket* prev;
+        DRAMPacket* next;
+
+        Link() : prev(NULL), next(NULL) { }
+    };
+
     /**
      * A DRAM packet stores packets along with the timestamp of when
      * the packet entered the queue, and also the decoded address.
@@ -425,6 +459,12 @@ class DRAMCtrl : public AbstractMemory
 
         const bool isRead;
 
+        /** Master that issued the request, for quality of service */
+        const MasterID masterId;
+
+        /** Configured quality of service priority of the master */
+        unsigned int qosPriority;
+
         /** Will be populated by address decoder */
         const uint8_t rank;
         const uint8_t bank;
@@ -459,17 +499,242 @@ class DRAMCtrl : public AbstractMemory
         Bank& bankRef;
         Rank& rankRef;
 
+        /**
+         * Arrival order and position of the packet in the read or
+         * write queue it is in, see DRAMQueue
+         */
+        uint64_t seqNum;
+        Link links[NumLinks];
+
         DRAMPacket(PacketPtr _pkt, bool is_read, uint8_t _rank, uint8_t _bank,
                    uint32_t _row, uint16_t bank_id, Addr _addr,
                    unsigned int _size, Bank& bank_ref, Rank& rank_ref)
             : entryTime(curTick()), readyTime(curTick()),
-              pkt(_pkt), isRead(is_read), rank(_rank), bank(_bank), row(_row),
+              pkt(_pkt), isRead(is_read), masterId(_pkt->req->masterId()),
+              qosPriority(0), rank(_rank), bank(_bank), row(_row),
               bankId(bank_id), addr(_addr), size(_size), burstHelper(NULL),
-              bankRef(bank_ref), rankRef(rank_ref)
+              bankRef(bank_ref), rankRef(rank_ref), seqNum(0)
         { }
 
     };
 
+    /**
+     * A list of DRAM packets in arrival order, linked through the
+     * packets themselves so that adding or removing a packet never
+     * allocates. A packet can be in one list per link.
+     */
+    template <PacketLink L>
+    class PacketList {
+
+      public:
+
+        class const_iterator {
+
+          public:
+
+            const_iterator(DRAMPacket* dram_pkt = NULL) : pkt(dram_pkt) { }
+
+            DRAMPacket* operator*() const { return pkt; }
+
+            const_iterator& operator++()
+            {
+                pkt = pkt->links[L].next;
+                return *this;
+            }
+
+            bool operator==(const const_iterator& other) const
+            { return pkt == other.pkt; }
+
+            bool operator!=(const const_iterator& other) const
+            { return pkt != other.pkt; }
+
+          private:
+
+            DRAMPacket* pkt;
+
+        };
+
+        PacketList() : head(NULL), tail(NULL), count(0) { }
+
+        size_t size() const { return count; }
+        bool empty() const { return !count; }
+        DRAMPacket* front() const { return head; }
+
+        const_iterator begin() const { return const_iterator(head); }
+        const_iterator end() const { return const_iterator(); }
+
+        void push_back(DRAMPacket* dram_pkt)
+        {
+            Link& link = dram_pkt->links[L];
+            link.prev = tail;
+            link.next = NULL;
+            if (tail)
+                tail->links[L].next = dram_pkt;
+            else
+                head = dram_pkt;
+            tail = dram_pkt;
+            ++count;
+        }
+
+        void erase(DRAMPacket* dram_pkt)
+        {
+            Link& link = dram_pkt->links[L];
+            if (link.prev)
+                link.prev->links[L].next = link.next;
+            else
+                head = link.next;
+            if (link.next)
+                link.next->links[L].prev = link.prev;
+            else
+                tail = link.prev;
+            --count;
+        }
+
+      private:
+
+        DRAMPacket* head;
+        DRAMPacket* tail;
+        size_t count;
+
+    };
+
+    /**
+     * Lists of DRAM packets with the same key, e.g. the same row of
+     * a bank, kept in an open addressing hash table. The table is
+     * sized up front for a maximum number of packets, and as there
+     * can never be more keys than packets, it never allocates or
+     * rehashes after that.
+     */
+    template <PacketLink L>
+    class PacketIndex {
+
+      public:
+
+        PacketIndex() : bits(0) { }
+
+        /** Size the table for at most max_packets packets */
+        void init(size_t max_packets);
+
+        /** The packets with a key, or NULL if there are none */
+        const PacketList<L>* find(uint64_t key) const;
+
+        /** Add a packet at the back of the list of a key */
+        void insert(uint64_t key, DRAMPacket* dram_pkt);
+
+        /** Remove a packet from the list of a key */
+        void erase(uint64_t key, DRAMPacket* dram_pkt);
+
+      private:
+
+        /** A slot is free when its list is empty */
+        struct Slot {
+            uint64_t key;
+            PacketList<L> list;
+
+            Slot() : key(0) { }
+        };
+
+        /** Slot where the probing for a key starts */
+        size_t home(uint64_t key) const
+        { return (key * ULL(0x9e3779b97f4a7c15)) >> (64 - bits); }
+
+        /** Slot of a key, or the free slot where it would go */
+        size_t lookup(uint64_t key) const;
+
+        unsigned int bits;
+        std::vector<Slot> slots;
+
+    };
+
+    /**
+     * A read or write queue of DRAM packets. Besides the arrival
+     * order, the packets are indexed per bank and per open row
+     * candidate (bank and row), so that the scheduler finds the
+     * oldest packet to a bank, or the oldest row hit, by looking at
+     * each bank rather than at each queued packet. The packets are
+     * also indexed by burst address, so that writes are merged and
+     * reads serviced by the write queue without a scan. All the
+     * lists are linked through the packets, and the indexes are
+     * sized for the capacity of the queue, so that queueing a
+     * packet does not allocate anything.
+     */
+    class DRAMQueue {
+
+      public:
+
+        typedef PacketList<QueueLink>::const_iterator const_iterator;
+
+        DRAMQueue() : burstSize(0), nextSeqNum(0) { }
+
+        /**
+         * Set up the queue once the geometry of the DRAM is known
+         *
+         * @param burst_size Size of a DRAM burst in bytes
+         * @param num_banks Number of banks over all the ranks
+         * @param max_packets Maximum number of packets in the queue
+         */
+        void init(unsigned int burst_size, unsigned int num_banks,
+                  unsigned int max_packets)
+        {
+            burstSize = burst_size;
+            perBank.resize(num_banks);
+            perRow.init(max_packets);
+            perBurst.init(max_packets);
+        }
+
+        size_t size() const { return packets.size(); }
+        bool empty() const { return packets.empty(); }
+
+        /** Iterate over the packets in arrival order */
+        const_iterator begin() const { return packets.begin(); }
+        const_iterator end() const { return packets.end(); }
+
+        /** Add a packet at the back of the queue */
+        void push_back(DRAMPacket* dram_pkt);
+
+        /** Take a packet out of the queue, wherever it is */
+        void remove(DRAMPacket* dram_pkt);
+
+        /** Packets to a bank, in arrival order */
+        const PacketList<BankLink>& bankPackets(uint16_t bank_id) const
+        { return perBank[bank_id]; }
+
+        /**
+         * Packets to a row of a bank, in arrival order
+         *
+         * @return The list of packets or NULL if there are none
+         */
+        const PacketList<RowLink>* rowPackets(uint16_t bank_id,
+                                              uint32_t row) const
+        { return perRow.find(rowKey(bank_id, row)); }
+
+        /**
+         * Find the packets that start within a burst of an address,
+         * the only ones that can overlap with or be merged with an
+         * access to that address.
+         *
+         * @param addr Address of the access
+         * @param pkts Filled with the packets, in arrival order
+         */
+        void nearPackets(Addr addr, std::vector<DRAMPacket*>& pkts) const;
+
+        /** Update the address index after a packet has been merged */
+        void updateAddr(DRAMPacket* dram_pkt, Addr addr, unsigned int size);
+
+      private:
+
+        static uint64_t rowKey(uint16_t bank_id, uint32_t row)
+        { return (uint64_t(bank_id) << 32) | row; }
+
+        unsigned int burstSize;
+        uint64_t nextSeqNum;
+
+        PacketList<QueueLink> packets;
+        std::vector<PacketList<BankLink> > perBank;
+        PacketIndex<RowLink> perRow;
+        PacketIndex<BurstLink> perBurst;
+    };
+
     /**
      * Bunch of things requires to setup "events" in gem5
      * When event "respondEvent" occurs for example, the method
@@ -567,30 +832,61 @@ class DRAMCtrl : public AbstractMemory
 
     /**
      * The memory schduler/arbiter - picks which request needs to
-     * go next, based on the specified policy such as FCFS or FR-FCFS
-     * and moves it to the head of the queue.
+     * go next, based on the specified policy such as FCFS or FR-FCFS.
      * Prioritizes accesses to the same rank as previous burst unless
      * controller is switching command type.
      *
      * @param queue Queued requests to consider
      * @param switched_cmd_type Command type is changing
-     * @return true if a packet is scheduled to a rank which is available else
-     * false
+     * @return The packet to issue next, or NULL if no packet goes to
+     * a rank which is available
      */
-    bool chooseNext(std::deque<DRAMPacket*>& queue, bool switched_cmd_type);
+    DRAMPacket* chooseNext(const DRAMQueue& queue, bool switched_cmd_type);
 
     /**
-     * For FR-FCFS policy reorder the read/write queue depending on row buffer
-     * hits and earliest banks available in DRAM
+     * For FR-FCFS policy pick the oldest row buffer hit, or else the
+     * oldest request to one of the earliest banks available in DRAM
      * Prioritizes accesses to the same rank as previous burst unless
      * controller is switching command type.
      *
      * @param queue Queued requests to consider
      * @param switched_cmd_type Command type is changing
-     * @return true if a packet is scheduled to a rank which is available else
-     * false
+     * @return The packet to issue next, or NULL if no packet goes to
+     * a rank which is available
+     */
+    DRAMPacket* reorderQueue(const DRAMQueue& queue, bool switched_cmd_type);
+
+    /**
+     * With quality of service, narrow the choice down to the most
+     * urgent of the oldest packet and the oldest row hit of every
+     * bank in the available ranks, and apply the scheduling policy
+     * amongst those.
+     *
+     * @param queue Queued requests to consider
+     * @param switched_cmd_type Command type is changing
+     * @param selected The packet to issue next, or NULL if none
+     * @return false if the queued packets are all equally urgent and
+     * the choice is left to the normal scheduling policy
+     */
+    bool chooseNextQoS(const DRAMQueue& queue, bool switched_cmd_type,
+                       DRAMPacket*& selected);
+
+    /**
+     * Look up the id of a master configured for quality of service,
+     * allowing the name to be given relative to the system.
+     */
+    MasterID qosMasterId(const std::string& master_name) const;
+
+    /**
+     * Determine the current priority of a queued packet, taking into
+     * account escalation and the bandwidth reserved for its master.
+     */
+    unsigned int qosPriority(const DRAMPacket* dram_pkt) const;
+
+    /**
+     * Charge an access against the bandwidth reserved for its master.
      */
-    bool reorderQueue(std::deque<DRAMPacket*>& queue, bool switched_cmd_type);
+    void qosCharge(const DRAMPacket* dram_pkt);
 
     /**
      * Find which are the earliest banks ready to issue an activate
@@ -601,7 +897,7 @@ class DRAMCtrl : public AbstractMemory
      * @param switched_cmd_type Command type is changing
      * @return One-hot encoded mask of bank indices
      */
-    uint64_t minBankPrep(const std::deque<DRAMPacket*>& queue,
+    uint64_t minBankPrep(const DRAMQueue& queue,
                          bool switched_cmd_type) const;
 
     /**
@@ -636,11 +932,22 @@ class DRAMCtrl : public AbstractMemory
      */
     void printQs() const;
 
+    /**
+     * Get a DRAM packet from the pool of free ones, or allocate a new
+     * one if the pool is empty, to avoid a heap allocation per burst
+     */
+    DRAMPacket* allocDRAMPacket(PacketPtr pkt, bool is_read, uint8_t rank,
+                                uint8_t bank, uint32_t row, uint16_t bank_id,
+                                Addr addr, unsigned int size);
+
+    /** Return a DRAM packet to the pool */
+    void freeDRAMPacket(DRAMPacket* dram_pkt);
+
     /**
      * The controller's main read and write queues
      */
-    std::deque<DRAMPacket*> readQueue;
-    std::deque<DRAMPacket*> writeQueue;
+    DRAMQueue readQueue;
+    DRAMQueue writeQueue;
 
     /**
      * Response queue where read packets wait after we're done working
@@ -652,6 +959,18 @@ class DRAMCtrl : public AbstractMemory
      */
     std::deque<DRAMPacket*> respQueue;
 
+    /**
+     * Storage of DRAM packets that are no longer in use, ready to be
+     * reused by allocDRAMPacket
+     */
+    std::vector<void*> dramPktPool;
+
+    /**
+     * Scratch space for the queued packets close to an incoming
+     * access, kept around to avoid an allocation per burst
+     */
+    std::vector<DRAMPacket*> nearPkts;
+
     /**
      * If we need to drain, keep the drain manager around until we're
      * done here.
@@ -710,6 +1029,9 @@ class DRAMCtrl : public AbstractMemory
     const Tick tRTP;
     const Tick tRFC;
     const Tick tREFI;
+    const bool perBankRefresh;
+    const Tick tRFCpb;
+    const Tick tREFIpb;
     const Tick tRRD;
     const Tick tRRD_L;
     const Tick tXAW;
@@ -723,6 +1045,45 @@ class DRAMCtrl : public AbstractMemory
     Enums::AddrMap addrMapping;
     Enums::PageManage pageMgmt;
 
+    /**
+     * Quality of service configuration, with the masters given by
+     * name and resolved to master ids once they are all known. The
+     * reserved bandwidths are in ticks per byte.
+     */
+    const std::vector<std::string> qosMasterNames;
+    const std::vector<unsigned int> qosMasterPriorities;
+    const std::vector<float> qosMasterBandwidths;
+    const Tick qosReservationWindow;
+    const Tick qosEscalation;
+
+    /**
+     * Quality of service state of a master, i.e. its priority and
+     * the bandwidth reserved for it, as a bucket of bytes that fills
+     * up at the reserved rate.
+     */
+    struct QoSMaster
+    {
+        unsigned int priority;
+        double bytesPerTick;
+        double maxCredit;
+        double credit;
+        Tick creditUpdated;
+
+        QoSMaster() : priority(0), bytesPerTick(0), maxCredit(0),
+                      credit(0), creditUpdated(0)
+        { }
+
+        double creditAt(Tick when) const
+        {
+            return std::min(maxCredit,
+                            credit + (when - creditUpdated) * bytesPerTick);
+        }
+    };
+
+    /** Per master id, empty if quality of service is not used */
+    std::vector<QoSMaster> qosMasters;
+    unsigned int qosMaxPriority;
+
     /**
      * Max column accesses (read and write) per row, before forefully
      * closing it.
@@ -794,6 +1155,10 @@ class DRAMCtrl : public AbstractMemory
     Stats::Formula avgBusLat;
     Stats::Formula avgMemAccLat;
 
+    // Percentiles of the queueing latency in the read and write queue
+    Stats::Quantiles rdQLatQuantiles;
+    Stats::Quantiles wrQLatQuantiles;
+
     // Average bandwidth
     Stats::Formula avgRdBW;
     Stats::Formula avgWrBW;
@@ -808,6 +1173,14 @@ class DRAMCtrl : public AbstractMemory
     Stats::Average avgRdQLen;
     Stats::Average avgWrQLen;
 
+    // Read bursts and latencies per master
+    Stats::Vector perMasterRdBursts;
+    Stats::Vector perMasterTotMemAccLat;
+    Stats::Formula perMasterAvgMemAccLat;
+    /** Per master id, only for the masters configured for QoS */
+    std::vector<std::unique_ptr<Stats::Quantiles>>
+        perMasterMemAccLatQuantiles;
+
     // Row hit count and rate
     Stats::Scalar readRowHits;
     Stats::Scalar writeRowHits;
@@ -859,6 +1232,7 @@ class DRAMCtrl : public AbstractMemory
     void regStats();
 
     DRAMCtrl(const DRAMCtrlParams* p);
+    ~DRAMCtrl();
 
     unsigned int drain(DrainManager* dm);
 
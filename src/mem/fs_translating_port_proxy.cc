@@ -57,7 +57,8 @@ using namespace TheISA;
 
 FSTranslatingPortProxy::FSTranslatingPortProxy(ThreadContext *tc)
     : PortProxy(tc->getCpuPtr()->getDataPort(),
-                tc->getSystemPtr()->cacheLineSize()), _tc(tc)
+                tc->getSystemPtr()->cacheLineSize(), tc->getSystemPtr()),
+      _tc(tc)
 {
 }
 
@@ -88,6 +88,13 @@ NoncoherentXBar::NoncoherentXBar(const NoncoherentXBarParams *p)
                                            csprintf(".respLayer%d", i)));
     }
 
+    // now that all the ports exist, tell the layers who they
+    // arbitrate between
+    for (auto l: reqLayers)
+        l->setSources(slavePorts, qosWeights);
+    for (auto l: respLayers)
+        l->setSources(masterPorts, std::vector<unsigned int>());
+
     clearPortCache();
 }
 
@@ -61,6 +61,7 @@
 #include "base/flags.hh"
 #include "base/misc.hh"
 #include "base/printable.hh"
+#include "base/slab_pool.hh"
 #include "base/types.hh"
 #include "mem/request.hh"
 #include "sim/core.hh"
@@ -258,6 +259,9 @@ class Packet : public Printable
     /// the packet is destroyed. The pointer is assumed to be pointing
     /// to an array, and delete [] is consequently called
     static const FlagsType DYNAMIC_DATA           = 0x00002000;
+    /// The data pointer points to a chunk from the data pool, and
+    /// is given back to the pool when the packet is destroyed.
+    static const FlagsType POOL_DATA              = 0x00004000;
     /// suppress the error if this packet encounters a functional
     /// access failure.
     static const FlagsType SUPPRESS_FUNC_ERROR    = 0x00008000;
@@ -702,6 +706,42 @@ class Packet : public Printable
         deleteData();
     }
 
+    /**
+     * Packets are allocated from a per-thread slab pool rather than
+     * the heap, as there are several of them created and destroyed
+     * for every memory transaction.
+     */
+    static void *
+    operator new(size_t alloc_size)
+    {
+        assert(alloc_size == sizeof(Packet));
+        return SlabPool<Packet>::allocate();
+    }
+
+    static void
+    operator delete(void *p)
+    {
+        SlabPool<Packet>::release(p);
+    }
+
+    /** Tag for the pool of packet data buffers. */
+    struct PoolData;
+
+    /**
+     * Size of the chunks in the data pool, chosen to hold a typical
+     * cache line. Larger packets have their data allocated on the
+     * heap.
+     */
+    static const unsigned PoolDataSize = 64;
+
+    typedef SlabPool<PoolData, PoolDataSize> DataPool;
+
+    /** Number of packets allocated, for the global host stats. */
+    static Counter numAllocated() { return SlabPool<Packet>::allocated(); }
+
+    /** Number of data buffers allocated from the data pool. */
+    static Counter numDataAllocated() { return DataPool::allocated(); }
+
     /**
      * Take a request packet and modify it in place to be suitable for
      * returning as a response to that request.
@@ -895,20 +935,30 @@ class Packet : public Printable
     void
     deleteData()
     {
-        if (flags.isSet(DYNAMIC_DATA))
+        if (flags.isSet(POOL_DATA))
+            DataPool::release(data);
+        else if (flags.isSet(DYNAMIC_DATA))
             delete [] data;
 
-        flags.clear(STATIC_DATA|DYNAMIC_DATA);
+        flags.clear(STATIC_DATA|DYNAMIC_DATA|POOL_DATA);
         data = NULL;
     }
 
-    /** Allocate memory for the packet. */
+    /**
+     * Allocate memory for the packet, using the data pool if the
+     * packet is small enough to fit in a pool chunk.
+     */
     void
     allocate()
     {
         assert(flags.noneSet(STATIC_DATA|DYNAMIC_DATA));
         flags.set(DYNAMIC_DATA);
-        data = new uint8_t[getSize()];
+        if (getSize() <= PoolDataSize) {
+            flags.set(POOL_DATA);
+            data = static_cast<PacketDataPtr>(DataPool::allocate());
+        } else {
+            data = new uint8_t[getSize()];
+        }
     }
 
     /**
@@ -41,6 +41,8 @@
  *          Andreas Hansson
  */
 
+#include <algorithm>
+
 #include "base/trace.hh"
 #include "debug/Drain.hh"
 #include "debug/PacketQueue.hh"
@@ -49,8 +51,9 @@
 using namespace std;
 
 PacketQueue::PacketQueue(EventManager& _em, const std::string& _label)
-    : em(_em), sendEvent(this), drainManager(NULL), label(_label),
-      waitingOnRetry(false)
+    : transmitBuckets(NumBuckets), transmitSize(0), headBucket(0),
+      nextSeq(0), em(_em), sendEvent(this), drainManager(NULL),
+      label(_label), waitingOnRetry(false)
 {
 }
 
@@ -69,16 +72,37 @@ PacketQueue::retry()
 bool
 PacketQueue::checkFunctional(PacketPtr pkt)
 {
+    if (transmitSize == 0)
+        return false;
+
     pkt->pushLabel(label);
 
-    auto i = transmitList.begin();
+    // functional accesses are rare, so rather than indexing every
+    // packet as it is queued, look through the buckets for the
+    // packets that overlap the access, and check them in transmit
+    // order
+    Addr start = pkt->getAddr();
+    Addr end = start + std::max(pkt->getSize(), 1u) - 1;
+    std::vector<const DeferredPacket*> candidates;
+    for (auto b = transmitBuckets.begin(); b != transmitBuckets.end(); ++b) {
+        for (auto i = b->begin(); i != b->end(); ++i) {
+            Addr i_start = i->pkt->getAddr();
+            Addr i_end = i_start + std::max(i->pkt->getSize(), 1u) - 1;
+            if (i_start <= end && start <= i_end)
+                candidates.push_back(&*i);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const DeferredPacket* a, const DeferredPacket* b)
+              { return a->before(*b); });
+
     bool found = false;
 
-    while (!found && i != transmitList.end()) {
+    for (auto i = candidates.begin(); !found && i != candidates.end(); ++i) {
         // If the buffered packet contains data, and it overlaps the
         // current packet, then update data
-        found = pkt->checkFunctional(i->pkt);
-        ++i;
+        found = pkt->checkFunctional((*i)->pkt);
     }
 
     pkt->popLabel();
@@ -86,6 +110,67 @@ PacketQueue::checkFunctional(PacketPtr pkt)
     return found;
 }
 
+void
+PacketQueue::insertDeferred(const DeferredPacket& dp)
+{
+    DeferredPacketList& bucket = transmitBuckets[bucketIndex(dp.tick)];
+
+    // the common case is a packet that goes after everything else in
+    // its bucket, otherwise find the first packet that is later
+    if (bucket.empty() || dp.tick >= bucket.back().tick) {
+        bucket.push_back(dp);
+    } else {
+        auto i = std::upper_bound(bucket.begin(), bucket.end(), dp,
+                                  [](const DeferredPacket& a,
+                                     const DeferredPacket& b)
+                                  { return a.before(b); });
+        bucket.insert(i, dp);
+    }
+
+    if (transmitSize == 0 || dp.before(transmitFront()))
+        headBucket = bucketIndex(dp.tick);
+
+    ++transmitSize;
+}
+
+void
+PacketQueue::popDeferred()
+{
+    assert(transmitSize != 0);
+
+    Tick slot = transmitFront().tick / BucketWidth;
+    transmitBuckets[headBucket].pop_front();
+    --transmitSize;
+
+    if (transmitSize == 0)
+        return;
+
+    // walk the calendar from the bucket of the packet we just
+    // removed, looking for a packet that belongs to the current
+    // year of the bucket it is in
+    for (unsigned k = 0; k < NumBuckets; ++k) {
+        unsigned b = (slot + k) % NumBuckets;
+        if (!transmitBuckets[b].empty() &&
+            transmitBuckets[b].front().tick / BucketWidth == slot + k) {
+            headBucket = b;
+            return;
+        }
+    }
+
+    // everything is more than a year ahead, so fall back to comparing
+    // the head of each bucket
+    bool found = false;
+    for (unsigned b = 0; b < NumBuckets; ++b) {
+        if (!transmitBuckets[b].empty() &&
+            (!found ||
+             transmitBuckets[b].front().before(transmitFront()))) {
+            headBucket = b;
+            found = true;
+        }
+    }
+    assert(found);
+}
+
 void
 PacketQueue::schedSendEvent(Tick when)
 {
@@ -116,41 +201,28 @@ PacketQueue::schedSendTiming(PacketPtr pkt, Tick when, bool send_as_snoop)
 
     // add a very basic sanity check on the port to ensure the
     // invisible buffer is not growing beyond reasonable limits
-    if (transmitList.size() > 100) {
+    if (transmitSize > 100) {
         panic("Packet queue %s has grown beyond 100 packets\n",
               name());
     }
 
-    // nothing on the list, or earlier than current front element,
-    // schedule an event
-    if (transmitList.empty() || when < transmitList.front().tick) {
-        // note that currently we ignore a potentially outstanding retry
-        // and could in theory put a new packet at the head of the
-        // transmit list before retrying the existing packet
-        transmitList.push_front(DeferredPacket(when, pkt, send_as_snoop));
-        schedSendEvent(when);
-        return;
-    }
+    // if the packet ends up at the head of the queue, schedule an
+    // event, note that currently we ignore a potentially outstanding
+    // retry and could in theory put a new packet at the head of the
+    // transmit queue before retrying the existing packet
+    bool new_head = transmitSize == 0 || when < transmitFront().tick;
 
-    // list is non-empty and this belongs at the end
-    if (when >= transmitList.back().tick) {
-        transmitList.push_back(DeferredPacket(when, pkt, send_as_snoop));
-        return;
-    }
+    insertDeferred(DeferredPacket(when, nextSeq++, pkt, send_as_snoop));
 
-    // this belongs in the middle somewhere, insertion sort
-    auto i = transmitList.begin();
-    ++i; // already checked for insertion at front
-    while (i != transmitList.end() && when >= i->tick)
-        ++i;
-    transmitList.insert(i, DeferredPacket(when, pkt, send_as_snoop));
+    if (new_head)
+        schedSendEvent(when);
 }
 
 void PacketQueue::trySendTiming()
 {
     assert(deferredPacketReady());
 
-    DeferredPacket dp = transmitList.front();
+    DeferredPacket dp = transmitFront();
 
     // use the appropriate implementation of sendTiming based on the
     // type of port associated with the queue, and whether the packet
@@ -159,7 +231,7 @@ void PacketQueue::trySendTiming()
 
     if (!waitingOnRetry) {
         // take the packet off the list
-        transmitList.pop_front();
+        popDeferred();
     }
 }
 
@@ -183,7 +255,7 @@ PacketQueue::scheduleSend(Tick time)
         }
     } else {
         // no more to send, so if we're draining, we may be done
-        if (drainManager && transmitList.empty() && !sendEvent.scheduled()) {
+        if (drainManager && transmitSize == 0 && !sendEvent.scheduled()) {
             DPRINTF(Drain, "PacketQueue done draining,"
                     "processing drain event\n");
             drainManager->signalDrainDone();
@@ -216,7 +288,7 @@ PacketQueue::processSendEvent()
 unsigned int
 PacketQueue::drain(DrainManager *dm)
 {
-    if (transmitList.empty())
+    if (transmitSize == 0)
         return 0;
     DPRINTF(Drain, "PacketQueue not drained\n");
     drainManager = dm;
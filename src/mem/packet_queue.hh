@@ -53,7 +53,8 @@
  * notifying the queue when a transfer ends.
  */
 
-#include <list>
+#include <deque>
+#include <vector>
 
 #include "mem/port.hh"
 #include "sim/drain.hh"
@@ -70,18 +71,57 @@ class PacketQueue : public Drainable
     class DeferredPacket {
       public:
         Tick tick;      ///< The tick when the packet is ready to transmit
+        uint64_t seq;   ///< Insertion order, to break ties on the tick
         PacketPtr pkt;  ///< Pointer to the packet to transmit
         bool sendAsSnoop; ///< Should it be sent as a snoop or not
-        DeferredPacket(Tick t, PacketPtr p, bool send_as_snoop)
-            : tick(t), pkt(p), sendAsSnoop(send_as_snoop)
+        DeferredPacket(Tick t, uint64_t s, PacketPtr p, bool send_as_snoop)
+            : tick(t), seq(s), pkt(p), sendAsSnoop(send_as_snoop)
         {}
+
+        /** Order by transmit time, and then by insertion. */
+        bool before(const DeferredPacket& other) const
+        { return tick < other.tick || (tick == other.tick && seq < other.seq); }
     };
 
-    typedef std::list<DeferredPacket> DeferredPacketList;
+    typedef std::deque<DeferredPacket> DeferredPacketList;
+
+    /**
+     * The outgoing packets that haven't been serviced yet are kept
+     * in a calendar queue, i.e. an array of buckets that each cover
+     * BucketWidth ticks, with the calendar wrapping around after
+     * NumBuckets buckets. Each bucket is sorted, and as most packets
+     * are scheduled a short and roughly constant time ahead, an
+     * insertion is almost always an append to a short bucket. Packets
+     * that are more than a calendar year ahead share the buckets
+     * with the packets of the current year, and are only slower to
+     * find when they eventually get to the head.
+     */
+    static const unsigned NumBuckets = 64;
+    static const Tick BucketWidth = 1000;
+
+    std::vector<DeferredPacketList> transmitBuckets;
+
+    /** Number of packets in the transmit buckets. */
+    size_t transmitSize;
+
+    /** Bucket holding the head packet, valid if transmitSize > 0. */
+    unsigned headBucket;
+
+    /** Counter used to order packets with the same tick. */
+    uint64_t nextSeq;
+
+    static unsigned bucketIndex(Tick tick)
+    { return (tick / BucketWidth) % NumBuckets; }
+
+    /** The packet at the head of the transmit buckets. */
+    const DeferredPacket& transmitFront() const
+    { return transmitBuckets[headBucket].front(); }
+
+    /** Add a packet to the transmit buckets. */
+    void insertDeferred(const DeferredPacket& dp);
 
-    /** A list of outgoing timing response packets that haven't been
-     * serviced yet. */
-    DeferredPacketList transmitList;
+    /** Remove the head packet and find the new head. */
+    void popDeferred();
 
     /** The manager which is used for the event queue */
     EventManager& em;
@@ -109,10 +149,10 @@ class PacketQueue : public Drainable
 
     /** Check whether we have a packet ready to go on the transmit list. */
     bool deferredPacketReady() const
-    { return !transmitList.empty() && transmitList.front().tick <= curTick(); }
+    { return transmitSize != 0 && transmitFront().tick <= curTick(); }
 
     Tick deferredPacketReadyTime() const
-    { return transmitList.empty() ? MaxTick : transmitList.front().tick; }
+    { return transmitSize == 0 ? MaxTick : transmitFront().tick; }
 
     /**
      * Attempt to send the packet at the head of the transmit
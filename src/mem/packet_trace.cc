@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cstring>
+
+#include "base/atomicio.hh"
+#include "base/misc.hh"
+#include "mem/packet_trace.hh"
+
+using namespace std;
+
+const char PacketTrace::magic[8] = { '\x89', 'g', 'e', 'm', '5', 'p',
+                                     'k', 't' };
+
+const uint32_t PacketTrace::version;
+
+bool
+PacketTrace::isPacketTrace(const string& filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    char file_magic[sizeof(magic)];
+    bool match = atomic_read(fd, file_magic, sizeof(file_magic)) ==
+        sizeof(file_magic) && memcmp(file_magic, magic, sizeof(magic)) == 0;
+    close(fd);
+    return match;
+}
+
+PacketTraceOutput::PacketTraceOutput(const string& filename,
+                                     const string& obj_id, uint64_t tick_freq,
+                                     bool compress, uint32_t buffer_records)
+    : fileName(filename), fd(-1), compress(compress),
+      bufferRecords(buffer_records), active(0), fill(0), pending(0),
+      pendingBuffer(0), done(false)
+{
+    if (bufferRecords == 0)
+        fatal("Packet trace %s needs a non-zero buffer size\n", fileName);
+
+    fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0)
+        panic("Could not open %s for writing\n", fileName);
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.recordSize = sizeof(PacketTraceRecord);
+    header.tickFreq = tick_freq;
+    strncpy(header.objId, obj_id.c_str(), sizeof(header.objId) - 1);
+
+    if (atomic_write(fd, &header, sizeof(header)) != sizeof(header))
+        panic("Failed to write header of packet trace %s\n", fileName);
+
+    buffers[0].resize(bufferRecords);
+    buffers[1].resize(bufferRecords);
+    if (compress)
+        compressed.resize(compressBound(bufferRecords *
+                                        sizeof(PacketTraceRecord)));
+
+    writer = thread(&PacketTraceOutput::writeLoop, this);
+}
+
+PacketTraceOutput::~PacketTraceOutput()
+{
+    if (fill != 0)
+        swapBuffers();
+
+    {
+        unique_lock<mutex> guard(lock);
+        done = true;
+    }
+    cond.notify_all();
+    writer.join();
+
+    close(fd);
+}
+
+void
+PacketTraceOutput::swapBuffers()
+{
+    {
+        unique_lock<mutex> guard(lock);
+        // wait for the writer to be done with the other buffer
+        cond.wait(guard, [this] { return pending == 0; });
+        pending = fill;
+        pendingBuffer = active;
+    }
+    cond.notify_all();
+
+    active ^= 1;
+    fill = 0;
+}
+
+void
+PacketTraceOutput::writeLoop()
+{
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        cond.wait(guard, [this] { return pending != 0 || done; });
+        if (pending == 0)
+            break;
+
+        // the buffer handed over is left alone until we clear pending
+        const PacketTraceRecord* records = buffers[pendingBuffer].data();
+        uint32_t num_records = pending;
+
+        guard.unlock();
+        writeBlock(records, num_records);
+        guard.lock();
+
+        pending = 0;
+        cond.notify_all();
+    }
+}
+
+void
+PacketTraceOutput::writeBlock(const PacketTraceRecord* records,
+                              uint32_t num_records)
+{
+    BlockHeader block = { num_records,
+                          uint32_t(num_records * sizeof(PacketTraceRecord)) };
+    const void* data = records;
+
+    if (compress) {
+        uLongf size = compressed.size();
+        // fall back to storing the block if it does not compress
+        if (compress2(compressed.data(), &size, (const Bytef*)records,
+                      block.size, Z_BEST_SPEED) == Z_OK &&
+            size < block.size) {
+            block.size = size;
+            data = compressed.data();
+        }
+    }
+
+    if (atomic_write(fd, &block, sizeof(block)) != sizeof(block) ||
+        atomic_write(fd, data, block.size) != block.size)
+        panic("Failed to write block to packet trace %s\n", fileName);
+}
+
+PacketTraceInput::PacketTraceInput(const string& filename)
+    : fileName(filename), fd(-1), pos(0)
+{
+    fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        panic("Could not open %s for reading\n", fileName);
+
+    if (atomic_read(fd, &header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, magic, sizeof(magic)) != 0)
+        panic("Input file %s is not a valid gem5 packet trace\n", fileName);
+
+    if (header.version != version ||
+        header.recordSize != sizeof(PacketTraceRecord))
+        panic("Packet trace %s has version %d with %d byte records, "
+              "expected version %d with %d byte records\n", fileName,
+              header.version, header.recordSize, version,
+              sizeof(PacketTraceRecord));
+
+    header.objId[sizeof(header.objId) - 1] = 0;
+}
+
+PacketTraceInput::~PacketTraceInput()
+{
+    close(fd);
+}
+
+void
+PacketTraceInput::reset()
+{
+    if (lseek(fd, sizeof(header), SEEK_SET) < 0)
+        panic("Failed to rewind packet trace %s\n", fileName);
+
+    records.clear();
+    pos = 0;
+}
+
+bool
+PacketTraceInput::readBlock()
+{
+    BlockHeader block;
+    ssize_t bytes = atomic_read(fd, &block, sizeof(block));
+    if (bytes == 0)
+        return false;
+
+    uLongf raw_size = block.numRecords * sizeof(PacketTraceRecord);
+    if (bytes != sizeof(block) || block.numRecords == 0 ||
+        block.size > raw_size)
+        panic("Corrupt block in packet trace %s\n", fileName);
+
+    records.resize(block.numRecords);
+    pos = 0;
+
+    if (block.size == raw_size) {
+        if (atomic_read(fd, records.data(), raw_size) != raw_size)
+            panic("Truncated block in packet trace %s\n", fileName);
+    } else {
+        // inflate straight into the records
+        compressed.resize(block.size);
+        if (atomic_read(fd, compressed.data(), block.size) != block.size ||
+            uncompress((Bytef*)records.data(), &raw_size, compressed.data(),
+                       block.size) != Z_OK ||
+            raw_size != block.numRecords * sizeof(PacketTraceRecord))
+            panic("Failed to decompress block in packet trace %s\n",
+                  fileName);
+    }
+
+    return true;
+}
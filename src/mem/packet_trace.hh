@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Declaration of a binary packet trace format with fixed-layout
+ * records, written in blocks by a background thread.
+ */
+
+#ifndef __MEM_PACKET_TRACE_HH__
+#define __MEM_PACKET_TRACE_HH__
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * A single packet in a binary trace. The layout is fixed, and the
+ * records are stored in the byte order of the host, which is
+ * little endian for all the hosts we build on.
+ */
+struct PacketTraceRecord
+{
+    /** Time the packet was seen */
+    uint64_t tick;
+
+    /** Address of the packet */
+    uint64_t addr;
+
+    /** Size of the packet in bytes */
+    uint32_t size;
+
+    /** Flags of the request */
+    uint32_t flags;
+
+    /** Command, as the index of the MemCmd */
+    uint32_t cmd;
+
+    /** Master ID of the request */
+    uint32_t masterId;
+};
+
+static_assert(sizeof(PacketTraceRecord) == 32,
+              "Unexpected padding in PacketTraceRecord");
+
+/**
+ * A binary packet trace starts with a header, followed by blocks of
+ * records. Each block is preceded by a block header giving the
+ * number of records and the number of bytes that follow. If the
+ * latter is smaller than the size of the records, the block is
+ * compressed with deflate.
+ */
+class PacketTrace
+{
+
+  public:
+
+    /**
+     * Check if a file is a binary packet trace by looking at its
+     * magic, thus distinguishing it from a protobuf trace.
+     *
+     * @param filename Path to the file to check
+     * @return true if the file is a binary packet trace
+     */
+    static bool isPacketTrace(const std::string& filename);
+
+  protected:
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t tickFreq;
+        char objId[104];
+    };
+
+    struct BlockHeader
+    {
+        uint32_t numRecords;
+        uint32_t size;
+    };
+
+    /// The leading non-ASCII byte keeps the magic apart from both the
+    /// protobuf magic and the gzip one
+    static const char magic[8];
+
+    static const uint32_t version = 1;
+
+    PacketTrace() {}
+
+  private:
+
+    /**
+     * Hide the copy constructor and assignment operator.
+     * @{
+     */
+    PacketTrace(const PacketTrace&);
+    PacketTrace& operator=(const PacketTrace&);
+    /** @} */
+};
+
+/**
+ * The output side of a binary packet trace. The records are written
+ * in place in one of two buffers, and once a buffer is full it is
+ * handed over to a host thread that compresses and writes it, while
+ * the simulation carries on filling the other buffer. The simulation
+ * thus only waits if it fills a buffer before the previous one is
+ * written.
+ */
+class PacketTraceOutput : public PacketTrace
+{
+
+  public:
+
+    /**
+     * Create a binary trace and start the thread writing it.
+     *
+     * @param filename Path to the file to create or truncate
+     * @param obj_id Name of the object capturing the trace
+     * @param tick_freq Frequency of the ticks in the trace
+     * @param compress Compress the blocks with deflate
+     * @param buffer_records Number of records per buffer
+     */
+    PacketTraceOutput(const std::string& filename, const std::string& obj_id,
+                      uint64_t tick_freq, bool compress,
+                      uint32_t buffer_records);
+
+    /**
+     * Write any remaining records, stop the thread and close the
+     * file.
+     */
+    ~PacketTraceOutput();
+
+    /**
+     * Get the next record to fill in. The record is part of the
+     * buffer, and is written once the buffer is full.
+     *
+     * @return The record to fill in
+     */
+    PacketTraceRecord& next()
+    {
+        if (fill == bufferRecords)
+            swapBuffers();
+        return buffers[active][fill++];
+    }
+
+  private:
+
+    /**
+     * Hand the active buffer over to the writer thread, waiting for
+     * the previous one to be written if needed.
+     */
+    void swapBuffers();
+
+    /** Main loop of the writer thread */
+    void writeLoop();
+
+    /**
+     * Compress and write a block of records.
+     */
+    void writeBlock(const PacketTraceRecord* records, uint32_t num_records);
+
+    const std::string fileName;
+
+    int fd;
+
+    const bool compress;
+
+    const uint32_t bufferRecords;
+
+    /// The two buffers, one being filled and one being written
+    std::vector<PacketTraceRecord> buffers[2];
+
+    /// Index of the buffer being filled
+    unsigned int active;
+
+    /// Number of records in the buffer being filled
+    uint32_t fill;
+
+    /// Number of records in the buffer handed over, zero if the
+    /// writer thread is idle
+    uint32_t pending;
+
+    /// Index of the buffer handed over
+    unsigned int pendingBuffer;
+
+    /// Set when the trace is closed
+    bool done;
+
+    /// Scratch space for the compressed blocks
+    std::vector<uint8_t> compressed;
+
+    std::mutex lock;
+    std::condition_variable cond;
+    std::thread writer;
+};
+
+/**
+ * The input side of a binary packet trace, decompressing a block at
+ * a time and handing out the records in place.
+ */
+class PacketTraceInput : public PacketTrace
+{
+
+  public:
+
+    /**
+     * Open a binary trace and check its header.
+     *
+     * @param filename Path to the file to read from
+     */
+    PacketTraceInput(const std::string& filename);
+
+    ~PacketTraceInput();
+
+    /**
+     * Get the next record in the trace.
+     *
+     * @return The next record, or NULL at the end of the trace
+     */
+    const PacketTraceRecord* read()
+    {
+        if (pos == records.size() && !readBlock())
+            return NULL;
+        return &records[pos++];
+    }
+
+    /**
+     * Reset the trace to the first record.
+     */
+    void reset();
+
+    /** Name of the object that captured the trace */
+    std::string objId() const { return header.objId; }
+
+    /** Frequency of the ticks in the trace */
+    uint64_t tickFreq() const { return header.tickFreq; }
+
+  private:
+
+    /**
+     * Read and decompress the next block.
+     *
+     * @return false at the end of the trace
+     */
+    bool readBlock();
+
+    const std::string fileName;
+
+    int fd;
+
+    Header header;
+
+    /// The records of the current block
+    std::vector<PacketTraceRecord> records;
+
+    /// Next record to hand out in the current block
+    size_t pos;
+
+    /// Scratch space for the compressed blocks
+    std::vector<uint8_t> compressed;
+};
+
+#endif //__MEM_PACKET_TRACE_HH__
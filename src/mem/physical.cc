@@ -38,23 +38,32 @@
  */
 
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/user.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <zlib.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <climits>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
 
+#include "base/bitfield.hh"
 #include "base/trace.hh"
 #include "debug/AddrRanges.hh"
 #include "debug/Checkpoint.hh"
 #include "mem/abstract_mem.hh"
 #include "mem/physical.hh"
+#include "sim/eventq.hh"
 
 /**
  * On Linux, MAP_NORESERVE allow us to simulate a very large memory
@@ -72,10 +81,20 @@ using namespace std;
 
 PhysicalMemory::PhysicalMemory(const string& _name,
                                const vector<AbstractMemory*>& _memories,
-                               bool mmap_using_noreserve) :
+                               bool mmap_using_noreserve,
+                               Enums::PhysMemFormat _format,
+                               unsigned int max_deltas,
+                               unsigned int num_threads) :
     _name(_name), rangeCache(addrMap.end()), size(0),
-    mmapUsingNoReserve(mmap_using_noreserve)
+    mmapUsingNoReserve(mmap_using_noreserve), format(_format),
+    maxDeltas(max_deltas),
+    numThreads(num_threads ? num_threads :
+               max(1u, thread::hardware_concurrency())),
+    backingStoreExported(false)
 {
+    for (auto& l : lineLocks)
+        l.store(0, std::memory_order_relaxed);
+
     if (mmap_using_noreserve)
         warn("Not reserving swap space. May cause SIGSEGV on actual usage\n");
 
@@ -186,11 +205,24 @@ PhysicalMemory::createBackingStore(AddrRange range,
     // it appropriately
     backingStore.push_back(make_pair(range, pmem));
 
+    // with incremental checkpoints, track the pages that are written,
+    // note that the bitmap storage stays in place as the vector of
+    // bitmaps grows
+    dirtyPages.emplace_back();
+    storeChains.emplace_back();
+    if (maxDeltas) {
+        uint64_t pages = divCeil(range.size(),
+                                 ULL(1) << AbstractMemory::DirtyPageShift);
+        dirtyPages.back().resize(divCeil(pages, 64), 0);
+    }
+
     // point the memories to their backing store
     for (const auto& m : _memories) {
         DPRINTF(AddrRanges, "Mapping memory %s to backing store\n",
                 m->name());
         m->setBackingStore(pmem);
+        if (maxDeltas)
+            m->setDirtyPages(dirtyPages.back().data());
     }
 }
 
@@ -288,6 +320,288 @@ PhysicalMemory::functionalAccess(PacketPtr pkt)
     }
 }
 
+uint8_t*
+PhysicalMemory::toHostRange(Addr addr, int size,
+                            AbstractMemory** mem) const
+{
+    if (size <= 0)
+        return NULL;
+
+    // do not touch the range cache, as this may be called by host
+    // threads other than the one simulating the owner
+    const auto& m = addrMap.find(addr);
+    if (m == addrMap.end())
+        return NULL;
+
+    uint8_t* host_addr = m->second->toHostAddr(addr);
+    if (!host_addr)
+        return NULL;
+
+    // the access may span several memories, e.g. when interleaved,
+    // but only as long as it stays within the backing store of the
+    // first one, which is linearly mapped
+    AddrRange access_range(addr, addr + size - 1);
+    for (const auto& s : backingStore) {
+        if (access_range.isSubset(s.first) &&
+            s.second + (addr - s.first.start()) == host_addr) {
+            *mem = m->second;
+            return host_addr;
+        }
+    }
+
+    return NULL;
+}
+
+bool
+PhysicalMemory::concurrentUse() const
+{
+    return inParallelMode && !concurrentContexts.empty();
+}
+
+bool
+PhysicalMemory::directRead(Addr addr, uint8_t* p, int size) const
+{
+    if (concurrentUse())
+        return false;
+
+    AbstractMemory* m;
+    uint8_t* host_addr = toHostRange(addr, size, &m);
+    if (!host_addr)
+        return false;
+
+    std::memcpy(p, host_addr, size);
+    return true;
+}
+
+bool
+PhysicalMemory::directWrite(Addr addr, const uint8_t* p, int size)
+{
+    if (concurrentUse())
+        return false;
+
+    AbstractMemory* m;
+    uint8_t* host_addr = toHostRange(addr, size, &m);
+    if (!host_addr)
+        return false;
+
+    std::memcpy(host_addr, p, size);
+    m->markDirty(host_addr, size);
+    return true;
+}
+
+unsigned int
+PhysicalMemory::lineLocksOf(Addr addr, int size, unsigned int* locks) const
+{
+    Addr first = addr >> LineShift;
+    Addr last = (addr + size - 1) >> LineShift;
+    panic_if(last - first >= MaxAccessLines,
+             "Access of %d bytes at %#x touches too many lines\n",
+             size, addr);
+
+    unsigned int n = 0;
+    for (Addr l = first; l <= last; ++l)
+        locks[n++] = l & (NumLineLocks - 1);
+
+    // sort them to always acquire locks in the same order, and drop
+    // any duplicates to not wait for ourselves
+    std::sort(locks, locks + n);
+    return std::unique(locks, locks + n) - locks;
+}
+
+bool
+PhysicalMemory::acquireLine(unsigned int lock, bool wait, uint64_t& seq)
+{
+    std::atomic<uint64_t>& l = lineLocks[lock];
+    seq = l.load(std::memory_order_relaxed);
+    while (true) {
+        if (seq & LineLocked) {
+            if (!wait)
+                return false;
+            seq = l.load(std::memory_order_relaxed);
+        } else if (l.compare_exchange_weak(seq, seq | LineLocked,
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+void
+PhysicalMemory::releaseLine(unsigned int lock, uint64_t seq, bool written,
+                            const ConcurrentContext& ctx)
+{
+    if (!written) {
+        lineLocks[lock].store(seq, std::memory_order_release);
+        return;
+    }
+
+    // a write clears all reservations on the line, and as there is
+    // no record of who holds them, tell anyone watching the lock
+    lineLocks[lock].store((seq & ~LineWatched) + LineSeqInc,
+                          std::memory_order_release);
+    if (seq & LineWatched) {
+        for (auto c : concurrentContexts) {
+            if (c != &ctx &&
+                c->watchLine.load(std::memory_order_relaxed) == lock)
+                c->monitorCleared.store(true, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool
+PhysicalMemory::concurrentAccess(PacketPtr pkt, ConcurrentContext& ctx)
+{
+    assert(pkt->isRequest());
+    Addr addr = pkt->getAddr();
+    int size = pkt->getSize();
+
+    AbstractMemory* m;
+    uint8_t* host_addr = toHostRange(addr, size, &m);
+    if (!host_addr)
+        return false;
+
+    Request* req = pkt->req;
+    unsigned int locks[MaxAccessLines];
+    unsigned int num_locks = lineLocksOf(addr, size, locks);
+
+    if (req->isLocked()) {
+        // a locked read-modify-write holds on to all the lines it
+        // touches until it is done, and only one can be in progress
+        // at any time to not deadlock
+        if (!ctx.numHeld)
+            busLock.lock();
+        for (unsigned int i = 0; i < num_locks; ++i) {
+            if (std::find(ctx.heldLines, ctx.heldLines + ctx.numHeld,
+                          locks[i]) != ctx.heldLines + ctx.numHeld)
+                continue;
+            panic_if(ctx.numHeld == MaxHeldLines,
+                     "Locked access at %#x holds too many lines\n", addr);
+            acquireLine(locks[i], true, ctx.heldSeqs[ctx.numHeld]);
+            ctx.heldLines[ctx.numHeld++] = locks[i];
+        }
+
+        if (pkt->isRead()) {
+            std::memcpy(pkt->getPtr<uint8_t>(), host_addr, size);
+        } else {
+            assert(pkt->isWrite());
+            std::memcpy(host_addr, pkt->getConstPtr<uint8_t>(), size);
+            m->markDirty(host_addr, size);
+        }
+    } else if (pkt->isRead() && !pkt->isWrite()) {
+        if (pkt->isLLSC()) {
+            assert(num_locks == 1);
+            std::atomic<uint64_t>& l = lineLocks[locks[0]];
+            uint64_t seq;
+            // read the data while the line is not written, and flag
+            // the reservation, retrying if someone got in between
+            do {
+                do {
+                    seq = l.load(std::memory_order_acquire);
+                } while (seq & LineLocked);
+                std::memcpy(pkt->getPtr<uint8_t>(), host_addr, size);
+            } while (!l.compare_exchange_weak(seq, seq | LineWatched,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_relaxed));
+            ctx.llscLine = locks[0];
+            ctx.llscSeq = seq | LineWatched;
+            ctx.watchLine.store(locks[0], std::memory_order_relaxed);
+        } else {
+            std::memcpy(pkt->getPtr<uint8_t>(), host_addr, size);
+        }
+    } else if (pkt->isWrite()) {
+        // take the line locks, only waiting as long as none are
+        // held, and skipping any held by an ongoing locked
+        // read-modify-write of our own
+        uint64_t seqs[MaxAccessLines];
+        bool owned[MaxAccessLines];
+        bool acquired;
+        do {
+            acquired = true;
+            unsigned int num_owned = 0;
+            for (unsigned int i = 0; i < num_locks; ++i) {
+                owned[i] = false;
+                if (std::find(ctx.heldLines, ctx.heldLines + ctx.numHeld,
+                              locks[i]) != ctx.heldLines + ctx.numHeld)
+                    continue;
+                if (!acquireLine(locks[i], num_owned == 0, seqs[i])) {
+                    for (unsigned int j = 0; j < i; ++j) {
+                        if (owned[j])
+                            releaseLine(locks[j], seqs[j], false, ctx);
+                    }
+                    acquired = false;
+                    break;
+                }
+                owned[i] = true;
+                ++num_owned;
+            }
+        } while (!acquired);
+
+        bool written = true;
+        if (pkt->cmd == MemCmd::SwapReq) {
+            std::vector<uint8_t> overwrite_val(size);
+            std::memcpy(&overwrite_val[0], pkt->getConstPtr<uint8_t>(), size);
+            std::memcpy(pkt->getPtr<uint8_t>(), host_addr, size);
+
+            if (req->isCondSwap()) {
+                if (size == sizeof(uint64_t)) {
+                    uint64_t condition_val64 = req->getExtraData();
+                    written = !std::memcmp(&condition_val64, host_addr,
+                                           sizeof(uint64_t));
+                } else if (size == sizeof(uint32_t)) {
+                    uint32_t condition_val32 = (uint32_t)req->getExtraData();
+                    written = !std::memcmp(&condition_val32, host_addr,
+                                           sizeof(uint32_t));
+                } else {
+                    panic("Invalid size for conditional read/write\n");
+                }
+            }
+
+            if (written)
+                std::memcpy(host_addr, &overwrite_val[0], size);
+        } else if (pkt->isLLSC()) {
+            // the store conditional succeeds if nobody wrote the
+            // line since the load locked
+            assert(num_locks == 1 && owned[0]);
+            written = ctx.llscLine == locks[0] && seqs[0] == ctx.llscSeq;
+            req->setExtraData(written ? 1 : 0);
+            ctx.llscLine = ConcurrentContext::NoLine;
+            ctx.watchLine.store(ConcurrentContext::NoLine,
+                                std::memory_order_relaxed);
+            if (written)
+                std::memcpy(host_addr, pkt->getConstPtr<uint8_t>(), size);
+        } else {
+            std::memcpy(host_addr, pkt->getConstPtr<uint8_t>(), size);
+        }
+
+        if (written)
+            m->markDirty(host_addr, size);
+
+        for (unsigned int i = 0; i < num_locks; ++i) {
+            if (owned[i])
+                releaseLine(locks[i], seqs[i], written, ctx);
+        }
+    } else {
+        panic("Unexpected concurrent access %s\n", pkt->cmdString());
+    }
+
+    if (pkt->needsResponse())
+        pkt->makeResponse();
+
+    return true;
+}
+
+void
+PhysicalMemory::concurrentUnlock(ConcurrentContext& ctx)
+{
+    if (!ctx.numHeld)
+        return;
+
+    for (unsigned int i = 0; i < ctx.numHeld; ++i)
+        releaseLine(ctx.heldLines[i], ctx.heldSeqs[i], true, ctx);
+    ctx.numHeld = 0;
+    busLock.unlock();
+}
+
 void
 PhysicalMemory::serialize(ostream& os)
 {
@@ -318,13 +632,74 @@ PhysicalMemory::serialize(ostream& os)
     }
 }
 
+/**
+ * Get the canonical, absolute, path of an existing file or directory.
+ */
+static string
+canonicalPath(const string& path)
+{
+    char* real_path = realpath(path.c_str(), NULL);
+    if (real_path == NULL)
+        fatal("Can't resolve path '%s': %s\n", path, strerror(errno));
+    string canonical_path(real_path);
+    free(real_path);
+    return canonical_path;
+}
+
+/**
+ * Express a canonical path relative to a canonical directory.
+ */
+static string
+relativePath(const string& dir, const string& path)
+{
+    // find the directories the two have in common
+    size_t common = 0;
+    if (path.compare(0, dir.size(), dir) == 0 && path.size() > dir.size() &&
+        path[dir.size()] == '/') {
+        common = dir.size() + 1;
+    } else {
+        for (size_t i = 0; i < min(dir.size(), path.size()) &&
+                 dir[i] == path[i]; ++i) {
+            if (dir[i] == '/')
+                common = i + 1;
+        }
+    }
+
+    // go up from what is left of the directory
+    string rel_path;
+    if (common < dir.size()) {
+        rel_path = "../";
+        for (size_t i = common; i < dir.size(); ++i) {
+            if (dir[i] == '/')
+                rel_path += "../";
+        }
+    }
+
+    return rel_path + path.substr(common);
+}
+
 void
 PhysicalMemory::serializeStore(ostream& os, unsigned int store_id,
                                AddrRange range, uint8_t* pmem)
 {
+    auto& chain = storeChains[store_id];
+
+    if (maxDeltas && backingStoreExported)
+        warn_once("Physical memory backing store is accessed directly by "
+                  "the host, writing full checkpoints\n");
+
+    // only write a delta if there is an image to apply it to, and all
+    // writes since that image was created are known
+    bool delta = !chain.empty() && chain.size() <= maxDeltas &&
+        !backingStoreExported;
+
     // we cannot use the address range for the name as the
-    // memories that are not part of the address map can overlap
-    string filename = name() + ".store" + to_string(store_id) + ".pmem";
+    // memories that are not part of the address map can overlap,
+    // and as later checkpoints in the same directory must not
+    // overwrite a delta that an earlier chain refers to, the deltas
+    // are also named after the tick they are taken at
+    string filename = name() + ".store" + to_string(store_id) +
+        (delta ? "." + to_string(curTick()) + ".delta" : ".pmem");
     long range_size = range.size();
 
     DPRINTF(Checkpoint, "Serializing physical memory %s with size %d\n",
@@ -336,10 +711,61 @@ PhysicalMemory::serializeStore(ostream& os, unsigned int store_id,
 
     // write memory file
     string filepath = Checkpoint::dir() + "/" + filename.c_str();
+    string store_format;
+    if (delta) {
+        store_format = "delta";
+
+        // two checkpoints at the same tick would still clash
+        if (::access(filepath.c_str(), F_OK) == 0)
+            fatal("Physical memory delta '%s' already exists, and other "
+                  "checkpoints may depend on it\n", filepath);
+
+        uint64_t pages = writeDeltaStore(filepath, range, pmem,
+                                         dirtyPages[store_id]);
+        DPRINTF(Checkpoint, "Wrote %d dirty pages on top of %d images\n",
+                pages, chain.size());
+
+        // record the images the delta applies to, relative to this
+        // checkpoint so that a chain of checkpoints can be moved
+        string cpt_dir = canonicalPath(Checkpoint::dir());
+        vector<string> chain_formats;
+        vector<string> chain_files;
+        for (const auto& c : chain) {
+            chain_formats.push_back(c.first);
+            chain_files.push_back(relativePath(cpt_dir, c.second));
+        }
+        arrayParamOut(os, "chain_formats", chain_formats);
+        arrayParamOut(os, "chain_files", chain_files);
+
+        chain.emplace_back(store_format, canonicalPath(filepath));
+    } else {
+        store_format = Enums::PhysMemFormatStrings[format];
+
+        if (format == Enums::raw)
+            writeRawStore(filepath, range, pmem);
+        else if (format == Enums::chunked)
+            writeChunkedStore(filepath, range, pmem);
+        else
+            writeGzipStore(filepath, range, pmem);
+
+        if (maxDeltas)
+            chain.assign(1, make_pair(store_format, canonicalPath(filepath)));
+    }
+
+    SERIALIZE_SCALAR(store_format);
+
+    // track the pages written from this checkpoint onwards
+    fill(dirtyPages[store_id].begin(), dirtyPages[store_id].end(), 0);
+}
+
+void
+PhysicalMemory::writeGzipStore(const string& filepath, AddrRange range,
+                               const uint8_t* pmem) const
+{
     gzFile compressed_mem = gzopen(filepath.c_str(), "wb");
     if (compressed_mem == NULL)
         fatal("Can't open physical memory checkpoint file '%s'\n",
-              filename);
+              filepath);
 
     uint64_t pass_size = 0;
 
@@ -352,7 +778,7 @@ PhysicalMemory::serializeStore(ostream& os, unsigned int store_id,
         if (gzwrite(compressed_mem, pmem + written,
                     (unsigned int) pass_size) != (int) pass_size) {
             fatal("Write failed on physical memory checkpoint file '%s'\n",
-                  filename);
+                  filepath);
         }
     }
 
@@ -360,10 +786,74 @@ PhysicalMemory::serializeStore(ostream& os, unsigned int store_id,
     // is zero
     if (gzclose(compressed_mem))
         fatal("Close failed on physical memory checkpoint file '%s'\n",
-              filename);
+              filepath);
 
 }
 
+/**
+ * Check if a chunk of memory is all zero.
+ */
+static bool
+isZero(const uint8_t* mem, uint64_t len)
+{
+    // compare the first byte and then the chunk with itself shifted
+    // by one byte, which lets memcmp do the heavy lifting
+    return len == 0 || (mem[0] == 0 && memcmp(mem, mem + 1, len - 1) == 0);
+}
+
+void
+PhysicalMemory::writeRawStore(const string& filepath, AddrRange range,
+                              const uint8_t* pmem) const
+{
+    // write a temporary file and move it in place once complete, as
+    // a simulation restored from an image with the same name may
+    // still have the old one mapped
+    string tmp_filepath = filepath + ".tmp";
+    int fd = open(tmp_filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s'\n",
+              tmp_filepath);
+
+    // pages that are all zero are skipped, leaving a hole in the
+    // file, and contiguous non-zero pages are written in one go
+    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    uint64_t offset = 0;
+    while (offset < range.size()) {
+        if (isZero(pmem + offset, min(page_size, range.size() - offset))) {
+            offset += page_size;
+            continue;
+        }
+
+        uint64_t end = offset + page_size;
+        while (end < range.size() &&
+               !isZero(pmem + end, min(page_size, range.size() - end)))
+            end += page_size;
+        end = min(end, range.size());
+
+        while (offset < end) {
+            ssize_t written = pwrite(fd, pmem + offset,
+                                     min<uint64_t>(end - offset, INT_MAX),
+                                     offset);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                fatal("Write failed on physical memory checkpoint file "
+                      "'%s': %s\n", tmp_filepath, strerror(errno));
+            }
+            offset += written;
+        }
+    }
+
+    // make sure any trailing zero pages are part of the file
+    if (ftruncate(fd, range.size()) != 0 || close(fd) != 0)
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              tmp_filepath);
+
+    if (rename(tmp_filepath.c_str(), filepath.c_str()) != 0)
+        fatal("Can't rename physical memory checkpoint file '%s': %s\n",
+              tmp_filepath, strerror(errno));
+}
+
 void
 PhysicalMemory::unserialize(Checkpoint* cp, const string& section)
 {
@@ -391,8 +881,6 @@ PhysicalMemory::unserialize(Checkpoint* cp, const string& section)
 void
 PhysicalMemory::unserializeStore(Checkpoint* cp, const string& section)
 {
-    const uint32_t chunk_size = 16384;
-
     unsigned int store_id;
     UNSERIALIZE_SCALAR(store_id);
 
@@ -400,10 +888,9 @@ PhysicalMemory::unserializeStore(Checkpoint* cp, const string& section)
     UNSERIALIZE_SCALAR(filename);
     string filepath = cp->cptDir + "/" + filename;
 
-    // mmap memoryfile
-    gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
-    if (compressed_mem == NULL)
-        fatal("Can't open physical memory checkpoint file '%s'", filename);
+    // checkpoints without a format all use gzip
+    string store_format = Enums::PhysMemFormatStrings[Enums::gzip];
+    UNSERIALIZE_OPT_SCALAR(store_format);
 
     // we've already got the actual backing store mapped
     uint8_t* pmem = backingStore[store_id].second;
@@ -412,13 +899,76 @@ PhysicalMemory::unserializeStore(Checkpoint* cp, const string& section)
     long range_size;
     UNSERIALIZE_SCALAR(range_size);
 
-    DPRINTF(Checkpoint, "Unserializing physical memory %s with size %d\n",
-            filename, range_size);
+    DPRINTF(Checkpoint, "Unserializing physical memory %s with size %d "
+            "(%s)\n", filename, range_size, store_format);
 
     if (range_size != range.size())
         fatal("Memory range size has changed! Saw %lld, expected %lld\n",
               range_size, range.size());
 
+    auto& chain = storeChains[store_id];
+    chain.clear();
+
+    // an incremental checkpoint first restores the images it applies
+    // to, starting with a full one
+    if (store_format == "delta") {
+        vector<string> chain_formats;
+        vector<string> chain_files;
+        arrayParamIn(cp, section, "chain_formats", chain_formats);
+        arrayParamIn(cp, section, "chain_files", chain_files);
+
+        fatal_if(chain_files.empty() ||
+                 chain_files.size() != chain_formats.size(),
+                 "Broken chain of images for physical memory checkpoint "
+                 "file '%s'\n", filename);
+
+        for (size_t i = 0; i < chain_files.size(); ++i) {
+            string chain_filepath = cp->cptDir + "/" + chain_files[i];
+            DPRINTF(Checkpoint, "Restoring %s image %s\n",
+                    chain_formats[i], chain_filepath);
+            readStore(chain_formats[i], chain_filepath, range, pmem);
+            if (maxDeltas)
+                chain.emplace_back(chain_formats[i],
+                                   canonicalPath(chain_filepath));
+        }
+    }
+
+    readStore(store_format, filepath, range, pmem);
+
+    // if incremental checkpoints are used, the next one applies to
+    // what was just restored, provided the chain is not too long
+    if (maxDeltas)
+        chain.emplace_back(store_format, canonicalPath(filepath));
+    fill(dirtyPages[store_id].begin(), dirtyPages[store_id].end(), 0);
+}
+
+void
+PhysicalMemory::readStore(const string& store_format, const string& filepath,
+                          AddrRange range, uint8_t* pmem) const
+{
+    if (store_format == Enums::PhysMemFormatStrings[Enums::raw])
+        mapRawStore(filepath, range, pmem);
+    else if (store_format == Enums::PhysMemFormatStrings[Enums::gzip])
+        readGzipStore(filepath, range, pmem);
+    else if (store_format == Enums::PhysMemFormatStrings[Enums::chunked])
+        readChunkedStore(filepath, range, pmem);
+    else if (store_format == "delta")
+        applyDeltaStore(filepath, range, pmem);
+    else
+        fatal("Unknown format '%s' of physical memory checkpoint file "
+              "'%s'\n", store_format, filepath);
+}
+
+void
+PhysicalMemory::readGzipStore(const string& filepath, AddrRange range,
+                              uint8_t* pmem) const
+{
+    const uint32_t chunk_size = 16384;
+
+    gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
+    if (compressed_mem == NULL)
+        fatal("Can't open physical memory checkpoint file '%s'", filepath);
+
     uint64_t curr_size = 0;
     long* temp_page = new long[chunk_size];
     long* pmem_current;
@@ -445,5 +995,354 @@ PhysicalMemory::unserializeStore(Checkpoint* cp, const string& section)
 
     if (gzclose(compressed_mem))
         fatal("Close failed on physical memory checkpoint file '%s'\n",
-              filename);
+              filepath);
+}
+
+void
+PhysicalMemory::mapRawStore(const string& filepath, AddrRange range,
+                            uint8_t* pmem) const
+{
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s'\n", filepath);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size != range.size())
+        fatal("Physical memory checkpoint file '%s' does not match the "
+              "size of the range %s\n", filepath, range.to_string());
+
+    // replace the (anonymous) backing store with a private mapping of
+    // the image at the same address, so that the pointers the
+    // memories already have stay valid
+    int map_flags = MAP_PRIVATE | MAP_FIXED;
+    if (mmapUsingNoReserve)
+        map_flags |= MAP_NORESERVE;
+
+    uint8_t* mapped = (uint8_t*) mmap(pmem, range.size(),
+                                      PROT_READ | PROT_WRITE,
+                                      map_flags, fd, 0);
+    if (mapped == (uint8_t*) MAP_FAILED) {
+        perror("mmap");
+        fatal("Could not mmap physical memory checkpoint file '%s'\n",
+              filepath);
+    }
+    assert(mapped == pmem);
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+}
+
+uint64_t
+PhysicalMemory::writeDeltaStore(const string& filepath, AddrRange range,
+                                const uint8_t* pmem,
+                                const vector<uint64_t>& dirty) const
+{
+    gzFile compressed_mem = gzopen(filepath.c_str(), "wb");
+    if (compressed_mem == NULL)
+        fatal("Can't open physical memory checkpoint file '%s'\n",
+              filepath);
+
+    // the image starts with the page size, followed by the index and
+    // contents of each dirty page, all in host byte order
+    const uint64_t page_size = ULL(1) << AbstractMemory::DirtyPageShift;
+    uint64_t pages = 0;
+
+    bool ok = gzwrite(compressed_mem, &page_size, sizeof(page_size)) ==
+        sizeof(page_size);
+    for (uint64_t w = 0; ok && w < dirty.size(); ++w) {
+        for (uint64_t bits = dirty[w]; ok && bits; bits &= bits - 1) {
+            uint64_t page = w * 64 + findLsbSet(bits);
+            uint64_t offset = page * page_size;
+            unsigned int len = min(page_size, range.size() - offset);
+            ok = gzwrite(compressed_mem, &page, sizeof(page)) ==
+                sizeof(page) &&
+                gzwrite(compressed_mem, pmem + offset, len) == (int)len;
+            ++pages;
+        }
+    }
+
+    if (!ok)
+        fatal("Write failed on physical memory checkpoint file '%s'\n",
+              filepath);
+
+    if (gzclose(compressed_mem))
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              filepath);
+
+    return pages;
+}
+
+void
+PhysicalMemory::applyDeltaStore(const string& filepath, AddrRange range,
+                                uint8_t* pmem) const
+{
+    gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
+    if (compressed_mem == NULL)
+        fatal("Can't open physical memory checkpoint file '%s'\n",
+              filepath);
+
+    uint64_t page_size;
+    if (gzread(compressed_mem, &page_size, sizeof(page_size)) !=
+        sizeof(page_size) || page_size == 0)
+        fatal("Bad header in physical memory checkpoint file '%s'\n",
+              filepath);
+
+    uint64_t page;
+    int bytes_read;
+    while ((bytes_read = gzread(compressed_mem, &page, sizeof(page))) ==
+           sizeof(page)) {
+        uint64_t offset = page * page_size;
+        if (offset >= range.size())
+            fatal("Page %d out of range in physical memory checkpoint "
+                  "file '%s'\n", page, filepath);
+
+        unsigned int len = min(page_size, range.size() - offset);
+        if (gzread(compressed_mem, pmem + offset, len) != (int)len)
+            fatal("Truncated physical memory checkpoint file '%s'\n",
+                  filepath);
+    }
+
+    if (bytes_read != 0)
+        fatal("Truncated physical memory checkpoint file '%s'\n",
+              filepath);
+
+    if (gzclose(compressed_mem))
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              filepath);
+}
+
+/**
+ * A chunked image starts with a header, followed by the compressed
+ * chunks in the order they were written, and lastly an index with an
+ * entry per chunk that is not all zero. Everything is stored in host
+ * byte order.
+ */
+struct ChunkedHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t codec;
+    uint64_t chunkSize;
+    uint64_t rangeSize;
+    uint64_t numChunks;
+    uint64_t indexOffset;
+};
+
+struct ChunkedIndexEntry
+{
+    uint64_t chunk;
+    uint64_t offset;
+    uint64_t size;
+};
+
+static const char chunkedMagic[8] = { 'g', 'e', 'm', '5', 'p', 'm', 'e', 'm' };
+static const uint32_t chunkedVersion = 1;
+
+// the chunks are deflated with zlib, favouring speed
+static const uint32_t chunkedCodecDeflate = 0;
+
+// large enough to compress well, small enough to skip zero regions
+static const uint64_t chunkedChunkSize = ULL(1) << 18;
+
+/**
+ * Write or read a buffer at an offset, dealing with partial
+ * transfers.
+ */
+static bool
+pwriteAll(int fd, const void* buf, uint64_t len, uint64_t offset)
+{
+    const uint8_t* p = (const uint8_t*)buf;
+    while (len) {
+        ssize_t n = pwrite(fd, p, min<uint64_t>(len, INT_MAX), offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+        offset += n;
+    }
+    return true;
+}
+
+static bool
+preadAll(int fd, void* buf, uint64_t len, uint64_t offset)
+{
+    uint8_t* p = (uint8_t*)buf;
+    while (len) {
+        ssize_t n = pread(fd, p, min<uint64_t>(len, INT_MAX), offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+        offset += n;
+    }
+    return true;
+}
+
+/**
+ * Run a function on a number of threads, including the calling one,
+ * and wait for all of them to finish.
+ */
+template <typename F>
+static void
+runOnThreads(unsigned int num_threads, F func)
+{
+    vector<thread> workers;
+    for (unsigned int i = 1; i < num_threads; ++i)
+        workers.emplace_back(func);
+    func();
+    for (auto& w : workers)
+        w.join();
+}
+
+void
+PhysicalMemory::writeChunkedStore(const string& filepath, AddrRange range,
+                                  const uint8_t* pmem) const
+{
+    int fd = open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s'\n",
+              filepath);
+
+    const uint64_t num_chunks = divCeil(range.size(), chunkedChunkSize);
+
+    // the threads grab chunks in turn, and append them to the file
+    // once compressed, the chunks thus end up in any order
+    atomic<uint64_t> next_chunk(0);
+    atomic<bool> failed(false);
+    mutex index_lock;
+    vector<ChunkedIndexEntry> index;
+    uint64_t file_end = sizeof(ChunkedHeader);
+
+    runOnThreads(numThreads, [&]() {
+        vector<uint8_t> buf(compressBound(chunkedChunkSize));
+        uint64_t chunk;
+        while (!failed && (chunk = next_chunk++) < num_chunks) {
+            uint64_t offset = chunk * chunkedChunkSize;
+            uint64_t len = min(chunkedChunkSize, range.size() - offset);
+            if (isZero(pmem + offset, len))
+                continue;
+
+            uLongf size = buf.size();
+            if (compress2(buf.data(), &size, pmem + offset, len,
+                          Z_BEST_SPEED) != Z_OK) {
+                failed = true;
+                break;
+            }
+
+            ChunkedIndexEntry entry = { chunk, 0, size };
+            {
+                lock_guard<mutex> lock(index_lock);
+                entry.offset = file_end;
+                file_end += size;
+                index.push_back(entry);
+            }
+
+            if (!pwriteAll(fd, buf.data(), size, entry.offset)) {
+                failed = true;
+                break;
+            }
+        }
+    });
+
+    if (failed)
+        fatal("Write failed on physical memory checkpoint file '%s'\n",
+              filepath);
+
+    sort(index.begin(), index.end(),
+         [](const ChunkedIndexEntry& a, const ChunkedIndexEntry& b)
+         { return a.chunk < b.chunk; });
+
+    ChunkedHeader header;
+    memcpy(header.magic, chunkedMagic, sizeof(header.magic));
+    header.version = chunkedVersion;
+    header.codec = chunkedCodecDeflate;
+    header.chunkSize = chunkedChunkSize;
+    header.rangeSize = range.size();
+    header.numChunks = index.size();
+    header.indexOffset = file_end;
+
+    if (!pwriteAll(fd, index.data(), index.size() * sizeof(index[0]),
+                   file_end) ||
+        !pwriteAll(fd, &header, sizeof(header), 0))
+        fatal("Write failed on physical memory checkpoint file '%s'\n",
+              filepath);
+
+    if (close(fd) != 0)
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              filepath);
+
+    DPRINTF(Checkpoint, "Wrote %d of %d chunks using %d threads\n",
+            index.size(), num_chunks, numThreads);
+}
+
+void
+PhysicalMemory::readChunkedStore(const string& filepath, AddrRange range,
+                                 uint8_t* pmem) const
+{
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s'\n", filepath);
+
+    ChunkedHeader header;
+    if (!preadAll(fd, &header, sizeof(header), 0) ||
+        memcmp(header.magic, chunkedMagic, sizeof(header.magic)) != 0)
+        fatal("Bad header in physical memory checkpoint file '%s'\n",
+              filepath);
+
+    if (header.version != chunkedVersion ||
+        header.codec != chunkedCodecDeflate)
+        fatal("Unsupported version %d or codec %d of physical memory "
+              "checkpoint file '%s'\n", header.version, header.codec,
+              filepath);
+
+    if (header.rangeSize != range.size() || header.chunkSize == 0)
+        fatal("Physical memory checkpoint file '%s' does not match the "
+              "size of the range %s\n", filepath, range.to_string());
+
+    vector<ChunkedIndexEntry> index(header.numChunks);
+    if (!preadAll(fd, index.data(), index.size() * sizeof(index[0]),
+                  header.indexOffset))
+        fatal("Truncated physical memory checkpoint file '%s'\n",
+              filepath);
+
+    // the chunks that are all zero are not in the image, and the
+    // backing store is left untouched for them
+    atomic<uint64_t> next_entry(0);
+    atomic<bool> failed(false);
+
+    runOnThreads(numThreads, [&]() {
+        vector<uint8_t> buf;
+        uint64_t i;
+        while (!failed && (i = next_entry++) < index.size()) {
+            const ChunkedIndexEntry& entry = index[i];
+            uint64_t offset = entry.chunk * header.chunkSize;
+            if (offset >= range.size()) {
+                failed = true;
+                break;
+            }
+
+            uLongf len = min(header.chunkSize, range.size() - offset);
+            uLongf expected_len = len;
+            buf.resize(entry.size);
+            if (!preadAll(fd, buf.data(), entry.size, entry.offset) ||
+                uncompress(pmem + offset, &len, buf.data(),
+                           entry.size) != Z_OK ||
+                len != expected_len) {
+                failed = true;
+                break;
+            }
+        }
+    });
+
+    if (failed)
+        fatal("Corrupt physical memory checkpoint file '%s'\n", filepath);
+
+    close(fd);
+
+    DPRINTF(Checkpoint, "Read %d chunks using %d threads\n",
+            index.size(), numThreads);
 }
@@ -40,7 +40,11 @@
 #ifndef __MEM_PHYSICAL_HH__
 #define __MEM_PHYSICAL_HH__
 
+#include <atomic>
+#include <mutex>
+
 #include "base/addr_range_map.hh"
+#include "enums/PhysMemFormat.hh"
 #include "mem/packet.hh"
 
 /**
@@ -67,6 +71,10 @@ class AbstractMemory;
 class PhysicalMemory : public Serializable
 {
 
+  public:
+
+    class ConcurrentContext;
+
   private:
 
     // Name for debugging
@@ -88,10 +96,102 @@ class PhysicalMemory : public Serializable
     // Let the user choose if we reserve swap space when calling mmap
     const bool mmapUsingNoReserve;
 
+    // Format of the memory images when checkpointing
+    const Enums::PhysMemFormat format;
+
+    // Maximum number of incremental checkpoints of a backing store
+    // before a full image is written again, 0 to always write full
+    // images
+    const unsigned int maxDeltas;
+
+    // Host threads used for chunked images
+    const unsigned int numThreads;
+
+    // Set once the backing store is handed out for direct access by
+    // the host, as writes are then no longer tracked
+    mutable bool backingStoreExported;
+
+    // Per backing store, a bitmap of the pages written since the last
+    // checkpoint, only used with incremental checkpoints
+    std::vector<std::vector<uint64_t>> dirtyPages;
+
+    // Per backing store, the images (format and canonical path) that
+    // make up its contents as of the last checkpoint, i.e. a full
+    // image followed by zero or more deltas
+    std::vector<std::vector<std::pair<std::string, std::string>>>
+        storeChains;
+
     // The physical memory used to provide the memory in the simulated
     // system
     std::vector<std::pair<AddrRange, uint8_t*>> backingStore;
 
+    // Granularity of the line locks used by concurrentAccess(), and
+    // the number of locks the lines are hashed onto
+    static const unsigned int LineShift = 6;
+    static const unsigned int NumLineLocks = 4096;
+
+    // The maximum number of lines a single access may touch
+    static const unsigned int MaxAccessLines = 4;
+
+    // The maximum number of lines held for a locked
+    // read-modify-write, which may be split in two accesses
+    static const unsigned int MaxHeldLines = 2 * MaxAccessLines;
+
+    // Each line lock is a sequence number that is bumped on every
+    // write, with the low bits flagging that the lock is held, and
+    // that some context has a load-locked reservation on a line that
+    // hashes to it
+    static const uint64_t LineLocked = 0x1;
+    static const uint64_t LineWatched = 0x2;
+    static const uint64_t LineSeqInc = 0x4;
+
+    std::atomic<uint64_t> lineLocks[NumLineLocks];
+
+    // Serialises locked read-modify-write sequences, the only
+    // accesses that hold line locks while waiting for others
+    std::mutex busLock;
+
+    // Contexts to tell about cleared reservations
+    std::vector<ConcurrentContext*> concurrentContexts;
+
+    /**
+     * Find the host address of a block of physical memory that lies
+     * completely within a single backing store.
+     *
+     * @param addr Physical start address
+     * @param size Size of the block in bytes
+     * @param mem Set to the memory the start address maps to
+     * @return Host address, or NULL if there is none
+     */
+    uint8_t* toHostRange(Addr addr, int size, AbstractMemory** mem) const;
+
+    /**
+     * Get the line locks covering an access, sorted and without
+     * duplicates.
+     *
+     * @param addr Physical start address
+     * @param size Size of the access in bytes
+     * @param locks Array of at least MaxAccessLines entries to fill
+     * @return The number of line locks
+     */
+    unsigned int lineLocksOf(Addr addr, int size, unsigned int* locks) const;
+
+    /**
+     * Acquire a line lock, either waiting for it or giving up if it
+     * is held by someone else.
+     *
+     * @return Whether the lock was acquired
+     */
+    bool acquireLine(unsigned int lock, bool wait, uint64_t& seq);
+
+    /**
+     * Release a line lock, bumping its sequence number if the line
+     * was written, and flagging any load-locked reservations on it
+     * as cleared.
+     */
+    void releaseLine(unsigned int lock, uint64_t seq, bool written,
+                     const ConcurrentContext& ctx);
+
     // Prevent copying
     PhysicalMemory(const PhysicalMemory&);
 
@@ -109,14 +209,129 @@ class PhysicalMemory : public Serializable
     void createBackingStore(AddrRange range,
                             const std::vector<AbstractMemory*>& _memories);
 
+    /**
+     * Write a backing store as a gzip compressed image.
+     */
+    void writeGzipStore(const std::string& filepath, AddrRange range,
+                        const uint8_t* pmem) const;
+
+    /**
+     * Write a backing store as a raw image, leaving holes in the
+     * file for the pages that are all zero.
+     */
+    void writeRawStore(const std::string& filepath, AddrRange range,
+                       const uint8_t* pmem) const;
+
+    /**
+     * Write a backing store as a chunked image, where the chunks that
+     * are all zero are skipped and the others compressed independent
+     * of each other, using a pool of host threads.
+     */
+    void writeChunkedStore(const std::string& filepath, AddrRange range,
+                           const uint8_t* pmem) const;
+
+    /**
+     * Read a chunked image into a backing store, decompressing the
+     * chunks in parallel.
+     */
+    void readChunkedStore(const std::string& filepath, AddrRange range,
+                          uint8_t* pmem) const;
+
+    /**
+     * Read a gzip compressed image into a backing store.
+     */
+    void readGzipStore(const std::string& filepath, AddrRange range,
+                       uint8_t* pmem) const;
+
+    /**
+     * Map a raw image in place of a backing store. The mapping is
+     * private, and thus copy on write, so that the image is only read
+     * on demand, and shared with any other process mapping it until
+     * the pages are written.
+     */
+    void mapRawStore(const std::string& filepath, AddrRange range,
+                     uint8_t* pmem) const;
+
+    /**
+     * Write the pages of a backing store that are marked as dirty,
+     * as a gzip compressed sequence of page index and page contents.
+     *
+     * @return The number of pages written
+     */
+    uint64_t writeDeltaStore(const std::string& filepath, AddrRange range,
+                             const uint8_t* pmem,
+                             const std::vector<uint64_t>& dirty) const;
+
+    /**
+     * Apply the pages of a delta image on top of a backing store.
+     */
+    void applyDeltaStore(const std::string& filepath, AddrRange range,
+                         uint8_t* pmem) const;
+
+    /**
+     * Read an image of a given format into a backing store.
+     */
+    void readStore(const std::string& store_format,
+                   const std::string& filepath, AddrRange range,
+                   uint8_t* pmem) const;
+
   public:
 
+    /**
+     * The state a context keeps for accesses done through
+     * concurrentAccess(). Apart from the flag telling that the
+     * reservation was cleared by someone else, it is only ever
+     * touched by the thread simulating the context.
+     */
+    class ConcurrentContext
+    {
+        friend class PhysicalMemory;
+
+      private:
+
+        // load-locked reservation, valid if the lock index is not
+        // NoLine, and still held if the sequence number is unchanged
+        unsigned int llscLine;
+        uint64_t llscSeq;
+
+        // line locks held for a locked read-modify-write, and their
+        // sequence numbers when acquired
+        unsigned int heldLines[MaxHeldLines];
+        uint64_t heldSeqs[MaxHeldLines];
+        unsigned int numHeld;
+
+        // line lock of the reservation for others to look at
+        std::atomic<unsigned int> watchLine;
+
+      public:
+
+        static const unsigned int NoLine = ~0U;
+
+        /**
+         * Set when a write by another context cleared the
+         * reservation, e.g. to wake up a context waiting for an
+         * event. It is up to the owner to check and clear it.
+         */
+        std::atomic<bool> monitorCleared;
+
+        ConcurrentContext()
+            : llscLine(NoLine), llscSeq(0), numHeld(0), watchLine(NoLine),
+              monitorCleared(false)
+        { }
+
+        /** Is a locked read-modify-write sequence in progress? */
+        bool holdingLines() const { return numHeld != 0; }
+    };
+
     /**
      * Create a physical memory object, wrapping a number of memories.
      */
     PhysicalMemory(const std::string& _name,
                    const std::vector<AbstractMemory*>& _memories,
-                   bool mmap_using_noreserve);
+                   bool mmap_using_noreserve,
+                   Enums::PhysMemFormat _format = Enums::gzip,
+                   unsigned int max_deltas = 0,
+                   unsigned int num_threads = 1);
 
     /**
      * Unmap all the backing store we have used.
@@ -163,12 +378,13 @@ class PhysicalMemory : public Serializable
      * that memories that are null are not present, and that the
      * backing store may also contain memories that are not part of
      * the OS-visible global address map and thus are allowed to
-     * overlap.
+     * overlap. As writes through these pointers are not tracked, any
+     * subsequent checkpoint is a full one.
      *
      * @return Pointers to the memory backing store
      */
     std::vector<std::pair<AddrRange, uint8_t*>> getBackingStore() const
-    { return backingStore; }
+    { backingStoreExported = true; return backingStore; }
 
     /**
      * Perform an untimed memory access and update all the state
@@ -189,6 +405,78 @@ class PhysicalMemory : public Serializable
      */
     void functionalAccess(PacketPtr pkt);
 
+    /**
+     * Perform an untimed access directly on the backing store, in a
+     * way that is safe when several host threads, e.g. CPUs on
+     * separate event queues, access memory at the same time. Plain
+     * loads and stores are not synchronised beyond what the host
+     * provides, load-locked/store-conditional pairs and swaps use
+     * per-line locks, and locked read-modify-write sequences hold the
+     * lines they touch until concurrentUnlock() is called. Memory
+     * statistics and the locked address lists of the individual
+     * memories are not updated, and the access is not seen by
+     * anything on the path to the memory.
+     *
+     * @param pkt Packet performing the access
+     * @param ctx State of the context doing the access
+     * @return false if the address is not backed by memory
+     */
+    bool concurrentAccess(PacketPtr pkt, ConcurrentContext& ctx);
+
+    /**
+     * Release the lines held for a locked read-modify-write
+     * sequence started by concurrentAccess().
+     *
+     * @param ctx State of the context holding the lines
+     */
+    void concurrentUnlock(ConcurrentContext& ctx);
+
+    /**
+     * Make a context known so that it is told about writes that
+     * clear its load-locked reservation. This must be done before
+     * the simulation starts.
+     *
+     * @param ctx State of the context
+     */
+    void addConcurrentContext(ConcurrentContext* ctx)
+    { concurrentContexts.push_back(ctx); }
+
+    /**
+     * Are CPUs on other threads possibly accessing memory through
+     * concurrentAccess() right now, in which case any other access
+     * has to take the line locks as well?
+     */
+    bool concurrentUse() const;
+
+    /**
+     * Copy a block straight out of the backing store, bypassing the
+     * memory system altogether. This is only correct when no other
+     * component (e.g. a cache) holds a more recent copy of the data,
+     * and it is up to the caller to ensure that this is the case.
+     * As the copy does not take any line locks, it is refused while
+     * CPUs may access memory concurrently.
+     *
+     * @param addr Physical start address
+     * @param p Buffer to copy the data to
+     * @param size Number of bytes to copy
+     * @return false if the block is not entirely backed by memory,
+     *         or if memory is in concurrent use
+     */
+    bool directRead(Addr addr, uint8_t* p, int size) const;
+
+    /**
+     * Copy a block straight into the backing store, the counterpart
+     * of directRead(). Written pages are tracked for incremental
+     * checkpoints just like for functional accesses.
+     *
+     * @param addr Physical start address
+     * @param p Data to write
+     * @param size Number of bytes to write
+     * @return false if the block is not entirely backed by memory,
+     *         or if memory is in concurrent use
+     */
+    bool directWrite(Addr addr, const uint8_t* p, int size);
+
     /**
      * Serialize all the memories in the system. This is independent
      * of the logical memory layout, and the serialization only sees
@@ -200,7 +488,9 @@ class PhysicalMemory : public Serializable
     void serialize(std::ostream& os);
 
     /**
-     * Serialize a specific store.
+     * Serialize a specific store. With incremental checkpoints, only
+     * the pages written since the last checkpoint are stored, along
+     * with the chain of images they apply to.
      *
      * @param store_id Unique identifier of this backing store
      * @param range The address range of this backing store
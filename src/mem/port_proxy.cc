@@ -39,10 +39,15 @@
 
 #include "base/chunk_generator.hh"
 #include "mem/port_proxy.hh"
+#include "sim/system.hh"
 
 void
 PortProxy::readBlob(Addr addr, uint8_t *p, int size) const
 {
+    if (_system && _system->directFunctionalAccess() &&
+        _system->getPhysMem().directRead(addr, p, size))
+        return;
+
     for (ChunkGenerator gen(addr, size, _cacheLineSize); !gen.done();
          gen.next()) {
         Request req(gen.addr(), gen.size(), 0, Request::funcMasterId);
@@ -56,6 +61,10 @@ PortProxy::readBlob(Addr addr, uint8_t *p, int size) const
 void
 PortProxy::writeBlob(Addr addr, const uint8_t *p, int size) const
 {
+    if (_system && _system->directFunctionalAccess() &&
+        _system->getPhysMem().directWrite(addr, p, size))
+        return;
+
     for (ChunkGenerator gen(addr, size, _cacheLineSize); !gen.done();
          gen.next()) {
         Request req(gen.addr(), gen.size(), 0, Request::funcMasterId);
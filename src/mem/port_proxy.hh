@@ -67,6 +67,8 @@
 #include "mem/port.hh"
 #include "sim/byteswap.hh"
 
+class System;
+
 /**
  * This object is a proxy for a structural port, to be used for debug
  * accesses.
@@ -91,9 +93,18 @@ class PortProxy
     /** Granularity of any transactions issued through this proxy. */
     const unsigned int _cacheLineSize;
 
+    /**
+     * System owning the memory behind the port, if any. When set,
+     * and the system permits it, accesses that are entirely backed
+     * by memory are copied directly to or from the backing store
+     * rather than being split into line-sized packets.
+     */
+    System *_system;
+
   public:
-    PortProxy(MasterPort &port, unsigned int cacheLineSize) :
-        _port(port), _cacheLineSize(cacheLineSize) { }
+    PortProxy(MasterPort &port, unsigned int cacheLineSize,
+              System *system = NULL) :
+        _port(port), _cacheLineSize(cacheLineSize), _system(system) { }
     virtual ~PortProxy() { }
 
     /**
@@ -56,6 +56,7 @@
 
 #include "base/flags.hh"
 #include "base/misc.hh"
+#include "base/slab_pool.hh"
 #include "base/types.hh"
 #include "sim/core.hh"
 
@@ -338,6 +339,26 @@ class Request
 
     ~Request() {}
 
+    /**
+     * Requests are allocated from a per-thread slab pool rather than
+     * the heap, as every memory access creates at least one.
+     */
+    static void *
+    operator new(size_t alloc_size)
+    {
+        assert(alloc_size == sizeof(Request));
+        return SlabPool<Request>::allocate();
+    }
+
+    static void
+    operator delete(void *p)
+    {
+        SlabPool<Request>::release(p);
+    }
+
+    /** Number of requests allocated, for the global host stats. */
+    static Counter numAllocated() { return SlabPool<Request>::allocated(); }
+
     /**
      * Set up CPU and thread numbers.
      */
@@ -42,13 +42,165 @@
  * Definition of a snoop filter.
  */
 
+#include "base/intmath.hh"
 #include "base/misc.hh"
 #include "base/trace.hh"
 #include "debug/SnoopFilter.hh"
 #include "mem/snoop_filter.hh"
 #include "sim/system.hh"
 
-std::pair<SnoopFilter::SnoopList, Cycles>
+SnoopFilter::SnoopFilter(const SnoopFilterParams *p)
+    : SimObject(p), numSets(p->entries / p->assoc), assoc(p->assoc),
+      useCount(0), allPorts(0), linesize(p->system->cacheLineSize()),
+      lookupLatency(p->lookup_latency)
+{
+    if (assoc == 0 || p->entries % assoc != 0)
+        fatal("Snoop filter %s entries (%d) must be a multiple of the "
+              "associativity (%d)\n", name(), p->entries, assoc);
+    if (!isPowerOf2(numSets))
+        fatal("Snoop filter %s number of sets (%d) must be a power of 2\n",
+              name(), numSets);
+
+    entries.resize(p->entries);
+}
+
+void
+SnoopFilter::setSlavePorts(const std::vector<SlavePort*>& bus_slave_ports)
+{
+    allPorts = 0;
+    for (auto port : bus_slave_ports) {
+        if (port->getId() >= 8 * sizeof(SnoopMask))
+            fatal("Snoop filter %s supports at most %d ports\n", name(),
+                  8 * sizeof(SnoopMask));
+        allPorts |= portToMask(*port);
+    }
+}
+
+SnoopFilter::SnoopItem*
+SnoopFilter::findItem(Addr line_addr)
+{
+    SnoopEntry* set = &entries[(line_addr / linesize) % numSets * assoc];
+    for (unsigned w = 0; w < assoc; ++w) {
+        if (set[w].valid && set[w].lineAddr == line_addr) {
+            set[w].lastUse = ++useCount;
+            return &set[w].item;
+        }
+    }
+
+    if (!overflow.empty()) {
+        auto o = overflow.find(line_addr);
+        if (o != overflow.end())
+            return &o->second;
+    }
+
+    return NULL;
+}
+
+SnoopFilter::SnoopEntry*
+SnoopFilter::findVictim(Addr line_addr)
+{
+    // use an entry that does not track anything if there is one,
+    // otherwise the least recently used one without any outstanding
+    // requests
+    SnoopEntry* set = &entries[(line_addr / linesize) % numSets * assoc];
+    SnoopEntry* victim = NULL;
+    for (unsigned w = 0; w < assoc; ++w) {
+        SnoopEntry& entry = set[w];
+        if (!entry.valid || !(entry.item.holder | entry.item.requested))
+            return &entry;
+        if (!entry.item.requested &&
+            (!victim || entry.lastUse < victim->lastUse))
+            victim = &entry;
+    }
+    return victim;
+}
+
+void
+SnoopFilter::replaceEntry(SnoopEntry* victim, Addr line_addr,
+                          const SnoopItem& item)
+{
+    if (victim->valid) {
+        evictions++;
+        if (victim->item.holder) {
+            DPRINTF(SnoopFilter, "%s: evicting line 0x%x held by %x\n",
+                    __func__, victim->lineAddr, victim->item.holder);
+            backInvalidationCount++;
+            backInvalidations.push_back(std::make_pair(victim->lineAddr,
+                                                       victim->item.holder));
+        }
+    }
+
+    victim->lineAddr = line_addr;
+    victim->valid = true;
+    victim->lastUse = ++useCount;
+    victim->item = item;
+}
+
+SnoopFilter::SnoopItem&
+SnoopFilter::allocateItem(Addr line_addr, bool& is_hit)
+{
+    SnoopItem* sf_item = findItem(line_addr);
+    is_hit = sf_item != NULL;
+    if (is_hit)
+        return *sf_item;
+
+    SnoopEntry* victim = findVictim(line_addr);
+    if (!victim) {
+        DPRINTF(SnoopFilter, "%s: set full of requests, line 0x%x "
+                "goes to the overflow table\n", __func__, line_addr);
+        overflowCount++;
+        return overflow[line_addr];
+    }
+
+    replaceEntry(victim, line_addr, SnoopItem());
+    return victim->item;
+}
+
+void
+SnoopFilter::releaseOverflow(Addr line_addr)
+{
+    if (overflow.empty())
+        return;
+
+    auto o = overflow.find(line_addr);
+    if (o == overflow.end() || o->second.requested)
+        return;
+
+    // without any outstanding requests the line is moved back into
+    // its set, and if the set is still pinned by requests the line
+    // is invalidated in its holders instead, as there are no clean
+    // evictions that would ever clear the holders and release it
+    SnoopItem item = o->second;
+    overflow.erase(o);
+    if (!item.holder)
+        return;
+
+    SnoopEntry* victim = findVictim(line_addr);
+    if (victim) {
+        DPRINTF(SnoopFilter, "%s: line 0x%x moves back from the overflow "
+                "table\n", __func__, line_addr);
+        replaceEntry(victim, line_addr, item);
+    } else {
+        DPRINTF(SnoopFilter, "%s: dropping line 0x%x held by %x from the "
+                "overflow table\n", __func__, line_addr, item.holder);
+        backInvalidationCount++;
+        backInvalidations.push_back(std::make_pair(line_addr, item.holder));
+    }
+}
+
+bool
+SnoopFilter::nextBackInvalidation(Addr& line_addr, SnoopMask& holders)
+{
+    if (backInvalidations.empty())
+        return false;
+
+    line_addr = backInvalidations.back().first;
+    holders = backInvalidations.back().second;
+    backInvalidations.pop_back();
+    return true;
+}
+
+std::pair<SnoopFilter::SnoopMask, Cycles>
 SnoopFilter::lookupRequest(const Packet* cpkt, const SlavePort& slave_port)
 {
     DPRINTF(SnoopFilter, "%s: packet src %s addr 0x%x cmd %s\n",
@@ -56,13 +208,25 @@ SnoopFilter::lookupRequest(const Packet* cpkt, const SlavePort& slave_port)
 
     Addr line_addr = cpkt->getAddr() & ~(linesize - 1);
     SnoopMask req_port = portToMask(slave_port);
-    auto sf_it = cachedLocations.find(line_addr);
-    bool is_hit = (sf_it != cachedLocations.end());
-    // Create a new element through operator[] and modify in-place
-    SnoopItem& sf_item = is_hit ? sf_it->second : cachedLocations[line_addr];
-    SnoopMask interested = sf_item.holder | sf_item.requested;
 
     totRequests++;
+
+    // only requests that will be tracked get a new entry, any other
+    // request for a line that is not tracked (e.g. a writeback of a
+    // line that was back-invalidated) has nobody else to snoop
+    bool is_hit;
+    SnoopItem* sf_item;
+    if (cpkt->needsResponse() && !cpkt->memInhibitAsserted()) {
+        sf_item = &allocateItem(line_addr, is_hit);
+    } else {
+        sf_item = findItem(line_addr);
+        is_hit = sf_item != NULL;
+        if (!is_hit)
+            return snoopDown(lookupLatency);
+    }
+
+    SnoopMask interested = sf_item->holder | sf_item->requested;
+
     if (is_hit) {
         // Single bit set -> value is a power of two
         if (isPow2(interested))
@@ -72,29 +236,29 @@ SnoopFilter::lookupRequest(const Packet* cpkt, const SlavePort& slave_port)
     }
 
     DPRINTF(SnoopFilter, "%s:   SF value %x.%x\n",
-            __func__, sf_item.requested, sf_item.holder);
+            __func__, sf_item->requested, sf_item->holder);
 
     if (cpkt->needsResponse()) {
         if (!cpkt->memInhibitAsserted()) {
             // Max one request per address per port
-            panic_if(sf_item.requested & req_port, "double request :( "\
-                     "SF value %x.%x\n", sf_item.requested, sf_item.holder);
+            panic_if(sf_item->requested & req_port, "double request :( "\
+                     "SF value %x.%x\n", sf_item->requested, sf_item->holder);
 
             // Mark in-flight requests to distinguish later on
-            sf_item.requested |= req_port;
+            sf_item->requested |= req_port;
         } else {
             // NOTE: The memInhibit might have been asserted by a cache closer
             // to the CPU, already -> the response will not be seen by this
             // filter -> we do not need to keep the in-flight request, but make
             // sure that we know that that cluster has a copy
-            panic_if(!(sf_item.holder & req_port), "Need to hold the value!");
+            panic_if(!(sf_item->holder & req_port), "Need to hold the value!");
             DPRINTF(SnoopFilter, "%s:   not marking request. SF value %x.%x\n",
-                    __func__,  sf_item.requested, sf_item.holder);
+                    __func__,  sf_item->requested, sf_item->holder);
         }
         DPRINTF(SnoopFilter, "%s:   new SF value %x.%x\n",
-                __func__,  sf_item.requested, sf_item.holder);
+                __func__,  sf_item->requested, sf_item->holder);
     }
-    return snoopSelected(maskToPortList(interested & ~req_port), lookupLatency);
+    return snoopSelected(interested & ~req_port, lookupLatency);
 }
 
 void
@@ -106,14 +270,22 @@ SnoopFilter::updateRequest(const Packet* cpkt, const SlavePort& slave_port,
 
     Addr line_addr = cpkt->getAddr() & ~(linesize - 1);
     SnoopMask req_port = portToMask(slave_port);
-    SnoopItem& sf_item  = cachedLocations[line_addr];
+    SnoopItem* sf_item = findItem(line_addr);
+
+    // a line that is not tracked has no outstanding requests, and
+    // any writeback is from a holder that has been back-invalidated
+    if (!sf_item) {
+        DPRINTF(SnoopFilter, "%s:   line not tracked\n", __func__);
+        return;
+    }
 
     DPRINTF(SnoopFilter, "%s:   old SF value %x.%x retry: %i\n",
-            __func__, sf_item.requested, sf_item.holder, will_retry);
+            __func__, sf_item->requested, sf_item->holder, will_retry);
 
     if (will_retry) {
         // Unmark a request that will come again.
-        sf_item.requested &= ~req_port;
+        sf_item->requested &= ~req_port;
+        releaseOverflow(line_addr);
         return;
     }
 
@@ -122,23 +294,23 @@ SnoopFilter::updateRequest(const Packet* cpkt, const SlavePort& slave_port,
         // Packets that will not evoke a response but still need updates of the
         // snoop filter; WRITEBACKs for now only
         if (cpkt->cmd == MemCmd::Writeback) {
-            // make sure that the sender actually had the line
-            panic_if(sf_item.requested & req_port, "double request :( "\
-                     "SF value %x.%x\n", sf_item.requested, sf_item.holder);
-            panic_if(!(sf_item.holder & req_port), "requester %x is not a "\
-                     "holder :( SF value %x.%x\n", req_port,
-                     sf_item.requested, sf_item.holder);
+            // make sure that the sender actually had the line, or
+            // that it was back-invalidated while the writeback was
+            // on its way and the line has since been reallocated
+            panic_if(sf_item->requested & req_port, "double request :( "\
+                     "SF value %x.%x\n", sf_item->requested, sf_item->holder);
             // Writebacks -> the sender does not have the line anymore
-            sf_item.holder &= ~req_port;
+            sf_item->holder &= ~req_port;
         } else {
             assert(0 == "Handle non-writeback, here");
         }
         DPRINTF(SnoopFilter, "%s:   new SF value %x.%x\n",
-                __func__,  sf_item.requested, sf_item.holder);
+                __func__,  sf_item->requested, sf_item->holder);
+        releaseOverflow(line_addr);
     }
 }
 
-std::pair<SnoopFilter::SnoopList, Cycles>
+std::pair<SnoopFilter::SnoopMask, Cycles>
 SnoopFilter::lookupSnoop(const Packet* cpkt)
 {
     DPRINTF(SnoopFilter, "%s: packet addr 0x%x cmd %s\n",
@@ -152,38 +324,38 @@ SnoopFilter::lookupSnoop(const Packet* cpkt)
     if (!filter_upward)
         return snoopAll(lookupLatency);
 
+    totSnoops++;
+
+    // a line that is not tracked is not held by anyone above
     Addr line_addr = cpkt->getAddr() & ~(linesize - 1);
-    auto sf_it = cachedLocations.find(line_addr);
-    bool is_hit = (sf_it != cachedLocations.end());
-    // Create a new element through operator[] and modify in-place
-    SnoopItem& sf_item = is_hit ? sf_it->second : cachedLocations[line_addr];
+    SnoopItem* sf_item = findItem(line_addr);
+    if (!sf_item)
+        return snoopDown(lookupLatency);
 
     DPRINTF(SnoopFilter, "%s:   old SF value %x.%x\n",
-            __func__, sf_item.requested, sf_item.holder);
+            __func__, sf_item->requested, sf_item->holder);
 
-    SnoopMask interested = (sf_item.holder | sf_item.requested);
+    SnoopMask interested = (sf_item->holder | sf_item->requested);
 
-    totSnoops++;
-    if (is_hit) {
-        // Single bit set -> value is a power of two
-        if (isPow2(interested))
-            hitSingleSnoops++;
-        else
-            hitMultiSnoops++;
-    }
+    // Single bit set -> value is a power of two
+    if (isPow2(interested))
+        hitSingleSnoops++;
+    else
+        hitMultiSnoops++;
 
     assert(cpkt->isInvalidate() == cpkt->needsExclusive());
-    if (cpkt->isInvalidate() && !sf_item.requested) {
+    if (cpkt->isInvalidate() && !sf_item->requested) {
         // Early clear of the holder, if no other request is currently going on
         // @todo: This should possibly be updated even though we do not filter
         // upward snoops
-        sf_item.holder = 0;
+        sf_item->holder = 0;
     }
 
     DPRINTF(SnoopFilter, "%s:   new SF value %x.%x interest: %x \n",
-            __func__, sf_item.requested, sf_item.holder, interested);
+            __func__, sf_item->requested, sf_item->holder, interested);
+    releaseOverflow(line_addr);
 
-    return snoopSelected(maskToPortList(interested), lookupLatency);
+    return snoopSelected(interested, lookupLatency);
 }
 
 void
@@ -198,40 +370,45 @@ SnoopFilter::updateSnoopResponse(const Packet* cpkt,
     Addr line_addr = cpkt->getAddr() & ~(linesize - 1);
     SnoopMask rsp_mask = portToMask(rsp_port);
     SnoopMask req_mask = portToMask(req_port);
-    SnoopItem& sf_item = cachedLocations[line_addr];
+    SnoopItem* sf_item = findItem(line_addr);
 
     assert(cpkt->isResponse());
     assert(cpkt->memInhibitAsserted());
 
+    // Lines with outstanding requests are never evicted
+    panic_if(!sf_item, "Line 0x%x with a request is not tracked\n",
+             line_addr);
+
     DPRINTF(SnoopFilter, "%s:   old SF value %x.%x\n",
-            __func__,  sf_item.requested, sf_item.holder);
+            __func__,  sf_item->requested, sf_item->holder);
 
     // The source should have the line
-    panic_if(!(sf_item.holder & rsp_mask), "SF value %x.%x does not have "\
-             "the line\n", sf_item.requested, sf_item.holder);
+    panic_if(!(sf_item->holder & rsp_mask), "SF value %x.%x does not have "\
+             "the line\n", sf_item->requested, sf_item->holder);
 
     // The destination should have had a request in
-    panic_if(!(sf_item.requested & req_mask), "SF value %x.%x missing "\
-             "the original request\n",  sf_item.requested, sf_item.holder);
+    panic_if(!(sf_item->requested & req_mask), "SF value %x.%x missing "\
+             "the original request\n",  sf_item->requested, sf_item->holder);
 
     // Update the residency of the cache line.
     if (cpkt->needsExclusive() || !cpkt->sharedAsserted()) {
         DPRINTF(SnoopFilter, "%s:  dropping %x because needs: %i shared: %i "\
                 "SF val: %x.%x\n", __func__,  rsp_mask,
                 cpkt->needsExclusive(), cpkt->sharedAsserted(),
-                sf_item.requested, sf_item.holder);
+                sf_item->requested, sf_item->holder);
 
-        sf_item.holder &= ~rsp_mask;
+        sf_item->holder &= ~rsp_mask;
         // The snoop filter does not see any ACKs from non-responding sharers
         // that have been invalidated :(  So below assert would be nice, but..
-        //assert(sf_item.holder == 0);
-        sf_item.holder = 0;
+        //assert(sf_item->holder == 0);
+        sf_item->holder = 0;
     }
     assert(cpkt->cmd != MemCmd::Writeback);
-    sf_item.holder |=  req_mask;
-    sf_item.requested &= ~req_mask;
+    sf_item->holder |=  req_mask;
+    sf_item->requested &= ~req_mask;
     DPRINTF(SnoopFilter, "%s:   new SF value %x.%x\n",
-            __func__, sf_item.requested, sf_item.holder);
+            __func__, sf_item->requested, sf_item->holder);
+    releaseOverflow(line_addr);
 }
 
 void
@@ -243,25 +420,30 @@ SnoopFilter::updateSnoopForward(const Packet* cpkt,
             cpkt->cmdString());
 
     Addr line_addr = cpkt->getAddr() & ~(linesize - 1);
-    SnoopItem& sf_item = cachedLocations[line_addr];
+    SnoopItem* sf_item = findItem(line_addr);
     SnoopMask rsp_mask M5_VAR_USED = portToMask(rsp_port);
 
     assert(cpkt->isResponse());
     assert(cpkt->memInhibitAsserted());
 
+    // nothing to update for a line that is not tracked
+    if (!sf_item)
+        return;
+
     DPRINTF(SnoopFilter, "%s:   old SF value %x.%x\n",
-            __func__,  sf_item.requested, sf_item.holder);
+            __func__,  sf_item->requested, sf_item->holder);
 
     // Remote (to this snoop filter) snoops update the filter already when they
     // arrive from below, because we may not see any response.
     if (cpkt->needsExclusive()) {
         // If the request to this snoop response hit an in-flight transaction,
         // the holder was not reset -> no assertion & do that here, now!
-        //assert(sf_item.holder == 0);
-        sf_item.holder = 0;
+        //assert(sf_item->holder == 0);
+        sf_item->holder = 0;
     }
     DPRINTF(SnoopFilter, "%s:   new SF value %x.%x\n",
-            __func__, sf_item.requested, sf_item.holder);
+            __func__, sf_item->requested, sf_item->holder);
+    releaseOverflow(line_addr);
 }
 
 void
@@ -272,24 +454,29 @@ SnoopFilter::updateResponse(const Packet* cpkt, const SlavePort& slave_port)
 
     Addr line_addr = cpkt->getAddr() & ~(linesize - 1);
     SnoopMask slave_mask = portToMask(slave_port);
-    SnoopItem& sf_item = cachedLocations[line_addr];
+    SnoopItem* sf_item = findItem(line_addr);
 
     assert(cpkt->isResponse());
 
+    // Lines with outstanding requests are never evicted
+    panic_if(!sf_item, "Line 0x%x with a request is not tracked\n",
+             line_addr);
+
     DPRINTF(SnoopFilter, "%s:   old SF value %x.%x\n",
-            __func__,  sf_item.requested, sf_item.holder);
+            __func__,  sf_item->requested, sf_item->holder);
 
     // Make sure we have seen the actual request, too
-    panic_if(!(sf_item.requested & slave_mask), "SF value %x.%x missing "\
-             "request bit\n", sf_item.requested, sf_item.holder);
+    panic_if(!(sf_item->requested & slave_mask), "SF value %x.%x missing "\
+             "request bit\n", sf_item->requested, sf_item->holder);
 
     // Update the residency of the cache line.
     if (cpkt->needsExclusive() || !cpkt->sharedAsserted())
-        sf_item.holder = 0;
-    sf_item.holder |=  slave_mask;
-    sf_item.requested &= ~slave_mask;
+        sf_item->holder = 0;
+    sf_item->holder |=  slave_mask;
+    sf_item->requested &= ~slave_mask;
     DPRINTF(SnoopFilter, "%s:   new SF value %x.%x\n",
-            __func__, sf_item.requested, sf_item.holder);
+            __func__, sf_item->requested, sf_item->holder);
+    releaseOverflow(line_addr);
 }
 
 void
@@ -322,6 +509,20 @@ SnoopFilter::regStats()
         .name(name() + ".hit_multi_snoops")
         .desc("Number of snoops hitting in the snoop filter with multiple "\
               "(>1) holders of the requested data.");
+
+    evictions
+        .name(name() + ".evictions")
+        .desc("Number of lines replaced in the snoop filter.");
+
+    backInvalidationCount
+        .name(name() + ".back_invalidations")
+        .desc("Number of replaced lines that had to be invalidated in "\
+              "their holders.");
+
+    overflowCount
+        .name(name() + ".overflows")
+        .desc("Number of lines tracked outside the table as their set only "\
+              "had lines with outstanding requests.");
 }
 
 SnoopFilter *
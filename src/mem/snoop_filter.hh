@@ -46,6 +46,7 @@
 #define __MEM_SNOOP_FILTER_HH__
 
 #include <utility>
+#include <vector>
 
 #include "base/hashmap.hh"
 #include "mem/packet.hh"
@@ -59,12 +60,12 @@
  * particular line of data. It can be queried (through lookup*) on
  * memory requests from above (reads / writes / ...); and also from
  * below (snoops). The snoop filter precisely knows about the location
- * of lines "above" it through a map from cache line address to
- * sharers/ports. The snoop filter ties into the flows of requests
- * (when they succeed at the lower interface), regular responses from
- * below and also responses from sideway's caches (in update*). This
- * allows the snoop filter to model cache-line residency by snooping
- * the messages.
+ * of lines "above" it through a set-associative table from cache line
+ * address to sharers/ports. The snoop filter ties into the flows of
+ * requests (when they succeed at the lower interface), regular
+ * responses from below and also responses from sideway's caches (in
+ * update*). This allows the snoop filter to model cache-line
+ * residency by snooping the messages.
  *
  * The tracking happens in two fields to be able to distinguish
  * between in-flight requests (in requested) and already pulled in
@@ -73,6 +74,17 @@
  * | holder) should be notified and the requesting MSHRs will take
  * care of ordering.
  *
+ * The table has a bounded capacity. When a new line needs an entry
+ * in a full set, the filter first reuses entries without any holders
+ * or requests, and otherwise evicts the least recently used entry
+ * without outstanding requests. The lines of an evicted entry are
+ * then invalidated in all its holders (back-invalidation), which is
+ * done by the crossbar after the lookup. Entries with outstanding
+ * requests are never evicted, and if a set only has such entries,
+ * the new line is tracked in a small overflow table until its own
+ * requests complete, at which point it moves back into its set or
+ * is back-invalidated as well.
+ *
  * Overall, some trickery is required because:
  * (1) snoops are not followed by an ACK, but only evoke a response if
  *     they need to (hit dirty)
@@ -85,12 +97,10 @@
  */
 class SnoopFilter : public SimObject {
   public:
-    typedef std::vector<SlavePort*> SnoopList;
+    /** Bitset of slave ports, indexed by port id. */
+    typedef uint64_t SnoopMask;
 
-    SnoopFilter (const SnoopFilterParams *p) : SimObject(p),
-        linesize(p->system->cacheLineSize()), lookupLatency(p->lookup_latency)
-    {
-    }
+    SnoopFilter (const SnoopFilterParams *p);
 
     /**
      * Init a new snoop filter and tell it about all the slave ports of the
@@ -98,21 +108,20 @@ class SnoopFilter : public SimObject {
      *
      * @param bus_slave_ports Vector of slave ports that the bus is attached to.
      */
-    void setSlavePorts(const std::vector<SlavePort*>& bus_slave_ports) {
-        slavePorts = bus_slave_ports;
-    }
+    void setSlavePorts(const std::vector<SlavePort*>& bus_slave_ports);
 
     /**
      * Lookup a request (from a slave port) in the snoop filter and return a
-     * list of other slave ports that need forwarding of the resulting snoops.
+     * set of other slave ports that need forwarding of the resulting snoops.
      * Additionally, update the tracking structures with new request
-     * information.
+     * information. Allocating an entry for the line might evict another
+     * line, which is then queued for back-invalidation.
      *
      * @param cpkt          Pointer to the request packet.  Not changed.
      * @param slave_port    Slave port where the request came from.
-     * @return Pair of a vector of snoop target ports and lookup latency.
+     * @return Pair of a mask of snoop target ports and lookup latency.
      */
-    std::pair<SnoopList, Cycles> lookupRequest(const Packet* cpkt,
+    std::pair<SnoopMask, Cycles> lookupRequest(const Packet* cpkt,
                                                const SlavePort& slave_port);
 
     /**
@@ -131,10 +140,10 @@ class SnoopFilter : public SimObject {
      * tracking logic and may also benefit from additional steering thanks to the
      * snoop filter.
      * @param cpkt Pointer to const Packet containing the snoop.
-     * @return Pair with a vector of SlavePorts that need snooping and a lookup
+     * @return Pair with a mask of SlavePorts that need snooping and a lookup
      *         latency.
      */
-    std::pair<SnoopList, Cycles> lookupSnoop(const Packet* cpkt);
+    std::pair<SnoopMask, Cycles> lookupSnoop(const Packet* cpkt);
 
     /**
      * Let the snoop filter see any snoop responses that turn into request responses
@@ -170,61 +179,131 @@ class SnoopFilter : public SimObject {
      */
     void updateResponse(const Packet *cpkt, const SlavePort& slave_port);
 
+    /**
+     * Get the next line that was evicted from the filter and has to
+     * be invalidated in its holders, removing it from the queue of
+     * pending back-invalidations.
+     *
+     * @param line_addr Address of the evicted line.
+     * @param holders   Mask of the ports holding the line.
+     * @return True if there was a pending back-invalidation.
+     */
+    bool nextBackInvalidation(Addr& line_addr, SnoopMask& holders);
+
     /**
      * Simple factory methods for standard return values for lookupRequest
      */
-    std::pair<SnoopList, Cycles> snoopAll(Cycles latency) const
+    std::pair<SnoopMask, Cycles> snoopAll(Cycles latency) const
     {
-        return std::make_pair(slavePorts, latency);
+        return std::make_pair(allPorts, latency);
     }
-    std::pair<SnoopList, Cycles> snoopSelected(const SnoopList& slave_ports,
+    std::pair<SnoopMask, Cycles> snoopSelected(SnoopMask slave_ports,
                                                Cycles latency) const
     {
         return std::make_pair(slave_ports, latency);
     }
-    std::pair<SnoopList, Cycles> snoopDown(Cycles latency) const
+    std::pair<SnoopMask, Cycles> snoopDown(Cycles latency) const
     {
-        SnoopList empty;
-        return std::make_pair(empty , latency);
+        return std::make_pair(SnoopMask(0), latency);
     }
 
+    /**
+     * Check if a port is part of a mask.
+     */
+    static bool inMask(SnoopMask mask, const SlavePort& port)
+    { return (mask >> port.getId()) & 1; }
+
     virtual void regStats();
 
   protected:
-    typedef uint64_t SnoopMask;
    /**
     * Per cache line item tracking a bitmask of SlavePorts who have an
     * outstanding request to this line (requested) or already share a cache line
     * with this address (holder).
     */
     struct SnoopItem {
+        SnoopItem() : requested(0), holder(0) {}
         SnoopMask requested;
         SnoopMask holder;
     };
+
+    /** An entry in the set-associative table. */
+    struct SnoopEntry {
+        SnoopEntry() : lineAddr(0), valid(false), lastUse(0) {}
+        Addr lineAddr;
+        bool valid;
+        /** Last lookup of the line, used for replacement. */
+        uint64_t lastUse;
+        SnoopItem item;
+    };
+
     /**
      * Convert a single port to a corresponding, one-hot bitmask
      * @param port SlavePort that should be converted.
      * @return One-hot bitmask corresponding to the port.
      */
     SnoopMask portToMask(const SlavePort& port) const;
+
+    /**
+     * Find the item of a line, if the line is tracked.
+     *
+     * @param line_addr Address of the line.
+     * @return The item of the line, or NULL if not tracked.
+     */
+    SnoopItem* findItem(Addr line_addr);
+
+    /**
+     * Find the item of a line, and allocate an entry if the line is
+     * not tracked, possibly evicting another line.
+     *
+     * @param line_addr Address of the line.
+     * @param is_hit Set to true if the line was already tracked.
+     * @return The item of the line.
+     */
+    SnoopItem& allocateItem(Addr line_addr, bool& is_hit);
+
     /**
-     * Convert multiple ports to a corresponding bitmask
-     * @param ports SnoopList that should be converted.
-     * @return Bitmask corresponding to the ports in the list.
+     * Pick the entry to use for a line in its set.
+     *
+     * @param line_addr Address of the line.
+     * @return The entry to replace, or NULL if all the entries of the
+     *         set have outstanding requests.
      */
-    SnoopMask portListToMask(const SnoopList& ports) const;
+    SnoopEntry* findVictim(Addr line_addr);
+
     /**
-     * Converts a bitmask of ports into the corresponing list of ports
-     * @param ports SnoopMask of the requested ports
-     * @return SnoopList containing all the requested SlavePorts
+     * Replace the contents of an entry, and queue the back-invalidation
+     * of the line it tracked if that line has holders.
+     *
+     * @param victim Entry to replace.
+     * @param line_addr Address of the new line.
+     * @param item Tracking state of the new line.
      */
-    SnoopList maskToPortList(SnoopMask ports) const;
+    void replaceEntry(SnoopEntry* victim, Addr line_addr,
+                      const SnoopItem& item);
+
+    /**
+     * Release the item of a line if it is in the overflow table and
+     * has no outstanding requests. The line is moved back into its
+     * set if possible, and invalidated in its holders otherwise.
+     */
+    void releaseOverflow(Addr line_addr);
 
   private:
-    /** Simple hash set of cached addresses. */
-    m5::hash_map<Addr, SnoopItem> cachedLocations;
-    /** List of all attached slave ports. */
-    SnoopList slavePorts;
+    /** Number of sets in the table. */
+    const unsigned numSets;
+    /** Associativity of the table. */
+    const unsigned assoc;
+    /** The table entries, stored set by set. */
+    std::vector<SnoopEntry> entries;
+    /** Lines that did not fit in a set pinned by outstanding requests. */
+    m5::hash_map<Addr, SnoopItem> overflow;
+    /** Evicted lines waiting to be invalidated in their holders. */
+    std::vector<std::pair<Addr, SnoopMask> > backInvalidations;
+    /** Counter used for the replacement decisions. */
+    uint64_t useCount;
+    /** Mask of all the attached slave ports. */
+    SnoopMask allPorts;
     /** Cache line size. */
     const unsigned linesize;
     /** Latency for doing a lookup in the filter */
@@ -238,6 +317,10 @@ class SnoopFilter : public SimObject {
     Stats::Scalar totSnoops;
     Stats::Scalar hitSingleSnoops;
     Stats::Scalar hitMultiSnoops;
+
+    Stats::Scalar evictions;
+    Stats::Scalar backInvalidationCount;
+    Stats::Scalar overflowCount;
 };
 
 inline SnoopFilter::SnoopMask
@@ -250,22 +333,4 @@ SnoopFilter::portToMask(const SlavePort& port) const
     return ((SnoopMask)1) << id;
 }
 
-inline SnoopFilter::SnoopMask
-SnoopFilter::portListToMask(const SnoopList& ports) const
-{
-    SnoopMask m = 0;
-    for (auto port = ports.begin(); port != ports.end(); ++port)
-        m |= portToMask(**port);
-    return m;
-}
-
-inline SnoopFilter::SnoopList
-SnoopFilter::maskToPortList(SnoopMask port_mask) const
-{
-    SnoopList res;
-    for (auto port = slavePorts.begin(); port != slavePorts.end(); ++port)
-        if (port_mask & portToMask(**port))
-            res.push_back(*port);
-    return res;
-}
 #endif // __MEM_SNOOP_FILTER_HH__
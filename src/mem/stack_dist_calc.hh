@@ -41,9 +41,10 @@
 #ifndef __MEM_STACK_DIST_CALC_HH__
 #define __MEM_STACK_DIST_CALC_HH__
 
-#include <map>
+#include <limits>
 #include <vector>
 
+#include "base/hashmap.hh"
 #include "base/types.hh"
 #include "mem/packet.hh"
 #include "params/StackDistCalc.hh"
@@ -53,28 +54,35 @@
 /**
   * The stack distance calculator is a passive object that merely
   * observes the addresses pass to it. It calculates stack distances
-  * of incoming addresses based on the partial sum hierarchy tree
-  * algorithm described by Alamasi et al.
+  * of incoming addresses based on the partial sum hierarchy
+  * algorithm described by Almasi et al.
   * http://doi.acm.org/10.1145/773039.773043.
   *
-  * A tree structure is maintained and updated at each transaction
-  * (unique or non-unique). The tree is implemented as an STL vector
-  * with layers of the form <map> Each layer in this tree is an
-  * ordered map <uint64_t, Node*>. Nodes are structs which take form
-  * of leaf, intermediate and root nodes. For example, in a tree with 3
-  * layers, tree[0][5] gives a leaf node pointer for key=5 tree[1][1]
-  * gives an intermediate node pointer for key=1 tree[2][0] gives the
-  * root node in the tree.
+  * Every access is given a slot in a time line, and each address
+  * only keeps the slot of its most recent access alive. The stack
+  * distance of an address is thus the number of live slots after
+  * its own. The live slots are kept in a binary indexed (Fenwick)
+  * tree, stored in a single contiguous vector, where both marking a
+  * slot live or dead, and counting the live slots up to a given one,
+  * take O(log n) time. A hash map gives the slot of each address
+  * (aiMap).
   *
-  * At every transaction a hash-map (aiMap) is looked up to check if
-  * the address was already encountered before. Based on this lookup a
+  * As the time line only grows, the slots are compacted once it is
+  * full: the live slots are renumbered in order, which preserves all
+  * the stack distances, and the tree is rebuilt in linear time. The
+  * time line is sized to be at least twice the number of live
+  * addresses after compaction, so the cost is amortised over at
+  * least as many accesses.
+  *
+  * At every transaction the hash map is looked up to check if the
+  * address was already encountered before. Based on this lookup a
   * transaction can be termed as unique or non-unique.
   *
   * In addition to the normal stack distance calculation, a feature to
-  * mark an old node in the tree is added. This is useful if it is
+  * mark an address on the stack is added. This is useful if it is
   * required to see the reuse pattern. For example, BackInvalidates
   * from a lower level (e.g. membus to L2), can be marked (isMarked
-  * flag of Node set to True). Then later if this same address is
+  * flag of the entry set to True). Then later if this same address is
   * accessed (by L1), the value of the isMarked flag would be
   * True. This would give some insight on how the BackInvalidates
   * policy of the lower level affect the read/write accesses in an
@@ -83,41 +91,29 @@
   * There are two functions provided to interface with the calculator:
   * 1. pair<uint64_t, bool> calcStackDistAndUpdate(Addr r_address,
   *                                                bool addNewNode)
-  * At every unique transaction a new leaf node is added at tree[0](leaf layer)
-  * and linked to the layer above (if addNewNode is True). The sums of all
-  * the intermediate nodes is updated till the root. The stack-distance is
+  * At every unique transaction a new slot is allocated at the end of
+  * the time line (if addNewNode is True). The stack-distance is
   * returned as a Constant representing INFINITY.
   *
-  * At every non-unique transaction the tree is traversed from the
-  * leaf at the returned index to the root, the old node is deleted
-  * from the tree, and the sums (to the right are collected) and
-  * decremented. The collected sum represets the stack distance of the
-  * found node. If this node was marked then a bool flag set to True
-  * is returned with the stack_distance. During this operation a node
-  * is discarded at the leaf layer always. Moreover during the
-  * traversal upwards using the updateSum() method, if an intermediate
-  * node is found with no children connected to it, then that is
-  * discarded too.
+  * At every non-unique transaction the live slots after the one of
+  * the address are counted, which is the stack distance, and the old
+  * slot is discarded. If this address was marked then a bool flag
+  * set to True is returned with the stack_distance.
   *
   * The return value of this function is a pair representing the
   * stack_distance and the value of the marked flag.
   *
   * 2. pair<uint64_t , bool> calcStackDist(Addr r_address, bool mark)
   * This is a stripped down version of the above function which is used to
-  * just inspect the tree, and mark a leaf node (if mark flag is set). The
-  * functionality to add a new node is removed.
+  * just inspect the stack, and mark an address (if mark flag is set). The
+  * functionality to add a new slot is removed.
   *
   * At every unique transaction the stack-distance is returned as a constant
   * representing INFINITY.
   *
-  * At every non-unique transaction the tree is traversed from the
-  * leaf at the returned index to the root, and the sums (to the right)
-  * are collected. The collected sum represets the stack distance of
-  * the found node.
-  *
-  * This function does NOT Modify the stack. (No node is added or
-  * deleted).  It is just used to mark a node already created and get
-  * its stack distance.
+  * This function does NOT Modify the stack. (No slot is added or
+  * discarded).  It is just used to mark an address already on the
+  * stack and get its stack distance.
   *
   * The return value of this function is a pair representing the stack
   * distance and the value of the marked flag.
@@ -154,14 +150,14 @@
   * Delete Old Entry |calcStackDistAndUpdate|Writebacks/Cleanevicts|
   * Dist.of Old entry|calcStackDist         |Cleanevicts/Invalidate|
   *
-  * Node Balancing: The tree structure is maintained by an
-  * updateTree() operation called when an intermediate node is
-  * required. The update operation is roughly categorized as a root
-  * update or intermediate layer update. When number of leaf nodes
-  * grow over a power of 2 then a new layer is added at the top of the
-  * tree and a new root node is initialized. The old node at the lower
-  * layer is connected to this.  In an intermediate node update
-  * operation a new intermediate node is added to the required layer.
+  * Sampling: Rather than tracking every address, the calculator can
+  * track a fixed fraction of the addresses, selected by a hash of the
+  * address, as done by SHARDS (Waldspurger et al., FAST'15). The
+  * stack distances seen amongst the sampled addresses are scaled by
+  * the inverse of the sampling rate, which gives an approximate
+  * distribution at a fraction of the cost in both time and
+  * memory. Note that the histograms then only count the sampled
+  * accesses.
   *
   * Debugging: Debugging can be enabled by setting the verifyStack flag
   * true. Debugging is implemented using a dummy stack that behaves in
@@ -172,108 +168,88 @@
   * pushed down, and the address is pushed at the top of the stack).
   *
   * A printStack(int numOfEntitiesToPrint) is provided to print top n entities
-  * in both (tree and STL based dummy stack).
+  * in both (the time line and STL based dummy stack).
   */
 class StackDistCalc : public SimObject
 {
 
   private:
 
-    struct Node;
-
-    typedef std::map<uint64_t, Node*> IndexNodeMap;
-    typedef std::map<Addr, uint64_t> AddressIndexMap;
-    typedef std::vector<IndexNodeMap> TreeType;
-
     /**
-     * Gets sum from the node upwards recursively till the root.  This
-     * function is called first by getSumsLeavesToRoot, and then
-     * recursively calls itself.
-     *
-     * @param node pointer to the node which is updated
-     * @param from_left variable which says that the request arrived
-     *        from the left
-     * @param sum_from_below Sum of left and right children below
-     * @param level level in the tree the calling node is located
-     * @param stack_dist stack distance of the node below
-     * @return The stack distance of the current address.
-     *
+     * The state kept per address on the stack
      */
-    uint64_t getSum(Node* node, bool from_left, uint64_t sum_from_below,
-                    uint64_t stack_dist, uint64_t level) const;
+    struct Entry {
+        // The address itself
+        Addr addr;
+
+        // Slot of the most recent access to the address
+        uint64_t slot;
+
+        /**
+         * Flag to indicate if this address is marked. Used in case
+         * where stack distance of a touched address is required.
+         */
+        bool isMarked;
+
+        Entry(Addr _addr) : addr(_addr), slot(0), isMarked(false)
+        { }
+    };
+
+    typedef m5::hash_map<Addr, Entry> AddressIndexMap;
 
     /**
-     * Gets the sum from the leaf node specified. This function
-     * is called by calcStackDist.
-     *
-     * @param node pointer to the node which is updated
-     * @return The stack distance of the current address.
+     * Mark a slot as live or dead in the tree.
      *
+     * @param slot The slot to update
+     * @param delta 1 to mark the slot as live, -1 to mark it as dead
      */
-    uint64_t getSumsLeavesToRoot(Node* node) const;
+    void addToTree(uint64_t slot, int32_t delta);
 
     /**
-     * Updates the nodes upwards recursively till the root.
-     * This function is first called by updateSumsLeavesToRoot,
-     * and then it recursively calls itself.
-     *
-     * @param node pointer to the node which is updated
-     * @param from_left variable which says that the request arrived
-     * from the left
-     * @param sum_from_below Sum of left and right children below
-     * @param level level in the tree the calling node is located
-     * @param stack_dist stack distance of the node below
-     * @param discard_node whether the calling node was discarded or not
-     * @return The stack distance of the current address.
+     * Count the live slots up to and including a given slot.
      *
+     * @param slot The last slot to include
+     * @return The number of live slots
      */
-    uint64_t updateSum(Node* node,
-                       bool from_left, uint64_t sum_from_below, uint64_t level,
-                       uint64_t stack_dist, bool discard_node);
+    uint64_t countLive(uint64_t slot) const;
 
     /**
-     * Updates the leaf nodes and nodes above. This function is
-     * called by the calcStackDistAndUpdate.
-     *
-     * @param node pointer to the node which is updated
-     * @param is_new_leaf is true if this is a newly added node
-     * @return The stack distance of the current address.
+     * Get the stack distance of an address on the stack, i.e. the
+     * number of live slots after its own.
      *
+     * @param entry The entry of the address
+     * @return The stack distance of the address
      */
-    uint64_t updateSumsLeavesToRoot(Node* node, bool is_new_leaf);
+    uint64_t getStackDist(const Entry& entry) const
+    { return numLive - countLive(entry.slot); }
 
     /**
-     * updateTree is a tree balancing operation, which maintains the
-     * binary tree structure.
-     * This method is called whenever index%2 == 0 (i.e. every
-     * alternate cycle) The two main operation are :
-     * OP1. Moving the root node one layer up if index counter
-     *       crosses power of 2
-     * OP2. Addition of intermediate nodes as and when required
-     *      and linking them to their parents in the layer above.
+     * Compact the time line by renumbering the live slots, and
+     * rebuild the tree, making room for new accesses.
      */
-    void updateTree();
+    void compact();
 
     /**
-     * This method is used for verification purposes
-     * It recursively traverses upwards from the given node till
-     * the root to check if the ultimate parent node (root-node) points
-     * to null.
-     *
-     * @param node pointer to the node whose sanity is being checked
-     * @param level the level at which this node is located in the tree
+     * Determine if an address is amongst the ones sampled.
      *
+     * @param addr The address to check
+     * @return true if the address is tracked
      */
-    void sanityCheckTree(const Node* node, uint64_t level = 0) const;
+    bool isSampled(Addr addr) const;
 
     /**
      * A convenient way of refering to infinity.
      */
     static constexpr uint64_t Infinity = std::numeric_limits<uint64_t>::max();
 
+    /**
+     * Minimum number of slots in the time line
+     */
+    static const uint64_t MinSlots = 4096;
+
     /**
      * Process the given address. If Mark is true then set the
-     * mark flag of the leaf node.
+     * mark flag of the address.
      * This function returns the stack distance of the incoming
      * address and the previous status of the mark flag.
      *
@@ -286,14 +262,14 @@ class StackDistCalc : public SimObject
 
     /**
      * Process the given address:
-     *  - Lookup the tree for the given address
-     *  - delete old node if found in tree
-     *  - add a new node (if addNewNode flag is set)
+     *  - Lookup the stack for the given address
+     *  - discard the old slot if found
+     *  - add a new slot (if addNewNode flag is set)
      * This function returns the stack distance of the incoming
      * address and the status of the mark flag.
      *
      * @param r_address The current address to process
-     * @param addNewNode If true, a new node is added to the tree
+     * @param addNewNode If true, a new slot is added to the stack
      * @return The stack distance of the current address and the mark flag.
      */
     std::pair<uint64_t, bool> calcStackDistAndUpdate(const Addr r_address,
@@ -308,19 +284,10 @@ class StackDistCalc : public SimObject
      */
     uint64_t getIndex() const { return index; }
 
-    /**
-     * Query depth of the tree (tree[0] represents leaf layer while
-     * tree[treeDepth] represents the root layer, all layers in
-     * between contain intermediate nodes)
-     *
-     * @return Tree depth
-     */
-    uint64_t getTreeDepth() const { return tree.size() - 1; }
-
     /**
      * Print the last n items on the stack.
-     * This method prints top n entries in the tree based implementation as
-     * well as dummy stack.
+     * This method prints top n entries in the time line as well as
+     * the dummy stack.
      * @param n Number of entries to print
      */
     void printStack(int n = 5) const;
@@ -329,7 +296,7 @@ class StackDistCalc : public SimObject
      * This is an alternative implementation of the stack-distance
      * in a naive way. It uses simple STL vector to represent the stack.
      * It can be used in parallel for debugging purposes.
-     * It is 10x slower than the tree based implemenation.
+     * It is a lot slower than the tree based implemenation.
      *
      * @param r_address The current address to process
      * @param update_stack Flag to indicate if stack should be updated
@@ -350,12 +317,10 @@ class StackDistCalc : public SimObject
 
     StackDistCalc(const StackDistCalcParams* p);
 
-    ~StackDistCalc();
-
     void regStats();
 
     /**
-     * Update the tree and the statistics.
+     * Update the stack and the statistics.
      *
      * @param cmd Command from the packet
      * @param addr Address to put on the stack
@@ -365,72 +330,41 @@ class StackDistCalc : public SimObject
   private:
 
     /**
-     * Node which takes form of Leaf, INode or Root
+     * Internal counter for address accesses (unique and non-unique)
+     * This counter increments everytime the calcStackDistAndUpdate()
+     * method adds an address to the stack.
      */
-    struct Node{
-        // Sum of the left children
-        uint64_t sumLeft;
-
-        // Sum of the right children
-        uint64_t sumRight;
-
-        // Flag to indicate that sumLeft has gone from non-zero value to 0
-        bool discardLeft;
-
-        // Flag to indicate that sumRight has gone from non-zero value to 0
-        bool discardRight;
-
-        // Index of the current element in the Map
-        uint64_t nodeIndex;
-
-        // Pointer to the parent
-        Node* parent;
-
-        // Flag to mark the node as the right/left child
-        bool isLeftNode;
+    uint64_t index;
 
-        /**
-         * Flag to indicate if this address is marked. Used in case
-         * where stack distance of a touched address is required.
-         */
-        bool isMarked;
+    // Binary indexed tree of live slots, with the root at index 0
+    // unused, so the entry for slot s is at s + 1
+    std::vector<uint32_t> tree;
 
-        /**
-         * The discard flags are false by default they become true if
-         * the node is reached again in a future lookup.
-         */
-        Node() : sumLeft(0), sumRight(0), discardLeft(false),
-                 discardRight(false), nodeIndex(0),
-                 parent(nullptr), isLeftNode(true), isMarked(false)
-        { }
-    };
+    // The entry owning each slot, or NULL if the slot is dead,
+    // relying on the entries of the hash map never moving
+    std::vector<Entry*> slotEntries;
 
-    /**
-     * Internal counter for address accesses (unique and non-unique)
-     * This counter increments everytime the calcStackDist() method is
-     * called. This counter is used as a key for the hash- map at the
-     * leaf layer. Practically at every call to the calculator this
-     * counter is incremented and a new leaf node is added in the tree
-     * at the leaf layer using this counter value as the key.
-     */
-    uint64_t index;
+    // Next slot to use in the time line
+    uint64_t nextSlot;
 
-    // Binary tree of partial sums
-    TreeType tree;
+    // Number of live slots, i.e. addresses on the stack
+    uint64_t numLive;
 
-    // Hash map which returns last seen index of each address
+    // Hash map which returns the stack entry of each address
     AddressIndexMap aiMap;
 
-    // Keeps count of number of the next unique index for each
-    // level in the tree
-    std::vector<uint64_t> nextIndex;
-
     // Dummy Stack for verification
     std::vector<uint64_t> stack;
 
     // Flag to enable verification of stack. (Slows down the simulation)
     const bool verifyStack;
 
+    // Fraction of the addresses tracked
+    const double samplingRate;
+
+    // Threshold on the address hash for an address to be sampled
+    const uint64_t samplingThreshold;
+
     // Disable the linear histograms
     const bool disableLinearHists;
 
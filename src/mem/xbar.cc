@@ -47,6 +47,8 @@
  * Definition of a crossbar object.
  */
 
+#include <algorithm>
+
 #include "base/misc.hh"
 #include "base/trace.hh"
 #include "debug/AddrRanges.hh"
@@ -57,11 +59,26 @@
 BaseXBar::BaseXBar(const BaseXBarParams *p)
     : MemObject(p),
       headerCycles(p->header_cycles), width(p->width),
+      arbitration(p->arbitration), qosWeights(p->qos_weights),
+      disableWaitTimeHists(p->disable_wait_time_hists),
+      waitTimeBins(p->wait_time_bins), waitTimeBucket(p->wait_time_bucket),
       gotAddrRanges(p->port_default_connection_count +
                           p->port_master_connection_count, false),
       gotAllAddrRanges(false), defaultPortID(InvalidPortID),
       useDefaultRange(p->use_default_range)
-{}
+{
+    if (!qosWeights.empty() &&
+        qosWeights.size() != p->port_slave_connection_count)
+        fatal("%s has %d qos weights but %d slave ports\n", name(),
+              qosWeights.size(), p->port_slave_connection_count);
+
+    for (auto w : qosWeights)
+        fatal_if(w == 0, "%s qos weights must be non-zero\n", name());
+
+    fatal_if(waitTimeBins == 0 || waitTimeBucket == 0,
+             "%s wait time histograms need at least one bin of at least "
+             "one cycle\n", name());
+}
 
 BaseXBar::~BaseXBar()
 {
@@ -136,8 +153,126 @@ template <typename SrcType, typename DstType>
 BaseXBar::Layer<SrcType,DstType>::Layer(DstType& _port, BaseXBar& _xbar,
                                        const std::string& _name) :
     port(_port), xbar(_xbar), _name(_name), state(IDLE), drainManager(NULL),
-    waitingForPeer(NULL), releaseEvent(this)
+    waitingHead(0), numWaiting(0), peerRetryFirst(false), lastGranted(0),
+    globalPass(0), waitingForPeer(NULL), releaseEvent(this)
+{
+}
+
+template <typename SrcType, typename DstType>
+void
+BaseXBar::Layer<SrcType,DstType>::setSources(
+    const std::vector<SrcType*>& src_ports,
+    const std::vector<unsigned int>& weights)
+{
+    assert(weights.empty() || weights.size() == src_ports.size());
+
+    // the stride of a source with unit weight, large enough to give
+    // a reasonable resolution for the weight ratios
+    const uint64_t unit_stride = ULL(1) << 20;
+
+    sources = src_ports;
+    waitingForLayer.resize(sources.size());
+    waitingSince.resize(sources.size(), MaxTick);
+    pass.resize(sources.size(), 0);
+    stride.resize(sources.size());
+    for (unsigned int i = 0; i < sources.size(); ++i)
+        stride[i] = unit_stride / (weights.empty() ? 1 : weights[i]);
+}
+
+template <typename SrcType, typename DstType>
+unsigned int
+BaseXBar::Layer<SrcType,DstType>::sourceIndex(SrcType* src_port) const
 {
+    // the ports are normally found based on their id, and the ones
+    // without an id, i.e. the snoop response ports, by searching
+    PortID id = src_port->getId();
+    if (id != InvalidPortID && id < sources.size() && sources[id] == src_port)
+        return id;
+
+    auto s = std::find(sources.begin(), sources.end(), src_port);
+    panic_if(s == sources.end(), "%s is not a source of layer %s\n",
+             src_port->name(), name());
+    return s - sources.begin();
+}
+
+template <typename SrcType, typename DstType>
+void
+BaseXBar::Layer<SrcType,DstType>::pushWaiting(unsigned int src, bool front)
+{
+    // every source waits at most once, so the ring never overflows
+    const unsigned int capacity = waitingForLayer.size();
+    assert(numWaiting < capacity);
+
+    if (front) {
+        waitingHead = (waitingHead + capacity - 1) % capacity;
+        waitingForLayer[waitingHead] = src;
+    } else {
+        waitingForLayer[(waitingHead + numWaiting) % capacity] = src;
+    }
+    ++numWaiting;
+
+    waitingSince[src] = curTick();
+
+    // a port that has not been competing for the layer does not get
+    // to make up for it
+    pass[src] = std::max(pass[src], globalPass);
+}
+
+template <typename SrcType, typename DstType>
+unsigned int
+BaseXBar::Layer<SrcType,DstType>::popWaiting()
+{
+    assert(numWaiting != 0);
+    const unsigned int capacity = waitingForLayer.size();
+
+    // position in the ring, relative to the head, of the port to
+    // grant, with the oldest port winning any ties
+    unsigned int pos = 0;
+    if (!peerRetryFirst) {
+        if (xbar.arbitration == Enums::round_robin) {
+            unsigned int best = capacity;
+            for (unsigned int i = 0; i < numWaiting; ++i) {
+                unsigned int src = waitingForLayer[(waitingHead + i) %
+                                                   capacity];
+                unsigned int distance = (src + capacity - lastGranted - 1) %
+                    capacity;
+                if (distance < best) {
+                    best = distance;
+                    pos = i;
+                }
+            }
+        } else if (xbar.arbitration == Enums::qos) {
+            for (unsigned int i = 1; i < numWaiting; ++i) {
+                unsigned int src = waitingForLayer[(waitingHead + i) %
+                                                   capacity];
+                unsigned int cur = waitingForLayer[(waitingHead + pos) %
+                                                   capacity];
+                if (pass[src] < pass[cur])
+                    pos = i;
+            }
+        }
+    }
+    peerRetryFirst = false;
+
+    unsigned int src = waitingForLayer[(waitingHead + pos) % capacity];
+
+    // close the gap by moving the older ports up one slot
+    for (unsigned int i = pos; i > 0; --i)
+        waitingForLayer[(waitingHead + i) % capacity] =
+            waitingForLayer[(waitingHead + i - 1) % capacity];
+    waitingHead = (waitingHead + 1) % capacity;
+    --numWaiting;
+
+    lastGranted = src;
+    globalPass = pass[src];
+    pass[src] += stride[src];
+
+    if (!xbar.disableWaitTimeHists)
+        waitTime[src].sample(xbar.ticksToCycles(curTick() -
+                                                waitingSince[src]));
+    waitingSince[src] = MaxTick;
+
+    return src;
 }
 
 template <typename SrcType, typename DstType>
@@ -174,15 +309,16 @@ BaseXBar::Layer<SrcType,DstType>::tryTiming(SrcType* src_port)
     // destination port is already engaged in a transaction waiting
     // for a retry from the peer
     if (state == BUSY || waitingForPeer != NULL) {
+        unsigned int src = sourceIndex(src_port);
+
         // the port should not be waiting already
-        assert(std::find(waitingForLayer.begin(), waitingForLayer.end(),
-                         src_port) == waitingForLayer.end());
+        assert(waitingSince[src] == MaxTick);
 
         // put the port at the end of the retry list waiting for the
         // layer to be freed up (and in the case of a busy peer, for
         // that transaction to go through, and then the layer to free
         // up)
-        waitingForLayer.push_back(src_port);
+        pushWaiting(src, false);
         return false;
     }
 
@@ -237,7 +373,7 @@ BaseXBar::Layer<SrcType,DstType>::releaseLayer()
     state = IDLE;
 
     // bus layer is now idle, so if someone is waiting we can retry
-    if (!waitingForLayer.empty()) {
+    if (numWaiting != 0) {
         // there is no point in sending a retry if someone is still
         // waiting for the peer
         if (waitingForPeer == NULL)
@@ -256,7 +392,7 @@ void
 BaseXBar::Layer<SrcType,DstType>::retryWaiting()
 {
     // this should never be called with no one waiting
-    assert(!waitingForLayer.empty());
+    assert(numWaiting != 0);
 
     // we always go to retrying from idle
     assert(state == IDLE);
@@ -264,10 +400,9 @@ BaseXBar::Layer<SrcType,DstType>::retryWaiting()
     // update the state
     state = RETRY;
 
-    // set the retrying port to the front of the retry list and pop it
-    // off the list
-    SrcType* retryingPort = waitingForLayer.front();
-    waitingForLayer.pop_front();
+    // pick the port to retry according to the arbitration policy
+    // and remove it from the list
+    SrcType* retryingPort = sources[popWaiting()];
 
     // tell the port to retry, which in some cases ends up calling the
     // layer again
@@ -295,8 +430,10 @@ BaseXBar::Layer<SrcType,DstType>::recvRetry()
 
     // add the port where the failed packet originated to the front of
     // the waiting ports for the layer, this allows us to call retry
-    // on the port immediately if the crossbar layer is idle
-    waitingForLayer.push_front(waitingForPeer);
+    // on the port immediately if the crossbar layer is idle, and
+    // ensures it goes first when the layer is busy
+    pushWaiting(sourceIndex(waitingForPeer), true);
+    peerRetryFirst = true;
 
     // we are no longer waiting for the peer
     waitingForPeer = NULL;
@@ -608,6 +745,17 @@ BaseXBar::Layer<SrcType,DstType>::regStats()
         .flags(nozero);
 
     utilization = 100 * occupancy / simTicks;
+
+    waitTime
+        .init(std::max<size_t>(sources.size(), 1), 0,
+              xbar.waitTimeBins * xbar.waitTimeBucket - 1,
+              xbar.waitTimeBucket)
+        .name(name() + ".waitTime")
+        .desc("Cycles spent waiting for the layer per source port")
+        .flags(xbar.disableWaitTimeHists ? nozero : pdf | nozero);
+
+    for (unsigned int i = 0; i < sources.size(); ++i)
+        waitTime.subname(i, sources[i]->name());
 }
 
 /**
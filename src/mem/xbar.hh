@@ -51,11 +51,12 @@
 #ifndef __MEM_XBAR_HH__
 #define __MEM_XBAR_HH__
 
-#include <deque>
+#include <vector>
 
 #include "base/addr_range_map.hh"
 #include "base/hashmap.hh"
 #include "base/types.hh"
+#include "enums/XBarArbitration.hh"
 #include "mem/mem_object.hh"
 #include "params/BaseXBar.hh"
 #include "sim/stats.hh"
@@ -87,6 +88,11 @@ class BaseXBar : public MemObject
      * ports or slave ports, depending on the direction of the
      * layer. Thus, a request layer has a retry list containing slave
      * ports, whereas a response layer holds master ports.
+     *
+     * As every source port waits for a layer at most once, the retry
+     * list is a ring buffer sized by the number of source ports, and
+     * the port to retry next is chosen from it according to the
+     * arbitration policy of the crossbar.
      */
     template <typename SrcType, typename DstType>
     class Layer : public Drainable
@@ -115,6 +121,19 @@ class BaseXBar : public MemObject
          */
         unsigned int drain(DrainManager *dm);
 
+        /**
+         * Tell the layer about all the ports that can send through
+         * it. This must be done before any timing requests, and
+         * before the stats are registered.
+         *
+         * @param sources Source ports, indexed by their port id
+         *                where they have one
+         * @param weights QoS weights of the sources, or empty to give
+         *                all sources the same weight
+         */
+        void setSources(const std::vector<SrcType*>& sources,
+                        const std::vector<unsigned int>& weights);
+
         /**
          * Get the crossbar layer's name
          */
@@ -209,11 +228,54 @@ class BaseXBar : public MemObject
         /** manager to signal when drained */
         DrainManager *drainManager;
 
+        /** The source ports of the layer. */
+        std::vector<SrcType*> sources;
+
+        /**
+         * Look up the index of a source port, which is its port id
+         * unless the port does not have one.
+         */
+        unsigned int sourceIndex(SrcType* src_port) const;
+
+        /**
+         * A ring buffer of the indices of the source ports that
+         * retry should be called on because the original send was
+         * delayed due to a busy layer, oldest first.
+         */
+        std::vector<unsigned int> waitingForLayer;
+        unsigned int waitingHead;
+        unsigned int numWaiting;
+
+        /** Tick each source port started waiting, or MaxTick */
+        std::vector<Tick> waitingSince;
+
+        /**
+         * Set if the port at the head of the ring was waiting for
+         * the peer, in which case it goes first irrespective of the
+         * arbitration policy.
+         */
+        bool peerRetryFirst;
+
+        void pushWaiting(unsigned int src, bool front);
+
+        /**
+         * Pick the next port to retry according to the arbitration
+         * policy and remove it from the ring.
+         */
+        unsigned int popWaiting();
+
+        /** Source index of the port last granted by a retry */
+        unsigned int lastGranted;
+
         /**
-         * A deque of ports that retry should be called on because
-         * the original send was delayed due to a busy layer.
+         * Stride scheduling state for the qos arbitration, where the
+         * waiting port with the lowest pass is granted and then has
+         * its pass advanced by its stride, being inversely
+         * proportional to its weight.
          */
-        std::deque<SrcType*> waitingForLayer;
+        std::vector<uint64_t> pass;
+        std::vector<uint64_t> stride;
+        uint64_t globalPass;
 
         /**
          * Track who is waiting for the retry when receiving it from a
@@ -239,6 +301,9 @@ class BaseXBar : public MemObject
         Stats::Scalar occupancy;
         Stats::Formula utilization;
 
+        /** Cycles each source port waited before being retried */
+        Stats::VectorDistribution waitTime;
+
     };
 
     /** cycles of overhead per transaction */
@@ -246,6 +311,15 @@ class BaseXBar : public MemObject
     /** the width of the xbar in bytes */
     const uint32_t width;
 
+    /** layer arbitration policy, and the weights for qos */
+    const Enums::XBarArbitration arbitration;
+    const std::vector<unsigned int> qosWeights;
+
+    /** layer wait time histogram configuration */
+    const bool disableWaitTimeHists;
+    const unsigned int waitTimeBins;
+    const Cycles waitTimeBucket;
+
     AddrRangeMap<PortID> portMap;
 
     /**
@@ -39,6 +39,8 @@ from SimpleMemory import *
 class MemoryMode(Enum): vals = ['invalid', 'atomic', 'timing',
                                 'atomic_noncaching']
 
+class PhysMemFormat(Enum): vals = ['gzip', 'raw', 'chunked']
+
 class System(MemObject):
     type = 'System'
     cxx_header = "sim/system.hh"
@@ -66,6 +68,34 @@ class System(MemObject):
     mmap_using_noreserve = Param.Bool(False, "mmap the backing store " \
                                           "without reserving swap")
 
+    # The memory image in a checkpoint is either gzip compressed,
+    # stored raw, or chunked. A raw image is larger (although pages
+    # that are all zero are not stored), but is mapped copy-on-write
+    # when restoring rather than decompressed and copied, so that
+    # restoring is lazy and simulations restored from the same
+    # checkpoint share the pages they do not modify. A chunked image
+    # skips the chunks that are all zero, and compresses the others
+    # independently, and thus in parallel, both when writing and
+    # reading the image. The format used by a checkpoint is recorded
+    # in it, and any format can be restored independent of this
+    # parameter.
+    physmem_format = Param.PhysMemFormat('gzip', "Format of the memory " \
+                                             "image in checkpoints")
+
+    # Host threads used for chunked memory images
+    physmem_threads = Param.Unsigned(0, "Threads used to (de)compress " \
+                                         "chunked memory images, 0 to use " \
+                                         "one per host core")
+
+    # Checkpoints can be incremental with respect to the memory,
+    # storing only the pages written since the previous checkpoint
+    # (taken or restored) along with the chain of images they apply
+    # to. The chain is restored from the full image onwards, and
+    # after the given number of deltas a full image is written
+    # again. The checkpoints in a chain have to be kept together.
+    physmem_max_deltas = Param.Unsigned(0, "Number of incremental memory " \
+                                            "checkpoints before a full one")
+
     # The memory ranges are to be populated when creating the system
     # such that these can be passed from the I/O subsystem through an
     # I/O bridge or cache
@@ -33,6 +33,21 @@
 
 std::mutex BaseGlobalEvent::globalQMutex;
 
+/** Callbacks run at every quantum boundary. */
+static CallbackQueue quantumCallbacks;
+
+void
+registerQuantumCallback(Callback *callback)
+{
+    quantumCallbacks.add(callback);
+}
+
+bool
+haveQuantumCallbacks()
+{
+    return !quantumCallbacks.empty();
+}
+
 BaseGlobalEvent::BaseGlobalEvent(Priority p, Flags f)
     : barrier(numMainEventQueues),
       barrierEvent(numMainEventQueues, NULL)
@@ -154,6 +169,8 @@ GlobalSyncEvent::BarrierEvent::process()
 void
 GlobalSyncEvent::process()
 {
+    quantumCallbacks.process();
+
     if (repeat) {
         schedule(curTick() + repeat);
     }
@@ -36,6 +36,7 @@
 #include <vector>
 
 #include "base/barrier.hh"
+#include "base/callback.hh"
 #include "sim/eventq_impl.hh"
 
 /**
@@ -235,5 +236,19 @@ class GlobalSyncEvent : public BaseGlobalEventTemplate<GlobalSyncEvent>
     Tick repeat;
 };
 
+/**
+ * Register a callback to be run at every quantum boundary, i.e. each
+ * time a GlobalSyncEvent is processed.  The callbacks are run in
+ * registration order by a single thread while all other simulation
+ * threads are parked at the barrier, which makes them the place to
+ * exchange state between objects living on different event queues.
+ * Events scheduled from a callback on another thread's queue are
+ * inserted before any thread resumes simulation.
+ */
+void registerQuantumCallback(Callback *callback);
+
+/** Has any object registered a callback for the quantum boundaries. */
+bool haveQuantumCallbacks();
+
 
 #endif // __SIM_GLOBAL_EVENT_HH__
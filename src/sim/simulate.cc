@@ -114,10 +114,16 @@ simulate(Tick num_cycles)
             fatal("Quantum for multi-eventq simulation not specified");
         }
 
+        inParallelMode = true;
+    }
+
+    // A quantum is also honoured with a single event queue if objects
+    // synchronise at quantum boundaries, so that they behave the same
+    // whether or not the simulation is spread over several threads.
+    if (numMainEventQueues > 1 ||
+        (simQuantum != 0 && haveQuantumCallbacks())) {
         quantum_event = new GlobalSyncEvent(curTick() + simQuantum, simQuantum,
                             EventBase::Progress_Event_Pri, 0);
-
-        inParallelMode = true;
     }
 
     // all subordinate (created) threads should be waiting on the
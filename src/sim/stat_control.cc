@@ -55,6 +55,8 @@
 #include "base/statistics.hh"
 #include "base/time.hh"
 #include "cpu/base.hh"
+#include "mem/packet.hh"
+#include "mem/request.hh"
 #include "sim/global_event.hh"
 #include "sim/stat_control.hh"
 
@@ -112,6 +114,9 @@ struct Global
     Stats::Formula hostTickRate;
     Stats::Value hostMemory;
     Stats::Value hostSeconds;
+    Stats::Value hostPacketAllocs;
+    Stats::Value hostPacketDataAllocs;
+    Stats::Value hostRequestAllocs;
 
     Stats::Value simInsts;
     Stats::Value simOps;
@@ -189,6 +194,27 @@ Global::Global()
         .precision(2)
         ;
 
+    hostPacketAllocs
+        .functor(Packet::numAllocated)
+        .name("host_packet_allocs")
+        .desc("Number of packets allocated from the slab pool")
+        .precision(0)
+        ;
+
+    hostPacketDataAllocs
+        .functor(Packet::numDataAllocated)
+        .name("host_packet_data_allocs")
+        .desc("Number of packet data buffers allocated from the slab pool")
+        .precision(0)
+        ;
+
+    hostRequestAllocs
+        .functor(Request::numAllocated)
+        .name("host_request_allocs")
+        .desc("Number of requests allocated from the slab pool")
+        .precision(0)
+        ;
+
     hostTickRate
         .name("host_tick_rate")
         .desc("Simulator tick rate (ticks/s)")
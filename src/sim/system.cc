@@ -82,14 +82,18 @@ System::System(Params *p)
       _numContexts(0),
       pagePtr(0),
       init_param(p->init_param),
-      physProxy(_systemPort, p->cache_line_size),
+      physProxy(_systemPort, p->cache_line_size, this),
       kernelSymtab(nullptr),
       kernel(nullptr),
       loadAddrMask(p->load_addr_mask),
       loadAddrOffset(p->load_offset),
       nextPID(0),
-      physmem(name() + ".physmem", p->memories, p->mmap_using_noreserve),
+      physmem(name() + ".physmem", p->memories, p->mmap_using_noreserve,
+              p->physmem_format, p->physmem_max_deltas,
+              p->physmem_threads),
       memoryMode(p->mem_mode),
+      started(false),
+      numCaches(0),
       _cacheLineSize(p->cache_line_size),
       workItemsBegin(0),
       workItemsEnd(0),
@@ -306,6 +310,14 @@ System::initState()
     activeCpus.clear();
 }
 
+void
+System::startup()
+{
+    // from here on caches may be populated, and debug accesses have
+    // to go through the memory system unless caches are bypassed
+    started = true;
+}
+
 void
 System::replaceThreadContext(ThreadContext *tc, int context_id)
 {
@@ -322,6 +334,8 @@ System::replaceThreadContext(ThreadContext *tc, int context_id)
 Addr
 System::allocPhysPages(int npages)
 {
+    std::lock_guard<std::mutex> lock(pageAllocMutex);
+
     Addr return_addr = pagePtr << PageShift;
     pagePtr += npages;
 
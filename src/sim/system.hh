@@ -47,6 +47,7 @@
 #ifndef __SYSTEM_HH__
 #define __SYSTEM_HH__
 
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -62,6 +63,7 @@
 #include "mem/port_proxy.hh"
 #include "mem/physical.hh"
 #include "params/System.hh"
+#include "sim/eventq.hh"
 
 /**
  * To avoid linking errors with LTO, only include the header if we
@@ -163,6 +165,36 @@ class System : public MemObject
     bool bypassCaches() const {
         return memoryMode == Enums::atomic_noncaching;
     }
+
+    /**
+     * Can debug accesses go straight to the backing store?
+     *
+     * This is the case before the simulation starts, as nothing
+     * can be cached or in flight yet, when caches are bypassed, as
+     * they are then guaranteed to be empty, and in atomic mode when
+     * the system has no caches at all, as nothing is ever in flight.
+     * In all other cases a cache may hold a dirty copy, and the snoop
+     * filter, if any, only tracks presence and not ownership.
+     *
+     * With several event queues running in parallel, the memory
+     * system is only accessed from its own queue (or with the line
+     * locks of parallel fastmem), and a debug access from another
+     * thread has to take the same route, unless caches are bypassed,
+     * in which case the CPUs (e.g. KVM) access memory directly anyway.
+     */
+    bool directFunctionalAccess() const {
+        if (!started)
+            return true;
+        if (bypassCaches())
+            return true;
+        return !inParallelMode && isAtomicMode() && !numCaches;
+    }
+
+    /**
+     * Called by the caches of the system on construction, to know
+     * whether the system has any caches at all.
+     */
+    void registerCache() { ++numCaches; }
     /** @} */
 
     /** @{ */
@@ -214,6 +246,10 @@ class System : public MemObject
 
     Addr pagePtr;
 
+    /** Serialises page allocation when processes on different event
+     *  queues fault in pages concurrently. */
+    std::mutex pageAllocMutex;
+
     uint64_t init_param;
 
     /** Port to physical memory used for writing object files into ram at
@@ -298,6 +334,12 @@ class System : public MemObject
 
     Enums::MemoryMode memoryMode;
 
+    /** Set once all objects are started and events may be running */
+    bool started;
+
+    /** Number of caches in the system. */
+    unsigned int numCaches;
+
     const unsigned int _cacheLineSize;
 
     uint64_t workItemsBegin;
@@ -488,6 +530,8 @@ class System : public MemObject
 
     void initState();
 
+    void startup();
+
     const Params *params() const { return (const Params *)_params; }
 
   public:
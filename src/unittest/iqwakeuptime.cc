@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Time the two structures the O3 IQ can track register consumers
+ * with, on a synthetic stream of instructions with two sources each
+ * that depend on the recent producers, completing in order once the
+ * IQ is full and squashing the youngest instructions now and then.
+ */
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "base/refcnt.hh"
+#include "cpu/o3/dep_graph.hh"
+#include "cpu/o3/dep_matrix.hh"
+
+using namespace std;
+
+class Inst : public RefCounted
+{
+  public:
+    InstSeqNum seqNum;
+    ThreadID threadNumber;
+    PhysRegIndex dest;
+    vector<PhysRegIndex> waiting;
+
+    Inst(InstSeqNum seq_num, PhysRegIndex _dest)
+        : seqNum(seq_num), threadNumber(0), dest(_dest)
+    { waiting.reserve(2); }
+};
+
+typedef RefCountingPtr<Inst> InstPtr;
+
+const int numIQEntries = 64;
+const int numPhysRegs = 256;
+const int squashInterval = 50;
+
+volatile int stop = false;
+
+void
+handle_alarm(int signal)
+{
+    stop = true;
+}
+
+void
+do_test(int seconds)
+{
+    stop = false;
+    alarm(seconds);
+}
+
+template <class Tracker>
+void
+wakeup(Tracker &tracker, InstPtr &inst)
+{
+    InstPtr dep = tracker.pop(inst->dest);
+    while (dep) {
+        dep->waiting.erase(find(dep->waiting.begin(), dep->waiting.end(),
+                                inst->dest));
+        dep = tracker.pop(inst->dest);
+    }
+    tracker.clearInst(inst->dest);
+}
+
+template <class Tracker>
+void
+time_tracker(const char *name, int seconds)
+{
+    Tracker tracker(numIQEntries);
+    tracker.resize(numPhysRegs);
+
+    deque<InstPtr> window;
+    InstSeqNum seq_num = 0;
+    uint64_t insts = 0;
+
+    srandom(1);
+    do_test(seconds);
+    while (!stop) {
+        // complete the oldest instruction once the IQ is full
+        if (window.size() == numIQEntries) {
+            wakeup(tracker, window.front());
+            window.pop_front();
+        }
+
+        // every so often squash the youngest quarter of the IQ
+        if (++seq_num % squashInterval == 0) {
+            for (int i = 0; i < numIQEntries / 4 && !window.empty(); ++i) {
+                InstPtr &inst = window.back();
+                for (int j = 0; j < inst->waiting.size(); ++j)
+                    tracker.remove(inst->waiting[j], inst);
+                wakeup(tracker, inst);
+                window.pop_back();
+            }
+            continue;
+        }
+
+        InstPtr inst = new Inst(seq_num, seq_num % numPhysRegs);
+        for (int i = 0; i < 2 && !window.empty(); ++i) {
+            // mostly depend on the last few producers
+            int distance = random() % min<int>(window.size(), 8);
+            PhysRegIndex src = window[window.size() - 1 - distance]->dest;
+            inst->waiting.push_back(src);
+            tracker.insert(src, inst);
+        }
+        tracker.setInst(inst->dest, inst);
+        window.push_back(inst);
+        ++insts;
+    }
+
+    cprintf("%s: %d instructions in %ds, %f instructions/s\n",
+            name, insts, seconds, insts / double(seconds));
+}
+
+int
+main()
+{
+    signal(SIGALRM, handle_alarm);
+
+    time_tracker<DependencyGraph<InstPtr> >("DependencyGraph", 10);
+    time_tracker<DependencyMatrix<InstPtr> >("DependencyMatrix", 10);
+
+    return 0;
+}
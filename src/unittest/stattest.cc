@@ -28,6 +28,7 @@
  * Authors: Nathan Binkert
  */
 
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -100,6 +101,8 @@ struct StatTest
     Histogram h11;
     Histogram h12;
     SparseHistogram sh1;
+    Quantiles q1;
+    Quantiles q2;
 
     Vector s19;
     Vector s20;
@@ -343,6 +346,18 @@ StatTest::init()
         .desc("this is sparse histogram 1")
         ;
 
+    q1
+        .init()
+        .name("Quantiles1")
+        .desc("this is quantiles 1")
+        ;
+
+    q2
+        .init(5)
+        .name("Quantiles2")
+        .desc("this is quantiles 2")
+        ;
+
     f1
         .name("Formula1")
         .desc("this is formula 1")
@@ -674,6 +689,25 @@ StatTest::run()
         sh1.sample(random() % 10000);
     }
 
+    for (int i = 0; i < 1000; i++) {
+        q1.sample(random() % 10000);
+    }
+
+    // the quantiles of a uniform distribution are known, and the
+    // estimates must be within the relative error of 2^-precision
+    for (int i = 1; i <= 100000; i++) {
+        q2.sample(i);
+    }
+
+    const double q2_quantiles[] = { 0.5, 0.99 };
+    for (double q : q2_quantiles) {
+        double exact = q * 100000;
+        double estimate = q2.quantile(q);
+        if (fabs(estimate - exact) > exact / (1 << 5))
+            panic("Quantiles2 estimates quantile %f as %f instead of %f\n",
+                  q, estimate, exact);
+    }
+
     s19[0] = 1;
     s19[1] = 100000;
     s20[0] = 100000;
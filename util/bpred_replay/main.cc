@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2015 The gem5 SDC model contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ *  Trace driven evaluation of the standalone conditional branch
+ *  predictors in src/cpu/pred, for tuning predictors without running
+ *  a full simulation for every configuration.
+ *
+ *  The trace is either a protobuf branch trace recorded by the
+ *  BranchTrace probe listener (see src/proto/bpred.proto), or, if its
+ *  name ends with .txt, a text file with one branch per line: the PC
+ *  in hex, T (taken), N (not taken) or U (unconditional), and
+ *  optionally the number of instructions since the previous branch.
+ *
+ *  The trace is loaded once and replayed against every predictor
+ *  configuration, spreading the configurations over several threads.
+ *  A configuration is the predictor name followed by key=value pairs
+ *  overriding its default geometry, for example:
+ *
+ *    tage-sc-l numTables=8 logTableSize=11 scHistLengths=6,11,21
+ *    hashed-perceptron logTableSize=12 histLengths=0,4,8,16,32,64
+ *
+ *  The replay follows the BPredUnit protocol: every branch is looked
+ *  up when fetched and committed depth branches later. A
+ *  mispredicted branch is trained and repaired immediately, as it
+ *  would be on a squash, and retired when it commits.
+ */
+
+#include <sys/time.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu/pred/hashed_perceptron.hh"
+#include "cpu/pred/tage_sc_l.hh"
+#include "proto/bpred.pb.h"
+#include "proto/protoio.hh"
+
+/**
+ * The proto I/O library reports errors through panic(), which is
+ * normally provided by base/misc.cc along with the rest of the
+ * simulator.
+ */
+void
+__exit_epilogue(int code, const char *func, const char *file, int line,
+                const char *format)
+{
+    std::cerr << "\n[" << func << ":" << file << ", line " << line << "]\n";
+    if (code < 0)
+        std::abort();
+    std::exit(code);
+}
+
+namespace
+{
+
+struct TraceBranch
+{
+    Addr pc;
+    uint32_t insts;
+    bool taken;
+    bool conditional;
+};
+
+struct InFlight
+{
+    const TraceBranch *br;
+    void *history;
+    bool squashed;
+};
+
+/** A predictor configuration and the outcome of its replay. */
+struct Run
+{
+    std::string spec;
+    uint64_t condBranches;
+    uint64_t mispredicts;
+    double seconds;
+};
+
+void
+usage(const char *prog_name)
+{
+    std::cerr << "Usage: " << prog_name <<
+        " [-p <config>]... [-c <config file>] [-j <threads>] "
+        "[-d <depth>] <trace>\n"
+        "\n"
+        "  -p  predictor configuration to evaluate, may be repeated\n"
+        "  -c  file with one predictor configuration per line\n"
+        "  -j  number of replay threads (all cores)\n"
+        "  -d  number of branches in flight between lookup and commit (0)\n"
+        "\n"
+        "Without -p or -c, the default tage-sc-l and hashed-perceptron\n"
+        "configurations are evaluated.\n";
+    std::exit(EXIT_FAILURE);
+}
+
+bool
+endsWith(const std::string &s, const std::string &suffix)
+{
+    return s.size() >= suffix.size() &&
+        s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool
+readTextTrace(const std::string &name, std::vector<TraceBranch> &trace)
+{
+    FILE *f = std::fopen(name.c_str(), "r");
+    if (!f)
+        return false;
+
+    char line[256];
+    while (std::fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+
+        unsigned long long pc;
+        char dir;
+        unsigned insts = 0;
+        if (std::sscanf(line, "%llx %c %u", &pc, &dir, &insts) < 2 ||
+            !std::strchr("TNU", dir)) {
+            std::cerr << "Malformed trace line: " << line;
+            std::fclose(f);
+            return false;
+        }
+
+        TraceBranch br;
+        br.pc = pc;
+        br.insts = insts;
+        br.taken = dir != 'N';
+        br.conditional = dir != 'U';
+        trace.push_back(br);
+    }
+
+    std::fclose(f);
+    return true;
+}
+
+bool
+readProtoTrace(const std::string &name, std::vector<TraceBranch> &trace)
+{
+    std::ifstream probe(name.c_str());
+    if (!probe.good())
+        return false;
+    probe.close();
+
+    ProtoInputStream input(name);
+
+    ProtoMessage::BranchHeader header_msg;
+    if (!input.read(header_msg)) {
+        std::cerr << "Could not read the trace header\n";
+        return false;
+    }
+
+    ProtoMessage::Branch branch_msg;
+    while (input.read(branch_msg)) {
+        TraceBranch br;
+        br.pc = branch_msg.pc();
+        br.insts = branch_msg.insts();
+        br.taken = branch_msg.taken();
+        br.conditional = !branch_msg.uncond();
+        trace.push_back(br);
+    }
+
+    return true;
+}
+
+/** Parses a comma separated list of history lengths. */
+bool
+parseList(const std::string &value, std::vector<unsigned> &list)
+{
+    list.clear();
+    std::istringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        char *end;
+        unsigned long v = std::strtoul(item.c_str(), &end, 0);
+        if (item.empty() || *end)
+            return false;
+        list.push_back(v);
+    }
+    return !list.empty();
+}
+
+bool
+parseUnsigned(const std::string &value, unsigned &v)
+{
+    char *end;
+    v = std::strtoul(value.c_str(), &end, 0);
+    return !value.empty() && !*end;
+}
+
+bool
+setTageParam(TageSCL::Config &c, const std::string &key,
+             const std::string &value)
+{
+    if (key == "scHistLengths")
+        return parseList(value, c.scHistLengths);
+
+    unsigned *field =
+        key == "instShiftAmt" ? &c.instShiftAmt :
+        key == "logBimodalSize" ? &c.logBimodalSize :
+        key == "numTables" ? &c.numTables :
+        key == "logTableSize" ? &c.logTableSize :
+        key == "minHist" ? &c.minHist :
+        key == "maxHist" ? &c.maxHist :
+        key == "minTagBits" ? &c.minTagBits :
+        key == "maxTagBits" ? &c.maxTagBits :
+        key == "logUResetPeriod" ? &c.logUResetPeriod :
+        key == "logLoopSets" ? &c.logLoopSets :
+        key == "logSCTableSize" ? &c.logSCTableSize :
+        NULL;
+    return field && parseUnsigned(value, *field);
+}
+
+bool
+setPerceptronParam(HashedPerceptron::Config &c, const std::string &key,
+                   const std::string &value)
+{
+    if (key == "histLengths")
+        return parseList(value, c.histLengths);
+
+    unsigned *field =
+        key == "instShiftAmt" ? &c.instShiftAmt :
+        key == "logTableSize" ? &c.logTableSize :
+        key == "weightBits" ? &c.weightBits :
+        NULL;
+    return field && parseUnsigned(value, *field);
+}
+
+/**
+ * Builds the predictor described by a configuration line.
+ * @return The predictor, or NULL after printing why it is invalid.
+ */
+ConditionalPredictor *
+makePredictor(const std::string &spec)
+{
+    std::istringstream ss(spec);
+    std::string type;
+    ss >> type;
+
+    TageSCL::Config tage;
+    HashedPerceptron::Config perceptron;
+    if (type != "tage-sc-l" && type != "hashed-perceptron") {
+        std::cerr << "Unknown predictor '" << type << "'\n";
+        return NULL;
+    }
+
+    std::string param;
+    while (ss >> param) {
+        size_t eq = param.find('=');
+        std::string key = param.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" :
+            param.substr(eq + 1);
+        bool ok = type == "tage-sc-l" ?
+            setTageParam(tage, key, value) :
+            setPerceptronParam(perceptron, key, value);
+        if (!ok) {
+            std::cerr << "Bad parameter '" << param << "' for " << type << "\n";
+            return NULL;
+        }
+    }
+
+    const char *err = type == "tage-sc-l" ?
+        tage.check() : perceptron.check();
+    if (err) {
+        std::cerr << "Invalid configuration '" << spec << "': " << err << "\n";
+        return NULL;
+    }
+
+    if (type == "tage-sc-l")
+        return new TageSCL(tage);
+    else
+        return new HashedPerceptron(perceptron);
+}
+
+void
+commit(ConditionalPredictor &pred, InFlight &b)
+{
+    if (b.squashed)
+        pred.retireSquashed(b.history);
+    else
+        pred.update(b.br->pc, b.br->taken, b.history, false);
+}
+
+double
+now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/** Replays the whole trace through one predictor. */
+void
+replay(ConditionalPredictor &pred, const std::vector<TraceBranch> &trace,
+       unsigned depth, Run &run)
+{
+    std::deque<InFlight> in_flight;
+    run.condBranches = 0;
+    run.mispredicts = 0;
+
+    double start = now();
+    for (size_t i = 0; i < trace.size(); ++i) {
+        InFlight b;
+        b.br = &trace[i];
+        b.squashed = false;
+
+        if (b.br->conditional) {
+            ++run.condBranches;
+            if (pred.lookup(b.br->pc, b.history) != b.br->taken) {
+                ++run.mispredicts;
+                pred.update(b.br->pc, b.br->taken, b.history, true);
+                b.squashed = true;
+            }
+        } else {
+            pred.uncondBranch(b.history);
+        }
+
+        in_flight.push_back(b);
+        if (in_flight.size() > depth) {
+            commit(pred, in_flight.front());
+            in_flight.pop_front();
+        }
+    }
+    while (!in_flight.empty()) {
+        commit(pred, in_flight.front());
+        in_flight.pop_front();
+    }
+    run.seconds = now() - start;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char **argv)
+{
+    std::vector<Run> runs;
+    unsigned depth = 0;
+    unsigned num_threads = std::thread::hardware_concurrency();
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (arg + 1 >= argc)
+            usage(argv[0]);
+
+        Run run;
+        if (std::strcmp(argv[arg], "-p") == 0) {
+            run.spec = argv[++arg];
+            runs.push_back(run);
+        } else if (std::strcmp(argv[arg], "-c") == 0) {
+            std::ifstream configs(argv[++arg]);
+            if (!configs.good()) {
+                std::cerr << "Could not read " << argv[arg] << "\n";
+                return EXIT_FAILURE;
+            }
+            while (std::getline(configs, run.spec)) {
+                if (!run.spec.empty() && run.spec[0] != '#')
+                    runs.push_back(run);
+            }
+        } else if (std::strcmp(argv[arg], "-j") == 0) {
+            num_threads = std::atoi(argv[++arg]);
+        } else if (std::strcmp(argv[arg], "-d") == 0) {
+            depth = std::atoi(argv[++arg]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (arg + 1 != argc)
+        usage(argv[0]);
+
+    if (runs.empty()) {
+        Run run;
+        run.spec = "tage-sc-l";
+        runs.push_back(run);
+        run.spec = "hashed-perceptron";
+        runs.push_back(run);
+    }
+
+    // check all configurations before spending time on the trace
+    for (auto &run : runs) {
+        ConditionalPredictor *pred = makePredictor(run.spec);
+        if (!pred)
+            return EXIT_FAILURE;
+        delete pred;
+    }
+
+    std::string trace_name = argv[arg];
+    std::vector<TraceBranch> trace;
+    bool read = endsWith(trace_name, ".txt") ?
+        readTextTrace(trace_name, trace) : readProtoTrace(trace_name, trace);
+    if (!read) {
+        std::cerr << "Could not read trace " << trace_name << "\n";
+        return EXIT_FAILURE;
+    }
+
+    uint64_t insts = 0;
+    for (auto &br : trace)
+        insts += br.insts;
+
+    // every thread replays the trace against the next configuration
+    // that has not been claimed yet
+    std::atomic<size_t> next_run(0);
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next_run++) < runs.size()) {
+            ConditionalPredictor *pred = makePredictor(runs[i].spec);
+            replay(*pred, trace, depth, runs[i]);
+            delete pred;
+        }
+    };
+
+    num_threads = std::max(1U, std::min<unsigned>(num_threads, runs.size()));
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < num_threads; ++t)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (auto &t : threads)
+        t.join();
+
+    std::printf("# %zu branches, %llu instructions, %u configurations\n",
+                trace.size(), (unsigned long long)insts,
+                (unsigned)runs.size());
+    std::printf("# %10s %10s %12s %12s  %s\n", "MPKI", "accuracy",
+                "mispredicts", "branches/s", "configuration");
+    for (auto &run : runs) {
+        char mpki[16] = "-";
+        if (insts)
+            std::snprintf(mpki, sizeof(mpki), "%.4f",
+                          1000.0 * run.mispredicts / insts);
+        std::printf("  %10s %9.4f%% %12llu %12.0f  %s\n", mpki,
+                    run.condBranches ? 100.0 *
+                    (run.condBranches - run.mispredicts) /
+                    run.condBranches : 0.0,
+                    (unsigned long long)run.mispredicts,
+                    run.seconds > 0 ? trace.size() / run.seconds : 0.0,
+                    run.spec.c_str());
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -602,6 +602,15 @@ def from_C(cpt):
                 cpt.set(sec, 'intRegs', ' '.join(intRegs))
                 cpt.set(sec, 'ccRegs',  ' '.join(ccRegs))
 
+# Checkpoint version E records the format of each physical memory
+# store, as the memory image is no longer necessarily gzip compressed.
+def from_D(cpt):
+    import re
+    for sec in cpt.sections():
+        if re.match('^.*sys.*\.physmem\.store\d+$', sec) and \
+                not cpt.has_option(sec, 'store_format'):
+            cpt.set(sec, 'store_format', 'gzip')
+
 migrations = []
 migrations.append(from_0)
 migrations.append(from_1)
@@ -616,6 +625,7 @@ migrations.append(from_9)
 migrations.append(from_A)
 migrations.append(from_B)
 migrations.append(from_C)
+migrations.append(from_D)
 
 verbose_print = False
 